@@ -0,0 +1,140 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <primitives/o_transactions.h>
+#include <primitives/transaction.h>
+#include <tinyformat.h>
+
+#include <cassert>
+#include <vector>
+
+/** The i-th distinct water price measurement by key, unsigned */
+static OTransactions::CWaterPriceMeasurementData WaterPrice(const CKey& key, int64_t i)
+{
+    OTransactions::CWaterPriceMeasurementData data;
+    data.currency_code = "USD";
+    data.price = 1520000 + i;
+    data.measurer = key.GetPubKey();
+    data.timestamp = 1767225600 + i;
+    data.invite_id = uint256::ONE;
+    data.proof_type = "url";
+    data.proof_data = "https://example.com/water/price";
+    return data;
+}
+
+static CTransaction WaterPriceTransaction(uint8_t version)
+{
+    CKey key;
+    key.MakeNewKey(true);
+
+    // Sized as the signature scheme of the payload version
+    auto data{WaterPrice(key, 0)};
+    data.signature.assign(version == OTransactions::O_TX_VERSION_COMPACT ? 65 : OTransactions::O_SCHNORR_SIG_SIZE, 0x30);
+
+    CMutableTransaction tx;
+    tx.vout.emplace_back(0, data.ToScript(version));
+    return CTransaction{tx};
+}
+
+/** Decode throughput of a water price measurement, its size in bytes is part of the name */
+static void DecodeWaterPrice(benchmark::Bench& bench, uint8_t version)
+{
+    ECC_Context ecc_context{};
+    const CTransaction tx{WaterPriceTransaction(version)};
+    const std::string name{strprintf("%s (%u bytes)", bench.name(), tx.vout[0].scriptPubKey.size())};
+    bench.unit("measurement").run(name, [&] {
+        auto data = OTransactions::ExtractWaterPriceMeasurement(tx);
+        assert(data);
+        ankerl::nanobench::doNotOptimizeAway(data);
+    });
+}
+
+static void OWaterPriceDecode(benchmark::Bench& bench)
+{
+    DecodeWaterPrice(bench, OTransactions::O_TX_VERSION);
+}
+
+static void OWaterPriceDecodeCompact(benchmark::Bench& bench)
+{
+    DecodeWaterPrice(bench, OTransactions::O_TX_VERSION_COMPACT);
+}
+
+/**
+ * Signature verification of MAX_O_BATCH_RECORDS single measurements in the
+ * given payload version: compact payloads recover the key from an ECDSA
+ * signature, full payloads verify a Schnorr signature against their key
+ */
+static void VerifyMeasurements(benchmark::Bench& bench, uint8_t version)
+{
+    ECC_Context ecc_context{};
+    CKey key;
+    key.MakeNewKey(true);
+
+    std::vector<OTransactions::CWaterPriceMeasurementData> measurements;
+    for (size_t i = 0; i < OTransactions::MAX_O_BATCH_RECORDS; i++) {
+        auto data{WaterPrice(key, i)};
+        bool signed_data;
+        if (version == OTransactions::O_TX_VERSION_COMPACT) {
+            data.measurer = CPubKey{};
+            data.measurer_id = key.GetPubKey().GetID();
+            signed_data = key.SignCompact(data.GetHash(), data.signature);
+        } else {
+            data.signature.resize(OTransactions::O_SCHNORR_SIG_SIZE);
+            signed_data = key.SignSchnorr(data.GetHash(), data.signature, nullptr, uint256::ONE);
+        }
+        assert(signed_data);
+        measurements.push_back(std::move(data));
+    }
+
+    bench.batch(measurements.size()).unit("measurement").run([&] {
+        for (const auto& data : measurements) {
+            const bool valid = data.VerifySignature();
+            assert(valid);
+            ankerl::nanobench::doNotOptimizeAway(valid);
+        }
+    });
+}
+
+static void OMeasurementVerifyCompact(benchmark::Bench& bench)
+{
+    VerifyMeasurements(bench, OTransactions::O_TX_VERSION_COMPACT);
+}
+
+static void OMeasurementVerifySchnorr(benchmark::Bench& bench)
+{
+    VerifyMeasurements(bench, OTransactions::O_TX_VERSION);
+}
+
+/** Signature verification of a full batch of water price measurements, per measurement */
+static void OBatchVerify(benchmark::Bench& bench)
+{
+    ECC_Context ecc_context{};
+    CKey key;
+    key.MakeNewKey(true);
+
+    OTransactions::CBatchData batch;
+    batch.record_type = OTransactions::OTxType::WATER_PRICE;
+    batch.record_version = OTransactions::O_TX_VERSION_COMPACT;
+    batch.submitter = key.GetPubKey();
+    for (size_t i = 0; i < OTransactions::MAX_O_BATCH_RECORDS; i++) {
+        batch.AddRecord(WaterPrice(key, i));
+    }
+    batch.signature.resize(OTransactions::O_SCHNORR_SIG_SIZE);
+    const bool signed_batch{key.SignSchnorr(batch.GetHash(), batch.signature, nullptr, uint256::ONE)};
+    assert(signed_batch);
+
+    bench.batch(batch.records.size()).unit("measurement").run([&] {
+        const bool valid = batch.VerifySignature();
+        assert(valid);
+        ankerl::nanobench::doNotOptimizeAway(valid);
+    });
+}
+
+BENCHMARK(OWaterPriceDecode, benchmark::PriorityLevel::HIGH);
+BENCHMARK(OWaterPriceDecodeCompact, benchmark::PriorityLevel::HIGH);
+BENCHMARK(OMeasurementVerifyCompact, benchmark::PriorityLevel::HIGH);
+BENCHMARK(OMeasurementVerifySchnorr, benchmark::PriorityLevel::HIGH);
+BENCHMARK(OBatchVerify, benchmark::PriorityLevel::HIGH);
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <iterator>
 #include <optional>
+#include <string>
 #include <vector>
 
 /**
@@ -140,15 +141,16 @@ public:
     //! Mutex to ensure only one concurrent CCheckQueueControl
     Mutex m_control_mutex;
 
-    //! Create a new check queue
-    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num)
+    //! Create a new check queue. name is used for logging, thread_prefix to name the worker threads.
+    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num,
+                         const std::string& name = "Script verification", const std::string& thread_prefix = "scriptch")
         : nBatchSize(batch_size)
     {
-        LogInfo("Script verification uses %d additional threads", worker_threads_num);
+        LogInfo("%s uses %d additional threads", name, worker_threads_num);
         m_worker_threads.reserve(worker_threads_num);
         for (int n = 0; n < worker_threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
+            m_worker_threads.emplace_back([this, n, thread_prefix]() {
+                util::ThreadRename(strprintf("%s.%i", thread_prefix, n));
                 Loop(false /* worker thread */);
             });
         }
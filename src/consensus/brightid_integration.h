@@ -6,6 +6,7 @@
 #ifndef BITCOIN_CONSENSUS_BRIGHTID_INTEGRATION_H
 #define BITCOIN_CONSENSUS_BRIGHTID_INTEGRATION_H
 
+#include <cmath>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -54,8 +55,11 @@ struct BrightIDUser {
           trust_score(0.0), is_active(false) {}
     
     SERIALIZE_METHODS(BrightIDUser, obj) {
-        // Convert double to int64_t for serialization (6 decimal precision)
-        int64_t trust_score_int = static_cast<int64_t>(obj.trust_score * 1000000);
+        // Convert double to int64_t for serialization (6 decimal precision). Rounded
+        // rather than truncated so that a read-back score re-serializes identically.
+        // The encoding is unchanged: a score written truncated reads back to the same
+        // integer, and version 2 of the BrightID DB recounts verified_trust_sum on open.
+        int64_t trust_score_int = std::llround(obj.trust_score * 1000000);
         uint8_t status_val = static_cast<uint8_t>(obj.status);
         uint8_t method_val = static_cast<uint8_t>(obj.method);
         
@@ -5,8 +5,10 @@
 #ifndef BITCOIN_CONSENSUS_MULTICURRENCY_H
 #define BITCOIN_CONSENSUS_MULTICURRENCY_H
 
+#include <array>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <optional>
@@ -195,6 +197,20 @@ static constexpr CurrencyId CURRENCY_KMF = 145; // Comorian Franc
 /** Maximum number of supported currencies */
 static constexpr CurrencyId MAX_CURRENCIES = 1000;
 
+/** Longest currency symbol, symbols are packed into 64 bits for lookup */
+static constexpr size_t MAX_CURRENCY_SYMBOL_LENGTH = 8;
+
+/** Pack a currency symbol into an integer, one byte per character. Returns 0
+ *  for symbols that are empty or longer than MAX_CURRENCY_SYMBOL_LENGTH. */
+constexpr uint64_t PackCurrencySymbol(std::string_view symbol) {
+    if (symbol.empty() || symbol.size() > MAX_CURRENCY_SYMBOL_LENGTH) return 0;
+    uint64_t code = 0;
+    for (size_t i = 0; i < symbol.size(); ++i) {
+        code |= uint64_t{static_cast<uint8_t>(symbol[i])} << (8 * i);
+    }
+    return code;
+}
+
 /** Currency metadata structure */
 struct CurrencyMetadata {
     CurrencyId id;
@@ -240,30 +256,69 @@ struct MultiCurrencyAmount {
     }
 };
 
-/** Currency registry for managing supported currencies */
+/** Entry of the built-in currency table */
+struct CurrencyTableEntry {
+    CurrencyId id;
+    std::string_view symbol;
+    std::string_view name;
+    uint8_t decimals;
+    bool is_fiat;
+};
+
+/**
+ * Currency registry for managing supported currencies
+ *
+ * Metadata is stored in a dense array indexed by CurrencyId. Symbols are
+ * packed into 64-bit codes and indexed in an open-addressed table, so
+ * lookups by id or symbol neither allocate nor walk a tree. The hash is
+ * chosen so the built-in currencies land in distinct slots; currencies
+ * registered later probe linearly.
+ */
 class CurrencyRegistry {
+public:
+    /** Slots of the symbol index, a power of two above twice MAX_CURRENCIES */
+    static constexpr int SYMBOL_INDEX_BITS = 11;
+    static constexpr size_t SYMBOL_INDEX_SLOTS = size_t{1} << SYMBOL_INDEX_BITS;
+    static constexpr uint64_t SYMBOL_HASH_MULTIPLIER = 0x3a1890c78092b4d5;
+    
+    /** Home slot of a packed symbol in the symbol index */
+    static constexpr size_t SymbolSlot(uint64_t code) {
+        return (code * SYMBOL_HASH_MULTIPLIER) >> (64 - SYMBOL_INDEX_BITS);
+    }
+    
 private:
-    std::map<CurrencyId, CurrencyMetadata> currencies;
-    std::map<std::string, CurrencyId> symbol_to_id;
+    struct SymbolIndexEntry {
+        uint64_t code{0}; // 0 marks an empty slot
+        CurrencyId id{0};
+    };
+    
+    std::vector<std::optional<CurrencyMetadata>> currencies; // MAX_CURRENCIES entries, indexed by id
+    std::array<SymbolIndexEntry, SYMBOL_INDEX_SLOTS> symbol_index{};
+    size_t currency_count{0};
     
 public:
     CurrencyRegistry();
     
-    /** Register a new currency */
+    /** Register a new currency. Fails if the id or symbol is taken, the id is
+     *  not below MAX_CURRENCIES or the symbol is empty or too long. */
     bool RegisterCurrency(const CurrencyMetadata& metadata);
     
-    /** Get currency metadata by ID */
-    std::optional<CurrencyMetadata> GetCurrency(CurrencyId id) const;
+    /** Get currency metadata by ID, nullptr if none is registered. Entries are
+     *  never moved or removed, so the pointer lives as long as the registry. */
+    const CurrencyMetadata* GetCurrency(CurrencyId id) const;
     
     /** Get currency ID by symbol */
-    std::optional<CurrencyId> GetCurrencyId(const std::string& symbol) const;
+    std::optional<CurrencyId> GetCurrencyId(std::string_view symbol) const;
     
     /** Check if currency is supported */
     bool IsSupported(CurrencyId id) const;
     
-    /** Get all registered currencies */
+    /** Get all registered currencies, ordered by ID */
     std::vector<CurrencyMetadata> GetAllCurrencies() const;
     
+    /** Number of registered currencies */
+    size_t Size() const { return currency_count; }
+    
     /** Initialize with default fiat currencies */
     void InitializeDefaultCurrencies();
 };
@@ -271,5 +326,12 @@ public:
 /** Global currency registry instance */
 extern CurrencyRegistry g_currency_registry;
 
+/** Id of a built-in currency by symbol. The built-in table is fixed at compile
+ *  time, unlike the registry, so encodings that must agree across nodes use it. */
+std::optional<CurrencyId> GetDefaultCurrencyId(std::string_view symbol);
+
+/** Symbol of a built-in currency by id */
+std::optional<std::string_view> GetDefaultCurrencySymbol(CurrencyId id);
+
 #endif // BITCOIN_CONSENSUS_MULTICURRENCY_H
 
@@ -6,14 +6,55 @@
 #include <common/args.h>
 #include <logging.h>
 #include <util/fs.h>
+#include <util/strencodings.h>
 #include <util/time.h>
 #include <streams.h>
 
+#include <cmath>
+#include <set>
+
 namespace OConsensus {
 
 // Global instance (initialized in init.cpp)
 std::unique_ptr<CBrightIDUserDB> g_brightid_db;
 
+namespace {
+
+/** Flush index rebuild batches once they grow past this size */
+constexpr size_t INDEX_BATCH_FLUSH_SIZE = 16 << 20;
+
+/** (birth currency, BrightID address); the length-prefixed currency keeps each currency contiguous */
+using BirthCurrencyKey = std::pair<uint8_t, std::pair<std::string, std::string>>;
+
+/** Birth currency is stored in context_id as "COUNTRY:CURRENCY", e.g. "USA:OUSD" */
+std::optional<std::string> ParseBirthCurrency(const BrightIDUser& user)
+{
+    size_t colon_pos = user.context_id.find(':');
+    if (colon_pos == std::string::npos) {
+        return std::nullopt;
+    }
+    return user.context_id.substr(colon_pos + 1);
+}
+
+/** Stabilization recipient key of a user, if the user is eligible to be indexed */
+std::optional<CPubKey> ParseRecipientKey(const BrightIDUser& user, const std::optional<std::string>& o_address)
+{
+    if (!user.IsVerified() || !user.is_active || !o_address.has_value()) {
+        return std::nullopt;
+    }
+    std::vector<unsigned char> pubkey_bytes = ParseHex(o_address.value());
+    if (pubkey_bytes.size() != CPubKey::COMPRESSED_SIZE && pubkey_bytes.size() != CPubKey::SIZE) {
+        return std::nullopt;
+    }
+    CPubKey pubkey(pubkey_bytes.begin(), pubkey_bytes.end());
+    if (!pubkey.IsValid()) {
+        return std::nullopt;
+    }
+    return pubkey;
+}
+
+} // namespace
+
 CBrightIDUserDB::CBrightIDUserDB(size_t cache_size, bool memory_only, bool wipe_data)
 {
     DBParams db_params;
@@ -31,10 +72,158 @@ CBrightIDUserDB::CBrightIDUserDB(size_t cache_size, bool memory_only, bool wipe_
         LogPrintf("O BrightID DB: Error opening database: %s\n", e.what());
         throw;
     }
+    
+    UpgradeIndexes();
+    
+    LOCK(m_db_mutex);
+    m_db->Read(DB_BRIGHTID_STATS, m_counters);
 }
 
 CBrightIDUserDB::~CBrightIDUserDB() = default;
 
+void BrightIDCounters::Apply(const BrightIDUser& user, int sign)
+{
+    // Counters never go below zero even if they were out of sync
+    auto adjust = [sign](uint64_t& value) { value = (sign < 0 && value == 0) ? 0 : value + sign; };
+    
+    adjust(user_count);
+    adjust(count_by_status[static_cast<uint8_t>(user.status)]);
+    if (count_by_status[static_cast<uint8_t>(user.status)] == 0) {
+        count_by_status.erase(static_cast<uint8_t>(user.status));
+    }
+    if (user.IsActive()) {
+        adjust(active_count);
+    }
+    if (user.IsVerified()) {
+        adjust(verified_count);
+        verified_trust_sum += sign * std::llround(user.trust_score * 1000000);
+    }
+}
+
+bool CBrightIDUserDB::WriteBatchWithCounters(CDBBatch& batch, const BrightIDCounters& counters)
+{
+    batch.Write(DB_BRIGHTID_STATS, counters);
+    if (!CommitBatch(batch)) {
+        return false;
+    }
+    m_counters = counters;
+    return true;
+}
+
+bool CBrightIDUserDB::CommitBatch(CDBBatch& batch)
+{
+    AssertLockHeld(m_db_mutex);
+    const bool defer{ODeferSyncScope::Active()};
+    if (!m_db->WriteBatch(batch, !defer)) {
+        return false;
+    }
+    m_unsynced = defer;
+    m_write_version++;
+    return true;
+}
+
+uint64_t CBrightIDUserDB::GetWriteVersion() const
+{
+    LOCK(m_db_mutex);
+    return m_write_version;
+}
+
+bool CBrightIDUserDB::Sync()
+{
+    LOCK(m_db_mutex);
+    if (!m_unsynced) {
+        return true;
+    }
+    
+    // A synced write flushes the log including all earlier unsynced writes
+    CDBBatch batch(*m_db);
+    if (!m_db->WriteBatch(batch, true)) {
+        LogPrintf("O BrightID DB: Failed to sync deferred writes\n");
+        return false;
+    }
+    m_unsynced = false;
+    return true;
+}
+
+void CBrightIDUserDB::UpgradeIndexes()
+{
+    LOCK(m_db_mutex);
+    
+    int version = 0;
+    if (m_db->Read(DB_BRIGHTID_VERSION, version) && version >= BRIGHTID_DB_VERSION) {
+        return;
+    }
+    
+    if (m_db->IsEmpty()) {
+        m_db->Write(DB_BRIGHTID_VERSION, BRIGHTID_DB_VERSION, true);
+        return;
+    }
+    
+    LogPrintf("O BrightID DB: Upgrading database from version %d to %d, rebuilding indexes\n",
+              version, BRIGHTID_DB_VERSION);
+    
+    CDBBatch batch(*m_db);
+    BrightIDCounters counters; // Recounted from scratch alongside the indexes
+    size_t indexed = 0;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(DB_BRIGHTID_USER); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, std::string> key;
+        if (!iterator->GetKey(key) || key.first != DB_BRIGHTID_USER) {
+            break;
+        }
+        
+        BrightIDUser user;
+        if (iterator->GetValue(user)) {
+            counters.Apply(user, 1);
+            auto currency = ParseBirthCurrency(user);
+            auto pubkey = ParseRecipientKey(user, GetOAddress(key.second));
+            if (currency.has_value() && pubkey.has_value()) {
+                batch.Write(BirthCurrencyKey{DB_BIRTH_CURRENCY, {currency.value(), key.second}}, pubkey.value());
+                indexed++;
+            }
+        }
+        
+        if (batch.ApproximateSize() > INDEX_BATCH_FLUSH_SIZE) {
+            m_db->WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    
+    // The version is written last so an interrupted upgrade is simply redone
+    batch.Write(DB_BRIGHTID_STATS, counters);
+    batch.Write(DB_BRIGHTID_VERSION, BRIGHTID_DB_VERSION);
+    m_db->WriteBatch(batch, true);
+    
+    LogPrintf("O BrightID DB: Indexed %d users by birth currency\n", indexed);
+}
+
+void CBrightIDUserDB::UpdateUserIndexes(CDBBatch& batch, BrightIDCounters& counters, const std::string& brightid_address,
+                                        const std::optional<BrightIDUser>& old_user, const std::optional<std::string>& old_o_address,
+                                        const std::optional<BrightIDUser>& new_user, const std::optional<std::string>& new_o_address)
+{
+    if (old_o_address.has_value()) m_measurer_cache.Erase(old_o_address.value());
+    if (new_o_address.has_value()) m_measurer_cache.Erase(new_o_address.value());
+    
+    if (old_user.has_value()) {
+        counters.Apply(old_user.value(), -1);
+        auto currency = ParseBirthCurrency(old_user.value());
+        if (currency.has_value() && ParseRecipientKey(old_user.value(), old_o_address).has_value()) {
+            batch.Erase(BirthCurrencyKey{DB_BIRTH_CURRENCY, {currency.value(), brightid_address}});
+        }
+    }
+    
+    // Written after the erase, so an unchanged entry survives the batch
+    if (new_user.has_value()) {
+        counters.Apply(new_user.value(), 1);
+        auto currency = ParseBirthCurrency(new_user.value());
+        auto pubkey = ParseRecipientKey(new_user.value(), new_o_address);
+        if (currency.has_value() && pubkey.has_value()) {
+            batch.Write(BirthCurrencyKey{DB_BIRTH_CURRENCY, {currency.value(), brightid_address}}, pubkey.value());
+        }
+    }
+}
+
 // ===== User Operations =====
 
 bool CBrightIDUserDB::WriteUser(const std::string& brightid_address, const BrightIDUser& user)
@@ -42,9 +231,13 @@ bool CBrightIDUserDB::WriteUser(const std::string& brightid_address, const Brigh
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    BrightIDCounters counters = m_counters;
     batch.Write(std::make_pair(DB_BRIGHTID_USER, brightid_address), user);
     
-    bool success = m_db->WriteBatch(batch, true);
+    auto o_addr = GetOAddress(brightid_address);
+    UpdateUserIndexes(batch, counters, brightid_address, ReadUser(brightid_address), o_addr, user, o_addr);
+    
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success) {
         LogDebug(BCLog::NET, "O BrightID DB: Wrote user %s (status=%d, trust=%.2f)\n",
@@ -79,12 +272,14 @@ bool CBrightIDUserDB::EraseUser(const std::string& brightid_address)
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    BrightIDCounters counters = m_counters;
     
     // Erase user data
     batch.Erase(std::make_pair(DB_BRIGHTID_USER, brightid_address));
     
     // Also erase address mappings
     auto o_addr = GetOAddress(brightid_address);
+    UpdateUserIndexes(batch, counters, brightid_address, ReadUser(brightid_address), o_addr, std::nullopt, std::nullopt);
     if (o_addr.has_value()) {
         batch.Erase(std::make_pair(DB_BRIGHTID_TO_O, brightid_address));
         batch.Erase(std::make_pair(DB_O_TO_BRIGHTID, o_addr.value()));
@@ -97,7 +292,7 @@ bool CBrightIDUserDB::EraseUser(const std::string& brightid_address)
         batch.Erase(std::make_pair(DB_ANONYMOUS_REP, anon_id.value()));
     }
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success) {
         LogDebug(BCLog::NET, "O BrightID DB: Erased user %s\n", brightid_address.substr(0, 16));
@@ -148,7 +343,11 @@ bool CBrightIDUserDB::LinkAddresses(const std::string& brightid_address, const s
     batch.Write(std::make_pair(DB_BRIGHTID_TO_O, brightid_address), o_address);
     batch.Write(std::make_pair(DB_O_TO_BRIGHTID, o_address), brightid_address);
     
-    bool success = m_db->WriteBatch(batch, true);
+    BrightIDCounters counters = m_counters;
+    auto user = ReadUser(brightid_address);
+    UpdateUserIndexes(batch, counters, brightid_address, user, GetOAddress(brightid_address), user, o_address);
+    
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success) {
         LogDebug(BCLog::NET, "O BrightID DB: Linked %s <-> %s\n",
@@ -171,7 +370,11 @@ bool CBrightIDUserDB::UnlinkAddresses(const std::string& brightid_address)
     batch.Erase(std::make_pair(DB_BRIGHTID_TO_O, brightid_address));
     batch.Erase(std::make_pair(DB_O_TO_BRIGHTID, o_addr.value()));
     
-    bool success = m_db->WriteBatch(batch, true);
+    BrightIDCounters counters = m_counters;
+    auto user = ReadUser(brightid_address);
+    UpdateUserIndexes(batch, counters, brightid_address, user, o_addr, user, std::nullopt);
+    
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success) {
         LogDebug(BCLog::NET, "O BrightID DB: Unlinked %s <-> %s\n",
@@ -205,6 +408,25 @@ std::optional<std::string> CBrightIDUserDB::GetBrightIDAddress(const std::string
     return std::nullopt;
 }
 
+bool CBrightIDUserDB::IsOAddressVerified(const std::string& o_address) const
+{
+    if (auto cached = m_measurer_cache.Get(o_address)) {
+        return cached.value();
+    }
+    
+    // Filled under the lock that writers hold while invalidating
+    LOCK(m_db_mutex);
+    
+    bool verified = false;
+    if (auto brightid_address = GetBrightIDAddress(o_address)) {
+        auto user = ReadUser(brightid_address.value());
+        verified = user.has_value() && user->IsVerified() && user->IsActive();
+    }
+    m_measurer_cache.Put(o_address, verified);
+    
+    return verified;
+}
+
 // ===== Anonymous ID Operations =====
 
 bool CBrightIDUserDB::WriteAnonymousID(const std::string& brightid_address, const std::string& anonymous_id)
@@ -214,7 +436,7 @@ bool CBrightIDUserDB::WriteAnonymousID(const std::string& brightid_address, cons
     CDBBatch batch(*m_db);
     batch.Write(std::make_pair(DB_ANONYMOUS_ID, brightid_address), anonymous_id);
     
-    return m_db->WriteBatch(batch, true);
+    return CommitBatch(batch);
 }
 
 std::optional<std::string> CBrightIDUserDB::GetAnonymousID(const std::string& brightid_address) const
@@ -239,7 +461,7 @@ bool CBrightIDUserDB::WriteAnonymousReputation(const std::string& anonymous_id,
     CDBBatch batch(*m_db);
     batch.Write(std::make_pair(DB_ANONYMOUS_REP, anonymous_id), reputation_int);
     
-    return m_db->WriteBatch(batch, true);
+    return CommitBatch(batch);
 }
 
 std::optional<double> CBrightIDUserDB::GetAnonymousReputation(const std::string& anonymous_id) const
@@ -268,7 +490,7 @@ bool CBrightIDUserDB::EraseAnonymousData(const std::string& brightid_address)
     batch.Erase(std::make_pair(DB_ANONYMOUS_ID, brightid_address));
     batch.Erase(std::make_pair(DB_ANONYMOUS_REP, anon_id.value()));
     
-    return m_db->WriteBatch(batch, true);
+    return CommitBatch(batch);
 }
 
 // ===== Batch Operations =====
@@ -369,12 +591,22 @@ bool CBrightIDUserDB::BatchWriteUsers(const std::vector<std::pair<std::string, B
     LOCK(m_db_mutex);
     
     CDBBatch db_batch(*m_db);
+    BrightIDCounters counters = m_counters;
+    
+    // Users written earlier in the same batch are what a later entry replaces
+    std::map<std::string, const BrightIDUser*> written;
     
     for (const auto& [brightid_addr, user] : batch) {
         db_batch.Write(std::make_pair(DB_BRIGHTID_USER, brightid_addr), user);
+        
+        auto o_addr = GetOAddress(brightid_addr);
+        auto it = written.find(brightid_addr);
+        UpdateUserIndexes(db_batch, counters, brightid_addr,
+                          it != written.end() ? std::optional{*it->second} : ReadUser(brightid_addr), o_addr, user, o_addr);
+        written[brightid_addr] = &user;
     }
     
-    bool success = m_db->WriteBatch(db_batch, true);
+    bool success = WriteBatchWithCounters(db_batch, counters);
     
     if (success) {
         LogPrintf("O BrightID DB: Batch wrote %d users\n", batch.size());
@@ -388,12 +620,18 @@ bool CBrightIDUserDB::BatchEraseUsers(const std::vector<std::string>& brightid_a
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    BrightIDCounters counters = m_counters;
+    
+    // A repeated address still reads as present, so only its first erase counts
+    std::set<std::string> erased;
     
     for (const auto& addr : brightid_addresses) {
+        if (!erased.insert(addr).second) continue;
         batch.Erase(std::make_pair(DB_BRIGHTID_USER, addr));
         
         // Also erase related data
         auto o_addr = GetOAddress(addr);
+        UpdateUserIndexes(batch, counters, addr, ReadUser(addr), o_addr, std::nullopt, std::nullopt);
         if (o_addr.has_value()) {
             batch.Erase(std::make_pair(DB_BRIGHTID_TO_O, addr));
             batch.Erase(std::make_pair(DB_O_TO_BRIGHTID, o_addr.value()));
@@ -406,7 +644,7 @@ bool CBrightIDUserDB::BatchEraseUsers(const std::vector<std::string>& brightid_a
         }
     }
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success) {
         LogPrintf("O BrightID DB: Batch erased %d users\n", brightid_addresses.size());
@@ -511,51 +749,36 @@ std::vector<std::string> CBrightIDUserDB::FindExpiringUsers(int64_t days_until_e
 }
 
 std::vector<CPubKey> CBrightIDUserDB::FindUsersByBirthCurrency(const std::string& birth_currency) const
+{
+    std::vector<CPubKey> matching_users;
+    ForEachUserByBirthCurrency(birth_currency, [&](const CPubKey& pubkey) {
+        matching_users.push_back(pubkey);
+    });
+    
+    LogDebug(BCLog::NET, "O BrightID DB: Found %d users with birth currency %s\n", 
+             matching_users.size(), birth_currency.c_str());
+    return matching_users;
+}
+
+void CBrightIDUserDB::ForEachUserByBirthCurrency(const std::string& birth_currency,
+                                                 const std::function<void(const CPubKey&)>& visitor) const
 {
     LOCK(m_db_mutex);
     
-    std::vector<CPubKey> matching_users;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
-    for (iterator->Seek(DB_BRIGHTID_USER); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, std::string> key;
-        if (!iterator->GetKey(key) || key.first != DB_BRIGHTID_USER) {
+    // Only verified, active users with a linked O address are indexed
+    for (iterator->Seek(BirthCurrencyKey{DB_BIRTH_CURRENCY, {birth_currency, ""}}); iterator->Valid(); iterator->Next()) {
+        BirthCurrencyKey key;
+        if (!iterator->GetKey(key) || key.first != DB_BIRTH_CURRENCY || key.second.first != birth_currency) {
             break;
         }
         
-        BrightIDUser user;
-        if (iterator->GetValue(user)) {
-            // Birth currency is stored in context_id as "COUNTRY:CURRENCY"
-            // Example: "USA:OUSD", "MEX:OMXN", "FRA:OEUR"
-            size_t colon_pos = user.context_id.find(':');
-            if (colon_pos != std::string::npos) {
-                std::string stored_currency = user.context_id.substr(colon_pos + 1);
-                
-                // Match birth currency and ensure user is verified and active
-                if (stored_currency == birth_currency && 
-                    user.IsVerified() && 
-                    user.is_active) {
-                    
-                    // Get user's O address (public key)
-                    auto o_address = GetOAddress(key.second);
-                    if (o_address.has_value()) {
-                        // Convert hex string to CPubKey
-                        std::vector<unsigned char> pubkey_bytes = ParseHex(o_address.value());
-                        if (pubkey_bytes.size() == 33 || pubkey_bytes.size() == 65) {
-                            CPubKey pubkey(pubkey_bytes.begin(), pubkey_bytes.end());
-                            if (pubkey.IsValid()) {
-                                matching_users.push_back(pubkey);
-                            }
-                        }
-                    }
-                }
-            }
+        CPubKey pubkey;
+        if (iterator->GetValue(pubkey)) {
+            visitor(pubkey);
         }
     }
-    
-    LogDebug(BCLog::NET, "O BrightID DB: Found %d users with birth currency %s\n", 
-             matching_users.size(), birth_currency.c_str());
-    return matching_users;
 }
 
 // ===== Statistics =====
@@ -563,70 +786,48 @@ std::vector<CPubKey> CBrightIDUserDB::FindUsersByBirthCurrency(const std::string
 size_t CBrightIDUserDB::GetUserCount() const
 {
     LOCK(m_db_mutex);
-    
-    size_t count = 0;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
-    
-    for (iterator->Seek(DB_BRIGHTID_USER); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, std::string> key;
-        if (!iterator->GetKey(key) || key.first != DB_BRIGHTID_USER) {
-            break;
-        }
-        count++;
-    }
-    
-    return count;
+    return m_counters.user_count;
 }
 
 size_t CBrightIDUserDB::GetVerifiedUserCount() const
+{
+    LOCK(m_db_mutex);
+    return m_counters.verified_count;
+}
+
+size_t CBrightIDUserDB::GetActiveUserCount() const
+{
+    LOCK(m_db_mutex);
+    return m_counters.active_count;
+}
+
+std::map<BrightIDStatus, size_t> CBrightIDUserDB::GetUserCountByStatus() const
 {
     LOCK(m_db_mutex);
     
-    size_t count = 0;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
-    
-    for (iterator->Seek(DB_BRIGHTID_USER); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, std::string> key;
-        if (!iterator->GetKey(key) || key.first != DB_BRIGHTID_USER) {
-            break;
-        }
-        
-        BrightIDUser user;
-        if (iterator->GetValue(user) && user.IsVerified()) {
-            count++;
-        }
+    std::map<BrightIDStatus, size_t> status_counts;
+    for (const auto& [status, count] : m_counters.count_by_status) {
+        status_counts[static_cast<BrightIDStatus>(status)] = count;
     }
     
-    return count;
+    return status_counts;
 }
 
-size_t CBrightIDUserDB::GetActiveUserCount() const
+double CBrightIDUserDB::GetAverageTrustScore() const
 {
     LOCK(m_db_mutex);
     
-    size_t count = 0;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
-    
-    for (iterator->Seek(DB_BRIGHTID_USER); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, std::string> key;
-        if (!iterator->GetKey(key) || key.first != DB_BRIGHTID_USER) {
-            break;
-        }
-        
-        BrightIDUser user;
-        if (iterator->GetValue(user) && user.IsActive()) {
-            count++;
-        }
+    if (m_counters.verified_count == 0) {
+        return 0.0;
     }
-    
-    return count;
+    return static_cast<double>(m_counters.verified_trust_sum) / 1000000.0 / m_counters.verified_count;
 }
 
-std::map<BrightIDStatus, size_t> CBrightIDUserDB::GetUserCountByStatus() const
+BrightIDCounters CBrightIDUserDB::ComputeCounters() const
 {
     LOCK(m_db_mutex);
     
-    std::map<BrightIDStatus, size_t> status_counts;
+    BrightIDCounters counters;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
     for (iterator->Seek(DB_BRIGHTID_USER); iterator->Valid(); iterator->Next()) {
@@ -637,35 +838,26 @@ std::map<BrightIDStatus, size_t> CBrightIDUserDB::GetUserCountByStatus() const
         
         BrightIDUser user;
         if (iterator->GetValue(user)) {
-            status_counts[user.status]++;
+            counters.Apply(user, 1);
         }
     }
     
-    return status_counts;
+    return counters;
 }
 
-double CBrightIDUserDB::GetAverageTrustScore() const
+bool CBrightIDUserDB::RebuildCounters()
 {
     LOCK(m_db_mutex);
     
-    double total_trust = 0.0;
-    size_t count = 0;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    CDBBatch batch(*m_db);
+    bool success = WriteBatchWithCounters(batch, ComputeCounters());
     
-    for (iterator->Seek(DB_BRIGHTID_USER); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, std::string> key;
-        if (!iterator->GetKey(key) || key.first != DB_BRIGHTID_USER) {
-            break;
-        }
-        
-        BrightIDUser user;
-        if (iterator->GetValue(user) && user.IsVerified()) {
-            total_trust += user.trust_score;
-            count++;
-        }
+    if (success) {
+        LogPrintf("O BrightID DB: Rebuilt counters (%d users, %d verified, %d active)\n",
+                  m_counters.user_count, m_counters.verified_count, m_counters.active_count);
     }
     
-    return count > 0 ? total_trust / count : 0.0;
+    return success;
 }
 
 // ===== Maintenance =====
@@ -741,15 +933,23 @@ bool CBrightIDUserDB::PruneInactiveUsers(int64_t inactive_days)
 
 void CBrightIDUserDB::Compact()
 {
-    LOCK(m_db_mutex);
-    
-    LogPrintf("O BrightID DB: Database compaction requested\n");
-    LogPrintf("O BrightID DB: Note: Compaction happens automatically via LevelDB\n");
-    LogPrintf("O BrightID DB: To force compaction, restart node with -reindex\n");
-    
-    // Note: CDBWrapper doesn't expose CompactRange publicly
-    // Compaction happens automatically in LevelDB
-    // Manual compaction can be triggered via -reindex flag
+    LogPrintf("O BrightID DB: Compacting %d key prefixes\n", BRIGHTID_DB_HOT_PREFIXES.size());
+    for (const uint8_t prefix : BRIGHTID_DB_HOT_PREFIXES) {
+        CompactKeyRange(OConsensus::OKeyRange{prefix, 0, std::nullopt});
+    }
+    LogPrintf("O BrightID DB: Compaction finished\n");
+}
+
+uint64_t CBrightIDUserDB::EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const
+{
+    return m_db->EstimateSize(range.BeginKey(), range.EndKey());
+}
+
+void CBrightIDUserDB::CompactKeyRange(const OConsensus::OKeyRange& range) const
+{
+    // LevelDB compaction is internally synchronized, so m_db_mutex is not
+    // held and writers are not blocked while the range is rewritten.
+    m_db->CompactRange(range.BeginKey(), range.EndKey());
 }
 
 size_t CBrightIDUserDB::EstimateSize() const
@@ -825,7 +1025,12 @@ bool CBrightIDUserDB::VerifyIntegrity() const
     LogPrintf("O BrightID DB: Integrity check complete. Total: %d, Corrupted: %d\n",
               total_users, corrupted_users);
     
-    return corrupted_users == 0;
+    bool counters_match = ComputeCounters() == m_counters;
+    if (!counters_match) {
+        LogPrintf("O BrightID DB: Persisted counters do not match records, run RebuildCounters\n");
+    }
+    
+    return corrupted_users == 0 && counters_match;
 }
 
 } // namespace OConsensus
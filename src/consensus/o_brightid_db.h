@@ -7,10 +7,15 @@
 
 #include <dbwrapper.h>
 #include <consensus/brightid_integration.h>
+#include <consensus/o_db_maintenance.h>
+#include <consensus/o_lookup_cache.h>
 #include <pubkey.h>
 #include <sync.h>
 #include <uint256.h>
 
+#include <array>
+#include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -24,14 +29,67 @@ static constexpr uint8_t DB_BRIGHTID_TO_O = 'b';           // BrightID address -
 static constexpr uint8_t DB_O_TO_BRIGHTID = 'o';           // O address -> BrightID address mapping
 static constexpr uint8_t DB_ANONYMOUS_ID = 'a';            // BrightID address -> Anonymous ID
 static constexpr uint8_t DB_ANONYMOUS_REP = 'r';           // Anonymous ID -> Reputation score
-static constexpr uint8_t DB_BRIGHTID_STATS = 's';          // Statistics
+static constexpr uint8_t DB_BRIGHTID_STATS = 's';          // Aggregate counters (BrightIDCounters)
+static constexpr uint8_t DB_BIRTH_CURRENCY = 'c';          // Index: (birth currency, BrightID address) -> O pubkey
 static constexpr uint8_t DB_BRIGHTID_VERSION = 'v';        // Database version
 
+/** Prefixes that see most erases and overwrites, compacted by background maintenance */
+static constexpr std::array<uint8_t, 4> BRIGHTID_DB_HOT_PREFIXES{
+    DB_BRIGHTID_USER, DB_BRIGHTID_TO_O, DB_O_TO_BRIGHTID, DB_BIRTH_CURRENCY};
+
+/** Current on-disk layout version. Bump when adding index keyspaces that must be
+ *  rebuilt for existing databases (see CBrightIDUserDB::UpgradeIndexes). */
+static constexpr int BRIGHTID_DB_VERSION = 2;
+
+/** Persisted aggregate user counters, updated in the same batch as every user write */
+struct BrightIDCounters {
+    uint64_t user_count{0};
+    uint64_t active_count{0};                      // Users passing BrightIDUser::IsActive()
+    uint64_t verified_count{0};                    // Users passing BrightIDUser::IsVerified()
+    int64_t verified_trust_sum{0};                 // Sum of verified users' trust scores, in millionths
+    std::map<uint8_t, uint64_t> count_by_status;
+    
+    SERIALIZE_METHODS(BrightIDCounters, obj) {
+        READWRITE(obj.user_count, obj.active_count, obj.verified_count,
+                  obj.verified_trust_sum, obj.count_by_status);
+    }
+    
+    /** Add (sign = 1) or remove (sign = -1) a user's contribution */
+    void Apply(const BrightIDUser& user, int sign);
+    
+    bool operator==(const BrightIDCounters&) const = default;
+};
+
 /** BrightID User Database - Persistent storage for Proof of Personhood data */
 class CBrightIDUserDB {
 private:
     std::unique_ptr<CDBWrapper> m_db;
     mutable RecursiveMutex m_db_mutex;
+    BrightIDCounters m_counters GUARDED_BY(m_db_mutex);
+    bool m_unsynced GUARDED_BY(m_db_mutex){false};
+    uint64_t m_write_version GUARDED_BY(m_db_mutex){0};
+    
+    /** O address -> whether it is linked to a verified, active user. Filled and
+     *  invalidated under m_db_mutex by IsOAddressVerified and UpdateUserIndexes. */
+    mutable OLookupCache<std::string, bool> m_measurer_cache;
+    
+    /** Rebuild secondary indexes for databases written by an older version */
+    void UpgradeIndexes();
+    
+    /** Replace the birth-currency index entry and counter contribution of a user
+     *  whose record or O address changes, and invalidate its cached verification */
+    void UpdateUserIndexes(CDBBatch& batch, BrightIDCounters& counters, const std::string& brightid_address,
+                           const std::optional<BrightIDUser>& old_user, const std::optional<std::string>& old_o_address,
+                           const std::optional<BrightIDUser>& new_user, const std::optional<std::string>& new_o_address);
+    
+    /** Scan all users and compute the aggregate counters from scratch */
+    BrightIDCounters ComputeCounters() const;
+    
+    /** Write a batch together with updated counters, adopting them on success */
+    bool WriteBatchWithCounters(CDBBatch& batch, const BrightIDCounters& counters);
+    
+    /** Write a batch, synced unless the calling thread is in an ODeferSyncScope */
+    bool CommitBatch(CDBBatch& batch);
     
 public:
     explicit CBrightIDUserDB(size_t cache_size, bool memory_only = false, bool wipe_data = false);
@@ -71,6 +129,15 @@ public:
     /** Get BrightID address for O address */
     std::optional<std::string> GetBrightIDAddress(const std::string& o_address) const;
     
+    /** Whether the O address is linked to a verified, active user. Cached. */
+    bool IsOAddressVerified(const std::string& o_address) const;
+    
+    /** Resize the verification cache (0 disables it) */
+    void SetMeasurerCacheCapacity(size_t capacity) { m_measurer_cache.SetCapacity(capacity); }
+    
+    /** Entry count and hit/miss counters of the verification cache */
+    OLookupCache<std::string, bool>::Stats GetMeasurerCacheStats() const { return m_measurer_cache.GetStats(); }
+    
     // ===== Anonymous ID Operations =====
     
     /** Store anonymous ID mapping */
@@ -122,10 +189,16 @@ public:
     /** Find users expiring soon */
     std::vector<std::string> FindExpiringUsers(int64_t days_until_expiry) const;
     
-    /** Find users by birth currency (for stabilization rewards) */
+    /** Find verified, active users with a linked O address by birth currency
+     *  (for stabilization rewards). Served by a prefix seek over the birth-currency index. */
     std::vector<CPubKey> FindUsersByBirthCurrency(const std::string& birth_currency) const;
     
+    /** Visit the same users as FindUsersByBirthCurrency without materializing the list */
+    void ForEachUserByBirthCurrency(const std::string& birth_currency,
+                                    const std::function<void(const CPubKey&)>& visitor) const;
+    
     // ===== Statistics =====
+    // Served from persisted counters maintained by every user write
     
     /** Get total number of users in database */
     size_t GetUserCount() const;
@@ -139,9 +212,23 @@ public:
     /** Get users by status count */
     std::map<BrightIDStatus, size_t> GetUserCountByStatus() const;
     
-    /** Get average trust score */
+    /** Get average trust score of verified users */
     double GetAverageTrustScore() const;
     
+    /** Recompute the persisted counters from a full scan */
+    bool RebuildCounters();
+    
+    /** Number of batches committed since the database was opened. Any change to
+     *  users or their links changes it, so state read at one version is current
+     *  for as long as the version is unchanged. */
+    uint64_t GetWriteVersion() const;
+    
+    // ===== Write Durability =====
+    
+    /** Make all writes committed since the last sync durable. Writes made
+     *  inside an ODeferSyncScope are committed without fsync until then. */
+    bool Sync();
+    
     // ===== Maintenance =====
     
     /** Prune expired users before cutoff timestamp */
@@ -150,9 +237,15 @@ public:
     /** Prune inactive users (not active for specified days) */
     bool PruneInactiveUsers(int64_t inactive_days);
     
-    /** Compact the database */
+    /** Compact all hot key prefixes */
     void Compact();
     
+    /** Estimated on-disk size of a range of keys, see OConsensus::SplitPrefix */
+    uint64_t EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const;
+    
+    /** Compact a range of keys */
+    void CompactKeyRange(const OConsensus::OKeyRange& range) const;
+    
     /** Get database size estimate */
     size_t EstimateSize() const;
     
@@ -167,7 +260,7 @@ public:
     /** Import users from file (for restore) */
     bool ImportUsers(const fs::path& import_path);
     
-    /** Verify database integrity */
+    /** Verify database integrity, including that the persisted counters match the records */
     bool VerifyIntegrity() const;
 };
 
@@ -8,11 +8,78 @@
 #include <util/fs.h>
 #include <streams.h>
 
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <map>
+
 namespace OConsensus {
 
 // Global instance (initialized in init.cpp)
 std::unique_ptr<CBusinessMinerDB> g_business_db;
 
+namespace {
+
+/** Flush upgrade batches once they grow past this size */
+constexpr size_t UPGRADE_BATCH_FLUSH_SIZE = 16 << 20;
+
+/** BusinessMinerStats as stored by version 0, without the recipient sketch */
+struct BusinessMinerStatsV0 {
+    BusinessMinerStats stats;
+    
+    SERIALIZE_METHODS(BusinessMinerStatsV0, obj) {
+        READWRITE(obj.stats.miner_pubkey_hash, obj.stats.total_transactions, obj.stats.distinct_recipients,
+                  obj.stats.last_qualification_height, obj.stats.first_seen_height, obj.stats.is_qualified,
+                  obj.stats.transaction_volume);
+    }
+};
+
+/**
+ * Key of the qualified index. Heights are stored big-endian so iteration
+ * visits miners in order of last qualification height.
+ */
+struct QualifiedIndexKey {
+    uint32_t height;
+    uint256 pubkey_hash;
+    
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BUSINESS_QUALIFIED);
+        ser_writedata32be(s, height);
+        s << pubkey_hash;
+    }
+    
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_BUSINESS_QUALIFIED) {
+            throw std::ios_base::failure("Invalid format for business qualified index key");
+        }
+        height = ser_readdata32be(s);
+        s >> pubkey_hash;
+    }
+};
+
+uint32_t IndexHeight(int64_t height)
+{
+    return static_cast<uint32_t>(std::clamp<int64_t>(height, 0, std::numeric_limits<int32_t>::max()));
+}
+
+QualifiedIndexKey MakeIndexKey(const uint256& pubkey_hash, const BusinessMinerStats& stats)
+{
+    return {IndexHeight(stats.last_qualification_height), pubkey_hash};
+}
+
+/** First qualification height still inside the window ending at height */
+uint32_t WindowStart(int height)
+{
+    return IndexHeight(int64_t{height} - BUSINESS_QUALIFICATION_PERIOD);
+}
+
+} // namespace
+
 CBusinessMinerDB::CBusinessMinerDB(size_t cache_size, bool memory_only, bool wipe_data)
 {
     DBParams db_params;
@@ -30,10 +97,145 @@ CBusinessMinerDB::CBusinessMinerDB(size_t cache_size, bool memory_only, bool wip
         LogPrintf("O Business DB: Error opening database: %s\n", e.what());
         throw;
     }
+    
+    Upgrade();
 }
 
 CBusinessMinerDB::~CBusinessMinerDB() = default;
 
+void CBusinessMinerDB::Upgrade()
+{
+    LOCK(m_db_mutex);
+    
+    int version = 0;
+    if (m_db->Read(DB_BUSINESS_VERSION, version) && version >= BUSINESS_DB_VERSION) {
+        return;
+    }
+    
+    if (m_db->IsEmpty()) {
+        m_db->Write(DB_BUSINESS_VERSION, BUSINESS_DB_VERSION, true);
+        return;
+    }
+    
+    LogPrintf("O Business DB: Upgrading database from version %d to %d\n", version, BUSINESS_DB_VERSION);
+    
+    CDBBatch batch(*m_db);
+    size_t upgraded = 0;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(DB_BUSINESS_STATS); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!iterator->GetKey(key) || key.first != DB_BUSINESS_STATS) {
+            break;
+        }
+        
+        BusinessMinerStats stats;
+        if (version < 1) {
+            // Recipients seen before version 1 are not known individually, so
+            // the sketch starts empty and distinct_recipients keeps its stored
+            // value until the miner's next update
+            BusinessMinerStatsV0 old_stats;
+            if (!iterator->GetValue(old_stats)) {
+                continue;
+            }
+            stats = old_stats.stats;
+            batch.Write(key, stats);
+        } else if (!iterator->GetValue(stats)) {
+            continue;
+        }
+        
+        if (version < 2) {
+            batch.Write(MakeIndexKey(key.second, stats), stats.MeetsBusinessCriteria());
+        }
+        upgraded++;
+        
+        if (batch.ApproximateSize() > UPGRADE_BATCH_FLUSH_SIZE) {
+            m_db->WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    
+    // The version is written last so an interrupted upgrade is simply redone
+    batch.Write(DB_BUSINESS_VERSION, BUSINESS_DB_VERSION);
+    m_db->WriteBatch(batch, true);
+    
+    LogPrintf("O Business DB: Upgraded %d business miner records\n", upgraded);
+}
+
+bool CBusinessMinerDB::CommitBatch(CDBBatch& batch)
+{
+    AssertLockHeld(m_db_mutex);
+    const bool defer{ODeferSyncScope::Active()};
+    if (!m_db->WriteBatch(batch, !defer)) {
+        // The window counts were adjusted for the batch already
+        m_window.reset();
+        return false;
+    }
+    m_unsynced = defer;
+    return true;
+}
+
+bool CBusinessMinerDB::Sync()
+{
+    LOCK(m_db_mutex);
+    if (!m_unsynced) {
+        return true;
+    }
+    
+    // A synced write flushes the log including all earlier unsynced writes
+    CDBBatch batch(*m_db);
+    if (!m_db->WriteBatch(batch, true)) {
+        LogPrintf("O Business DB: Failed to sync deferred writes\n");
+        return false;
+    }
+    m_unsynced = false;
+    return true;
+}
+
+void CBusinessMinerDB::UpdateIndex(CDBBatch& batch, const uint256& pubkey_hash,
+                                   const std::optional<BusinessMinerStats>& prior,
+                                   const std::optional<BusinessMinerStats>& stats)
+{
+    AssertLockHeld(m_db_mutex);
+    
+    const auto adjust = [&](const QualifiedIndexKey& key, bool qualifies, int sign) {
+        if (!m_window || key.height < WindowStart(m_window->height)) return;
+        m_window->counts.active += sign;
+        if (qualifies) m_window->counts.qualified += sign;
+    };
+    
+    if (prior) {
+        const QualifiedIndexKey key = MakeIndexKey(pubkey_hash, *prior);
+        batch.Erase(key);
+        adjust(key, prior->MeetsBusinessCriteria(), -1);
+    }
+    if (stats) {
+        const QualifiedIndexKey key = MakeIndexKey(pubkey_hash, *stats);
+        batch.Write(key, stats->MeetsBusinessCriteria());
+        adjust(key, stats->MeetsBusinessCriteria(), 1);
+    }
+}
+
+void CBusinessMinerDB::CountIndexRange(int64_t from, std::optional<int64_t> to, int sign) const
+{
+    AssertLockHeld(m_db_mutex);
+    assert(m_window);
+    
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(QualifiedIndexKey{IndexHeight(from), uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        QualifiedIndexKey key;
+        if (!iterator->GetKey(key) || (to && key.height >= *to)) {
+            break;
+        }
+        
+        bool qualifies = false;
+        iterator->GetValue(qualifies);
+        m_window->counts.active += sign;
+        if (qualifies) m_window->counts.qualified += sign;
+    }
+}
+
 // ===== Business Stats Operations =====
 
 bool CBusinessMinerDB::WriteBusinessStats(const uint256& pubkey_hash, const BusinessMinerStats& stats)
@@ -42,8 +244,9 @@ bool CBusinessMinerDB::WriteBusinessStats(const uint256& pubkey_hash, const Busi
     
     CDBBatch batch(*m_db);
     batch.Write(std::make_pair(DB_BUSINESS_STATS, pubkey_hash), stats);
+    UpdateIndex(batch, pubkey_hash, ReadBusinessStats(pubkey_hash), stats);
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = CommitBatch(batch);
     
     if (success) {
         LogDebug(BCLog::NET, "O Business DB: Wrote stats for miner %s (tx=%d, recipients=%d)\n",
@@ -78,10 +281,16 @@ bool CBusinessMinerDB::EraseBusinessStats(const uint256& pubkey_hash)
 {
     LOCK(m_db_mutex);
     
+    const auto prior = ReadBusinessStats(pubkey_hash);
+    if (!prior) {
+        return true;
+    }
+    
     CDBBatch batch(*m_db);
     batch.Erase(std::make_pair(DB_BUSINESS_STATS, pubkey_hash));
+    UpdateIndex(batch, pubkey_hash, prior, std::nullopt);
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = CommitBatch(batch);
     
     if (success) {
         LogDebug(BCLog::NET, "O Business DB: Erased stats for miner %s\n",
@@ -103,7 +312,7 @@ bool CBusinessMinerDB::WriteBusinessRatio(int height, double ratio)
     CDBBatch batch(*m_db);
     batch.Write(std::make_pair(DB_BUSINESS_RATIO, height), ratio_int);
     
-    return m_db->WriteBatch(batch, true);
+    return CommitBatch(batch);
 }
 
 std::optional<double> CBusinessMinerDB::ReadBusinessRatio(int height) const
@@ -126,7 +335,7 @@ bool CBusinessMinerDB::EraseBusinessRatio(int height)
     CDBBatch batch(*m_db);
     batch.Erase(std::make_pair(DB_BUSINESS_RATIO, height));
     
-    return m_db->WriteBatch(batch, true);
+    return CommitBatch(batch);
 }
 
 // ===== Batch Operations =====
@@ -137,24 +346,18 @@ std::vector<uint256> CBusinessMinerDB::GetQualifiedBusinessMiners(int height) co
     
     std::vector<uint256> qualified;
     
-    // Iterate through all business miners
+    // Only miners that qualified recently enough are visited
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
-    for (iterator->Seek(DB_BUSINESS_STATS); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_BUSINESS_STATS) {
+    for (iterator->Seek(QualifiedIndexKey{WindowStart(height), uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        QualifiedIndexKey key;
+        if (!iterator->GetKey(key)) {
             break;
         }
         
-        BusinessMinerStats stats;
-        if (!iterator->GetValue(stats)) {
-            continue;
-        }
-        
-        // Check if qualified and recent
-        if (stats.is_qualified && 
-            (height - stats.last_qualification_height <= BUSINESS_QUALIFICATION_PERIOD)) {
-            qualified.push_back(key.second);
+        bool qualifies = false;
+        if (iterator->GetValue(qualifies) && qualifies) {
+            qualified.push_back(key.pubkey_hash);
         }
     }
     
@@ -186,17 +389,47 @@ std::vector<std::pair<uint256, BusinessMinerStats>> CBusinessMinerDB::GetAllBusi
     return all_miners;
 }
 
+std::vector<std::pair<uint256, BusinessMinerStats>> CBusinessMinerDB::GetBusinessMinersSince(int height) const
+{
+    LOCK(m_db_mutex);
+    
+    std::vector<std::pair<uint256, BusinessMinerStats>> miners;
+    
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(QualifiedIndexKey{IndexHeight(height), uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        QualifiedIndexKey key;
+        if (!iterator->GetKey(key)) {
+            break;
+        }
+        
+        if (auto stats = ReadBusinessStats(key.pubkey_hash)) {
+            miners.emplace_back(key.pubkey_hash, std::move(*stats));
+        }
+    }
+    
+    return miners;
+}
+
 bool CBusinessMinerDB::BatchWriteStats(const std::vector<std::pair<uint256, BusinessMinerStats>>& batch)
 {
     LOCK(m_db_mutex);
     
     CDBBatch db_batch(*m_db);
     
+    // Stats written earlier in the same batch are what a later entry replaces
+    std::map<uint256, const BusinessMinerStats*> written;
+    
     for (const auto& [pubkey_hash, stats] : batch) {
         db_batch.Write(std::make_pair(DB_BUSINESS_STATS, pubkey_hash), stats);
+        
+        auto it = written.find(pubkey_hash);
+        UpdateIndex(db_batch, pubkey_hash,
+                    it != written.end() ? std::optional{*it->second} : ReadBusinessStats(pubkey_hash), stats);
+        written[pubkey_hash] = &stats;
     }
     
-    bool success = m_db->WriteBatch(db_batch, true);
+    bool success = CommitBatch(db_batch);
     
     if (success) {
         LogPrintf("O Business DB: Batch wrote %d business miner stats\n", batch.size());
@@ -213,22 +446,22 @@ bool CBusinessMinerDB::PruneOldData(int cutoff_height)
     int pruned_stats = 0;
     int pruned_ratios = 0;
     
-    // Prune old business miner stats
+    // Prune miners inactive for 2x qualification period, oldest first through the index
+    const int64_t stats_cutoff = int64_t{cutoff_height} - BUSINESS_QUALIFICATION_PERIOD * 2;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
-    for (iterator->Seek(DB_BUSINESS_STATS); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_BUSINESS_STATS) {
+    for (iterator->Seek(QualifiedIndexKey{0, uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        QualifiedIndexKey key;
+        if (!iterator->GetKey(key) || key.height >= stats_cutoff) {
             break;
         }
         
-        BusinessMinerStats stats;
-        if (iterator->GetValue(stats)) {
-            // Remove if inactive for 2x qualification period
-            if (cutoff_height - stats.last_qualification_height > (BUSINESS_QUALIFICATION_PERIOD * 2)) {
-                batch.Erase(std::make_pair(DB_BUSINESS_STATS, key.second));
-                pruned_stats++;
-            }
+        auto stats = ReadBusinessStats(key.pubkey_hash);
+        if (!stats || stats->last_qualification_height < stats_cutoff) {
+            batch.Erase(std::make_pair(DB_BUSINESS_STATS, key.pubkey_hash));
+            UpdateIndex(batch, key.pubkey_hash, stats, std::nullopt);
+            batch.Erase(key);
+            pruned_stats++;
         }
     }
     
@@ -247,7 +480,7 @@ bool CBusinessMinerDB::PruneOldData(int cutoff_height)
         }
     }
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = CommitBatch(batch);
     
     if (success && (pruned_stats > 0 || pruned_ratios > 0)) {
         LogPrintf("O Business DB: Pruned %d inactive miners and %d old ratios at height %d\n",
@@ -278,44 +511,54 @@ size_t CBusinessMinerDB::GetBusinessMinerCount() const
 }
 
 size_t CBusinessMinerDB::GetQualifiedBusinessCount(int current_height) const
+{
+    return GetActiveMinerCounts(current_height).qualified;
+}
+
+ActiveMinerCounts CBusinessMinerDB::GetActiveMinerCounts(int height) const
 {
     LOCK(m_db_mutex);
     
-    size_t count = 0;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    const uint32_t start = WindowStart(height);
+    if (!m_window) {
+        m_window = WindowCounts{height, {}};
+        CountIndexRange(start, std::nullopt, 1);
+        return m_window->counts;
+    }
     
-    for (iterator->Seek(DB_BUSINESS_STATS); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_BUSINESS_STATS) {
-            break;
-        }
-        
-        BusinessMinerStats stats;
-        if (iterator->GetValue(stats)) {
-            // Check if qualified and recent
-            if (stats.is_qualified && 
-                (current_height - stats.last_qualification_height <= BUSINESS_QUALIFICATION_PERIOD)) {
-                count++;
-            }
-        }
+    // Only miners whose last qualification height the window start passes change
+    const uint32_t previous_start = WindowStart(m_window->height);
+    if (start > previous_start) {
+        CountIndexRange(previous_start, start, -1);
+    } else if (start < previous_start) {
+        CountIndexRange(start, previous_start, 1);
     }
+    m_window->height = height;
     
-    return count;
+    return m_window->counts;
 }
 
 // ===== Maintenance =====
 
 void CBusinessMinerDB::Compact()
 {
-    LOCK(m_db_mutex);
-    
-    LogPrintf("O Business DB: Database compaction requested\n");
-    LogPrintf("O Business DB: Note: Compaction happens automatically via LevelDB\n");
-    LogPrintf("O Business DB: To force compaction, restart node with -reindex\n");
-    
-    // Note: CDBWrapper doesn't expose CompactRange publicly
-    // Compaction happens automatically in LevelDB
-    // Manual compaction can be triggered via -reindex flag
+    LogPrintf("O Business DB: Compacting %d key prefixes\n", BUSINESS_DB_HOT_PREFIXES.size());
+    for (const uint8_t prefix : BUSINESS_DB_HOT_PREFIXES) {
+        CompactKeyRange(OConsensus::OKeyRange{prefix, 0, std::nullopt});
+    }
+    LogPrintf("O Business DB: Compaction finished\n");
+}
+
+uint64_t CBusinessMinerDB::EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const
+{
+    return m_db->EstimateSize(range.BeginKey(), range.EndKey());
+}
+
+void CBusinessMinerDB::CompactKeyRange(const OConsensus::OKeyRange& range) const
+{
+    // LevelDB compaction is internally synchronized, so m_db_mutex is not
+    // held and writers are not blocked while the range is rewritten.
+    m_db->CompactRange(range.BeginKey(), range.EndKey());
 }
 
 size_t CBusinessMinerDB::EstimateSize() const
@@ -6,10 +6,12 @@
 #define BITCOIN_CONSENSUS_O_BUSINESS_DB_H
 
 #include <dbwrapper.h>
+#include <consensus/o_db_maintenance.h>
 #include <consensus/o_pow_pob.h>
 #include <sync.h>
 #include <uint256.h>
 
+#include <array>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -19,14 +21,56 @@ namespace OConsensus {
 /** Database key prefixes for business miner data */
 static constexpr uint8_t DB_BUSINESS_STATS = 'b';      // Business miner statistics
 static constexpr uint8_t DB_BUSINESS_RATIO = 'r';      // Cached business ratios by height
-static constexpr uint8_t DB_BUSINESS_QUALIFIED = 'q';  // Qualified business miners index
+static constexpr uint8_t DB_BUSINESS_QUALIFIED = 'q';  // Miners by last qualification height
 static constexpr uint8_t DB_BUSINESS_VERSION = 'v';    // Database version
 
+/** Prefixes that see most erases and overwrites, compacted by background maintenance */
+static constexpr std::array<uint8_t, 3> BUSINESS_DB_HOT_PREFIXES{
+    DB_BUSINESS_STATS, DB_BUSINESS_RATIO, DB_BUSINESS_QUALIFIED};
+
+/** Current on-disk layout version. Version 1 added the recipient sketch to
+ *  BusinessMinerStats, version 2 the qualified index (see CBusinessMinerDB::Upgrade). */
+static constexpr int BUSINESS_DB_VERSION = 2;
+
+/** Miners active within the qualification window ending at a height */
+struct ActiveMinerCounts {
+    size_t active{0};
+    size_t qualified{0};
+};
+
 /** Business Miner Database - Persistent storage for PoB consensus data */
 class CBusinessMinerDB {
 private:
     std::unique_ptr<CDBWrapper> m_db;
     mutable RecursiveMutex m_db_mutex;
+    bool m_unsynced GUARDED_BY(m_db_mutex){false};
+    
+    /**
+     * Counts of the qualification window last queried. Every stats write
+     * adjusts them through the qualified index, and moving the window to
+     * another height only visits the miners whose last qualification height
+     * it passes, so keeping the counts current costs O(changes) per block.
+     * Rebuilt from the index on first use.
+     */
+    struct WindowCounts {
+        int height;
+        ActiveMinerCounts counts;
+    };
+    mutable std::optional<WindowCounts> m_window GUARDED_BY(m_db_mutex);
+    
+    /** Write a batch, synced unless the calling thread is in an ODeferSyncScope */
+    bool CommitBatch(CDBBatch& batch);
+    
+    /** Bring records stored by an older version to the current layout */
+    void Upgrade();
+    
+    /** Replace a miner's qualified index entry for prior with one for stats, adjusting the window counts */
+    void UpdateIndex(CDBBatch& batch, const uint256& pubkey_hash,
+                     const std::optional<BusinessMinerStats>& prior,
+                     const std::optional<BusinessMinerStats>& stats);
+    
+    /** Add sign times the index entries with qualification heights in [from, to) to the window counts */
+    void CountIndexRange(int64_t from, std::optional<int64_t> to, int sign) const;
     
 public:
     explicit CBusinessMinerDB(size_t cache_size, bool memory_only = false, bool wipe_data = false);
@@ -65,6 +109,9 @@ public:
     /** Get all business miners (for iteration) */
     std::vector<std::pair<uint256, BusinessMinerStats>> GetAllBusinessMiners() const;
     
+    /** Get the miners last qualified at or after a height */
+    std::vector<std::pair<uint256, BusinessMinerStats>> GetBusinessMinersSince(int height) const;
+    
     /** Batch write multiple stats */
     bool BatchWriteStats(const std::vector<std::pair<uint256, BusinessMinerStats>>& batch);
     
@@ -79,11 +126,26 @@ public:
     /** Get qualified business miner count */
     size_t GetQualifiedBusinessCount(int current_height) const;
     
+    /** Get the active and qualified miner counts of the qualification window ending at height */
+    ActiveMinerCounts GetActiveMinerCounts(int height) const;
+    
+    // ===== Write Durability =====
+    
+    /** Make all writes committed since the last sync durable. Writes made
+     *  inside an ODeferSyncScope are committed without fsync until then. */
+    bool Sync();
+    
     // ===== Maintenance =====
     
-    /** Compact the database */
+    /** Compact all hot key prefixes */
     void Compact();
     
+    /** Estimated on-disk size of a range of keys, see OConsensus::SplitPrefix */
+    uint64_t EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const;
+    
+    /** Compact a range of keys */
+    void CompactKeyRange(const OConsensus::OKeyRange& range) const;
+    
     /** Get database size estimate */
     size_t EstimateSize() const;
     
@@ -0,0 +1,177 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/o_db_maintenance.h>
+#include <consensus/o_brightid_db.h>
+#include <consensus/o_business_db.h>
+#include <consensus/o_stabilization_db.h>
+#include <logging.h>
+#include <measurement/o_measurement_db.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace OConsensus {
+
+ODBMaintenance g_db_maintenance;
+
+namespace {
+
+/** Jobs before compaction: prune URLs */
+constexpr size_t PRUNE_JOBS = 1;
+
+constexpr size_t COMPACTION_PREFIXES = OMeasurement::MEASUREMENT_DB_HOT_PREFIXES.size() +
+                                       BRIGHTID_DB_HOT_PREFIXES.size() + BUSINESS_DB_HOT_PREFIXES.size() +
+                                       STABILIZATION_DB_HOT_PREFIXES.size();
+
+/** A hot prefix and the database it is in */
+struct CompactionJob {
+    uint8_t prefix;
+    std::function<uint64_t(const OKeyRange&)> estimate;
+    std::function<void(const OKeyRange&)> compact;
+};
+
+template <typename DB>
+std::optional<CompactionJob> MakeJob(const std::unique_ptr<DB>& db, uint8_t prefix)
+{
+    if (!db) {
+        return std::nullopt;
+    }
+    const DB* open_db = db.get();
+    return CompactionJob{
+        prefix,
+        [open_db](const OKeyRange& range) { return open_db->EstimateKeyRangeSize(range); },
+        [open_db](const OKeyRange& range) { open_db->CompactKeyRange(range); },
+    };
+}
+
+/** Compaction job index, std::nullopt if its database is not open */
+std::optional<CompactionJob> GetCompactionJob(size_t index)
+{
+    using OMeasurement::g_measurement_db;
+
+    if (index < OMeasurement::MEASUREMENT_DB_HOT_PREFIXES.size()) {
+        return MakeJob(g_measurement_db, OMeasurement::MEASUREMENT_DB_HOT_PREFIXES[index]);
+    }
+    index -= OMeasurement::MEASUREMENT_DB_HOT_PREFIXES.size();
+
+    if (index < BRIGHTID_DB_HOT_PREFIXES.size()) {
+        return MakeJob(g_brightid_db, BRIGHTID_DB_HOT_PREFIXES[index]);
+    }
+    index -= BRIGHTID_DB_HOT_PREFIXES.size();
+
+    if (index < BUSINESS_DB_HOT_PREFIXES.size()) {
+        return MakeJob(g_business_db, BUSINESS_DB_HOT_PREFIXES[index]);
+    }
+    index -= BUSINESS_DB_HOT_PREFIXES.size();
+
+    return MakeJob(g_stabilization_db, STABILIZATION_DB_HOT_PREFIXES[index]);
+}
+
+} // namespace
+
+std::vector<OKeyRange> SplitPrefix(uint8_t prefix, const std::function<uint64_t(const OKeyRange&)>& estimate)
+{
+    const uint64_t total = estimate(OKeyRange{prefix, 0, std::nullopt});
+    const uint64_t count = std::clamp<uint64_t>((total + O_DB_COMPACTION_RANGE_BYTES - 1) / O_DB_COMPACTION_RANGE_BYTES,
+                                                1, O_DB_MAX_COMPACTION_RANGES);
+
+    std::vector<OKeyRange> ranges;
+    uint64_t begin = 0;
+    for (uint64_t i = 1; i < count; i++) {
+        // Smallest position with i / count of the prefix before it
+        const uint64_t target = total / count * i;
+        uint64_t low = begin;
+        uint64_t high = std::numeric_limits<uint64_t>::max();
+        while (low < high) {
+            const uint64_t mid = low + (high - low) / 2;
+            if (estimate(OKeyRange{prefix, 0, mid}) >= target) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        if (low > begin) {
+            ranges.push_back(OKeyRange{prefix, begin, low});
+            begin = low;
+        }
+    }
+    ranges.push_back(OKeyRange{prefix, begin, std::nullopt});
+    return ranges;
+}
+
+size_t ODBMaintenance::JobCount()
+{
+    return PRUNE_JOBS + COMPACTION_PREFIXES;
+}
+
+bool ODBMaintenance::RunSlice(std::chrono::milliseconds budget)
+{
+    LOCK(m_mutex);
+
+    const auto start = SteadyClock::now();
+    if (m_next_job == 0) {
+        if (m_last_pass_start && start - *m_last_pass_start < O_DB_MAINTENANCE_PASS_INTERVAL) {
+            return false;
+        }
+        m_last_pass_start = start;
+        LogDebug(BCLog::NET, "O DB Maintenance: Starting pass (%d jobs)\n", JobCount());
+    }
+
+    do {
+        RunStep();
+    } while (m_next_job < JobCount() && SteadyClock::now() - start < budget);
+
+    if (m_next_job < JobCount()) {
+        return false;
+    }
+
+    m_next_job = 0;
+    m_completed_passes++;
+    LogDebug(BCLog::NET, "O DB Maintenance: Pass %d finished\n", m_completed_passes);
+    return true;
+}
+
+size_t ODBMaintenance::NextJob() const
+{
+    LOCK(m_mutex);
+    return m_next_job;
+}
+
+int ODBMaintenance::CompletedPasses() const
+{
+    LOCK(m_mutex);
+    return m_completed_passes;
+}
+
+void ODBMaintenance::RunStep()
+{
+    if (m_next_job < PRUNE_JOBS) {
+        if (OMeasurement::g_measurement_db) OMeasurement::g_measurement_db->PruneInactiveURLs();
+        m_next_job++;
+        return;
+    }
+
+    const auto job = GetCompactionJob(m_next_job - PRUNE_JOBS);
+    if (!job) {
+        m_ranges.clear();
+        m_next_job++;
+        return;
+    }
+
+    // Splitting a prefix is a step of its own, each of its ranges another
+    if (m_ranges.empty()) {
+        m_ranges = SplitPrefix(job->prefix, job->estimate);
+        m_next_range = 0;
+        return;
+    }
+
+    job->compact(m_ranges[m_next_range++]);
+    if (m_next_range == m_ranges.size()) {
+        m_ranges.clear();
+        m_next_job++;
+    }
+}
+
+} // namespace OConsensus
@@ -0,0 +1,137 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CONSENSUS_O_DB_MAINTENANCE_H
+#define BITCOIN_CONSENSUS_O_DB_MAINTENANCE_H
+
+#include <sync.h>
+#include <util/time.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace OConsensus {
+
+/** Interval at which the scheduler runs a maintenance slice */
+static constexpr auto O_DB_MAINTENANCE_SLICE_INTERVAL{std::chrono::minutes{1}};
+/** Wall-clock budget of one maintenance slice */
+static constexpr auto O_DB_MAINTENANCE_SLICE_BUDGET{std::chrono::milliseconds{250}};
+/** Minimum time between the starts of two maintenance passes */
+static constexpr auto O_DB_MAINTENANCE_PASS_INTERVAL{std::chrono::hours{6}};
+/** Estimated on-disk size of the key range one compaction step rewrites */
+static constexpr uint64_t O_DB_COMPACTION_RANGE_BYTES{4 << 20};
+/** Most key ranges one prefix is compacted in */
+static constexpr uint64_t O_DB_MAX_COMPACTION_RANGES{256};
+
+/**
+ * Defers fsync of the O database writes made by the current thread for the
+ * lifetime of the scope, until the databases' Sync(). Connecting a block
+ * opens one so its writes are made durable once with the chainstate, while
+ * writes from other threads, such as RPC, are still synced on commit.
+ */
+class ODeferSyncScope
+{
+public:
+    ODeferSyncScope() { ++t_depth; }
+    ~ODeferSyncScope() { --t_depth; }
+    ODeferSyncScope(const ODeferSyncScope&) = delete;
+    ODeferSyncScope& operator=(const ODeferSyncScope&) = delete;
+
+    /** Whether writes on this thread are deferred */
+    static bool Active() { return t_depth > 0; }
+
+private:
+    static inline thread_local int t_depth{0};
+};
+
+/**
+ * A range of the keys under one prefix byte. Positions are the eight bytes
+ * that follow the prefix, read big-endian, so ranges are ordered like the
+ * keys in them whatever the key layout. The range starts at position begin
+ * and ends before position end, or at the end of the prefix without one.
+ */
+struct OKeyRange {
+    uint8_t prefix{0};
+    uint64_t begin{0};
+    std::optional<uint64_t> end;
+
+    /** First key of the range */
+    std::array<uint8_t, 9> BeginKey() const { return Key(prefix, begin); }
+
+    /** Key the range ends before */
+    std::array<uint8_t, 9> EndKey() const
+    {
+        return end ? Key(prefix, *end) : Key(static_cast<uint8_t>(prefix + 1), 0);
+    }
+
+private:
+    static std::array<uint8_t, 9> Key(uint8_t prefix, uint64_t position)
+    {
+        std::array<uint8_t, 9> key{prefix};
+        for (int i = 8; i > 0; i--, position >>= 8) {
+            key[i] = static_cast<uint8_t>(position);
+        }
+        return key;
+    }
+};
+
+/**
+ * Split the keys under prefix into ranges of about O_DB_COMPACTION_RANGE_BYTES
+ * on disk, at most O_DB_MAX_COMPACTION_RANGES of them. Boundaries are found
+ * by bisecting positions with estimate, the estimated on-disk size of a
+ * range, so they follow the data rather than any one byte of the keys.
+ */
+std::vector<OKeyRange> SplitPrefix(uint8_t prefix, const std::function<uint64_t(const OKeyRange&)>& estimate);
+
+/**
+ * Incremental compaction of the O databases.
+ *
+ * A pass prunes inactive bot URLs from the measurement database, then
+ * compacts the hot prefixes of the measurement, BrightID, business miner
+ * and stabilization databases, so that tombstones left behind by pruning
+ * stop adding read amplification. Expired invites are consensus state and
+ * are pruned by the blocks that connect, not here.
+ *
+ * The pass is split into small steps: pruning, splitting a prefix into key
+ * ranges with SplitPrefix, and compacting one of those ranges. Each slice
+ * runs steps until its time budget is spent (at least one step), and the
+ * next slice resumes where the previous one stopped. Databases that are not
+ * open are skipped.
+ */
+class ODBMaintenance {
+public:
+    /** Run steps of the current pass within budget. Returns true if this slice completed a pass. */
+    bool RunSlice(std::chrono::milliseconds budget) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Number of jobs in one pass: the pruning, then one per hot prefix */
+    static size_t JobCount();
+
+    /** Index of the job the next slice works on */
+    size_t NextJob() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Number of passes completed since startup */
+    int CompletedPasses() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    mutable Mutex m_mutex;
+    size_t m_next_job GUARDED_BY(m_mutex){0};
+    std::vector<OKeyRange> m_ranges GUARDED_BY(m_mutex); // Ranges of the prefix being compacted
+    size_t m_next_range GUARDED_BY(m_mutex){0};
+    int m_completed_passes GUARDED_BY(m_mutex){0};
+    std::optional<SteadyClock::time_point> m_last_pass_start GUARDED_BY(m_mutex);
+
+    void RunStep() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+
+/** Global maintenance state, driven from the node scheduler */
+extern ODBMaintenance g_db_maintenance;
+
+} // namespace OConsensus
+
+#endif // BITCOIN_CONSENSUS_O_DB_MAINTENANCE_H
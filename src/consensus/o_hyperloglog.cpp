@@ -0,0 +1,55 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/o_hyperloglog.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace OConsensus {
+
+void HyperLogLog::Add(uint64_t hash)
+{
+    // The top bits select the register, the position of the first set bit
+    // among the rest is the observed rank
+    const size_t index = hash >> (64 - HLL_PRECISION);
+    const uint64_t rest = hash << HLL_PRECISION;
+    const uint8_t rank = rest == 0 ? 64 - HLL_PRECISION + 1 : std::countl_zero(rest) + 1;
+    m_registers[index] = std::max(m_registers[index], rank);
+}
+
+void HyperLogLog::Merge(const HyperLogLog& other)
+{
+    for (size_t i = 0; i < REGISTERS; i++) {
+        m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+    }
+}
+
+uint64_t HyperLogLog::Estimate() const
+{
+    constexpr double m = REGISTERS;
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (const uint8_t reg : m_registers) {
+        sum += std::ldexp(1.0, -reg);
+        if (reg == 0) zeros++;
+    }
+
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        // Linear counting is more accurate while many registers are empty
+        estimate = m * std::log(m / zeros);
+    }
+    return static_cast<uint64_t>(std::llround(estimate));
+}
+
+bool HyperLogLog::IsEmpty() const
+{
+    return std::all_of(m_registers.begin(), m_registers.end(), [](uint8_t reg) { return reg == 0; });
+}
+
+} // namespace OConsensus
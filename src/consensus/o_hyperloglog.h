@@ -0,0 +1,132 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CONSENSUS_O_HYPERLOGLOG_H
+#define BITCOIN_CONSENSUS_O_HYPERLOGLOG_H
+
+#include <serialize.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace OConsensus {
+
+/** log2 of the number of HyperLogLog registers */
+static constexpr int HLL_PRECISION{8};
+
+/**
+ * HyperLogLog distinct-count sketch.
+ *
+ * Estimates the number of distinct 64-bit hashes added to it in a fixed
+ * 2^HLL_PRECISION bytes, with a standard error of about 1.04 / sqrt(256),
+ * i.e. 6.5%. Small counts fall back to linear counting and are close to
+ * exact. Merging two sketches gives the sketch of the union of their inputs.
+ *
+ * Inputs must already be uniformly distributed, e.g. taken from a SHA256.
+ */
+class HyperLogLog
+{
+public:
+    static constexpr size_t REGISTERS{size_t{1} << HLL_PRECISION};
+
+    void Add(uint64_t hash);
+    void Merge(const HyperLogLog& other);
+    uint64_t Estimate() const;
+    bool IsEmpty() const;
+
+    SERIALIZE_METHODS(HyperLogLog, obj) { READWRITE(obj.m_registers); }
+
+    bool operator==(const HyperLogLog&) const = default;
+
+private:
+    std::array<uint8_t, REGISTERS> m_registers{};
+};
+
+/**
+ * Distinct count over a sliding window of block heights.
+ *
+ * The window of WINDOW blocks is covered by BUCKETS buckets of
+ * ceil(WINDOW / BUCKETS) blocks each, every bucket a HyperLogLog of the
+ * hashes added at its heights. One more bucket holds the span still in
+ * progress, so the estimate at a height covers the WINDOW blocks before it
+ * plus up to one bucket span. Buckets that leave the window are reused.
+ *
+ * Size is fixed at (BUCKETS + 1) sketches regardless of how many hashes
+ * are added.
+ */
+template <int64_t WINDOW, size_t BUCKETS>
+class WindowedHyperLogLog
+{
+public:
+    static constexpr int64_t BUCKET_SPAN{(WINDOW + BUCKETS - 1) / BUCKETS};
+
+    void Add(uint64_t hash, int64_t height)
+    {
+        BucketFor(SpanIndex(height)).sketch.Add(hash);
+    }
+
+    /** Add everything in other, e.g. the recipients of one block */
+    void Merge(const WindowedHyperLogLog& other)
+    {
+        for (const Bucket& bucket : other.m_buckets) {
+            if (bucket.index >= 0) BucketFor(bucket.index).sketch.Merge(bucket.sketch);
+        }
+    }
+
+    /** Estimated number of distinct hashes added within the window ending at height */
+    uint64_t Estimate(int64_t height) const
+    {
+        const int64_t current = SpanIndex(height);
+        HyperLogLog merged;
+        for (const Bucket& bucket : m_buckets) {
+            if (bucket.index >= 0 && bucket.index <= current && current - bucket.index <= static_cast<int64_t>(BUCKETS)) {
+                merged.Merge(bucket.sketch);
+            }
+        }
+        return merged.Estimate();
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        for (const Bucket& bucket : m_buckets) s << bucket.index << bucket.sketch;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        for (Bucket& bucket : m_buckets) s >> bucket.index >> bucket.sketch;
+    }
+
+    bool operator==(const WindowedHyperLogLog&) const = default;
+
+private:
+    struct Bucket {
+        int64_t index{-1}; // Span index (height / BUCKET_SPAN), -1 if unused
+        HyperLogLog sketch;
+
+        bool operator==(const Bucket&) const = default;
+    };
+
+    std::array<Bucket, BUCKETS + 1> m_buckets;
+
+    static int64_t SpanIndex(int64_t height) { return height < 0 ? 0 : height / BUCKET_SPAN; }
+
+    /** The bucket of a span, cleared first if it still holds an older span. A
+     *  bucket already holding a newer span absorbs the data of the older one. */
+    Bucket& BucketFor(int64_t index)
+    {
+        Bucket& bucket = m_buckets[index % m_buckets.size()];
+        if (bucket.index < index) {
+            bucket.index = index;
+            bucket.sketch = HyperLogLog{};
+        }
+        return bucket;
+    }
+};
+
+} // namespace OConsensus
+
+#endif // BITCOIN_CONSENSUS_O_HYPERLOGLOG_H
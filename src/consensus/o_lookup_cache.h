@@ -0,0 +1,151 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CONSENSUS_O_LOOKUP_CACHE_H
+#define BITCOIN_CONSENSUS_O_LOOKUP_CACHE_H
+
+#include <sync.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace OConsensus {
+
+/** Default number of entries of each O database lookup cache */
+static constexpr size_t DEFAULT_O_LOOKUP_CACHE_ENTRIES{50000};
+
+/**
+ * Bounded in-memory cache for point lookups in the O databases.
+ *
+ * Keys are spread by hash over a fixed number of shards, each with its own
+ * mutex and least-recently-used eviction, so lookups of different keys from
+ * several threads rarely contend. Hits and misses are counted so the
+ * capacity can be tuned.
+ *
+ * The cache knows nothing about the database it fronts. The owner fills and
+ * invalidates it while holding its database lock, so a cached entry never
+ * outlives the record it was read from.
+ */
+template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+class OLookupCache
+{
+public:
+    struct Stats {
+        size_t entries{0};
+        size_t capacity{0};
+        uint64_t hits{0};
+        uint64_t misses{0};
+
+        double HitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+    };
+
+    explicit OLookupCache(size_t capacity = DEFAULT_O_LOOKUP_CACHE_ENTRIES) { SetCapacity(capacity); }
+
+    /** Look up a key, counting a hit or a miss */
+    std::optional<Value> Get(const Key& key)
+    {
+        Shard& shard = ShardFor(key);
+        LOCK(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            m_misses++;
+            return std::nullopt;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        m_hits++;
+        return it->second->second;
+    }
+
+    /** Insert or replace an entry, evicting the least recently used one of its shard if full */
+    void Put(const Key& key, Value value)
+    {
+        const size_t shard_capacity = m_shard_capacity.load();
+        if (shard_capacity == 0) return;
+
+        Shard& shard = ShardFor(key);
+        LOCK(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return;
+        }
+        while (shard.lru.size() >= shard_capacity) {
+            shard.index.erase(shard.lru.back().first);
+            shard.lru.pop_back();
+        }
+        shard.lru.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.lru.begin());
+    }
+
+    void Erase(const Key& key)
+    {
+        Shard& shard = ShardFor(key);
+        LOCK(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) return;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+
+    void Clear()
+    {
+        for (Shard& shard : m_shards) {
+            LOCK(shard.mutex);
+            shard.index.clear();
+            shard.lru.clear();
+        }
+    }
+
+    /** Change the maximum number of entries (0 disables the cache). Drops all entries. */
+    void SetCapacity(size_t capacity)
+    {
+        m_shard_capacity = capacity == 0 ? 0 : std::max<size_t>(1, (capacity + SHARDS - 1) / SHARDS);
+        Clear();
+    }
+
+    Stats GetStats() const
+    {
+        Stats stats;
+        for (const Shard& shard : m_shards) {
+            LOCK(shard.mutex);
+            stats.entries += shard.lru.size();
+        }
+        stats.capacity = m_shard_capacity.load() * SHARDS;
+        stats.hits = m_hits.load();
+        stats.misses = m_misses.load();
+        return stats;
+    }
+
+private:
+    static constexpr size_t SHARDS{16};
+
+    using List = std::list<std::pair<Key, Value>>;
+
+    struct Shard {
+        mutable Mutex mutex;
+        List lru GUARDED_BY(mutex); // Most recently used first
+        std::unordered_map<Key, typename List::iterator, Hasher> index GUARDED_BY(mutex);
+    };
+
+    std::array<Shard, SHARDS> m_shards;
+    std::atomic<size_t> m_shard_capacity{0};
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    Hasher m_hasher;
+
+    Shard& ShardFor(const Key& key) { return m_shards[m_hasher(key) % SHARDS]; }
+};
+
+} // namespace OConsensus
+
+#endif // BITCOIN_CONSENSUS_O_LOOKUP_CACHE_H
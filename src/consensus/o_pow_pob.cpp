@@ -4,6 +4,7 @@
 
 #include <consensus/o_pow_pob.h>
 #include <consensus/o_business_db.h>
+#include <consensus/o_undo.h>
 #include <arith_uint256.h>
 #include <chain.h>
 #include <chainparams.h>
@@ -42,20 +43,7 @@ bool HybridPowPobConsensus::IsBusinessMiner(const uint256& pubkey_hash, int heig
         return false;
     }
     
-    // Check qualification criteria
-    if (stats.total_transactions < MIN_BUSINESS_TRANSACTIONS) {
-        return false;
-    }
-    
-    if (stats.distinct_recipients < MIN_BUSINESS_DISTINCT_KEYS) {
-        return false;
-    }
-    
-    if (stats.transaction_volume < MIN_BUSINESS_VOLUME) {
-        return false;
-    }
-    
-    return stats.is_qualified;
+    return stats.MeetsBusinessCriteria();
 }
 
 double HybridPowPobConsensus::GetBusinessRatio(int height) const 
@@ -70,21 +58,10 @@ double HybridPowPobConsensus::GetBusinessRatio(int height) const
         return cached.value();
     }
     
-    int total_active_miners = 0;
-    int qualified_business_miners = 0;
-    
-    // Get all business miners from database
-    auto all_miners = g_business_db->GetAllBusinessMiners();
-    
-    // Count active miners in the qualification period
-    for (const auto& [pubkey, stats] : all_miners) {
-        if (height - stats.last_qualification_height <= BUSINESS_QUALIFICATION_PERIOD) {
-            total_active_miners++;
-            if (IsBusinessMiner(pubkey, height)) {
-                qualified_business_miners++;
-            }
-        }
-    }
+    // Counts are maintained by the database as stats change
+    const ActiveMinerCounts counts = g_business_db->GetActiveMinerCounts(height);
+    const size_t total_active_miners = counts.active;
+    const size_t qualified_business_miners = counts.qualified;
     
     double ratio = 0.0;
     if (total_active_miners > 0) {
@@ -258,7 +235,8 @@ bool HybridPowPobConsensus::ValidateBusinessMinerBlock(const CBlock& block,
 
 void HybridPowPobConsensus::UpdateBusinessStats(const uint256& pubkey_hash, 
                                                 const CTransaction& tx, 
-                                                int height) 
+                                                int height,
+                                                OBlockUndo* undo) 
 {
     if (pubkey_hash.IsNull() || !g_business_db) {
         return;
@@ -279,7 +257,7 @@ void HybridPowPobConsensus::UpdateBusinessStats(const uint256& pubkey_hash,
     stats.total_transactions++;
     stats.last_qualification_height = height;
     
-    // Track unique recipients
+    // Track unique recipients over the qualification period
     for (const auto& output : tx.vout) {
         // Extract recipient pubkey hash from output script
         uint256 recipient_hash;
@@ -289,9 +267,9 @@ void HybridPowPobConsensus::UpdateBusinessStats(const uint256& pubkey_hash,
         ss << output.scriptPubKey;
         recipient_hash = ss.GetHash();
         
-        stats.recipient_set.insert(recipient_hash);
+        stats.recipient_sketch.Add(recipient_hash.GetUint64(0), height);
     }
-    stats.distinct_recipients = stats.recipient_set.size();
+    stats.distinct_recipients = stats.recipient_sketch.Estimate(height);
     
     // Update transaction volume
     CAmount tx_value = 0;
@@ -306,6 +284,7 @@ void HybridPowPobConsensus::UpdateBusinessStats(const uint256& pubkey_hash,
                         (stats.transaction_volume >= MIN_BUSINESS_VOLUME);
     
     // Write updated stats back to database
+    if (undo) undo->SaveBusinessStats(pubkey_hash);
     if (!g_business_db->WriteBusinessStats(pubkey_hash, stats)) {
         LogPrintf("O PoB: Failed to write business stats to database for miner %s\n",
                   pubkey_hash.GetHex().substr(0, 16));
@@ -380,8 +359,10 @@ void HybridPowPobConsensus::ReEvaluateQualifications(int current_height)
     int disqualified = 0;
     std::vector<std::pair<uint256, BusinessMinerStats>> updates;
     
-    // Get all miners from database
-    auto all_miners = g_business_db->GetAllBusinessMiners();
+    // Miners active in the window plus those that left it within the last
+    // period. A flag left set on an older miner is harmless: every check of
+    // qualification also checks recency.
+    auto all_miners = g_business_db->GetBusinessMinersSince(current_height - BUSINESS_QUALIFICATION_PERIOD * 2);
     
     for (auto& [pubkey, stats] : all_miners) {
         bool was_qualified = stats.is_qualified;
@@ -396,6 +377,11 @@ void HybridPowPobConsensus::ReEvaluateQualifications(int current_height)
             continue;
         }
         
+        // Recipients that left the qualification window no longer count
+        const int64_t distinct_recipients = stats.recipient_sketch.Estimate(current_height);
+        const bool recipients_changed = distinct_recipients != stats.distinct_recipients;
+        stats.distinct_recipients = distinct_recipients;
+        
         // Re-evaluate qualification
         bool should_be_qualified = (stats.total_transactions >= MIN_BUSINESS_TRANSACTIONS) &&
                                    (stats.distinct_recipients >= MIN_BUSINESS_DISTINCT_KEYS) &&
@@ -409,6 +395,8 @@ void HybridPowPobConsensus::ReEvaluateQualifications(int current_height)
             stats.is_qualified = false;
             disqualified++;
             updates.emplace_back(pubkey, stats);
+        } else if (recipients_changed) {
+            updates.emplace_back(pubkey, stats);
         }
     }
     
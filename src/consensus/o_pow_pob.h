@@ -5,6 +5,7 @@
 #ifndef BITCOIN_CONSENSUS_O_POW_POB_H
 #define BITCOIN_CONSENSUS_O_POW_POB_H
 
+#include <consensus/o_hyperloglog.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <uint256.h>
@@ -18,11 +19,17 @@ class CChainParams;
 
 namespace OConsensus {
 
+struct OBlockUndo;
+
 /** Business Miner Qualification Thresholds */
 static constexpr int64_t MIN_BUSINESS_TRANSACTIONS = 100;      // Per qualification period
 static constexpr int64_t MIN_BUSINESS_DISTINCT_KEYS = 20;      // Unique recipients required
 static constexpr int64_t BUSINESS_QUALIFICATION_PERIOD = 144 * 7;  // 1 week in blocks (~10 min blocks)
 static constexpr int64_t MIN_BUSINESS_VOLUME = 1000000;       // Minimum transaction volume (10,000.00 O in satoshis)
+static constexpr size_t RECIPIENT_SKETCH_BUCKETS = 4;          // Height buckets of the distinct-recipient window
+
+/** Distinct recipients of a business miner over the qualification period */
+using RecipientSketch = WindowedHyperLogLog<BUSINESS_QUALIFICATION_PERIOD, RECIPIENT_SKETCH_BUCKETS>;
 
 /** Mining Difficulty Adjustments */
 static constexpr double DIFFICULTY_REDUCTION_FACTOR = 0.5;     // Max 50% reduction at full business participation
@@ -47,17 +54,24 @@ struct BusinessMinerStats {
     int64_t first_seen_height;
     bool is_qualified;
     CAmount transaction_volume;  // Total value processed
-    std::set<uint256> recipient_set;  // Track unique recipients
+    RecipientSketch recipient_sketch;  // Unique recipients; distinct_recipients is its estimate at the last update
     
     BusinessMinerStats() 
         : miner_pubkey_hash(), total_transactions(0), distinct_recipients(0),
           last_qualification_height(0), first_seen_height(0), is_qualified(false),
           transaction_volume(0) {}
     
+    /** Whether the stats meet every business miner criterion, regardless of how recent they are */
+    bool MeetsBusinessCriteria() const
+    {
+        return is_qualified && total_transactions >= MIN_BUSINESS_TRANSACTIONS &&
+               distinct_recipients >= MIN_BUSINESS_DISTINCT_KEYS && transaction_volume >= MIN_BUSINESS_VOLUME;
+    }
+    
     SERIALIZE_METHODS(BusinessMinerStats, obj) {
         READWRITE(obj.miner_pubkey_hash, obj.total_transactions, obj.distinct_recipients,
                   obj.last_qualification_height, obj.first_seen_height, obj.is_qualified,
-                  obj.transaction_volume);
+                  obj.transaction_volume, obj.recipient_sketch);
     }
 };
 
@@ -78,8 +92,8 @@ public:
     /** Validate that block meets PoW requirements (considers PoB status) */
     bool CheckProofOfWork(uint256 hash, unsigned int nBits, bool is_business_miner, const CChainParams& params) const;
     
-    /** Update business miner statistics from a transaction */
-    void UpdateBusinessStats(const uint256& pubkey_hash, const CTransaction& tx, int height);
+    /** Update business miner statistics from a transaction, saving the prior stats to undo if set */
+    void UpdateBusinessStats(const uint256& pubkey_hash, const CTransaction& tx, int height, OBlockUndo* undo = nullptr);
     
     /** Ensure business miners don't mine their own transactions */
     bool ValidateBusinessMinerBlock(const CBlock& block, const uint256& miner_pubkey) const;
@@ -0,0 +1,369 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/o_stabilization_db.h>
+#include <common/args.h>
+#include <logging.h>
+#include <util/fs.h>
+
+#include <algorithm>
+
+namespace OConsensus {
+
+// Global instance (initialized in init.cpp)
+std::unique_ptr<CStabilizationDB> g_stabilization_db;
+
+namespace {
+
+/**
+ * Key of a stabilization transaction. Heights are stored big-endian so
+ * iteration visits transactions in height order.
+ */
+struct TransactionKey {
+    uint32_t height;
+    uint256 tx_id;
+    
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_STABILIZATION_TX);
+        ser_writedata32be(s, height);
+        s << tx_id;
+    }
+    
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_STABILIZATION_TX) {
+            throw std::ios_base::failure("Invalid format for stabilization transaction key");
+        }
+        height = ser_readdata32be(s);
+        s >> tx_id;
+    }
+};
+
+uint32_t KeyHeight(int height)
+{
+    return static_cast<uint32_t>(std::max(height, 0));
+}
+
+} // namespace
+
+CStabilizationDB::CStabilizationDB(size_t cache_size, bool memory_only, bool wipe_data)
+{
+    DBParams db_params;
+    db_params.path = gArgs.GetDataDirNet() / "stabilization";
+    db_params.cache_bytes = cache_size;
+    db_params.memory_only = memory_only;
+    db_params.wipe_data = wipe_data;
+    db_params.obfuscate = true;
+    
+    try {
+        m_db = std::make_unique<CDBWrapper>(db_params);
+        LogPrintf("O Stabilization DB: Opened database at %s (cache: %d MB, memory_only: %d)\n",
+                  fs::PathToString(db_params.path), cache_size / (1024 * 1024), memory_only);
+    } catch (const std::exception& e) {
+        LogPrintf("O Stabilization DB: Error opening database: %s\n", e.what());
+        throw;
+    }
+    
+    int version = 0;
+    if (!m_db->Read(DB_STABILIZATION_VERSION, version)) {
+        m_db->Write(DB_STABILIZATION_VERSION, STABILIZATION_DB_VERSION, true);
+    }
+}
+
+CStabilizationDB::~CStabilizationDB() = default;
+
+bool CStabilizationDB::CommitBatch(CDBBatch& batch)
+{
+    AssertLockHeld(m_db_mutex);
+    const bool defer{ODeferSyncScope::Active()};
+    if (!m_db->WriteBatch(batch, !defer)) {
+        return false;
+    }
+    m_unsynced = defer;
+    return true;
+}
+
+bool CStabilizationDB::Sync()
+{
+    LOCK(m_db_mutex);
+    if (!m_unsynced) {
+        return true;
+    }
+    
+    // A synced write flushes the log including all earlier unsynced writes
+    CDBBatch batch(*m_db);
+    if (!m_db->WriteBatch(batch, true)) {
+        LogPrintf("O Stabilization DB: Failed to sync deferred writes\n");
+        return false;
+    }
+    m_unsynced = false;
+    return true;
+}
+
+// ===== Currency Stability Status =====
+
+bool CStabilizationDB::WriteStatus(const std::vector<CurrencyStabilityInfo>& infos)
+{
+    LOCK(m_db_mutex);
+    
+    CDBBatch batch(*m_db);
+    for (const auto& info : infos) {
+        batch.Write(std::make_pair(DB_STABILITY_STATUS, info.currency_code), info);
+    }
+    
+    bool success = CommitBatch(batch);
+    
+    if (!success) {
+        LogPrintf("O Stabilization DB: Failed to write status of %d currencies\n", infos.size());
+    }
+    
+    return success;
+}
+
+std::map<std::string, CurrencyStabilityInfo> CStabilizationDB::ReadAllStatus() const
+{
+    LOCK(m_db_mutex);
+    
+    std::map<std::string, CurrencyStabilityInfo> status;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(DB_STABILITY_STATUS); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, std::string> key;
+        if (!iterator->GetKey(key) || key.first != DB_STABILITY_STATUS) {
+            break;
+        }
+    
+        CurrencyStabilityInfo info;
+        if (iterator->GetValue(info)) {
+            status.emplace(key.second, std::move(info));
+        }
+    }
+    
+    return status;
+}
+
+// ===== Stabilization Transactions =====
+
+bool CStabilizationDB::WriteTransaction(const StabilizationTransaction& tx)
+{
+    LOCK(m_db_mutex);
+    
+    // Blocks are assembled and connected with the same transactions, which
+    // must only count once
+    const TransactionKey key{KeyHeight(tx.block_height), tx.tx_id};
+    if (m_db->Exists(key)) {
+        return true;
+    }
+    
+    StabilizationTotals totals = ReadTotals();
+    StabilizationTotals currency_totals = ReadCurrencyTotals(tx.unstable_currency);
+    for (StabilizationTotals* t : {&totals, &currency_totals}) {
+        t->coins_created += tx.coins_created;
+        t->transactions++;
+        t->recipients += tx.recipients.size();
+    }
+    
+    CDBBatch batch(*m_db);
+    batch.Write(key, tx);
+    batch.Write(DB_STABILIZATION_SUMMARY, totals);
+    batch.Write(std::make_pair(DB_STABILIZATION_TOTALS, tx.unstable_currency), currency_totals);
+    
+    bool success = CommitBatch(batch);
+    
+    if (success) {
+        LogDebug(BCLog::NET, "O Stabilization DB: Recorded transaction %s for %s at height %d\n",
+                 tx.tx_id.GetHex().substr(0, 16), tx.unstable_currency, tx.block_height);
+    } else {
+        LogPrintf("O Stabilization DB: Failed to record transaction %s\n", tx.tx_id.GetHex().substr(0, 16));
+    }
+    
+    return success;
+}
+
+bool CStabilizationDB::HasTransaction(int height, const uint256& tx_id) const
+{
+    LOCK(m_db_mutex);
+    return m_db->Exists(TransactionKey{KeyHeight(height), tx_id});
+}
+
+std::vector<StabilizationTransaction> CStabilizationDB::GetTransactions(const std::string& currency,
+                                                                        int start_height, int end_height) const
+{
+    LOCK(m_db_mutex);
+    
+    std::vector<StabilizationTransaction> history;
+    if (end_height < start_height || end_height < 0) {
+        return history;
+    }
+    
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(TransactionKey{KeyHeight(start_height), uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        TransactionKey key;
+        if (!iterator->GetKey(key) || key.height > KeyHeight(end_height)) {
+            break;
+        }
+    
+        StabilizationTransaction tx;
+        if (iterator->GetValue(tx) && tx.unstable_currency == currency) {
+            history.push_back(std::move(tx));
+        }
+    }
+    
+    return history;
+}
+
+bool CStabilizationDB::PruneTransactions(int cutoff_height)
+{
+    LOCK(m_db_mutex);
+    
+    if (cutoff_height <= 0) {
+        return true;
+    }
+    
+    CDBBatch batch(*m_db);
+    int pruned = 0;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(TransactionKey{0, uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        TransactionKey key;
+        if (!iterator->GetKey(key) || key.height >= KeyHeight(cutoff_height)) {
+            break;
+        }
+        batch.Erase(key);
+        pruned++;
+    }
+    
+    if (pruned == 0) {
+        return true;
+    }
+    
+    bool success = CommitBatch(batch);
+    
+    if (success) {
+        LogPrintf("O Stabilization DB: Pruned %d transactions below height %d\n", pruned, cutoff_height);
+    }
+    
+    return success;
+}
+
+bool CStabilizationDB::EraseTransactionsAtHeight(int height)
+{
+    LOCK(m_db_mutex);
+    
+    CDBBatch batch(*m_db);
+    StabilizationTotals totals = ReadTotals();
+    std::map<std::string, StabilizationTotals> currency_totals;
+    int erased = 0;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(TransactionKey{KeyHeight(height), uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        TransactionKey key;
+        if (!iterator->GetKey(key) || key.height != KeyHeight(height)) {
+            break;
+        }
+    
+        StabilizationTransaction tx;
+        if (!iterator->GetValue(tx)) {
+            LogPrintf("O Stabilization DB: Failed to read transaction %s at height %d\n",
+                      key.tx_id.GetHex().substr(0, 16), height);
+            return false;
+        }
+    
+        auto it = currency_totals.find(tx.unstable_currency);
+        if (it == currency_totals.end()) {
+            it = currency_totals.emplace(tx.unstable_currency, ReadCurrencyTotals(tx.unstable_currency)).first;
+        }
+        for (StabilizationTotals* t : {&totals, &it->second}) {
+            t->coins_created -= tx.coins_created;
+            t->transactions--;
+            t->recipients -= tx.recipients.size();
+        }
+        batch.Erase(key);
+        erased++;
+    }
+    
+    if (erased == 0) {
+        return true;
+    }
+    
+    batch.Write(DB_STABILIZATION_SUMMARY, totals);
+    for (const auto& [currency, t] : currency_totals) {
+        batch.Write(std::make_pair(DB_STABILIZATION_TOTALS, currency), t);
+    }
+    
+    bool success = CommitBatch(batch);
+    
+    if (success) {
+        LogDebug(BCLog::NET, "O Stabilization DB: Erased %d transactions at height %d\n", erased, height);
+    } else {
+        LogPrintf("O Stabilization DB: Failed to erase transactions at height %d\n", height);
+    }
+    
+    return success;
+}
+
+size_t CStabilizationDB::GetTransactionCount() const
+{
+    LOCK(m_db_mutex);
+    
+    size_t count = 0;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(TransactionKey{0, uint256::ZERO}); iterator->Valid(); iterator->Next()) {
+        TransactionKey key;
+        if (!iterator->GetKey(key)) {
+            break;
+        }
+        count++;
+    }
+    
+    return count;
+}
+
+// ===== Totals =====
+
+StabilizationTotals CStabilizationDB::ReadTotals() const
+{
+    LOCK(m_db_mutex);
+    
+    StabilizationTotals totals;
+    m_db->Read(DB_STABILIZATION_SUMMARY, totals);
+    return totals;
+}
+
+StabilizationTotals CStabilizationDB::ReadCurrencyTotals(const std::string& currency) const
+{
+    LOCK(m_db_mutex);
+    
+    StabilizationTotals totals;
+    m_db->Read(std::make_pair(DB_STABILIZATION_TOTALS, currency), totals);
+    return totals;
+}
+
+// ===== Maintenance =====
+
+uint64_t CStabilizationDB::EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const
+{
+    return m_db->EstimateSize(range.BeginKey(), range.EndKey());
+}
+
+void CStabilizationDB::CompactKeyRange(const OConsensus::OKeyRange& range) const
+{
+    // LevelDB compaction is internally synchronized, so m_db_mutex is not
+    // held and writers are not blocked while the range is rewritten.
+    m_db->CompactRange(range.BeginKey(), range.EndKey());
+}
+
+size_t CStabilizationDB::EstimateSize() const
+{
+    LOCK(m_db_mutex);
+    return m_db->DynamicMemoryUsage();
+}
+
+} // namespace OConsensus
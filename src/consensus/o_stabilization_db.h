@@ -0,0 +1,122 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CONSENSUS_O_STABILIZATION_DB_H
+#define BITCOIN_CONSENSUS_O_STABILIZATION_DB_H
+
+#include <consensus/amount.h>
+#include <consensus/o_db_maintenance.h>
+#include <consensus/stabilization_mining.h>
+#include <dbwrapper.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace OConsensus {
+
+/** Database key prefixes for stabilization mining data */
+static constexpr uint8_t DB_STABILITY_STATUS = 's';       // Currency stability status by currency code
+static constexpr uint8_t DB_STABILIZATION_TX = 't';       // Stabilization transactions by height and txid
+static constexpr uint8_t DB_STABILIZATION_TOTALS = 'c';   // Totals per currency
+static constexpr uint8_t DB_STABILIZATION_SUMMARY = 'g';  // Totals over all currencies
+static constexpr uint8_t DB_STABILIZATION_VERSION = 'v';  // Database version
+
+/** Prefixes that see most erases and overwrites, compacted by background maintenance */
+static constexpr std::array<uint8_t, 1> STABILIZATION_DB_HOT_PREFIXES{DB_STABILIZATION_TX};
+
+static constexpr int STABILIZATION_DB_VERSION = 1;
+
+/** Running totals of recorded stabilization transactions. They are kept
+ *  separately so pruning old transactions does not change them. */
+struct StabilizationTotals {
+    CAmount coins_created{0};
+    int64_t transactions{0};
+    int64_t recipients{0};
+    
+    SERIALIZE_METHODS(StabilizationTotals, obj) {
+        READWRITE(obj.coins_created, obj.transactions, obj.recipients);
+    }
+};
+
+/** Stabilization Database - Persistent storage for stabilization mining state */
+class CStabilizationDB {
+private:
+    std::unique_ptr<CDBWrapper> m_db;
+    mutable RecursiveMutex m_db_mutex;
+    bool m_unsynced GUARDED_BY(m_db_mutex){false};
+    
+    /** Write a batch, synced unless the calling thread is in an ODeferSyncScope */
+    bool CommitBatch(CDBBatch& batch);
+    
+public:
+    explicit CStabilizationDB(size_t cache_size, bool memory_only = false, bool wipe_data = false);
+    ~CStabilizationDB();
+    
+    // ===== Currency Stability Status =====
+    
+    /** Write the stability status of the currencies in infos */
+    bool WriteStatus(const std::vector<CurrencyStabilityInfo>& infos);
+    
+    /** Read the stability status of all currencies */
+    std::map<std::string, CurrencyStabilityInfo> ReadAllStatus() const;
+    
+    // ===== Stabilization Transactions =====
+    
+    /** Record a stabilization transaction and add it to the totals. Recording the same transaction again is a no-op. */
+    bool WriteTransaction(const StabilizationTransaction& tx);
+    
+    /** Check if a transaction was recorded at a height */
+    bool HasTransaction(int height, const uint256& tx_id) const;
+    
+    /** Get the transactions for a currency recorded between two heights (inclusive) */
+    std::vector<StabilizationTransaction> GetTransactions(const std::string& currency, int start_height, int end_height) const;
+    
+    /** Erase transactions recorded below cutoff_height. Totals are kept. */
+    bool PruneTransactions(int cutoff_height);
+    
+    /** Erase the transactions recorded at a height and take them out of the totals, for a disconnected block */
+    bool EraseTransactionsAtHeight(int height);
+    
+    /** Number of transactions currently stored */
+    size_t GetTransactionCount() const;
+    
+    // ===== Totals =====
+    
+    /** Totals over all recorded transactions */
+    StabilizationTotals ReadTotals() const;
+    
+    /** Totals over the recorded transactions of one currency */
+    StabilizationTotals ReadCurrencyTotals(const std::string& currency) const;
+    
+    // ===== Write Durability =====
+    
+    /** Make all writes committed since the last sync durable. Writes made
+     *  inside an ODeferSyncScope are committed without fsync until then. */
+    bool Sync();
+    
+    // ===== Maintenance =====
+    
+    /** Estimated on-disk size of a range of keys, see OConsensus::SplitPrefix */
+    uint64_t EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const;
+    
+    /** Compact a range of keys */
+    void CompactKeyRange(const OConsensus::OKeyRange& range) const;
+    
+    /** Get database size estimate */
+    size_t EstimateSize() const;
+};
+
+/** Global stabilization database instance */
+extern std::unique_ptr<CStabilizationDB> g_stabilization_db;
+
+} // namespace OConsensus
+
+#endif // BITCOIN_CONSENSUS_O_STABILIZATION_DB_H
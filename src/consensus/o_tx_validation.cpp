@@ -6,91 +6,312 @@
 
 #include <chain.h>
 #include <consensus/o_brightid_db.h>
+#include <consensus/o_business_db.h>
+#include <consensus/o_db_maintenance.h>
+#include <consensus/o_stabilization_db.h>
+#include <consensus/o_undo.h>
 #include <hash.h>
 #include <logging.h>
+#include <measurement/measurement_stats.h>
 #include <measurement/o_measurement_db.h>
 #include <primitives/block.h>
 #include <pubkey.h>
 #include <util/time.h>
+#include <util/overloaded.h>
 #include <util/strencodings.h>
 
 #include <optional>
+#include <set>
 
 namespace OConsensus {
 
-bool ProcessOTransactions(const CBlock& block, const CBlockIndex* pindex) {
+namespace {
+
+/** State-dependent halves of the Process* handlers, run after the stateless Check* */
+bool ApplyUserVerification(const OTransactions::CUserVerificationData& data, const CTransaction& tx, int height, OBlockUndo* undo);
+bool ApplyWaterPriceMeasurement(const OTransactions::CWaterPriceMeasurementData& data, const CTransaction& tx, int height, OBlockUndo* undo);
+bool ApplyExchangeRateMeasurement(const OTransactions::CExchangeRateMeasurementData& data, const CTransaction& tx, int height, OBlockUndo* undo);
+bool ApplyMeasurementValidation(const OTransactions::CMeasurementValidationData& data, const CTransaction& tx, int height, OBlockUndo* undo);
+bool ApplyMeasurementInvite(const OTransactions::CMeasurementInviteData& data, const CTransaction& tx, int height, OBlockUndo* undo);
+
+/**
+ * Fill in the measurer of a measurement decoded from a compact payload,
+ * which only names it by key hash. The key is that of the user invited by
+ * the invitation the measurement answers.
+ * 
+ * @return false if the invitation is unknown or for a different key
+ */
+template <typename Measurement>
+bool ResolveMeasurer(Measurement& data)
+{
+    if (data.measurer.IsValid()) {
+        return true;
+    }
+    if (!OMeasurement::g_measurement_db) {
+        return false;
+    }
+    const auto invite = OMeasurement::g_measurement_db->GetInviteStatus(data.invite_id);
+    if (!invite.exists || invite.invited_user.GetID() != data.measurer_id) {
+        return false;
+    }
+    data.measurer = invite.invited_user;
+    return true;
+}
+
+/** Apply one record of a batch, all records share the batch transaction */
+bool ApplyBatchRecord(const OTxRecord& record, const CTransaction& tx, int height, OBlockUndo* undo)
+{
+    return std::visit(util::Overloaded{
+        [&](const OTransactions::CWaterPriceMeasurementData& data) {
+            return ApplyWaterPriceMeasurement(data, tx, height, undo);
+        },
+        [&](const OTransactions::CExchangeRateMeasurementData& data) {
+            return ApplyExchangeRateMeasurement(data, tx, height, undo);
+        },
+        [&](const OTransactions::CMeasurementValidationData& data) {
+            return ApplyMeasurementValidation(data, tx, height, undo);
+        },
+        [&](const OTransactions::CMeasurementInviteData& data) {
+            return ApplyMeasurementInvite(data, tx, height, undo);
+        },
+    }, record);
+}
+
+/**
+ * Whether a batch record is the submitter's own. A compact measurement only
+ * names its measurer by key hash, which the signed submitter key fills in.
+ */
+bool ClaimRecord(OTransactions::CWaterPriceMeasurementData& data, const CPubKey& submitter)
+{
+    if (!data.measurer.IsValid() && data.measurer_id == submitter.GetID()) {
+        data.measurer = submitter;
+    }
+    return data.measurer == submitter;
+}
+
+bool ClaimRecord(OTransactions::CExchangeRateMeasurementData& data, const CPubKey& submitter)
+{
+    if (!data.measurer.IsValid() && data.measurer_id == submitter.GetID()) {
+        data.measurer = submitter;
+    }
+    return data.measurer == submitter;
+}
+
+bool ClaimRecord(const OTransactions::CMeasurementValidationData& data, const CPubKey& submitter)
+{
+    return data.validator == submitter;
+}
+
+bool ClaimRecord(const OTransactions::CMeasurementInviteData&, const CPubKey&)
+{
+    // Invitations are written by miners and not signed yet
+    return true;
+}
+
+/** Id a batch record is stored under, no two records of a batch may share one */
+template <typename T>
+uint256 RecordId(const T& data)
+{
+    return data.GetHash();
+}
+
+uint256 RecordId(const OTransactions::CMeasurementInviteData& data)
+{
+    return data.invite_id;
+}
+
+/** Decode the records of a batch and keep those passing check */
+template <typename T>
+bool CheckBatchRecords(const OTransactions::CBatchData& data, OTxBatch& batch, bool (*check)(const T&))
+{
+    std::set<uint256> ids;
+    batch.records.reserve(data.records.size());
+    for (size_t i = 0; i < data.records.size(); i++) {
+        auto record = data.GetRecord<T>(i);
+        if (!record) {
+            LogPrintf("O Validation: Malformed record %d in batch\n", i);
+            return false;
+        }
+        if (!ClaimRecord(*record, data.submitter)) {
+            LogPrintf("O Validation: Record %d in batch is not the submitter's\n", i);
+            return false;
+        }
+        // Records that differ only in fields the id does not cover, such as a
+        // signature, are still the same measurement
+        if (!ids.insert(RecordId(*record)).second) {
+            LogPrintf("O Validation: Record %d in batch repeats an earlier record\n", i);
+            return false;
+        }
+        if (check(*record)) {
+            batch.records.emplace_back(std::move(*record));
+        }
+    }
+    return true;
+}
+
+/** Prune the invites that were used or expired before time, recording them in undo */
+bool PruneInvites(int64_t time, OBlockUndo* undo)
+{
+    const auto expired = OMeasurement::g_measurement_db->GetExpiredInvites(time);
+    if (expired.empty()) {
+        return true;
+    }
+    if (undo) {
+        for (const uint256& invite_id : expired) {
+            undo->SaveInvite(invite_id);
+        }
+    }
+    return OMeasurement::g_measurement_db->PruneExpiredInvites(time);
+}
+
+} // namespace
+
+bool SyncOState() {
+    bool success = true;
+    if (OMeasurement::g_measurement_db) success &= OMeasurement::g_measurement_db->Sync();
+    if (g_brightid_db) success &= g_brightid_db->Sync();
+    if (g_business_db) success &= g_business_db->Sync();
+    if (g_stabilization_db) success &= g_stabilization_db->Sync();
+    return success;
+}
+
+OTxPrecheck PrecheckOTransaction(const CTransaction& tx) {
+    OTxPrecheck result;
+    // The payload is located once, every decode below reads it in place
+    const auto view = OTransactions::GetOTxView(tx);
+    if (!view) {
+        return result;
+    }
+    
+    result.type = OTransactions::GetOTxType(*view);
+    if (!result.type.has_value()) {
+        LogPrintf("O Validation: Could not determine O transaction type\n");
+        return result;  // Skip malformed O transactions
+    }
+    
+    switch (result.type.value()) {
+        case OTransactions::OTxType::USER_VERIFY:
+            if (auto data = OTransactions::ExtractUserVerification(*view)) {
+                result.valid = CheckUserVerification(*data);
+                result.data = std::move(*data);
+            }
+            break;
+        
+        case OTransactions::OTxType::WATER_PRICE:
+            if (auto data = OTransactions::ExtractWaterPriceMeasurement(*view)) {
+                result.valid = CheckWaterPriceMeasurement(*data);
+                result.data = std::move(*data);
+            }
+            break;
+        
+        case OTransactions::OTxType::EXCHANGE_RATE:
+            if (auto data = OTransactions::ExtractExchangeRateMeasurement(*view)) {
+                result.valid = CheckExchangeRateMeasurement(*data);
+                result.data = std::move(*data);
+            }
+            break;
+        
+        case OTransactions::OTxType::MEASUREMENT_VALIDATION:
+            if (auto data = OTransactions::ExtractMeasurementValidation(*view)) {
+                result.valid = CheckMeasurementValidation(*data);
+                result.data = std::move(*data);
+            }
+            break;
+        
+        case OTransactions::OTxType::MEASUREMENT_INVITE:
+            if (auto data = OTransactions::ExtractMeasurementInvite(*view)) {
+                result.valid = CheckMeasurementInvite(*data);
+                result.data = std::move(*data);
+            }
+            break;
+        
+        case OTransactions::OTxType::BATCH:
+            if (auto data = OTransactions::ExtractBatch(*view)) {
+                OTxBatch batch;
+                result.valid = CheckBatch(*data, batch);
+                result.data = std::move(batch);
+            }
+            break;
+        
+        default:
+            LogPrintf("O Validation: Unknown O transaction type: %d\n", 
+                     static_cast<int>(result.type.value()));
+            break;
+    }
+    
+    return result;
+}
+
+std::optional<std::string> OTxCheck::operator()() {
+    *m_result = PrecheckOTransaction(*m_tx);
+    return std::nullopt;
+}
+
+bool ProcessOTransactions(const CBlock& block, const CBlockIndex* pindex, OBlockUndo* undo,
+                          const std::vector<OTxPrecheck>* prechecks) {
     if (!pindex) {
         LogPrintf("O Validation: Invalid block index\n");
         return false;
     }
     
+    if (prechecks && prechecks->size() != block.vtx.size()) {
+        prechecks = nullptr;
+    }
+    
     int height = pindex->nHeight;
     int processed_count = 0;
     
-    // Process all transactions in the block
-    for (const auto& tx : block.vtx) {
-        if (!OTransactions::IsOTransaction(*tx)) {
-            continue;
-        }
+    // Writes are synced once with the chainstate instead of per transaction
+    ODeferSyncScope deferred_sync;
+    
+    // Apply all O transactions in the block, in block order
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
         
-        auto tx_type = OTransactions::GetOTxType(*tx);
-        if (!tx_type.has_value()) {
-            LogPrintf("O Validation: Could not determine O transaction type\n");
-            continue;  // Skip malformed O transactions
+        OTxPrecheck local_precheck;
+        if (!prechecks) {
+            local_precheck = PrecheckOTransaction(tx);
+        }
+        const OTxPrecheck& precheck = prechecks ? (*prechecks)[i] : local_precheck;
+        if (!precheck.valid) {
+            continue;  // Not an O transaction, or failed stateless checks
         }
         
-        bool processed = false;
-        
-        switch (tx_type.value()) {
-            case OTransactions::OTxType::USER_VERIFY: {
-                auto data = OTransactions::ExtractUserVerification(*tx);
-                if (data.has_value()) {
-                    processed = ProcessUserVerification(data.value(), *tx, height);
-                }
-                break;
-            }
-            
-            case OTransactions::OTxType::WATER_PRICE: {
-                auto data = OTransactions::ExtractWaterPriceMeasurement(*tx);
-                if (data.has_value()) {
-                    processed = ProcessWaterPriceMeasurement(data.value(), *tx, height);
-                }
-                break;
-            }
-            
-            case OTransactions::OTxType::EXCHANGE_RATE: {
-                auto data = OTransactions::ExtractExchangeRateMeasurement(*tx);
-                if (data.has_value()) {
-                    processed = ProcessExchangeRateMeasurement(data.value(), *tx, height);
-                }
-                break;
-            }
-            
-            case OTransactions::OTxType::MEASUREMENT_VALIDATION: {
-                auto data = OTransactions::ExtractMeasurementValidation(*tx);
-                if (data.has_value()) {
-                    processed = ProcessMeasurementValidation(data.value(), *tx, height);
+        // Number of records applied, a batch applies each of its records in order
+        int processed = std::visit(util::Overloaded{
+            [](std::monostate) { return 0; },
+            [&](const OTransactions::CUserVerificationData& data) {
+                return int{ApplyUserVerification(data, tx, height, undo)};
+            },
+            [&](const OTransactions::CWaterPriceMeasurementData& data) {
+                return int{ApplyWaterPriceMeasurement(data, tx, height, undo)};
+            },
+            [&](const OTransactions::CExchangeRateMeasurementData& data) {
+                return int{ApplyExchangeRateMeasurement(data, tx, height, undo)};
+            },
+            [&](const OTransactions::CMeasurementValidationData& data) {
+                return int{ApplyMeasurementValidation(data, tx, height, undo)};
+            },
+            [&](const OTransactions::CMeasurementInviteData& data) {
+                return int{ApplyMeasurementInvite(data, tx, height, undo)};
+            },
+            [&](const OTxBatch& batch) {
+                int applied = 0;
+                for (const OTxRecord& record : batch.records) {
+                    applied += ApplyBatchRecord(record, tx, height, undo);
                 }
-                break;
-            }
-            
-            case OTransactions::OTxType::MEASUREMENT_INVITE: {
-                auto data = OTransactions::ExtractMeasurementInvite(*tx);
-                if (data.has_value()) {
-                    processed = ProcessMeasurementInvite(data.value(), *tx, height);
-                }
-                break;
-            }
-            
-            default:
-                LogPrintf("O Validation: Unknown O transaction type: %d\n", 
-                         static_cast<int>(tx_type.value()));
-                break;
-        }
+                return applied;
+            },
+        }, precheck.data);
         
-        if (processed) {
-            processed_count++;
-        }
+        processed_count += processed;
+    }
+    
+    // Invites used or expired before the block's median time past can no
+    // longer be answered. They are pruned as part of the block, so that every
+    // node prunes the same invites and disconnecting the block restores them.
+    if (OMeasurement::g_measurement_db && !PruneInvites(pindex->GetMedianTimePast(), undo)) {
+        LogPrintf("O Validation: Failed to prune invites at height %d\n", height);
     }
     
     if (processed_count > 0) {
@@ -101,14 +322,7 @@ bool ProcessOTransactions(const CBlock& block, const CBlockIndex* pindex) {
     return true;  // Non-critical errors don't invalidate the block
 }
 
-bool ProcessUserVerification(
-    const OTransactions::CUserVerificationData& data,
-    const CTransaction& tx,
-    int height
-) {
-    LogPrintf("O Validation: Processing user verification [%s] for %s from %s at height %d\n",
-             data.identity_provider.c_str(), data.user_id.c_str(), data.country_code.c_str(), height);
-    
+bool CheckUserVerification(const OTransactions::CUserVerificationData& data) {
     // Validate data structure
     if (!data.IsValid()) {
         LogPrintf("O Validation: Invalid user verification data\n");
@@ -128,6 +342,20 @@ bool ProcessUserVerification(
         return false;
     }
     
+    return true;
+}
+
+namespace {
+
+bool ApplyUserVerification(
+    const OTransactions::CUserVerificationData& data,
+    const CTransaction& tx,
+    int height,
+    OBlockUndo* undo
+) {
+    LogPrintf("O Validation: Processing user verification [%s] for %s from %s at height %d\n",
+             data.identity_provider.c_str(), data.user_id.c_str(), data.country_code.c_str(), height);
+    
     // Create unique user key: provider + user_id
     std::string user_key = data.identity_provider + ":" + data.user_id;
     
@@ -155,6 +383,7 @@ bool ProcessUserVerification(
     
     // Store in database
     if (g_brightid_db) {
+        if (undo) undo->SaveUser(user_key);
         if (!g_brightid_db->WriteUser(user_key, user)) {
             LogPrintf("O Validation: Failed to write user to database\n");
             return false;
@@ -162,6 +391,7 @@ bool ProcessUserVerification(
         
         // Link addresses (user_key <-> o_pubkey)
         std::string o_address = HexStr(data.o_pubkey);
+        if (undo) undo->SaveLink(user_key);
         if (!g_brightid_db->LinkAddresses(user_key, o_address)) {
             LogPrintf("O Validation: Failed to link addresses\n");
             return false;
@@ -175,20 +405,71 @@ bool ProcessUserVerification(
     return true;
 }
 
-bool ProcessWaterPriceMeasurement(
-    const OTransactions::CWaterPriceMeasurementData& data,
+} // namespace
+
+bool ProcessUserVerification(
+    const OTransactions::CUserVerificationData& data,
     const CTransaction& tx,
-    int height
+    int height,
+    OBlockUndo* undo
 ) {
-    LogPrintf("O Validation: Processing water price measurement for %s at height %d\n",
-             data.currency_code.c_str(), height);
-    
+    return CheckUserVerification(data) && ApplyUserVerification(data, tx, height, undo);
+}
+
+namespace {
+
+/** Checks of the water price measurement content, batch records are covered by the batch signature instead */
+bool CheckWaterPriceRecord(const OTransactions::CWaterPriceMeasurementData& data) {
     // Validate data structure
     if (!data.IsValid()) {
         LogPrintf("O Validation: Invalid water price measurement data\n");
         return false;
     }
     
+    // Validate proof
+    if (!ValidateWaterPriceProof(data.proof_type, data.proof_data, data.currency_code)) {
+        LogPrintf("O Validation: Invalid water price proof\n");
+        return false;
+    }
+    
+    return true;
+}
+
+} // namespace
+
+bool CheckWaterPriceMeasurement(const OTransactions::CWaterPriceMeasurementData& data) {
+    if (!CheckWaterPriceRecord(data)) {
+        return false;
+    }
+    
+    if (!data.VerifySignature()) {
+        LogPrintf("O Validation: Invalid water price measurement signature\n");
+        return false;
+    }
+    
+    return true;
+}
+
+namespace {
+
+bool ApplyWaterPriceMeasurement(
+    const OTransactions::CWaterPriceMeasurementData& data,
+    const CTransaction& tx,
+    int height,
+    OBlockUndo* undo
+) {
+    if (!data.measurer.IsValid()) {
+        auto resolved = data;
+        if (!ResolveMeasurer(resolved)) {
+            LogPrintf("O Validation: Unknown measurer for compact water price measurement\n");
+            return false;
+        }
+        return ApplyWaterPriceMeasurement(resolved, tx, height, undo);
+    }
+    
+    LogPrintf("O Validation: Processing water price measurement for %s at height %d\n",
+             data.currency_code.c_str(), height);
+    
     // Validate measurer is verified
     if (!IsMeasurerVerified(data.measurer)) {
         LogPrintf("O Validation: Measurer not verified for water price measurement\n");
@@ -201,13 +482,7 @@ bool ProcessWaterPriceMeasurement(
         return false;
     }
     
-    // Validate proof
-    if (!ValidateWaterPriceProof(data.proof_type, data.proof_data, data.currency_code)) {
-        LogPrintf("O Validation: Invalid water price proof\n");
-        return false;
-    }
-    
-    // TODO: Validate signature
+    // The signature was verified by CheckWaterPriceMeasurement, or by CheckBatch for batch records
     
     // Store in measurement database
     if (OMeasurement::g_measurement_db) {
@@ -233,10 +508,12 @@ bool ProcessWaterPriceMeasurement(
             OMeasurement::MeasurementSource::USER_OFFLINE;
         // auto_validation will be default-initialized
         
+        if (undo) undo->SaveWaterPrice(measurement.measurement_id);
         if (!OMeasurement::g_measurement_db->WriteWaterPrice(measurement.measurement_id, measurement)) {
             LogPrintf("O Validation: Failed to write water price to database\n");
             return false;
         }
+        OMeasurement::g_measurement_stats.AddWaterPrice(measurement);
         
         LogPrintf("O Validation: Water price stored: %s = %.6f at height %d\n",
                  data.currency_code.c_str(), data.GetPriceAsDouble(), height);
@@ -245,20 +522,65 @@ bool ProcessWaterPriceMeasurement(
     return true;
 }
 
-bool ProcessExchangeRateMeasurement(
-    const OTransactions::CExchangeRateMeasurementData& data,
+} // namespace
+
+bool ProcessWaterPriceMeasurement(
+    const OTransactions::CWaterPriceMeasurementData& data,
     const CTransaction& tx,
-    int height
+    int height,
+    OBlockUndo* undo
 ) {
-    LogPrintf("O Validation: Processing exchange rate measurement %s/%s at height %d\n",
-             data.from_currency.c_str(), data.to_currency.c_str(), height);
-    
+    return CheckWaterPriceMeasurement(data) && ApplyWaterPriceMeasurement(data, tx, height, undo);
+}
+
+namespace {
+
+/** Checks of the exchange rate measurement content, batch records are covered by the batch signature instead */
+bool CheckExchangeRateRecord(const OTransactions::CExchangeRateMeasurementData& data) {
     // Validate data structure
     if (!data.IsValid()) {
         LogPrintf("O Validation: Invalid exchange rate measurement data\n");
         return false;
     }
     
+    return true;
+}
+
+} // namespace
+
+bool CheckExchangeRateMeasurement(const OTransactions::CExchangeRateMeasurementData& data) {
+    if (!CheckExchangeRateRecord(data)) {
+        return false;
+    }
+    
+    if (!data.VerifySignature()) {
+        LogPrintf("O Validation: Invalid exchange rate measurement signature\n");
+        return false;
+    }
+    
+    return true;
+}
+
+namespace {
+
+bool ApplyExchangeRateMeasurement(
+    const OTransactions::CExchangeRateMeasurementData& data,
+    const CTransaction& tx,
+    int height,
+    OBlockUndo* undo
+) {
+    if (!data.measurer.IsValid()) {
+        auto resolved = data;
+        if (!ResolveMeasurer(resolved)) {
+            LogPrintf("O Validation: Unknown measurer for compact exchange rate measurement\n");
+            return false;
+        }
+        return ApplyExchangeRateMeasurement(resolved, tx, height, undo);
+    }
+    
+    LogPrintf("O Validation: Processing exchange rate measurement %s/%s at height %d\n",
+             data.from_currency.c_str(), data.to_currency.c_str(), height);
+    
     // Validate measurer is verified
     if (!IsMeasurerVerified(data.measurer)) {
         LogPrintf("O Validation: Measurer not verified for exchange rate measurement\n");
@@ -272,7 +594,7 @@ bool ProcessExchangeRateMeasurement(
     }
     
     // TODO: Validate proof data
-    // TODO: Validate signature
+    // The signature was verified by CheckExchangeRateMeasurement, or by CheckBatch for batch records
     
     // Store in measurement database
     if (OMeasurement::g_measurement_db) {
@@ -293,10 +615,12 @@ bool ProcessExchangeRateMeasurement(
         measurement.source = OMeasurement::MeasurementSource::USER_ONLINE;
         // auto_validation will be default-initialized
         
+        if (undo) undo->SaveExchangeRate(measurement.measurement_id);
         if (!OMeasurement::g_measurement_db->WriteExchangeRate(measurement.measurement_id, measurement)) {
             LogPrintf("O Validation: Failed to write exchange rate to database\n");
             return false;
         }
+        OMeasurement::g_measurement_stats.AddExchangeRate(measurement);
         
         LogPrintf("O Validation: Exchange rate stored: %s/%s = %.6f at height %d\n",
                  data.from_currency.c_str(), data.to_currency.c_str(), 
@@ -306,6 +630,17 @@ bool ProcessExchangeRateMeasurement(
     return true;
 }
 
+} // namespace
+
+bool ProcessExchangeRateMeasurement(
+    const OTransactions::CExchangeRateMeasurementData& data,
+    const CTransaction& tx,
+    int height,
+    OBlockUndo* undo
+) {
+    return CheckExchangeRateMeasurement(data) && ApplyExchangeRateMeasurement(data, tx, height, undo);
+}
+
 bool ValidateProviderSignature(const OTransactions::CUserVerificationData& data) {
     if (data.provider_sig.empty()) {
         return false;
@@ -356,24 +691,24 @@ bool ValidateMeasurementInvitation(const uint256& invite_id, const CPubKey& meas
         return false;
     }
     
-    auto invite = OMeasurement::g_measurement_db->ReadInvite(invite_id);
-    if (!invite.has_value()) {
+    auto invite = OMeasurement::g_measurement_db->GetInviteStatus(invite_id);
+    if (!invite.exists) {
         return false;
     }
     
     // Check if invitation is for this measurer
-    if (invite->invited_user != measurer) {
+    if (invite.invited_user != measurer) {
         return false;
     }
     
     // Check if not expired
     int64_t current_time = GetTime();
-    if (invite->expires_at < current_time) {
+    if (invite.expires_at < current_time) {
         return false;
     }
     
     // Check if not already used
-    if (invite->is_used) {
+    if (invite.is_used) {
         return false;
     }
     
@@ -417,45 +752,55 @@ bool IsMeasurerVerified(const CPubKey& measurer) {
         return false;
     }
     
-    // Get BrightID address for this O pubkey
-    std::string pubkey_str = HexStr(measurer);
-    auto brightid_addr = g_brightid_db->GetBrightIDAddress(pubkey_str);
+    // Served from the database's verification cache for repeat measurers
+    return g_brightid_db->IsOAddressVerified(HexStr(measurer));
+}
+
+namespace {
+
+/** Checks of the measurement validation content, batch records are covered by the batch signature instead */
+bool CheckMeasurementValidationRecord(const OTransactions::CMeasurementValidationData& data)
+{
+    // Basic validation
+    if (!data.IsValid()) {
+        LogPrintf("O Validation: Invalid measurement validation data\n");
+        return false;
+    }
     
-    if (!brightid_addr.has_value()) {
+    return true;
+}
+
+} // namespace
+
+bool CheckMeasurementValidation(const OTransactions::CMeasurementValidationData& data)
+{
+    if (!CheckMeasurementValidationRecord(data)) {
         return false;
     }
     
-    // Check if user is verified
-    auto user = g_brightid_db->ReadUser(brightid_addr.value());
-    if (!user.has_value()) {
+    if (!data.VerifySignature()) {
+        LogPrintf("O Validation: Invalid measurement validation signature\n");
         return false;
     }
     
-    return user->IsVerified() && user->IsActive();
+    return true;
 }
 
-bool ProcessMeasurementValidation(
+namespace {
+
+bool ApplyMeasurementValidation(
     const OTransactions::CMeasurementValidationData& data,
     const CTransaction& tx,
-    int height)
+    int height,
+    OBlockUndo* undo)
 {
-    // Basic validation
-    if (!data.IsValid()) {
-        LogPrintf("O Validation: Invalid measurement validation data\n");
-        return false;
-    }
-    
     // Check validator is verified
     if (!IsMeasurerVerified(data.validator)) {
         LogPrintf("O Validation: Validator not verified in BrightID database\n");
         return false;
     }
     
-    // TODO: Validate signature
-    // if (!ValidateUserSignature(data)) {
-    //     LogPrintf("O Validation: Invalid validator signature\n");
-    //     return false;
-    // }
+    // The signature was verified by CheckMeasurementValidation, or by CheckBatch for batch records
     
     // Store validation in measurement database
     if (!OMeasurement::g_measurement_db) {
@@ -492,7 +837,11 @@ bool ProcessMeasurementValidation(
         }
         
         // Store updated measurement
+        if (undo) undo->SaveWaterPrice(data.measurement_id);
         validation_stored = OMeasurement::g_measurement_db->WriteWaterPrice(data.measurement_id, measurement.value());
+        if (validation_stored) {
+            OMeasurement::g_measurement_stats.AddWaterPrice(measurement.value());
+        }
         
         LogPrintf("O Validation: Water price validation stored: %s by %s (total validators: %d)\n",
                  data.measurement_id.GetHex().c_str(),
@@ -525,7 +874,11 @@ bool ProcessMeasurementValidation(
         }
         
         // Store updated measurement
+        if (undo) undo->SaveExchangeRate(data.measurement_id);
         validation_stored = OMeasurement::g_measurement_db->WriteExchangeRate(data.measurement_id, measurement.value());
+        if (validation_stored) {
+            OMeasurement::g_measurement_stats.AddExchangeRate(measurement.value());
+        }
         
         LogPrintf("O Validation: Exchange rate validation stored: %s by %s (total validators: %d)\n",
                  data.measurement_id.GetHex().c_str(),
@@ -541,10 +894,18 @@ bool ProcessMeasurementValidation(
     return validation_stored;
 }
 
-bool ProcessMeasurementInvite(
-    const OTransactions::CMeasurementInviteData& data,
+} // namespace
+
+bool ProcessMeasurementValidation(
+    const OTransactions::CMeasurementValidationData& data,
     const CTransaction& tx,
-    int height)
+    int height,
+    OBlockUndo* undo)
+{
+    return CheckMeasurementValidation(data) && ApplyMeasurementValidation(data, tx, height, undo);
+}
+
+bool CheckMeasurementInvite(const OTransactions::CMeasurementInviteData& data)
 {
     // Basic validation
     if (!data.IsValid()) {
@@ -552,6 +913,17 @@ bool ProcessMeasurementInvite(
         return false;
     }
     
+    return true;
+}
+
+namespace {
+
+bool ApplyMeasurementInvite(
+    const OTransactions::CMeasurementInviteData& data,
+    const CTransaction& tx,
+    int height,
+    OBlockUndo* undo)
+{
     // Check if invited user is verified
     if (!IsMeasurerVerified(data.invited_user)) {
         LogPrintf("O Validation: Invited user not verified in BrightID database\n");
@@ -602,6 +974,7 @@ bool ProcessMeasurementInvite(
     invite.block_height = data.block_height;
     
     // Store invitation
+    if (undo) undo->SaveInvite(data.invite_id);
     if (!OMeasurement::g_measurement_db->WriteInvite(data.invite_id, invite)) {
         LogPrintf("O Validation: Failed to write invitation to database\n");
         return false;
@@ -616,5 +989,44 @@ bool ProcessMeasurementInvite(
     return true;
 }
 
+} // namespace
+
+bool ProcessMeasurementInvite(
+    const OTransactions::CMeasurementInviteData& data,
+    const CTransaction& tx,
+    int height,
+    OBlockUndo* undo)
+{
+    return CheckMeasurementInvite(data) && ApplyMeasurementInvite(data, tx, height, undo);
+}
+
+bool CheckBatch(const OTransactions::CBatchData& data, OTxBatch& batch)
+{
+    if (!data.IsValid()) {
+        LogPrintf("O Validation: Invalid batch data\n");
+        return false;
+    }
+    
+    if (data.record_type != OTransactions::OTxType::MEASUREMENT_INVITE && !data.VerifySignature()) {
+        LogPrintf("O Validation: Invalid batch signature\n");
+        return false;
+    }
+    
+    batch.record_type = data.record_type;
+    batch.records.clear();
+    switch (data.record_type) {
+        case OTransactions::OTxType::WATER_PRICE:
+            return CheckBatchRecords(data, batch, &CheckWaterPriceRecord);
+        case OTransactions::OTxType::EXCHANGE_RATE:
+            return CheckBatchRecords(data, batch, &CheckExchangeRateRecord);
+        case OTransactions::OTxType::MEASUREMENT_VALIDATION:
+            return CheckBatchRecords(data, batch, &CheckMeasurementValidationRecord);
+        case OTransactions::OTxType::MEASUREMENT_INVITE:
+            return CheckBatchRecords(data, batch, &CheckMeasurementInvite);
+        default:
+            return false;
+    }
+}
+
 } // namespace OConsensus
 
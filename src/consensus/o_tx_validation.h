@@ -9,10 +9,17 @@
 #include <primitives/o_transactions.h>
 #include <primitives/transaction.h>
 
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
 class CBlockIndex;
 
 namespace OConsensus {
 
+struct OBlockUndo;
+
 /**
  * Validate and process O-specific transactions
  * 
@@ -20,16 +27,127 @@ namespace OConsensus {
  * BrightID verifications, water price measurements, and exchange rate measurements.
  */
 
+/** Maximum number of worker threads pre-validating O transactions */
+static constexpr int MAX_O_CHECK_THREADS{4};
+
+/** A record of a batch O transaction */
+using OTxRecord = std::variant<
+    OTransactions::CWaterPriceMeasurementData,
+    OTransactions::CExchangeRateMeasurementData,
+    OTransactions::CMeasurementValidationData,
+    OTransactions::CMeasurementInviteData>;
+
+/** Decoded records of a batch O transaction that passed their stateless checks, in batch order */
+struct OTxBatch {
+    OTransactions::OTxType record_type;
+    std::vector<OTxRecord> records;
+};
+
+/** Decoded payload of an O transaction, std::monostate if it did not decode */
+using OTxData = std::variant<
+    std::monostate,
+    OTransactions::CUserVerificationData,
+    OTransactions::CWaterPriceMeasurementData,
+    OTransactions::CExchangeRateMeasurementData,
+    OTransactions::CMeasurementValidationData,
+    OTransactions::CMeasurementInviteData,
+    OTxBatch>;
+
+/** Result of decoding an O transaction and running its stateless checks */
+struct OTxPrecheck {
+    std::optional<OTransactions::OTxType> type; // nullopt if not a (well-formed) O transaction
+    OTxData data;
+    bool valid{false}; // Decoded and passed the Check* function of its type
+};
+
+/**
+ * Decode an O transaction and run the checks that do not depend on O
+ * database state (structure, signatures, proof format).
+ * 
+ * The payload is located and decoded once. ConnectBlock keeps the results
+ * for a block by transaction index and hands them to ProcessOTransactions,
+ * so block connection never decodes a payload twice.
+ * 
+ * Safe to call concurrently with ProcessOTransactions.
+ */
+OTxPrecheck PrecheckOTransaction(const CTransaction& tx);
+
+/**
+ * CCheckQueue job that prechecks one O transaction of a block on a worker
+ * thread, while ConnectBlock is still checking inputs and scripts. The
+ * result is written to a slot owned by the caller, which must outlive the
+ * queue control that runs the job.
+ * 
+ * An O transaction failing its checks is skipped, it does not invalidate
+ * the block, so the job never reports an error.
+ */
+class OTxCheck
+{
+private:
+    const CTransaction* m_tx;
+    OTxPrecheck* m_result;
+
+public:
+    OTxCheck(const CTransaction& tx, OTxPrecheck& result) : m_tx(&tx), m_result(&result) {}
+
+    std::optional<std::string> operator()();
+};
+
 /**
  * Process all O-specific transactions in a block
  * 
  * Called during ConnectBlock to extract and store O data in databases.
+ * Invites used or expired before the block's median time past are pruned
+ * afterwards, as part of the block.
  * 
  * @param block The block containing transactions
  * @param pindex Block index with height and timestamp
+ * @param undo If set, receives the prior state of every record the block changes
+ * @param prechecks If set, PrecheckOTransaction results for block.vtx by index;
+ *                  transactions are prechecked inline otherwise
  * @return true if all O transactions are valid, false otherwise
  */
-bool ProcessOTransactions(const CBlock& block, const CBlockIndex* pindex);
+bool ProcessOTransactions(const CBlock& block, const CBlockIndex* pindex, OBlockUndo* undo = nullptr,
+                          const std::vector<OTxPrecheck>* prechecks = nullptr);
+
+/**
+ * Make O state written while connecting blocks durable
+ * 
+ * ProcessOTransactions applies its database writes immediately but defers
+ * their fsync, so a block costs one sync per O database instead of one per
+ * O transaction. This is called from Chainstate::FlushStateToDisk before the
+ * coins database is flushed, so the on-disk O state never lags behind the
+ * chainstate that refers to it. Replaying blocks after an unclean shutdown
+ * re-applies any writes that were lost.
+ * 
+ * @return false if any O database failed to sync
+ */
+bool SyncOState();
+
+/**
+ * Stateless checks of each O transaction type, the part of the matching
+ * Process* function that does not read the O databases. Measurements and
+ * validations have their signature verified here, on the parallel precheck.
+ * 
+ * @return true if the data passes the checks
+ */
+bool CheckUserVerification(const OTransactions::CUserVerificationData& data);
+bool CheckWaterPriceMeasurement(const OTransactions::CWaterPriceMeasurementData& data);
+bool CheckExchangeRateMeasurement(const OTransactions::CExchangeRateMeasurementData& data);
+bool CheckMeasurementValidation(const OTransactions::CMeasurementValidationData& data);
+bool CheckMeasurementInvite(const OTransactions::CMeasurementInviteData& data);
+
+/**
+ * Stateless checks of a batch O transaction: its structure, the submitter's
+ * signature over all records, and that every measurement or validation is
+ * the submitter's own. A record that fails to decode invalidates the batch,
+ * a record that fails the content checks of its type is left out of batch.
+ * Records carry no signature of their own and are covered by the batch's.
+ * 
+ * @param[out] batch The decoded records that passed their checks
+ * @return true if the batch passes the checks
+ */
+bool CheckBatch(const OTransactions::CBatchData& data, OTxBatch& batch);
 
 /**
  * Validate and process a user verification transaction
@@ -45,12 +163,14 @@ bool ProcessOTransactions(const CBlock& block, const CBlockIndex* pindex);
  * @param data The verification data
  * @param tx The transaction containing this data
  * @param height Block height
+ * @param undo If set, receives the prior state of records this transaction changes
  * @return true if valid and processed, false otherwise
  */
 bool ProcessUserVerification(
     const OTransactions::CUserVerificationData& data,
     const CTransaction& tx,
-    int height
+    int height,
+    OBlockUndo* undo = nullptr
 );
 
 /**
@@ -66,12 +186,14 @@ bool ProcessUserVerification(
  * @param data The measurement data
  * @param tx The transaction containing this data
  * @param height Block height
+ * @param undo If set, receives the prior state of records this transaction changes
  * @return true if valid and processed, false otherwise
  */
 bool ProcessWaterPriceMeasurement(
     const OTransactions::CWaterPriceMeasurementData& data,
     const CTransaction& tx,
-    int height
+    int height,
+    OBlockUndo* undo = nullptr
 );
 
 /**
@@ -87,12 +209,14 @@ bool ProcessWaterPriceMeasurement(
  * @param data The measurement data
  * @param tx The transaction containing this data
  * @param height Block height
+ * @param undo If set, receives the prior state of records this transaction changes
  * @return true if valid and processed, false otherwise
  */
 bool ProcessExchangeRateMeasurement(
     const OTransactions::CExchangeRateMeasurementData& data,
     const CTransaction& tx,
-    int height
+    int height,
+    OBlockUndo* undo = nullptr
 );
 
 /**
@@ -130,12 +254,14 @@ bool ValidateUserSignature(const OTransactions::CUserVerificationData& data);
  * @param data The validation data
  * @param tx The transaction containing this data
  * @param height Block height
+ * @param undo If set, receives the prior state of records this transaction changes
  * @return true if valid and processed, false otherwise
  */
 bool ProcessMeasurementValidation(
     const OTransactions::CMeasurementValidationData& data,
     const CTransaction& tx,
-    int height
+    int height,
+    OBlockUndo* undo = nullptr
 );
 
 /**
@@ -152,12 +278,14 @@ bool ProcessMeasurementValidation(
  * @param data The invitation data
  * @param tx The transaction containing this data
  * @param height Block height
+ * @param undo If set, receives the prior state of records this transaction changes
  * @return true if valid and processed, false otherwise
  */
 bool ProcessMeasurementInvite(
     const OTransactions::CMeasurementInviteData& data,
     const CTransaction& tx,
-    int height
+    int height,
+    OBlockUndo* undo = nullptr
 );
 
 /**
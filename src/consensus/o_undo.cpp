@@ -0,0 +1,182 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/o_undo.h>
+
+#include <chain.h>
+#include <consensus/o_brightid_db.h>
+#include <consensus/o_business_db.h>
+#include <consensus/o_stabilization_db.h>
+#include <logging.h>
+#include <measurement/measurement_stats.h>
+#include <measurement/o_measurement_db.h>
+#include <streams.h>
+
+namespace OConsensus {
+
+using OMeasurement::g_measurement_db;
+using OMeasurement::g_measurement_stats;
+
+// ===== OBlockUndo =====
+
+void OBlockUndo::SaveWaterPrice(const uint256& measurement_id)
+{
+    if (g_measurement_db) water_prices.push_back({measurement_id, g_measurement_db->ReadWaterPrice(measurement_id)});
+}
+
+void OBlockUndo::SaveExchangeRate(const uint256& measurement_id)
+{
+    if (g_measurement_db) exchange_rates.push_back({measurement_id, g_measurement_db->ReadExchangeRate(measurement_id)});
+}
+
+void OBlockUndo::SaveInvite(const uint256& invite_id)
+{
+    if (g_measurement_db) invites.push_back({invite_id, g_measurement_db->ReadInvite(invite_id)});
+}
+
+void OBlockUndo::SaveUser(const std::string& brightid_address)
+{
+    if (g_brightid_db) users.push_back({brightid_address, g_brightid_db->ReadUser(brightid_address)});
+}
+
+void OBlockUndo::SaveLink(const std::string& brightid_address)
+{
+    if (g_brightid_db) links.push_back({brightid_address, g_brightid_db->GetOAddress(brightid_address)});
+}
+
+void OBlockUndo::SaveBusinessStats(const uint256& pubkey_hash)
+{
+    if (g_business_db) business_stats.push_back({pubkey_hash, g_business_db->ReadBusinessStats(pubkey_hash)});
+}
+
+bool OBlockUndo::IsEmpty() const
+{
+    return water_prices.empty() && exchange_rates.empty() && invites.empty() &&
+           users.empty() && links.empty() && business_stats.empty();
+}
+
+// ===== Applying undo data =====
+
+bool ApplyOBlockUndo(const OBlockUndo& undo)
+{
+    bool success = true;
+
+    // Records are restored newest first, so the oldest saved state of a key wins
+    if (g_business_db) {
+        for (auto it = undo.business_stats.rbegin(); it != undo.business_stats.rend(); ++it) {
+            success &= it->prior ? g_business_db->WriteBusinessStats(it->key, *it->prior)
+                                 : g_business_db->EraseBusinessStats(it->key);
+        }
+    }
+
+    if (g_brightid_db) {
+        // Links before users: erasing a user also drops its links
+        for (auto it = undo.links.rbegin(); it != undo.links.rend(); ++it) {
+            auto current = g_brightid_db->GetOAddress(it->key);
+            if (current == it->prior) continue;
+            if (current) success &= g_brightid_db->UnlinkAddresses(it->key);
+            if (it->prior) success &= g_brightid_db->LinkAddresses(it->key, *it->prior);
+        }
+        for (auto it = undo.users.rbegin(); it != undo.users.rend(); ++it) {
+            success &= it->prior ? g_brightid_db->WriteUser(it->key, *it->prior)
+                                 : g_brightid_db->EraseUser(it->key);
+        }
+    }
+
+    if (g_measurement_db) {
+        for (auto it = undo.invites.rbegin(); it != undo.invites.rend(); ++it) {
+            success &= it->prior ? g_measurement_db->WriteInvite(it->key, *it->prior)
+                                 : g_measurement_db->EraseInvite(it->key);
+        }
+        for (auto it = undo.exchange_rates.rbegin(); it != undo.exchange_rates.rend(); ++it) {
+            if (auto current = g_measurement_db->ReadExchangeRate(it->key)) {
+                g_measurement_stats.RemoveExchangeRate(*current);
+            }
+            if (it->prior) {
+                success &= g_measurement_db->WriteExchangeRate(it->key, *it->prior);
+                g_measurement_stats.AddExchangeRate(*it->prior);
+            } else {
+                success &= g_measurement_db->EraseExchangeRate(it->key);
+            }
+        }
+        for (auto it = undo.water_prices.rbegin(); it != undo.water_prices.rend(); ++it) {
+            if (auto current = g_measurement_db->ReadWaterPrice(it->key)) {
+                g_measurement_stats.RemoveWaterPrice(*current);
+            }
+            if (it->prior) {
+                success &= g_measurement_db->WriteWaterPrice(it->key, *it->prior);
+                g_measurement_stats.AddWaterPrice(*it->prior);
+            } else {
+                success &= g_measurement_db->EraseWaterPrice(it->key);
+            }
+        }
+    }
+
+    return success;
+}
+
+bool WriteOBlockUndo(const CBlockIndex& index, const OBlockUndo& undo)
+{
+    const uint256 block_hash = index.GetBlockHash();
+    if (!g_measurement_db || undo.IsEmpty() || g_measurement_db->HasBlockUndo(block_hash)) {
+        return true;
+    }
+
+    DataStream ss{};
+    ss << undo;
+    return g_measurement_db->WriteBlockUndo(block_hash, index.nHeight, {UCharCast(ss.data()), UCharCast(ss.data() + ss.size())});
+}
+
+bool PruneOBlockUndo(int height)
+{
+    if (!g_measurement_db) {
+        return true;
+    }
+    return g_measurement_db->PruneBlockUndo(height);
+}
+
+bool DisconnectOTransactions(const CBlockIndex& index)
+{
+    // Stabilization transactions follow from the block and its height alone,
+    // so the ones recorded at this height are simply erased again
+    if (g_stabilization_db && !g_stabilization_db->EraseTransactionsAtHeight(index.nHeight)) {
+        LogPrintf("O Validation: Failed to revert stabilization transactions of block %s\n", index.GetBlockHash().ToString());
+        return false;
+    }
+
+    if (!g_measurement_db) {
+        return true;
+    }
+
+    const uint256 block_hash = index.GetBlockHash();
+    auto data = g_measurement_db->ReadBlockUndo(block_hash);
+    if (!data) {
+        // Either the block did not change O state or its record was pruned
+        if (index.nHeight < g_measurement_db->GetBlockUndoPrunedHeight()) {
+            LogPrintf("O Validation: O undo data for block %s was pruned\n", block_hash.ToString());
+            return false;
+        }
+        return true;
+    }
+
+    OBlockUndo undo;
+    try {
+        DataStream ss{MakeByteSpan(*data)};
+        ss >> undo;
+    } catch (const std::exception& e) {
+        LogPrintf("O Validation: Failed to read O undo data for block %s: %s\n", block_hash.ToString(), e.what());
+        return false;
+    }
+
+    if (!ApplyOBlockUndo(undo)) {
+        LogPrintf("O Validation: Failed to apply O undo data for block %s\n", block_hash.ToString());
+        return false;
+    }
+    g_measurement_db->EraseBlockUndo(block_hash, index.nHeight);
+
+    LogDebug(BCLog::NET, "O Validation: Reverted O state of block %s at height %d\n", block_hash.ToString(), index.nHeight);
+    return true;
+}
+
+} // namespace OConsensus
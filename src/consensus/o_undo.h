@@ -0,0 +1,125 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CONSENSUS_O_UNDO_H
+#define BITCOIN_CONSENSUS_O_UNDO_H
+
+#include <consensus/brightid_integration.h>
+#include <consensus/o_pow_pob.h>
+#include <measurement/measurement_system.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+class CBlockIndex;
+
+namespace OConsensus {
+
+/** Number of blocks below the tip whose O undo records are kept */
+static constexpr int O_BLOCK_UNDO_KEEP_DEPTH{2016};
+
+/** State of one O database record before a block touched it */
+template <typename Key, typename Value>
+struct OUndoRecord {
+    Key key;
+    std::optional<Value> prior; // nullopt if the record did not exist
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << key << prior.has_value();
+        if (prior) s << *prior;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        bool has_prior;
+        s >> key >> has_prior;
+        prior.reset();
+        if (has_prior) {
+            Value value;
+            s >> value;
+            prior = std::move(value);
+        }
+    }
+};
+
+/**
+ * Undo data for the O databases, the counterpart of CBlockUndo for the
+ * measurement, BrightID and business miner state a block changes.
+ *
+ * Records are appended in the order the block touches them, before each
+ * write, so applying them in reverse order restores the state as it was
+ * before the block even if a record was written more than once.
+ *
+ * The record of each connected block is stored in the measurement database
+ * keyed by block hash, and applied and erased when the block is disconnected.
+ * Records of blocks more than O_BLOCK_UNDO_KEEP_DEPTH below the tip are
+ * pruned (see PruneOBlockUndo).
+ */
+struct OBlockUndo {
+    std::vector<OUndoRecord<uint256, OMeasurement::WaterPriceMeasurement>> water_prices;
+    std::vector<OUndoRecord<uint256, OMeasurement::ExchangeRateMeasurement>> exchange_rates;
+    std::vector<OUndoRecord<uint256, OMeasurement::MeasurementInvite>> invites;
+    std::vector<OUndoRecord<std::string, BrightIDUser>> users;
+    std::vector<OUndoRecord<std::string, std::string>> links; // BrightID address -> linked O address
+    std::vector<OUndoRecord<uint256, BusinessMinerStats>> business_stats;
+
+    SERIALIZE_METHODS(OBlockUndo, obj)
+    {
+        READWRITE(obj.water_prices, obj.exchange_rates, obj.invites, obj.users, obj.links, obj.business_stats);
+    }
+
+    /** Save the current state of a record before it is written */
+    void SaveWaterPrice(const uint256& measurement_id);
+    void SaveExchangeRate(const uint256& measurement_id);
+    void SaveInvite(const uint256& invite_id);
+    void SaveUser(const std::string& brightid_address);
+    void SaveLink(const std::string& brightid_address);
+    void SaveBusinessStats(const uint256& pubkey_hash);
+
+    bool IsEmpty() const;
+
+    /** Whether reverting changes water price or exchange rate measurements */
+    bool HasMeasurements() const { return !water_prices.empty() || !exchange_rates.empty(); }
+};
+
+/**
+ * Restore the O databases to the state recorded in undo, and revert the
+ * running measurement statistics accordingly.
+ *
+ * @return false if any record could not be restored
+ */
+bool ApplyOBlockUndo(const OBlockUndo& undo);
+
+/**
+ * Store the undo record of a connected block. An existing record for the
+ * block is kept: it was captured when the block was first connected, while
+ * reconnecting an already applied block (e.g. during -checklevel=4
+ * verification) would capture the post-block state.
+ */
+bool WriteOBlockUndo(const CBlockIndex& index, const OBlockUndo& undo);
+
+/**
+ * Erase the undo records of blocks below height. Blocks below the highest
+ * height pruned so far can no longer be disconnected.
+ */
+bool PruneOBlockUndo(int height);
+
+/**
+ * Revert the O state changes of a block that is being disconnected from
+ * the active chain, and erase its undo record.
+ *
+ * @return false if the stored undo record is unreadable, was pruned or could
+ *         not be applied
+ */
+bool DisconnectOTransactions(const CBlockIndex& index);
+
+} // namespace OConsensus
+
+#endif // BITCOIN_CONSENSUS_O_UNDO_H
@@ -111,8 +111,8 @@ bool StabilizationConsensusValidator::ShouldBlockHaveStabilization(
 std::vector<CTransaction> StabilizationConsensusValidator::CalculateExpectedStabilizationTransactions(
     const CBlock& block, int height) const {
     
-    // Use the same logic as the stabilization mining system
-    return g_stabilization_mining.CreateStabilizationTransactions(block, height);
+    // The block's cached plan, as used by the stabilization mining system
+    return g_stabilization_mining.GetBlockPlan(block, height)->transactions;
 }
 
 bool StabilizationConsensusValidator::VerifyStabilizationTransaction(
@@ -279,21 +279,14 @@ StabilizationConsensusValidator::CalculateDeterministicParams(
     
     StabilizationParams params;
     
-    // Get unstable currencies
-    params.unstable_currencies = g_stabilization_mining.GetUnstableCurrencies();
-    
-    // Calculate coins per currency
-    for (const auto& currency : params.unstable_currencies) {
-        auto info = g_stabilization_mining.GetStabilityStatus(currency);
-        if (info.has_value() && info->IsUnstable()) {
-            CAmount coins = g_stabilization_mining.CalculateCoinsForCurrency(currency, block, height);
-            params.coins_per_currency[currency] = coins;
-            
-            // Calculate recipient count
-            int recipient_count = g_stabilization_mining.CalculateOptimalRecipientCount(coins);
-            params.recipient_counts[currency] = recipient_count;
-        }
+    // Coins and recipient counts come from the block's plan, which block
+    // assembly and connection share
+    const auto plan = g_stabilization_mining.GetBlockPlan(block, height);
+    for (const auto& [currency, info] : *plan->status) {
+        if (info.IsUnstable()) params.unstable_currencies.push_back(currency);
     }
+    params.coins_per_currency = plan->coins_per_currency;
+    params.recipient_counts = plan->recipient_counts;
     
     return params;
 }
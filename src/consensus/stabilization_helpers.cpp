@@ -6,26 +6,70 @@
 #include <consensus/currency_lifecycle.h>
 #include <consensus/currency_disappearance_handling.h>
 #include <consensus/o_brightid_db.h>
+#include <consensus/o_stabilization_db.h>
+#include <crypto/siphash.h>
+#include <hash.h>
 #include <measurement/measurement_system.h>
 #include <logging.h>
+#include <primitives/multicurrency_txout.h>
 #include <random.h>
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <algorithm>
 #include <cmath>
+#include <tuple>
 
 namespace OConsensus {
 
+void StabilizationMining::LoadState() {
+    LOCK(m_write_mutex);
+    if (!g_stabilization_db) return;
+    
+    auto status = std::make_shared<const StatusMap>(g_stabilization_db->ReadAllStatus());
+    LogPrintf("O Stabilization: Loaded stability status of %d currencies\n", status->size());
+    LOCK(m_snapshot_mutex);
+    m_status = std::move(status);
+}
+
+std::shared_ptr<const StabilizationMining::StatusMap> StabilizationMining::GetStatusSnapshot() const {
+    LOCK(m_snapshot_mutex);
+    return m_status;
+}
+
+void StabilizationMining::CommitStatus(std::shared_ptr<const StatusMap> next, const std::vector<std::string>& changed) {
+    AssertLockHeld(m_write_mutex);
+    
+    if (g_stabilization_db && !changed.empty()) {
+        std::vector<CurrencyStabilityInfo> infos;
+        infos.reserve(changed.size());
+        for (const auto& currency : changed) infos.push_back(next->at(currency));
+        g_stabilization_db->WriteStatus(infos);
+    }
+    
+    LOCK(m_snapshot_mutex);
+    m_status = std::move(next);
+}
+
 bool StabilizationMining::IsCurrencyStable(const std::string& currency) const {
-    auto it = m_currency_status.find(currency);
-    return (it == m_currency_status.end()) ? true : it->second.IsStable();
+    const auto status = GetStatusSnapshot();
+    auto it = status->find(currency);
+    return (it == status->end()) ? true : it->second.IsStable();
 }
 
 void StabilizationMining::UpdateStabilityStatus(const std::string& currency,
                                                 double expected_price, double observed_price,
                                                 double exchange_rate, int height) {
-    auto& info = m_currency_status[currency];
+    LOCK(m_write_mutex);
+    auto next = std::make_shared<StatusMap>(*GetStatusSnapshot());
+    auto& info = (*next)[currency];
     info.currency_code = currency;
+    ApplyObservation(info, expected_price, observed_price, exchange_rate, height);
+    CommitStatus(std::move(next), {currency});
+}
+
+void StabilizationMining::ApplyObservation(CurrencyStabilityInfo& info, double expected_price, double observed_price,
+                                           double exchange_rate, int height) const {
+    const std::string& currency = info.currency_code;
     info.expected_water_price = expected_price;
     info.observed_water_price = observed_price;
     info.observed_exchange_rate = exchange_rate;
@@ -50,13 +94,14 @@ void StabilizationMining::UpdateStabilityStatus(const std::string& currency,
 
 std::optional<CurrencyStabilityInfo> StabilizationMining::GetStabilityStatus(
     const std::string& currency) const {
-    auto it = m_currency_status.find(currency);
-    return (it == m_currency_status.end()) ? std::nullopt : std::make_optional(it->second);
+    const auto status = GetStatusSnapshot();
+    auto it = status->find(currency);
+    return (it == status->end()) ? std::nullopt : std::make_optional(it->second);
 }
 
 std::vector<std::string> StabilizationMining::GetUnstableCurrencies() const {
     std::vector<std::string> unstable;
-    for (const auto& [currency, info] : m_currency_status) {
+    for (const auto& [currency, info] : *GetStatusSnapshot()) {
         if (info.IsUnstable()) unstable.push_back(currency);
     }
     return unstable;
@@ -64,36 +109,33 @@ std::vector<std::string> StabilizationMining::GetUnstableCurrencies() const {
 
 std::vector<std::string> StabilizationMining::GetStableCurrencies() const {
     std::vector<std::string> stable;
-    for (const auto& [currency, info] : m_currency_status) {
+    for (const auto& [currency, info] : *GetStatusSnapshot()) {
         if (info.IsStable()) stable.push_back(currency);
     }
     return stable;
 }
 
 bool StabilizationMining::IsCurrencyInactive(const std::string& currency, int height) const {
-    auto it = m_currency_status.find(currency);
-    return (it != m_currency_status.end()) && 
+    const auto status = GetStatusSnapshot();
+    auto it = status->find(currency);
+    return (it != status->end()) && 
            (it->second.IsInactive() || 
             (height - it->second.last_check_height > StabilizationConfig::INACTIVE_TIME_RANGE));
 }
 
 void StabilizationMining::MarkCurrencyInactive(const std::string& currency, int height) {
-    auto& info = m_currency_status[currency];
+    LOCK(m_write_mutex);
+    auto next = std::make_shared<StatusMap>(*GetStatusSnapshot());
+    auto& info = (*next)[currency];
     info.currency_code = currency;
     info.status = StabilityStatus::INACTIVE;
     info.last_check_height = height;
+    CommitStatus(std::move(next), {currency});
     LogPrintf("O Stabilization: Currency %s marked as INACTIVE\n", currency);
 }
 
 CAmount StabilizationMining::CalculateStabilizationCoins(const CBlock& block, int height) {
-    CAmount total_coins = 0;
-    for (const auto& currency : GetUnstableCurrencies()) {
-        auto info = GetStabilityStatus(currency);
-        if (info.has_value() && MeetsInstabilityThreshold(info.value(), height)) {
-            total_coins += CalculateCoinsForCurrency(currency, block, height);
-        }
-    }
-    return total_coins;
+    return GetBlockPlan(block, height)->total_coins;
 }
 
 CAmount StabilizationMining::CalculateCoinsForCurrency(const std::string& currency,
@@ -105,20 +147,25 @@ CAmount StabilizationMining::CalculateVolumeDifference(const std::string& curren
                                                        const CBlock& block) const {
     auto info = GetStabilityStatus(currency);
     if (!info.has_value()) return 0;
+    return CalculateCoinsForInfo(*info, GetBlockTransactionVolume(block));
+}
+
+CAmount StabilizationMining::CalculateCoinsForInfo(const CurrencyStabilityInfo& info, const BlockVolume& block_volume) const {
+    const std::string& currency = info.currency_code;
     
     // Calculate stabilization coins based on:
     // Volume of transactions in currency × Exchange rate deviation from water price
     
     // Get transaction volume in this currency (from block transactions)
-    CAmount transaction_volume = GetTransactionVolumeInCurrency(currency, block);
+    CAmount transaction_volume = GetVolumeInCurrency(currency, block_volume);
     
     // Get exchange rate deviation (how far O currency is from water price)
-    double exchange_rate_deviation = CalculateExchangeRateDeviation(currency);
+    double exchange_rate_deviation = ExchangeRateDeviation(info);
     
     // Calculate dynamic stabilization factor based on volatility/deviation
     // Formula: Scales from 0.1 (minimal instability) to 1.0 (severe instability)
     // This ensures more aggressive stabilization for highly volatile currencies
-    double stabilization_factor = CalculateDynamicStabilizationFactor(info->stability_ratio, currency);
+    double stabilization_factor = CalculateDynamicStabilizationFactor(info);
     
     // Calculate stabilization coins needed
     // Formula: Volume × Deviation × Dynamic Stabilization Factor
@@ -134,24 +181,39 @@ CAmount StabilizationMining::CalculateVolumeDifference(const std::string& curren
 }
 
 std::vector<CPubKey> StabilizationMining::SelectRewardRecipients(
-    int count, const std::string& exclude_currency) const {
-    std::vector<CPubKey> all_recipients;
-    std::vector<std::string> stable = GetStableCurrencies();
-    
-    stable.erase(std::remove(stable.begin(), stable.end(), exclude_currency), stable.end());
+    int count, const uint256& seed, const std::string& exclude_currency) const {
+    if (count <= 0) return {};
     
-    for (const auto& currency : stable) {
-        auto currency_users = GetUsersByCurrency(currency);
-        all_recipients.insert(all_recipients.end(), currency_users.begin(), currency_users.end());
+    RecipientSampler sampler(seed, count);
+    for (const auto& currency : GetStableCurrencies()) {
+        if (currency == exclude_currency) continue;
+        SampleUsersByCurrency(currency, sampler);
     }
     
-    return RandomSample(all_recipients, std::min(count, (int)all_recipients.size()));
+    LogPrintf("O Stabilization: Sampled %d of %d eligible users for reward selection\n",
+             std::min<int>(count, sampler.Seen()), static_cast<int>(sampler.Seen()));
+    
+    return sampler.Finish();
 }
 
 std::vector<CPubKey> StabilizationMining::SelectRecipientsFromCurrency(
-    int count, const std::string& currency) const {
-    auto users = GetUsersByCurrency(currency);
-    return RandomSample(users, std::min(count, (int)users.size()));
+    int count, const uint256& seed, const std::string& currency) const {
+    if (count <= 0) return {};
+    
+    RecipientSampler sampler(seed, count);
+    SampleUsersByCurrency(currency, sampler);
+    return sampler.Finish();
+}
+
+void StabilizationMining::SampleUsersByCurrency(const std::string& currency, RecipientSampler& sampler) const {
+    if (!g_brightid_db) {
+        LogPrintf("O Stabilization: BrightID database not initialized\n");
+        return;
+    }
+    
+    g_brightid_db->ForEachUserByBirthCurrency(currency, [&](const CPubKey& pubkey) {
+        sampler.Add(pubkey);
+    });
 }
 
 std::vector<CPubKey> StabilizationMining::GetUsersByCurrency(const std::string& currency) const {
@@ -191,31 +253,49 @@ int StabilizationMining::CalculateOptimalRecipientCount(CAmount total_coins) con
 }
 
 CAmount StabilizationMining::GetTransactionVolumeInCurrency(const std::string& currency, const CBlock& block) const {
-    // TODO: Implement actual transaction volume calculation
-    // This should sum up all transaction values in the specified currency
-    
-    CAmount total_volume = 0;
+    return GetVolumeInCurrency(currency, GetBlockTransactionVolume(block));
+}
+
+BlockVolume StabilizationMining::GetBlockTransactionVolume(const CBlock& block) const {
+    BlockVolume volume;
     for (const auto& tx : block.vtx) {
-        // TODO: Parse transaction outputs and sum values in the specified currency
-        // For now, use a placeholder calculation
-        total_volume += tx->GetValueOut();  // This is Bitcoin's total, need currency-specific calculation
+        // Stabilization transactions have no inputs; the coinbase is counted like any other transaction
+        if (tx->vin.empty()) continue;
+        for (const auto& txout : tx->vout) {
+            const MultiCurrencyAmount amount = CMultiCurrencyTxOut::LegacyAmount(txout);
+            volume.by_currency[amount.currency_id] += amount.amount;
+        }
+    }
+    return volume;
+}
+
+CAmount StabilizationMining::GetVolumeInCurrency(const std::string& currency, const BlockVolume& volume) const {
+    auto id = g_currency_registry.GetCurrencyId(currency);
+    if (id.has_value() && *id != CURRENCY_BTC) {
+        CAmount currency_volume = volume.Get(*id);
+        if (currency_volume > 0) return currency_volume;
     }
     
-    // Placeholder: assume 10% of Bitcoin volume is in this currency
-    // In real implementation, this would be currency-specific
-    return total_volume / 10;
+    // Outputs without amounts of their own in this currency, which is every
+    // legacy output, keep the old estimate of 10% of the base currency volume
+    return volume.Get(CURRENCY_BTC) / 10;
 }
 
 double StabilizationMining::CalculateExchangeRateDeviation(const std::string& currency) const {
     auto info = GetStabilityStatus(currency);
     if (!info.has_value()) return 0.0;
+    return ExchangeRateDeviation(*info);
+}
+
+double StabilizationMining::ExchangeRateDeviation(const CurrencyStabilityInfo& info) const {
+    const std::string& currency = info.currency_code;
     
     // Exchange rate deviation is the difference between:
     // 1. Expected O currency value (based on water price)
     // 2. Actual O currency exchange rate
     
     double expected_value = 1.0;  // 1 O should equal 1 liter of water
-    double actual_exchange_rate = info->stability_ratio;  // Use stability_ratio as deviation measure
+    double actual_exchange_rate = info.stability_ratio;  // Use stability_ratio as deviation measure
     
     if (actual_exchange_rate == 0) return 0.0;
     
@@ -228,24 +308,81 @@ double StabilizationMining::CalculateExchangeRateDeviation(const std::string& cu
     return deviation;
 }
 
-std::vector<CTransaction> StabilizationMining::CreateStabilizationTransactions(
-    const CBlock& block, int height) {
-    std::vector<CTransaction> stab_txs;
-    CAmount total_coins = CalculateStabilizationCoins(block, height);
+std::shared_ptr<const StabilizationPlan> StabilizationMining::GetBlockPlan(const CBlock& block, int height) const {
+    const auto key = std::make_pair(block.hashPrevBlock, height);
+    BlockVolume block_volume = GetBlockTransactionVolume(block);
+    const auto status = GetStatusSnapshot();
+    // Read before sampling, so a write racing the build only forces a rebuild
+    const uint64_t brightid_version = g_brightid_db ? g_brightid_db->GetWriteVersion() : 0;
+    
+    {
+        LOCK(m_plan_mutex);
+        auto it = m_plans.find(key);
+        // A plan is reused only if it was built from the same inputs; a status
+        // update, a BrightID write or different transactions need a new one
+        if (it != m_plans.end() && it->second->status == status && it->second->block_volume == block_volume &&
+            it->second->brightid_version == brightid_version) {
+            return it->second;
+        }
+    }
     
-    if (total_coins == 0) return stab_txs;
+    // Built without holding the lock, recipient sampling reads the BrightID database
+    auto plan = BuildBlockPlan(block, height, std::move(block_volume), status, brightid_version);
     
-    for (const auto& currency : GetUnstableCurrencies()) {
-        auto info = GetStabilityStatus(currency);
-        if (!info.has_value() || !MeetsInstabilityThreshold(info.value(), height)) continue;
-        
-        CAmount currency_coins = CalculateCoinsForCurrency(currency, block, height);
-        if (currency_coins == 0) continue;
+    LOCK(m_plan_mutex);
+    if (m_plans.size() >= MAX_CACHED_PLANS && !m_plans.count(key)) {
+        // The plan for the lowest height is the one furthest behind the tip
+        m_plans.erase(std::min_element(m_plans.begin(), m_plans.end(), [](const auto& a, const auto& b) {
+            return a.first.second < b.first.second;
+        }));
+    }
+    m_plans[key] = plan;
+    return plan;
+}
+
+void StabilizationMining::EvictBlockPlans(const uint256& tip_hash) {
+    LOCK(m_plan_mutex);
+    for (auto it = m_plans.begin(); it != m_plans.end();) {
+        if (it->first.first == tip_hash) {
+            ++it;
+        } else {
+            it = m_plans.erase(it);
+        }
+    }
+}
+
+std::shared_ptr<const StabilizationPlan> StabilizationMining::BuildBlockPlan(
+    const CBlock& block, int height, BlockVolume block_volume, std::shared_ptr<const StatusMap> status,
+    uint64_t brightid_version) const {
+    auto plan = std::make_shared<StabilizationPlan>();
+    plan->prev_block_hash = block.hashPrevBlock;
+    plan->height = height;
+    plan->block_volume = std::move(block_volume);
+    plan->status = std::move(status);
+    plan->brightid_version = brightid_version;
+    
+    for (const auto& [currency, info] : *plan->status) {
+        if (!MeetsInstabilityThreshold(info, height)) continue;
+        plan->triggered = true;
         
+        CAmount currency_coins = CalculateCoinsForInfo(info, plan->block_volume);
         // Calculate number of recipients based on economic need
         // More recipients for larger stabilization amounts
         int recipient_count = CalculateOptimalRecipientCount(currency_coins);
-        auto recipients = SelectRewardRecipients(recipient_count, currency);
+        plan->coins_per_currency[currency] = currency_coins;
+        plan->recipient_counts[currency] = recipient_count;
+        plan->total_coins += currency_coins;
+    }
+    
+    if (plan->total_coins == 0) return plan;
+    
+    for (const auto& [currency, currency_coins] : plan->coins_per_currency) {
+        if (currency_coins == 0) continue;
+        
+        // Seeded with the parent block, height and currency. The block's own hash
+        // changes while the miner fills it in, these are fixed before it does.
+        uint256 seed = (HashWriter{} << block.hashPrevBlock << height << currency).GetSHA256();
+        auto recipients = SelectRewardRecipients(plan->recipient_counts.at(currency), seed, currency);
         if (recipients.empty()) continue;
         
         // Calculate amount per recipient based on total coins and recipient count
@@ -264,96 +401,115 @@ std::vector<CTransaction> StabilizationMining::CreateStabilizationTransactions(
         }
         
         CTransaction tx(mtx);
-        stab_txs.push_back(tx);
         
         StabilizationTransaction stab_record;
         stab_record.tx_id = tx.GetHash();
         stab_record.unstable_currency = currency;
         stab_record.coins_created = amount_per_recipient * recipients.size();
-        stab_record.recipients = recipients;
+        stab_record.recipients = std::move(recipients);
         stab_record.block_height = height;
         stab_record.timestamp = GetTime();
-        stab_record.deviation_ratio = info->stability_ratio;
-        RecordStabilizationTransaction(stab_record);
+        stab_record.deviation_ratio = plan->status->at(currency).stability_ratio;
+        
+        plan->transactions.push_back(std::move(tx));
+        plan->records.push_back(std::move(stab_record));
     }
     
-    return stab_txs;
+    return plan;
+}
+
+std::vector<CTransaction> StabilizationMining::CreateStabilizationTransactions(
+    const CBlock& block, int height) {
+    return GetBlockPlan(block, height)->transactions;
+}
+
+void StabilizationMining::RecordStabilizationPlan(const StabilizationPlan& plan) {
+    for (const auto& record : plan.records) {
+        RecordStabilizationTransaction(record);
+    }
+    
+    if (plan.height % StabilizationConfig::PRUNE_INTERVAL == 0) {
+        PruneOldData(plan.height - StabilizationConfig::HISTORY_BLOCKS);
+    }
 }
 
 void StabilizationMining::RecordStabilizationTransaction(const StabilizationTransaction& tx) {
-    m_stabilization_txs[tx.tx_id] = tx;
-    m_stats.total_coins_created += tx.coins_created;
-    m_stats.total_transactions++;
-    m_stats.total_recipients += tx.recipients.size();
+    if (!g_stabilization_db) {
+        LogPrintf("O Stabilization: Stabilization database not initialized, transaction %s not recorded\n",
+                  tx.tx_id.GetHex().substr(0, 16));
+        return;
+    }
+    g_stabilization_db->WriteTransaction(tx);
 }
 
 std::vector<StabilizationTransaction> StabilizationMining::GetStabilizationHistory(
     const std::string& currency, int start_height, int end_height) const {
-    std::vector<StabilizationTransaction> history;
-    for (const auto& [tx_id, tx] : m_stabilization_txs) {
-        if (tx.unstable_currency == currency && tx.block_height >= start_height && 
-            tx.block_height <= end_height) {
-            history.push_back(tx);
-        }
-    }
-    return history;
+    if (!g_stabilization_db) return {};
+    return g_stabilization_db->GetTransactions(currency, start_height, end_height);
 }
 
 CAmount StabilizationMining::GetTotalCoinsCreated(const std::string& currency) const {
-    CAmount total = 0;
-    for (const auto& [tx_id, tx] : m_stabilization_txs) {
-        if (tx.unstable_currency == currency) total += tx.coins_created;
-    }
-    return total;
+    if (!g_stabilization_db) return 0;
+    return g_stabilization_db->ReadCurrencyTotals(currency).coins_created;
 }
 
 std::map<std::string, CurrencyStabilityInfo> StabilizationMining::GetAllStabilityStatus() const {
-    return m_currency_status;
+    return *GetStatusSnapshot();
 }
 
 StabilizationMining::StabilizationStats StabilizationMining::GetStatistics() const {
     StabilizationStats stats;
     stats.total_unstable_currencies = stats.total_stable_currencies = stats.total_inactive_currencies = 0;
     
-    for (const auto& [currency, info] : m_currency_status) {
+    for (const auto& [currency, info] : *GetStatusSnapshot()) {
         if (info.IsStable()) stats.total_stable_currencies++;
         else if (info.IsUnstable()) stats.total_unstable_currencies++;
         else if (info.IsInactive()) stats.total_inactive_currencies++;
     }
     
-    stats.total_coins_created = m_stats.total_coins_created;
-    stats.total_transactions = m_stats.total_transactions;
-    stats.total_recipients = m_stats.total_recipients;
+    const StabilizationTotals totals = g_stabilization_db ? g_stabilization_db->ReadTotals() : StabilizationTotals{};
+    stats.total_coins_created = totals.coins_created;
+    stats.total_transactions = totals.transactions;
+    stats.total_recipients = totals.recipients;
     return stats;
 }
 
 void StabilizationMining::ReEvaluateAllCurrencies(int height) {
-    for (auto& [currency, info] : m_currency_status) {
+    // Averages are gathered before taking the write lock, the measurement
+    // system itself updates stability status while holding its own locks
+    std::vector<std::tuple<std::string, double, double>> observations;
+    for (const auto& [currency, info] : *GetStatusSnapshot()) {
         double avg_water_price = GetAverageWaterPrice(currency, 30);
         double avg_exchange_rate = GetAverageExchangeRate(currency, "O", 7);
         if (avg_water_price > 0 && avg_exchange_rate > 0) {
-            UpdateStabilityStatus(currency, 1.0, avg_water_price, avg_exchange_rate, height);
+            observations.emplace_back(currency, avg_water_price, avg_exchange_rate);
         }
     }
+    
+    LOCK(m_write_mutex);
+    auto next = std::make_shared<StatusMap>(*GetStatusSnapshot());
+    std::vector<std::string> changed;
+    for (const auto& [currency, avg_water_price, avg_exchange_rate] : observations) {
+        auto& info = (*next)[currency];
+        info.currency_code = currency;
+        ApplyObservation(info, 1.0, avg_water_price, avg_exchange_rate, height);
+        changed.push_back(currency);
+    }
+    CommitStatus(std::move(next), changed);
 }
 
 void StabilizationMining::PruneOldData(int cutoff_height) {
-    int pruned = 0;
-    for (auto it = m_stabilization_txs.begin(); it != m_stabilization_txs.end();) {
-        if (it->second.block_height < cutoff_height) {
-            it = m_stabilization_txs.erase(it);
-            pruned++;
-        } else ++it;
-    }
-    if (pruned > 0) LogPrintf("O Stabilization: Pruned %d old transactions\n", pruned);
+    if (g_stabilization_db) g_stabilization_db->PruneTransactions(cutoff_height);
 }
 
 double StabilizationMining::CalculateStabilityRatio(double expected, double observed) const {
     return (expected == 0) ? 0.0 : std::abs(expected - observed) / expected;
 }
 
-double StabilizationMining::CalculateDynamicStabilizationFactor(double stability_ratio, 
-                                                                const std::string& currency) const {
+double StabilizationMining::CalculateDynamicStabilizationFactor(const CurrencyStabilityInfo& info) const {
+    const std::string& currency = info.currency_code;
+    const double stability_ratio = info.stability_ratio;
+    
     // Dynamic stabilization factor based on volatility level
     // Scales from 0.1 (minimal instability) to 1.0 (severe instability)
     
@@ -390,9 +546,8 @@ double StabilizationMining::CalculateDynamicStabilizationFactor(double stability
     
     // Consider duration of instability (optional enhancement)
     // If currency has been unstable for a long time, increase factor slightly
-    auto info = GetStabilityStatus(currency);
-    if (info.has_value() && info->unstable_since_height > 0) {
-        int64_t blocks_unstable = info->last_check_height - info->unstable_since_height;
+    if (info.unstable_since_height > 0) {
+        int64_t blocks_unstable = info.last_check_height - info.unstable_since_height;
         int64_t days_unstable = blocks_unstable / (24 * 60 * 60 / 12); // Assuming 12s blocks
         
         // Add up to 0.1 factor for prolonged instability (>7 days)
@@ -414,16 +569,36 @@ bool StabilizationMining::MeetsInstabilityThreshold(const CurrencyStabilityInfo&
     return info.IsUnstable() && (height - info.unstable_since_height) >= StabilizationConfig::UNSTABLE_TIME_RANGE;
 }
 
-std::vector<CPubKey> StabilizationMining::RandomSample(const std::vector<CPubKey>& users, int count) const {
-    if (users.empty() || count <= 0) return {};
-    std::vector<CPubKey> sample = users;
+RecipientSampler::RecipientSampler(const uint256& seed, size_t capacity)
+    : m_k0(seed.GetUint64(0)), m_k1(seed.GetUint64(1)), m_capacity(capacity) {
+    m_heap.reserve(capacity);
+}
+
+void RecipientSampler::Add(const CPubKey& candidate) {
+    m_seen++;
+    if (m_capacity == 0) return;
     
-    FastRandomContext rng;
-    for (size_t i = sample.size() - 1; i > 0; --i) {
-        std::swap(sample[i], sample[rng.randrange(i + 1)]);
+    std::pair<uint64_t, CPubKey> entry{CSipHasher(m_k0, m_k1).Write(candidate).Finalize(), candidate};
+    if (m_heap.size() < m_capacity) {
+        m_heap.push_back(std::move(entry));
+        std::push_heap(m_heap.begin(), m_heap.end());
+    } else if (entry < m_heap.front()) {
+        // Replace the highest rank currently kept
+        std::pop_heap(m_heap.begin(), m_heap.end());
+        m_heap.back() = std::move(entry);
+        std::push_heap(m_heap.begin(), m_heap.end());
     }
+}
+
+std::vector<CPubKey> RecipientSampler::Finish() const {
+    auto ranked = m_heap;
+    std::sort_heap(ranked.begin(), ranked.end());
     
-    if (sample.size() > static_cast<size_t>(count)) sample.resize(count);
+    std::vector<CPubKey> sample;
+    sample.reserve(ranked.size());
+    for (const auto& [rank, pubkey] : ranked) {
+        sample.push_back(pubkey);
+    }
     return sample;
 }
 
@@ -438,14 +613,7 @@ double StabilizationMining::GetAverageExchangeRate(const std::string& from, cons
 }
 
 bool ShouldTriggerStabilization(const CBlock& block, int height) {
-    for (const auto& currency : g_stabilization_mining.GetUnstableCurrencies()) {
-        auto info = g_stabilization_mining.GetStabilityStatus(currency);
-        if (info.has_value() && 
-            (height - info->unstable_since_height) >= StabilizationConfig::UNSTABLE_TIME_RANGE) {
-            return true;
-        }
-    }
-    return false;
+    return g_stabilization_mining.GetBlockPlan(block, height)->triggered;
 }
 
 bool ValidateStabilizationTransactions(const CBlock& block, int height) {
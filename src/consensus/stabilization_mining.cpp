@@ -17,11 +17,8 @@ namespace OConsensus {
 StabilizationMining g_stabilization_mining;
 
 StabilizationMining::StabilizationMining()
+    : m_status{std::make_shared<const StatusMap>()}
 {
-    m_stats.total_coins_created = 0;
-    m_stats.total_transactions = 0;
-    m_stats.total_recipients = 0;
-    
     LogPrintf("O Stabilization Mining: Initialized\n");
 }
 
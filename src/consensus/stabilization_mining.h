@@ -6,13 +6,17 @@
 #define BITCOIN_CONSENSUS_STABILIZATION_MINING_H
 
 #include <consensus/amount.h>
+#include <consensus/multicurrency.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <pubkey.h>
 #include <uint256.h>
 #include <serialize.h>
+#include <sync.h>
+#include <util/serfloat.h>
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
@@ -27,6 +31,18 @@ enum class StabilityStatus : uint8_t {
     UNKNOWN = 3
 };
 
+/** Serializes a double as its IEEE 754 encoding, as EncodedDoubleFormatter in policy/fees.cpp */
+struct StabilityDoubleFormatter {
+    template <typename Stream> void Ser(Stream& s, double v) { s << EncodeDouble(v); }
+    
+    template <typename Stream> void Unser(Stream& s, double& v)
+    {
+        uint64_t encoded;
+        s >> encoded;
+        v = DecodeDouble(encoded);
+    }
+};
+
 /** Currency Stability Information */
 struct CurrencyStabilityInfo {
     std::string currency_code;
@@ -46,11 +62,14 @@ struct CurrencyStabilityInfo {
           last_check_height(0), measurement_count(0) {}
     
     SERIALIZE_METHODS(CurrencyStabilityInfo, obj) {
-        uint8_t status_val = static_cast<uint8_t>(obj.status);
-        READWRITE(obj.currency_code, obj.expected_water_price, obj.observed_water_price,
-                  obj.observed_exchange_rate, obj.stability_ratio, status_val,
+        uint8_t status_val{0};
+        SER_WRITE(obj, status_val = static_cast<uint8_t>(obj.status));
+        READWRITE(obj.currency_code, Using<StabilityDoubleFormatter>(obj.expected_water_price),
+                  Using<StabilityDoubleFormatter>(obj.observed_water_price),
+                  Using<StabilityDoubleFormatter>(obj.observed_exchange_rate),
+                  Using<StabilityDoubleFormatter>(obj.stability_ratio), status_val,
                   obj.unstable_since_height, obj.last_check_height, obj.measurement_count);
-        if (ser_action.ForRead()) obj.status = static_cast<StabilityStatus>(status_val);
+        SER_READ(obj, obj.status = static_cast<StabilityStatus>(status_val));
     }
     
     bool IsStable() const { return status == StabilityStatus::STABLE; }
@@ -67,6 +86,8 @@ namespace StabilizationConfig {
     static constexpr CAmount MIN_STABILIZATION_REWARD = 100;   // 1.00 O minimum per recipient
     static constexpr CAmount MAX_STABILIZATION_REWARD = 10000; // 100.00 O maximum per recipient
     static constexpr int MIN_MEASUREMENTS_REQUIRED = 10;       // Minimum measurements for stability check
+    static constexpr int HISTORY_BLOCKS = 144 * 365;           // ~1 year of stabilization transactions kept
+    static constexpr int PRUNE_INTERVAL = 144;                 // Blocks between two history prunes
     // Note: No MAX_RECIPIENTS_PER_BLOCK - recipients determined by economic need
 }
 
@@ -86,15 +107,113 @@ struct StabilizationTransaction {
     
     SERIALIZE_METHODS(StabilizationTransaction, obj) {
         READWRITE(obj.tx_id, obj.unstable_currency, obj.coins_created, obj.recipients,
-                  obj.block_height, obj.timestamp, obj.deviation_ratio);
+                  obj.block_height, obj.timestamp, Using<StabilityDoubleFormatter>(obj.deviation_ratio));
+    }
+};
+
+/**
+ * Output value of a block's spending transactions per currency.
+ *
+ * Gathered in one pass over the block, so looking up the volume of every
+ * unstable currency does not walk the block again. Coinbase, stabilization
+ * and reward transactions create coins rather than move them and differ
+ * between a template and the mined block, so they are left out.
+ */
+struct BlockVolume {
+    std::map<CurrencyId, CAmount> by_currency;
+    
+    CAmount Get(CurrencyId currency) const
+    {
+        auto it = by_currency.find(currency);
+        return it == by_currency.end() ? 0 : it->second;
     }
+    
+    bool operator==(const BlockVolume&) const = default;
+};
+
+/**
+ * Stabilization outcome of one block.
+ *
+ * Built once per (previous block, height) from one status snapshot and the
+ * block's volume, then shared by block
+ * assembly, block connection and consensus validation. Building has no side
+ * effects; the transactions are recorded when the block is connected.
+ */
+struct StabilizationPlan {
+    uint256 prev_block_hash;
+    int height{0};
+    BlockVolume block_volume;
+    std::shared_ptr<const std::map<std::string, CurrencyStabilityInfo>> status; // Snapshot the plan was built from
+    uint64_t brightid_version{0};                        // CBrightIDUserDB::GetWriteVersion() recipients were sampled at
+    
+    bool triggered{false};                               // Some currency has been unstable long enough
+    std::map<std::string, CAmount> coins_per_currency;   // Coins owed per currency due for stabilization
+    std::map<std::string, int> recipient_counts;         // Recipients wanted per currency
+    CAmount total_coins{0};
+    std::vector<CTransaction> transactions;
+    std::vector<StabilizationTransaction> records;       // One per transaction
+};
+
+/**
+ * Deterministic bottom-k sampler for stabilization recipients.
+ *
+ * Each candidate is ranked by a SipHash of its public key keyed with the
+ * seed, and only the `capacity` lowest ranks are kept in a bounded heap.
+ * The sample is a uniform random subset that depends only on the seed and
+ * the candidate set, not on visiting order, so miners and validators seeded
+ * with the same seed agree on it while holding O(capacity) keys.
+ */
+class RecipientSampler {
+public:
+    RecipientSampler(const uint256& seed, size_t capacity);
+    
+    /** Offer one candidate */
+    void Add(const CPubKey& candidate);
+    
+    /** Selected recipients, ordered by rank */
+    std::vector<CPubKey> Finish() const;
+    
+    /** Number of candidates offered so far */
+    size_t Seen() const { return m_seen; }
+    
+private:
+    uint64_t m_k0;
+    uint64_t m_k1;
+    size_t m_capacity;
+    size_t m_seen{0};
+    std::vector<std::pair<uint64_t, CPubKey>> m_heap; // Max-heap on (rank, key)
 };
 
-/** Stabilization Mining Manager */
+/**
+ * Stabilization Mining Manager
+ *
+ * Currency stability status is published as an immutable map behind a
+ * shared pointer. Readers (RPC, block assembly, block connection) copy the
+ * pointer and work on that snapshot without waiting for writers; writers
+ * are serialized, build a modified copy, persist the changed entries and
+ * publish the copy. Status and the stabilization transaction history are
+ * stored in g_stabilization_db when it is open.
+ */
 class StabilizationMining {
 public:
+    using StatusMap = std::map<std::string, CurrencyStabilityInfo>;
+    
     StabilizationMining();
     
+    /** Replace the in-memory status with the one stored in g_stabilization_db */
+    void LoadState() EXCLUSIVE_LOCKS_REQUIRED(!m_write_mutex, !m_snapshot_mutex);
+    
+    /** Current stability status of all currencies */
+    std::shared_ptr<const StatusMap> GetStatusSnapshot() const EXCLUSIVE_LOCKS_REQUIRED(!m_snapshot_mutex);
+    
+    /** Stabilization plan of a block. It is built on first use and reused until
+     *  the tip changes, as long as the status and the block's volume match. */
+    std::shared_ptr<const StabilizationPlan> GetBlockPlan(const CBlock& block, int height) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_plan_mutex, !m_snapshot_mutex);
+    
+    /** Drop cached plans of blocks that do not build on tip_hash */
+    void EvictBlockPlans(const uint256& tip_hash) EXCLUSIVE_LOCKS_REQUIRED(!m_plan_mutex);
+    
     // ===== Currency Stability Detection =====
     
     /** Check if a currency is stable */
@@ -105,7 +224,7 @@ public:
                                double expected_price,
                                double observed_price,
                                double exchange_rate,
-                               int height);
+                               int height) EXCLUSIVE_LOCKS_REQUIRED(!m_write_mutex, !m_snapshot_mutex);
     
     /** Get stability status for a currency */
     std::optional<CurrencyStabilityInfo> GetStabilityStatus(const std::string& currency) const;
@@ -120,7 +239,7 @@ public:
     bool IsCurrencyInactive(const std::string& currency, int height) const;
     
     /** Mark currency as inactive */
-    void MarkCurrencyInactive(const std::string& currency, int height);
+    void MarkCurrencyInactive(const std::string& currency, int height) EXCLUSIVE_LOCKS_REQUIRED(!m_write_mutex, !m_snapshot_mutex);
     
     // ===== Stabilization Coin Creation =====
     
@@ -138,12 +257,14 @@ public:
     
     // ===== Recipient Selection =====
     
-    /** Select random authenticated users from stable currency regions */
-    std::vector<CPubKey> SelectRewardRecipients(int count, 
+    /** Select random authenticated users from stable currency regions.
+     *  The selection is deterministic in seed (derived from the parent block) and
+     *  streams candidates from the BrightID birth-currency index. */
+    std::vector<CPubKey> SelectRewardRecipients(int count, const uint256& seed,
                                                 const std::string& exclude_currency = "") const;
     
     /** Select recipients specifically from a stable currency */
-    std::vector<CPubKey> SelectRecipientsFromCurrency(int count,
+    std::vector<CPubKey> SelectRecipientsFromCurrency(int count, const uint256& seed,
                                                       const std::string& currency) const;
     
     /** Get users by their birth currency (from user consensus system) */
@@ -151,12 +272,15 @@ public:
     
     // ===== Stabilization Transactions =====
     
-    /** Create stabilization transactions for a block */
+    /** Create stabilization transactions for a block, see GetBlockPlan */
     std::vector<CTransaction> CreateStabilizationTransactions(const CBlock& block, int height);
     
     /** Record stabilization transaction */
     void RecordStabilizationTransaction(const StabilizationTransaction& tx);
     
+    /** Record the transactions of a connected block's plan and prune old history */
+    void RecordStabilizationPlan(const StabilizationPlan& plan);
+    
     /** Get stabilization history */
     std::vector<StabilizationTransaction> GetStabilizationHistory(
         const std::string& currency, int start_height, int end_height) const;
@@ -182,9 +306,9 @@ public:
     StabilizationStats GetStatistics() const;
     
     /** Re-evaluate all currency stability statuses */
-    void ReEvaluateAllCurrencies(int height);
+    void ReEvaluateAllCurrencies(int height) EXCLUSIVE_LOCKS_REQUIRED(!m_write_mutex, !m_snapshot_mutex);
     
-    /** Prune old stability data */
+    /** Prune stabilization transactions recorded below cutoff_height */
     void PruneOldData(int cutoff_height);
     
     /** Calculate optimal number of recipients based on stabilization amount */
@@ -193,28 +317,50 @@ public:
     /** Get transaction volume in specific currency */
     CAmount GetTransactionVolumeInCurrency(const std::string& currency, const CBlock& block) const;
     
+    /** Volume of the block's spending transactions per currency */
+    BlockVolume GetBlockTransactionVolume(const CBlock& block) const;
+    
+    /** Volume of one currency, by its symbol, in a block's volume */
+    CAmount GetVolumeInCurrency(const std::string& currency, const BlockVolume& volume) const;
+    
     /** Calculate exchange rate deviation from water price */
     double CalculateExchangeRateDeviation(const std::string& currency) const;
 
 private:
-    // Storage
-    std::map<std::string, CurrencyStabilityInfo> m_currency_status;
-    std::map<uint256, StabilizationTransaction> m_stabilization_txs;
+    /** Serializes writers of the status map */
+    mutable Mutex m_write_mutex;
+    /** Held only to copy or swap the published pointer */
+    mutable Mutex m_snapshot_mutex;
+    std::shared_ptr<const StatusMap> m_status GUARDED_BY(m_snapshot_mutex);
     
-    // Statistics
-    struct InternalStats {
-        CAmount total_coins_created;
-        int64_t total_transactions;
-        int64_t total_recipients;
-    } m_stats;
+    /** Plans cached by (previous block hash, height), the lowest height evicted first */
+    static constexpr size_t MAX_CACHED_PLANS{8};
+    mutable Mutex m_plan_mutex;
+    mutable std::map<std::pair<uint256, int>, std::shared_ptr<const StabilizationPlan>> m_plans GUARDED_BY(m_plan_mutex);
+    
+    std::shared_ptr<const StabilizationPlan> BuildBlockPlan(const CBlock& block, int height, BlockVolume block_volume,
+                                                            std::shared_ptr<const StatusMap> status,
+                                                            uint64_t brightid_version) const;
+    
+    /** Coins to create for an unstable currency given the block volume */
+    CAmount CalculateCoinsForInfo(const CurrencyStabilityInfo& info, const BlockVolume& block_volume) const;
+    double ExchangeRateDeviation(const CurrencyStabilityInfo& info) const;
+    
+    /** Persist the entries of next named in changed and publish next */
+    void CommitStatus(std::shared_ptr<const StatusMap> next, const std::vector<std::string>& changed)
+        EXCLUSIVE_LOCKS_REQUIRED(m_write_mutex, !m_snapshot_mutex);
+    
+    /** Apply one observation to a currency's status */
+    void ApplyObservation(CurrencyStabilityInfo& info, double expected_price, double observed_price,
+                          double exchange_rate, int height) const;
     
     // Helper functions
     double CalculateStabilityRatio(double expected, double observed) const;
     bool MeetsInstabilityThreshold(const CurrencyStabilityInfo& info, int height) const;
-    std::vector<CPubKey> RandomSample(const std::vector<CPubKey>& users, int count) const;
+    void SampleUsersByCurrency(const std::string& currency, RecipientSampler& sampler) const;
     
     /** Calculate dynamic stabilization factor based on volatility level */
-    double CalculateDynamicStabilizationFactor(double stability_ratio, const std::string& currency) const;
+    double CalculateDynamicStabilizationFactor(const CurrencyStabilityInfo& info) const;
     
     /** Integration with measurement system */
     double GetAverageWaterPrice(const std::string& currency, int days) const;
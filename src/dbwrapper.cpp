@@ -368,6 +368,13 @@ size_t CDBWrapper::EstimateSizeImpl(std::span<const std::byte> key1, std::span<c
     return size;
 }
 
+void CDBWrapper::CompactRangeImpl(std::span<const std::byte> key1, std::span<const std::byte> key2) const
+{
+    leveldb::Slice slKey1(CharCast(key1.data()), key1.size());
+    leveldb::Slice slKey2(CharCast(key2.data()), key2.size());
+    DBContext().pdb->CompactRange(&slKey1, &slKey2);
+}
+
 bool CDBWrapper::IsEmpty()
 {
     std::unique_ptr<CDBIterator> it(NewIterator());
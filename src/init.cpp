@@ -22,7 +22,12 @@
 #include <consensus/consensus.h>
 #include <consensus/o_brightid_db.h>
 #include <consensus/o_business_db.h>
+#include <consensus/o_db_maintenance.h>
+#include <consensus/o_lookup_cache.h>
+#include <consensus/o_stabilization_db.h>
+#include <consensus/stabilization_mining.h>
 #include <measurement/o_measurement_db.h>
+#include <measurement/stability_snapshot.h>
 #include <deploymentstatus.h>
 #include <hash.h>
 #include <httprpc.h>
@@ -497,6 +502,7 @@ void SetupServerArgs(ArgsManager& argsman, bool can_listen_ipc)
     argsman.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY_HOURS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet3: %s, testnet4: %s, signet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnet4ChainParams->GetConsensus().nMinimumChainWork.GetHex(), signetChainParams->GetConsensus().nMinimumChainWork.GetHex()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-olookupcache=<n>", strprintf("Maximum number of entries in each of the in-memory measurer verification and measurement invite caches, 0 to disable (default: %u)", OConsensus::DEFAULT_O_LOOKUP_CACHE_ENTRIES), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-par=<n>", strprintf("Set the number of script verification threads (0 = auto, up to %d, <0 = leave that many cores free, default: %d)",
         MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -1744,6 +1750,7 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     size_t brightid_cache = kernel_cache_sizes.coins_db / 10;     // 10% - For billions of users
     size_t measurement_cache = kernel_cache_sizes.coins_db / 4;  // 25% - CRITICAL: water price data
     size_t business_cache = kernel_cache_sizes.coins_db / 20;    // 5% - business miners
+    size_t stabilization_cache = kernel_cache_sizes.coins_db / 50; // 2% - stabilization status and history
     
     try {
         // Initialize Measurement Database (CRITICAL: water prices, exchange rates)
@@ -1773,11 +1780,37 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         LogPrintf("* Using %.1f MiB for business miner database\n", 
                   business_cache * (1.0 / 1024 / 1024));
         
+        // Initialize Stabilization Database (currency stability, stabilization history)
+        OConsensus::g_stabilization_db = std::make_unique<OConsensus::CStabilizationDB>(
+            stabilization_cache,
+            false,  // Not memory-only
+            do_reindex  // Wipe if reindexing
+        );
+        LogPrintf("* Using %.1f MiB for stabilization database\n", 
+                  stabilization_cache * (1.0 / 1024 / 1024));
+        OConsensus::g_stabilization_mining.LoadState();
+        
+        const size_t lookup_cache_entries = std::max<int64_t>(0, args.GetIntArg("-olookupcache", OConsensus::DEFAULT_O_LOOKUP_CACHE_ENTRIES));
+        OMeasurement::g_measurement_db->SetInviteCacheCapacity(lookup_cache_entries);
+        OConsensus::g_brightid_db->SetMeasurerCacheCapacity(lookup_cache_entries);
+        
         LogPrintf("O Blockchain databases initialized successfully\n");
     } catch (const std::exception& e) {
         return InitError(strprintf(_("Error initializing O Blockchain databases: %s"), e.what()));
     }
 
+    // Rebuild the stability map served over REST as blocks are connected and disconnected
+    validation_signals.RegisterValidationInterface(&OMeasurement::g_stability_snapshot);
+
+    // Incremental pruning and compaction of the O databases, in bounded slices
+    scheduler.scheduleEvery([]{
+        try {
+            OConsensus::g_db_maintenance.RunSlice(OConsensus::O_DB_MAINTENANCE_SLICE_BUDGET);
+        } catch (const std::exception& e) {
+            LogPrintf("O DB Maintenance: Error in maintenance slice: %s\n", e.what());
+        }
+    }, OConsensus::O_DB_MAINTENANCE_SLICE_INTERVAL);
+
     // ********************************************************* Step 9: load wallet
     for (const auto& client : node.chain_clients) {
         if (!client->load()) {
@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <measurement/measurement_system.h>
+#include <measurement/measurement_stats.h>
+#include <measurement/stability_snapshot.h>
 #include <measurement/o_measurement_db.h>
 #include <consensus/user_consensus.h>
 #include <consensus/currency_lifecycle.h>
@@ -285,26 +287,17 @@ std::optional<AverageWithConfidence> MeasurementSystem::GetAverageWaterPriceWith
     int64_t current_time = GetTime();
     int64_t start_time = current_time - (days * 24 * 3600);
     
-    std::vector<WaterPriceMeasurement> measurements = 
-        GetWaterPricesInRange(currency, start_time, current_time);
+    WindowStatistics stats = g_measurement_stats.GetWaterPriceStats(currency, start_time, current_time);
     
-    if (measurements.empty()) {
+    if (stats.count == 0) {
         return std::nullopt;
     }
     
-    std::vector<double> prices;
-    for (const auto& m : measurements) {
-        prices.push_back(static_cast<double>(m.price));
-    }
-    
-    double avg = CalculateGaussianAverage(prices);
-    double std_dev = CalculateStandardDeviation(prices);
-    
-    AverageWithConfidence result(avg, static_cast<int>(measurements.size()), std_dev);
+    AverageWithConfidence result(stats.gaussian_average, stats.count, stats.std_deviation);
     
-    LogPrintf("O Measurement: Water price average for %s over %d days: %.4f (n=%d, std_dev=%.4f, confidence=%s)\n",
-              currency.c_str(), days, avg, static_cast<int>(measurements.size()), std_dev, 
-              result.GetConfidenceString().c_str());
+    LogDebug(BCLog::VALIDATION, "O Measurement: Water price average for %s over %d days: %.4f (n=%d, std_dev=%.4f, confidence=%s)\n",
+             currency.c_str(), days, stats.gaussian_average, stats.count, stats.std_deviation,
+             result.GetConfidenceString().c_str());
     
     return result;
 }
@@ -315,26 +308,17 @@ std::optional<AverageWithConfidence> MeasurementSystem::GetAverageExchangeRateWi
     int64_t current_time = GetTime();
     int64_t start_time = current_time - (days * 24 * 3600);
     
-    std::vector<ExchangeRateMeasurement> measurements = 
-        GetExchangeRatesInRange(from_currency, to_currency, start_time, current_time);
+    WindowStatistics stats = g_measurement_stats.GetExchangeRateStats(from_currency, to_currency, start_time, current_time);
     
-    if (measurements.empty()) {
+    if (stats.count == 0) {
         return std::nullopt;
     }
     
-    std::vector<double> rates;
-    for (const auto& m : measurements) {
-        rates.push_back(m.exchange_rate);
-    }
-    
-    double avg = CalculateGaussianAverage(rates);
-    double std_dev = CalculateStandardDeviation(rates);
-    
-    AverageWithConfidence result(avg, static_cast<int>(measurements.size()), std_dev);
+    AverageWithConfidence result(stats.gaussian_average, stats.count, stats.std_deviation);
     
-    LogPrintf("O Measurement: Exchange rate average for %s->%s over %d days: %.4f (n=%d, std_dev=%.4f, confidence=%s)\n",
-              from_currency.c_str(), to_currency.c_str(), days, avg, 
-              static_cast<int>(measurements.size()), std_dev, result.GetConfidenceString().c_str());
+    LogDebug(BCLog::VALIDATION, "O Measurement: Exchange rate average for %s->%s over %d days: %.4f (n=%d, std_dev=%.4f, confidence=%s)\n",
+             from_currency.c_str(), to_currency.c_str(), days, stats.gaussian_average,
+             stats.count, stats.std_deviation, result.GetConfidenceString().c_str());
     
     return result;
 }
@@ -420,40 +404,28 @@ double MeasurementSystem::CalculateVolatility(MeasurementType type, const std::s
     int64_t current_time = GetTime();
     int64_t start_time = current_time - (days * 24 * 3600);
     
-    std::vector<double> values;
+    WindowStatistics stats;
     
     if (type == MeasurementType::WATER_PRICE || type == MeasurementType::WATER_PRICE_OFFLINE_VALIDATION) {
-        std::vector<WaterPriceMeasurement> measurements = GetWaterPricesInRange(currency, start_time, current_time);
-        for (const auto& m : measurements) {
-            if (m.is_validated) {
-                values.push_back(static_cast<double>(m.price) / 100.0);
-            }
-        }
+        stats = g_measurement_stats.GetWaterPriceStats(currency, start_time, current_time);
     } else if (type == MeasurementType::EXCHANGE_RATE || type == MeasurementType::EXCHANGE_RATE_OFFLINE_VALIDATION) {
         // For exchange rates, we need to determine the currency pair
         if (IsOCurrency(currency)) {
             std::string fiat_currency = GetCorrespondingFiatCurrency(currency);
-            std::vector<ExchangeRateMeasurement> measurements = GetExchangeRatesInRange(currency, fiat_currency, start_time, current_time);
-            for (const auto& m : measurements) {
-                if (m.is_validated) {
-                    values.push_back(m.exchange_rate);
-                }
-            }
+            stats = g_measurement_stats.GetExchangeRateStats(currency, fiat_currency, start_time, current_time);
         }
     }
     
-    if (values.size() < 2) {
+    if (stats.count < 2) {
         return 0.0; // Not enough data to calculate volatility
     }
     
     // Calculate coefficient of variation (standard deviation / mean)
-    double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
-    if (mean == 0.0) {
+    if (stats.mean == 0.0) {
         return 0.0;
     }
     
-    double std_dev = CalculateStandardDeviation(values);
-    return std_dev / mean; // Coefficient of variation
+    return stats.std_deviation / stats.mean; // Coefficient of variation
 }
 
 bool MeasurementSystem::IsEarlyStage(MeasurementType type, const std::string& currency) const
@@ -635,6 +607,25 @@ void MeasurementSystem::StoreDailyAverage(const DailyAverage& avg)
               avg.is_stable ? "YES" : "NO");
 }
 
+void MeasurementSystem::StoreDailyAverages(const std::vector<DailyAverage>& averages)
+{
+    int significant = 0;
+    for (const auto& avg : averages) {
+        m_daily_averages[avg.currency_code + "_" + avg.date] = avg;
+        if (avg.is_statistically_significant) significant++;
+    }
+    
+    // Persist the whole day in a single database batch
+    if (g_measurement_db && !averages.empty()) {
+        if (!g_measurement_db->BatchWriteDailyAverages(averages)) {
+            LogPrintf("O Measurement: Failed to persist %d daily averages\n", averages.size());
+        }
+    }
+    
+    LogPrintf("O Measurement: Stored %d daily averages (%d statistically significant)\n",
+              averages.size(), significant);
+}
+
 void MeasurementSystem::CalculateDailyAverages(int height) {
     int64_t current_time = GetTime();
     std::string today = FormatDate(current_time);
@@ -645,29 +636,38 @@ void MeasurementSystem::CalculateDailyAverages(int height) {
     // Get all supported O currencies
     std::vector<std::string> currencies = GetSupportedOCurrencies();
     
+    // Each currency's day is summarized once from the running per-day buckets,
+    // then all results are persisted together.
+    std::vector<DailyAverage> averages;
+    averages.reserve(currencies.size());
     for (const auto& currency : currencies) {
-        CalculateDailyAverageForCurrency(currency, today, height);
+        averages.push_back(BuildDailyAverage(currency, today, height));
     }
     
+    StoreDailyAverages(averages);
+    
     // Recalculate currency stability status after updating averages
     RecalculateCurrencyStability(height);
+    
+    g_stability_snapshot.Refresh(height);
 }
 
-void MeasurementSystem::CalculateDailyAverageForCurrency(const std::string& currency, 
-                                                        const std::string& date, 
-                                                        int height) {
-    // Calculate daily average water price
-    auto water_price_avg = GetDailyAverageWaterPriceInternal(currency, date);
+DailyAverage MeasurementSystem::BuildDailyAverage(const std::string& currency, 
+                                                  const std::string& date, 
+                                                  int height) const {
+    int64_t start_time = ParseDateToTimestamp(date);
+    int64_t end_time = start_time + 24 * 3600 - 1; // End of day
+    
+    // Water prices are stored in cents, exchange rates as plain ratios
+    WindowStatistics water = g_measurement_stats.GetWaterPriceStats(currency, start_time, end_time);
     
-    // Calculate daily average exchange rate (O currency to corresponding fiat)
-    double exchange_rate_avg = 0.0;
+    // Exchange rate statistics (O currency to corresponding fiat)
+    WindowStatistics exchange;
     if (IsOCurrency(currency)) {
         std::string fiat_currency = GetCorrespondingFiatCurrency(currency);
-        auto exchange_avg = GetDailyAverageExchangeRateInternal(currency, fiat_currency, date);
-        if (exchange_avg.has_value()) {
-            exchange_rate_avg = exchange_avg.value();
-        }
+        exchange = g_measurement_stats.GetExchangeRateStats(currency, fiat_currency, start_time, end_time);
     }
+    double exchange_rate_avg = exchange.count > 0 ? exchange.gaussian_average : 0.0;
     
     // Determine if currency is stable
     bool is_stable = true;
@@ -675,9 +675,7 @@ void MeasurementSystem::CalculateDailyAverageForCurrency(const std::string& curr
         is_stable = IsOCurrencyStable(currency, exchange_rate_avg);
     }
     
-    // Get measurement count and calculate confidence
-    int measurement_count = GetDailyMeasurementCount(currency, date);
-    double std_deviation = CalculateDailyStandardDeviation(currency, date);
+    int measurement_count = water.count + exchange.count;
     
     // Calculate confidence level
     ConfidenceLevel confidence_level;
@@ -701,17 +699,16 @@ void MeasurementSystem::CalculateDailyAverageForCurrency(const std::string& curr
     DailyAverage daily_avg;
     daily_avg.currency_code = currency;
     daily_avg.date = date;
-    daily_avg.avg_water_price = water_price_avg.value_or(0.0);
+    daily_avg.avg_water_price = water.count > 0 ? water.gaussian_average / 100.0 : 0.0;
     daily_avg.avg_exchange_rate = exchange_rate_avg;
     daily_avg.measurement_count = measurement_count;
-    daily_avg.std_deviation = std_deviation;
+    daily_avg.std_deviation = water.count >= 2 ? water.sample_std_deviation / 100.0 : 0.0;
     daily_avg.is_stable = is_stable;
     daily_avg.block_height = height;
     daily_avg.confidence_level = confidence_level;
     daily_avg.is_statistically_significant = is_statistically_significant;
     
-    // Store the daily average
-    StoreDailyAverage(daily_avg);
+    return daily_avg;
 }
 
 void MeasurementSystem::RecalculateCurrencyStability(int height) {
@@ -827,107 +824,6 @@ std::vector<DailyAverage> MeasurementSystem::GetDailyAveragesInRange(const std::
     return results;
 }
 
-// Helper functions for daily average calculations
-
-std::optional<double> MeasurementSystem::GetDailyAverageWaterPriceInternal(const std::string& currency, const std::string& date) const {
-    // Parse date to get start and end timestamps for the day
-    int64_t start_time = ParseDateToTimestamp(date);
-    int64_t end_time = start_time + 24 * 3600 - 1; // End of day
-    
-    std::vector<WaterPriceMeasurement> measurements = GetWaterPricesInRange(currency, start_time, end_time);
-    
-    if (measurements.empty()) {
-        return std::nullopt;
-    }
-    
-    std::vector<double> prices;
-    for (const auto& m : measurements) {
-        if (m.is_validated) {
-            prices.push_back(static_cast<double>(m.price) / 100.0); // Convert from cents
-        }
-    }
-    
-    if (prices.empty()) {
-        return std::nullopt;
-    }
-    
-    return CalculateGaussianAverage(prices);
-}
-
-std::optional<double> MeasurementSystem::GetDailyAverageExchangeRateInternal(const std::string& from_currency, const std::string& to_currency, const std::string& date) const {
-    // Parse date to get start and end timestamps for the day
-    int64_t start_time = ParseDateToTimestamp(date);
-    int64_t end_time = start_time + 24 * 3600 - 1; // End of day
-    
-    std::vector<ExchangeRateMeasurement> measurements = GetExchangeRatesInRange(from_currency, to_currency, start_time, end_time);
-    
-    if (measurements.empty()) {
-        return std::nullopt;
-    }
-    
-    std::vector<double> rates;
-    for (const auto& m : measurements) {
-        if (m.is_validated) {
-            rates.push_back(m.exchange_rate);
-        }
-    }
-    
-    if (rates.empty()) {
-        return std::nullopt;
-    }
-    
-    return CalculateGaussianAverage(rates);
-}
-
-int MeasurementSystem::GetDailyMeasurementCount(const std::string& currency, const std::string& date) const {
-    int64_t start_time = ParseDateToTimestamp(date);
-    int64_t end_time = start_time + 24 * 3600 - 1;
-    
-    std::vector<WaterPriceMeasurement> water_measurements = GetWaterPricesInRange(currency, start_time, end_time);
-    
-    int count = 0;
-    for (const auto& m : water_measurements) {
-        if (m.is_validated) count++;
-    }
-    
-    // Add exchange rate measurements if it's an O currency
-    if (IsOCurrency(currency)) {
-        std::string fiat_currency = GetCorrespondingFiatCurrency(currency);
-        std::vector<ExchangeRateMeasurement> exchange_measurements = GetExchangeRatesInRange(currency, fiat_currency, start_time, end_time);
-        
-        for (const auto& m : exchange_measurements) {
-            if (m.is_validated) count++;
-        }
-    }
-    
-    return count;
-}
-
-double MeasurementSystem::CalculateDailyStandardDeviation(const std::string& currency, const std::string& date) const {
-    int64_t start_time = ParseDateToTimestamp(date);
-    int64_t end_time = start_time + 24 * 3600 - 1;
-    
-    std::vector<WaterPriceMeasurement> measurements = GetWaterPricesInRange(currency, start_time, end_time);
-    
-    if (measurements.empty()) {
-        return 0.0;
-    }
-    
-    std::vector<double> prices;
-    for (const auto& m : measurements) {
-        if (m.is_validated) {
-            prices.push_back(static_cast<double>(m.price) / 100.0);
-        }
-    }
-    
-    if (prices.size() < 2) {
-        return 0.0;
-    }
-    
-    double mean = std::accumulate(prices.begin(), prices.end(), 0.0) / prices.size();
-    return CalculateStandardDeviation(prices, mean);
-}
-
 std::string MeasurementSystem::FormatDate(int64_t timestamp) const {
     // Simple date formatting - in practice, you'd use a proper date library
     time_t time = static_cast<time_t>(timestamp);
@@ -1689,8 +1585,8 @@ void MeasurementSystem::ProcessOOnlyCurrencyMeasurement(const std::string& curre
     measurement.confidence_score = 1.0; // Full confidence for O_ONLY measurements
     
     // Store in persistent database
-    if (g_measurement_db) {
-        g_measurement_db->WriteWaterPrice(measurement.measurement_id, measurement);
+    if (g_measurement_db && g_measurement_db->WriteWaterPrice(measurement.measurement_id, measurement)) {
+        g_measurement_stats.AddWaterPrice(measurement);
     }
     
     // Update O_ONLY stability tracking
@@ -0,0 +1,329 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <measurement/measurement_stats.h>
+#include <measurement/o_measurement_db.h>
+#include <logging.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace OMeasurement {
+
+MeasurementStatsCache g_measurement_stats;
+
+namespace {
+
+constexpr int64_t SECONDS_PER_DAY = 24 * 3600;
+
+int64_t DayOf(int64_t timestamp)
+{
+    return std::max<int64_t>(timestamp, 0) / SECONDS_PER_DAY;
+}
+
+} // namespace
+
+// ===== DailyAccumulator =====
+
+bool DailyAccumulator::Add(const uint256& id, double value, int64_t timestamp)
+{
+    if (!m_values.emplace(id, Entry{value, timestamp}).second) {
+        return false;  // Already counted
+    }
+
+    m_sorted.insert(std::upper_bound(m_sorted.begin(), m_sorted.end(), value), value);
+    m_sum += value;
+    m_sum_sq += value * value;
+    return true;
+}
+
+bool DailyAccumulator::Remove(const uint256& id)
+{
+    auto it = m_values.find(id);
+    if (it == m_values.end()) {
+        return false;
+    }
+
+    const double value = it->second.value;
+    m_values.erase(it);
+
+    auto sorted_it = std::lower_bound(m_sorted.begin(), m_sorted.end(), value);
+    if (sorted_it != m_sorted.end() && *sorted_it == value) {
+        m_sorted.erase(sorted_it);
+    }
+
+    if (m_values.empty()) {
+        // Reset instead of subtracting to avoid accumulating rounding error
+        m_sum = 0.0;
+        m_sum_sq = 0.0;
+    } else {
+        m_sum -= value;
+        m_sum_sq -= value * value;
+    }
+    return true;
+}
+
+DailyAccumulator DailyAccumulator::Slice(int64_t start_time, int64_t end_time) const
+{
+    DailyAccumulator slice;
+    for (const auto& [id, entry] : m_values) {
+        if (entry.timestamp >= start_time && entry.timestamp <= end_time) {
+            slice.Add(id, entry.value, entry.timestamp);
+        }
+    }
+    return slice;
+}
+
+WindowStatistics SummarizeBuckets(const std::vector<const DailyAccumulator*>& buckets)
+{
+    WindowStatistics stats;
+
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (const auto* bucket : buckets) {
+        stats.count += bucket->Count();
+        sum += bucket->Sum();
+        sum_sq += bucket->SumOfSquares();
+    }
+
+    if (stats.count == 0) {
+        return stats;
+    }
+
+    const double n = static_cast<double>(stats.count);
+    stats.mean = sum / n;
+
+    const double squared_deviation = std::max(0.0, sum_sq - n * stats.mean * stats.mean);
+    stats.std_deviation = std::sqrt(squared_deviation / n);
+    stats.sample_std_deviation = stats.count > 1 ? std::sqrt(squared_deviation / (n - 1)) : 0.0;
+
+    if (stats.count == 1) {
+        stats.gaussian_average = stats.mean;
+        return stats;
+    }
+
+    // Trim values further than GAUSSIAN_STD_THRESHOLD sample deviations from the
+    // mean. Only the tails of each sorted bucket are visited.
+    const double band = Config::GAUSSIAN_STD_THRESHOLD * stats.sample_std_deviation;
+    const double low = stats.mean - band;
+    const double high = stats.mean + band;
+
+    double kept_sum = sum;
+    int kept_count = stats.count;
+    for (const auto* bucket : buckets) {
+        const auto& sorted = bucket->SortedValues();
+        for (auto it = sorted.begin(); it != sorted.end() && *it < low; ++it) {
+            kept_sum -= *it;
+            kept_count--;
+        }
+        for (auto it = sorted.rbegin(); it != sorted.rend() && *it > high; ++it) {
+            kept_sum -= *it;
+            kept_count--;
+        }
+    }
+
+    stats.gaussian_average = kept_count > 0 ? kept_sum / kept_count : stats.mean;
+    return stats;
+}
+
+// ===== MeasurementStatsCache =====
+
+void MeasurementStatsCache::AddWaterPrice(const WaterPriceMeasurement& measurement)
+{
+    if (!measurement.is_validated) return;
+
+    LOCK(m_mutex);
+    Update({MeasurementType::WATER_PRICE, measurement.currency_code, ""}, measurement.timestamp,
+           measurement.measurement_id, static_cast<double>(measurement.price), true);
+}
+
+void MeasurementStatsCache::RemoveWaterPrice(const WaterPriceMeasurement& measurement)
+{
+    LOCK(m_mutex);
+    Update({MeasurementType::WATER_PRICE, measurement.currency_code, ""}, measurement.timestamp,
+           measurement.measurement_id, 0.0, false);
+}
+
+void MeasurementStatsCache::AddExchangeRate(const ExchangeRateMeasurement& measurement)
+{
+    if (!measurement.is_validated) return;
+
+    LOCK(m_mutex);
+    Update({MeasurementType::EXCHANGE_RATE, measurement.from_currency, measurement.to_currency},
+           measurement.timestamp, measurement.measurement_id, measurement.exchange_rate, true);
+}
+
+void MeasurementStatsCache::RemoveExchangeRate(const ExchangeRateMeasurement& measurement)
+{
+    LOCK(m_mutex);
+    Update({MeasurementType::EXCHANGE_RATE, measurement.from_currency, measurement.to_currency},
+           measurement.timestamp, measurement.measurement_id, 0.0, false);
+}
+
+WindowStatistics MeasurementStatsCache::GetWaterPriceStats(const std::string& currency, int64_t start_time, int64_t end_time)
+{
+    LOCK(m_mutex);
+    return Summarize({MeasurementType::WATER_PRICE, currency, ""}, start_time, end_time);
+}
+
+WindowStatistics MeasurementStatsCache::GetExchangeRateStats(const std::string& from_currency, const std::string& to_currency,
+                                                             int64_t start_time, int64_t end_time)
+{
+    LOCK(m_mutex);
+    return Summarize({MeasurementType::EXCHANGE_RATE, from_currency, to_currency}, start_time, end_time);
+}
+
+void MeasurementStatsCache::Clear()
+{
+    LOCK(m_mutex);
+    m_buckets.clear();
+    m_loaded_series.clear();
+}
+
+size_t MeasurementStatsCache::BucketCount() const
+{
+    LOCK(m_mutex);
+    return m_buckets.size();
+}
+
+void MeasurementStatsCache::Update(const SeriesKey& series, int64_t timestamp, const uint256& id, double value, bool add)
+{
+    // Series that were never queried are loaded from the database on first use
+    if (!m_loaded_series.count(series)) {
+        return;
+    }
+
+    const int64_t today = DayOf(GetTime());
+    EvictExpired(today);
+
+    const int64_t day = DayOf(timestamp);
+    if (day <= today - STATS_RETENTION_DAYS) {
+        return;
+    }
+
+    const auto& [type, currency, to_currency] = series;
+    BucketKey key{type, currency, to_currency, day};
+
+    if (add) {
+        m_buckets[key].Add(id, value, timestamp);
+        return;
+    }
+
+    auto it = m_buckets.find(key);
+    if (it != m_buckets.end() && it->second.Remove(id) && it->second.Count() == 0) {
+        m_buckets.erase(it);
+    }
+}
+
+void MeasurementStatsCache::LoadSeries(const SeriesKey& series)
+{
+    m_loaded_series.insert(series);
+    if (!g_measurement_db) {
+        return;
+    }
+
+    const int64_t today = DayOf(GetTime());
+    const int64_t start_time = (today - STATS_RETENTION_DAYS + 1) * SECONDS_PER_DAY;
+    const int64_t end_time = std::numeric_limits<int64_t>::max();
+    const auto& [type, currency, to_currency] = series;
+
+    size_t loaded = 0;
+    if (type == MeasurementType::WATER_PRICE) {
+        for (const auto& m : g_measurement_db->GetWaterPricesInRange(currency, start_time, end_time)) {
+            if (m.is_validated) {
+                m_buckets[BucketKey{type, currency, to_currency, DayOf(m.timestamp)}].Add(
+                    m.measurement_id, static_cast<double>(m.price), m.timestamp);
+                loaded++;
+            }
+        }
+    } else {
+        for (const auto& m : g_measurement_db->GetExchangeRatesInRange(currency, to_currency, start_time, end_time)) {
+            if (m.is_validated) {
+                m_buckets[BucketKey{type, currency, to_currency, DayOf(m.timestamp)}].Add(
+                    m.measurement_id, m.exchange_rate, m.timestamp);
+                loaded++;
+            }
+        }
+    }
+
+    LogDebug(BCLog::VALIDATION, "O Measurement Stats: Loaded %d measurements for %s%s%s\n",
+             loaded, currency, to_currency.empty() ? "" : "/", to_currency);
+}
+
+void MeasurementStatsCache::EvictExpired(int64_t today)
+{
+    if (today == m_last_eviction_day) {
+        return;
+    }
+    m_last_eviction_day = today;
+
+    for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+        if (std::get<3>(it->first) <= today - STATS_RETENTION_DAYS) {
+            it = m_buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+WindowStatistics MeasurementStatsCache::Summarize(const SeriesKey& series, int64_t start_time, int64_t end_time)
+{
+    if (end_time < start_time) {
+        return {};
+    }
+
+    const int64_t today = DayOf(GetTime());
+    const int64_t start_day = DayOf(start_time);
+    const int64_t end_day = DayOf(end_time);
+    const auto& [type, currency, to_currency] = series;
+
+    // Windows reaching past the retention horizon are computed from the
+    // database directly, using the same arithmetic as the cached buckets.
+    if (start_day <= today - STATS_RETENTION_DAYS) {
+        DailyAccumulator window;
+        if (g_measurement_db) {
+            if (type == MeasurementType::WATER_PRICE) {
+                for (const auto& m : g_measurement_db->GetWaterPricesInRange(currency, start_time, end_time)) {
+                    if (m.is_validated) window.Add(m.measurement_id, static_cast<double>(m.price), m.timestamp);
+                }
+            } else {
+                for (const auto& m : g_measurement_db->GetExchangeRatesInRange(currency, to_currency, start_time, end_time)) {
+                    if (m.is_validated) window.Add(m.measurement_id, m.exchange_rate, m.timestamp);
+                }
+            }
+        }
+        return SummarizeBuckets({&window});
+    }
+
+    if (!m_loaded_series.count(series)) {
+        LoadSeries(series);
+    }
+    EvictExpired(today);
+
+    // The first and last day of a window that is not day-aligned are only
+    // partly inside it, their buckets are sliced to the window
+    std::vector<DailyAccumulator> edges;
+    edges.reserve(2);
+    std::vector<const DailyAccumulator*> buckets;
+    for (auto it = m_buckets.lower_bound(BucketKey{type, currency, to_currency, start_day});
+         it != m_buckets.end(); ++it) {
+        const auto& [bucket_type, bucket_currency, bucket_to, bucket_day] = it->first;
+        if (bucket_type != type || bucket_currency != currency || bucket_to != to_currency || bucket_day > end_day) {
+            break;
+        }
+        const bool partial = (bucket_day == start_day && start_time > bucket_day * SECONDS_PER_DAY) ||
+                             (bucket_day == end_day && end_time < (bucket_day + 1) * SECONDS_PER_DAY - 1);
+        if (partial) {
+            buckets.push_back(&edges.emplace_back(it->second.Slice(start_time, end_time)));
+        } else {
+            buckets.push_back(&it->second);
+        }
+    }
+
+    return SummarizeBuckets(buckets);
+}
+
+} // namespace OMeasurement
@@ -0,0 +1,123 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MEASUREMENT_MEASUREMENT_STATS_H
+#define BITCOIN_MEASUREMENT_MEASUREMENT_STATS_H
+
+#include <measurement/measurement_system.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace OMeasurement {
+
+/** Days of history kept in memory; older windows are answered from the database */
+static constexpr int STATS_RETENTION_DAYS = 35;
+
+/** Summary of all validated measurements of one series over a time window */
+struct WindowStatistics {
+    int count{0};
+    double mean{0.0};
+    double std_deviation{0.0};        // Population standard deviation
+    double sample_std_deviation{0.0}; // Sample (n-1) standard deviation
+    double gaussian_average{0.0};     // Mean after trimming values beyond GAUSSIAN_STD_THRESHOLD
+};
+
+/**
+ * Running statistics for one (series, type, day) bucket.
+ *
+ * Keeps count, sum and sum of squares so that mean and deviation are O(1),
+ * plus a sorted sample so that outlier tails can be trimmed without
+ * touching the values in the middle of the distribution.
+ */
+class DailyAccumulator {
+public:
+    bool Add(const uint256& id, double value, int64_t timestamp);
+    bool Remove(const uint256& id);
+
+    /** The measurements of this bucket taken between start_time and end_time, inclusive */
+    DailyAccumulator Slice(int64_t start_time, int64_t end_time) const;
+
+    int Count() const { return static_cast<int>(m_values.size()); }
+    double Sum() const { return m_sum; }
+    double SumOfSquares() const { return m_sum_sq; }
+    const std::vector<double>& SortedValues() const { return m_sorted; }
+
+private:
+    struct Entry {
+        double value;
+        int64_t timestamp;
+    };
+
+    std::map<uint256, Entry> m_values; // Measurement id -> entry, for idempotent add/remove
+    std::vector<double> m_sorted;
+    double m_sum{0.0};
+    double m_sum_sq{0.0};
+};
+
+/**
+ * In-memory per-(currency, type, day) statistics for validated measurements.
+ *
+ * Updated as measurements are connected and reverted on disconnect, so that
+ * averages, deviations and confidence levels no longer re-fetch raw
+ * measurements from CMeasurementDB. A series is loaded from the database
+ * the first time it is queried (typically after startup); updates for
+ * series that were never queried are ignored until then.
+ *
+ * Water price series are keyed by currency code and hold the price in the
+ * smallest currency unit. Exchange rate series are keyed by the currency pair.
+ */
+class MeasurementStatsCache {
+public:
+    void AddWaterPrice(const WaterPriceMeasurement& measurement) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void RemoveWaterPrice(const WaterPriceMeasurement& measurement) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void AddExchangeRate(const ExchangeRateMeasurement& measurement) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void RemoveExchangeRate(const ExchangeRateMeasurement& measurement) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Statistics of validated water prices for a currency between start_time and end_time, inclusive */
+    WindowStatistics GetWaterPriceStats(const std::string& currency, int64_t start_time, int64_t end_time)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Statistics of validated exchange rates for a pair between start_time and end_time, inclusive */
+    WindowStatistics GetExchangeRateStats(const std::string& from_currency, const std::string& to_currency,
+                                          int64_t start_time, int64_t end_time) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Drop all cached state (e.g. after the measurement database was rebuilt) */
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Number of buckets currently held in memory */
+    size_t BucketCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    /** (type, currency, to_currency); to_currency is empty for water prices */
+    using SeriesKey = std::tuple<MeasurementType, std::string, std::string>;
+    using BucketKey = std::tuple<MeasurementType, std::string, std::string, int64_t>;
+
+    mutable Mutex m_mutex;
+    std::map<BucketKey, DailyAccumulator> m_buckets GUARDED_BY(m_mutex);
+    std::set<SeriesKey> m_loaded_series GUARDED_BY(m_mutex);
+    int64_t m_last_eviction_day GUARDED_BY(m_mutex){0};
+
+    void Update(const SeriesKey& series, int64_t timestamp, const uint256& id, double value, bool add)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void LoadSeries(const SeriesKey& series) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void EvictExpired(int64_t today) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    WindowStatistics Summarize(const SeriesKey& series, int64_t start_time, int64_t end_time)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+
+/** Compute window statistics from a set of running buckets */
+WindowStatistics SummarizeBuckets(const std::vector<const DailyAccumulator*>& buckets);
+
+/** Global running statistics instance */
+extern MeasurementStatsCache g_measurement_stats;
+
+} // namespace OMeasurement
+
+#endif // BITCOIN_MEASUREMENT_MEASUREMENT_STATS_H
@@ -618,6 +618,9 @@ public:
     /** Store daily average */
     void StoreDailyAverage(const DailyAverage& avg);
     
+    /** Store a set of daily averages, persisting them in one database batch */
+    void StoreDailyAverages(const std::vector<DailyAverage>& averages);
+    
     /** Calculate and store daily averages for all currencies */
     void CalculateDailyAverages(int height);
     
@@ -637,11 +640,7 @@ public:
 
 private:
     // Helper functions for daily average calculations
-    void CalculateDailyAverageForCurrency(const std::string& currency, const std::string& date, int height);
-    std::optional<double> GetDailyAverageWaterPriceInternal(const std::string& currency, const std::string& date) const;
-    std::optional<double> GetDailyAverageExchangeRateInternal(const std::string& from_currency, const std::string& to_currency, const std::string& date) const;
-    int GetDailyMeasurementCount(const std::string& currency, const std::string& date) const;
-    double CalculateDailyStandardDeviation(const std::string& currency, const std::string& date) const;
+    DailyAverage BuildDailyAverage(const std::string& currency, const std::string& date, int height) const;
     int64_t ParseDateToTimestamp(const std::string& date) const;
     
 public:
@@ -3,17 +3,449 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <measurement/o_measurement_db.h>
+#include <measurement/measurement_stats.h>
+#include <measurement/stability_snapshot.h>
 #include <common/args.h>
+#include <crypto/common.h>
+#include <hash.h>
 #include <logging.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
 #include <util/time.h>
 #include <streams.h>
 
+#include <algorithm>
+
 namespace OMeasurement {
 
 // Global instance (initialized in init.cpp)
 std::unique_ptr<CMeasurementDB> g_measurement_db;
 
+namespace {
+
+/** Flush index rebuild batches once they grow past this size */
+constexpr size_t INDEX_BATCH_FLUSH_SIZE = 16 << 20;
+
+/**
+ * Secondary index keys. Integers are written big-endian so that LevelDB's
+ * lexicographic ordering matches numeric ordering, which turns time and
+ * height range queries into a single bounded seek. Negative values are
+ * clamped to zero since they never occur for valid measurements.
+ */
+struct CurrencyTimeKey {
+    std::string currency;
+    uint64_t timestamp{0};
+    uint256 id;
+
+    CurrencyTimeKey() = default;
+    CurrencyTimeKey(const std::string& currency_in, int64_t timestamp_in, const uint256& id_in)
+        : currency(currency_in), timestamp(std::max<int64_t>(timestamp_in, 0)), id(id_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_WATER_BY_CURRENCY);
+        s << currency << Using<BigEndianFormatter<8>>(timestamp) << id;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_WATER_BY_CURRENCY) {
+            throw std::ios_base::failure("Invalid format for water price currency index key");
+        }
+        s >> currency >> Using<BigEndianFormatter<8>>(timestamp) >> id;
+    }
+};
+
+struct PairTimeKey {
+    std::string from_currency;
+    std::string to_currency;
+    uint64_t timestamp{0};
+    uint256 id;
+
+    PairTimeKey() = default;
+    PairTimeKey(const std::string& from_in, const std::string& to_in, int64_t timestamp_in, const uint256& id_in)
+        : from_currency(from_in), to_currency(to_in), timestamp(std::max<int64_t>(timestamp_in, 0)), id(id_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_EXCHANGE_BY_PAIR);
+        s << from_currency << to_currency << Using<BigEndianFormatter<8>>(timestamp) << id;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_EXCHANGE_BY_PAIR) {
+            throw std::ios_base::failure("Invalid format for exchange rate pair index key");
+        }
+        s >> from_currency >> to_currency >> Using<BigEndianFormatter<8>>(timestamp) >> id;
+    }
+};
+
+struct HeightKey {
+    uint8_t prefix{0};
+    uint32_t height{0};
+    uint256 id;
+
+    explicit HeightKey(uint8_t prefix_in) : prefix(prefix_in) {}
+    HeightKey(uint8_t prefix_in, int height_in, const uint256& id_in)
+        : prefix(prefix_in), height(std::max(height_in, 0)), id(id_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        ser_writedata32be(s, height);
+        s << id;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != prefix) {
+            throw std::ios_base::failure("Invalid format for measurement height index key");
+        }
+        height = ser_readdata32be(s);
+        s >> id;
+    }
+};
+
+struct SubmitterKey {
+    uint8_t prefix{0};
+    CPubKey submitter;
+    uint256 id;
+
+    explicit SubmitterKey(uint8_t prefix_in) : prefix(prefix_in) {}
+    SubmitterKey(uint8_t prefix_in, const CPubKey& submitter_in, const uint256& id_in)
+        : prefix(prefix_in), submitter(submitter_in), id(id_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        s << submitter << id;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != prefix) {
+            throw std::ios_base::failure("Invalid format for measurement submitter index key");
+        }
+        s >> submitter >> id;
+    }
+};
+
+/** Invites of a user, ordered by expiry so expired ones can be skipped with one seek */
+struct InviteUserKey {
+    CPubKey user;
+    uint64_t expires_at{0};
+    uint256 id;
+
+    InviteUserKey() = default;
+    InviteUserKey(const CPubKey& user_in, int64_t expires_at_in, const uint256& id_in)
+        : user(user_in), expires_at(std::max<int64_t>(expires_at_in, 0)), id(id_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_INVITE_BY_USER);
+        s << user << Using<BigEndianFormatter<8>>(expires_at) << id;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_INVITE_BY_USER) {
+            throw std::ios_base::failure("Invalid format for invite user index key");
+        }
+        s >> user >> Using<BigEndianFormatter<8>>(expires_at) >> id;
+    }
+};
+
+/**
+ * Invites ordered by the time from which they can be pruned: their expiry,
+ * or zero once used. The value names the user index entry, so pruning never
+ * reads the invites themselves.
+ */
+struct InviteExpiryKey {
+    uint64_t prune_time{0};
+    uint256 id;
+
+    InviteExpiryKey() = default;
+    InviteExpiryKey(int64_t prune_time_in, const uint256& id_in)
+        : prune_time(std::max<int64_t>(prune_time_in, 0)), id(id_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_INVITE_BY_EXPIRY);
+        s << Using<BigEndianFormatter<8>>(prune_time) << id;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_INVITE_BY_EXPIRY) {
+            throw std::ios_base::failure("Invalid format for invite expiry index key");
+        }
+        s >> Using<BigEndianFormatter<8>>(prune_time) >> id;
+    }
+};
+
+/** Index entries carry no payload; the primary record is looked up by id */
+constexpr uint8_t INDEX_PRESENT{1};
+
+int64_t InvitePruneTime(const MeasurementInvite& invite)
+{
+    return invite.is_used ? 0 : invite.expires_at;
+}
+
+void WriteInviteIndexes(CDBBatch& batch, const uint256& id, const MeasurementInvite& invite)
+{
+    batch.Write(InviteUserKey(invite.invited_user, invite.expires_at, id), INDEX_PRESENT);
+    batch.Write(InviteExpiryKey(InvitePruneTime(invite), id), std::make_pair(invite.invited_user, invite.expires_at));
+}
+
+void EraseInviteIndexes(CDBBatch& batch, const uint256& id, const MeasurementInvite& invite)
+{
+    batch.Erase(InviteUserKey(invite.invited_user, invite.expires_at, id));
+    batch.Erase(InviteExpiryKey(InvitePruneTime(invite), id));
+}
+
+/** Read the invites of a user expiring at or after first_expiry, through the user index */
+std::vector<MeasurementInvite> ReadUserInvites(CDBWrapper& db, const CPubKey& user, int64_t first_expiry, bool active_only)
+{
+    std::vector<MeasurementInvite> user_invites;
+    std::unique_ptr<CDBIterator> iterator(db.NewIterator());
+    
+    for (iterator->Seek(InviteUserKey(user, first_expiry, uint256{})); iterator->Valid(); iterator->Next()) {
+        InviteUserKey key;
+        if (!iterator->GetKey(key) || key.user != user) {
+            break;
+        }
+        
+        MeasurementInvite invite;
+        if (!db.Read(std::make_pair(DB_INVITE, key.id), invite)) {
+            continue;
+        }
+        if (!active_only || (!invite.is_used && !invite.is_expired)) {
+            user_invites.push_back(std::move(invite));
+        }
+    }
+    
+    return user_invites;
+}
+
+void WriteWaterIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const WaterPriceMeasurement& m)
+{
+    counters.AddWaterPrice(m);
+    batch.Write(CurrencyTimeKey(m.currency_code, m.timestamp, id), INDEX_PRESENT);
+    batch.Write(HeightKey(DB_WATER_BY_HEIGHT, m.block_height, id), INDEX_PRESENT);
+    batch.Write(SubmitterKey(DB_WATER_BY_SUBMITTER, m.submitter, id), INDEX_PRESENT);
+    if (!m.is_validated) {
+        batch.Write(std::make_pair(DB_WATER_UNVALIDATED, id), INDEX_PRESENT);
+    }
+}
+
+void EraseWaterIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const WaterPriceMeasurement& m)
+{
+    counters.RemoveWaterPrice(m);
+    batch.Erase(CurrencyTimeKey(m.currency_code, m.timestamp, id));
+    batch.Erase(HeightKey(DB_WATER_BY_HEIGHT, m.block_height, id));
+    batch.Erase(SubmitterKey(DB_WATER_BY_SUBMITTER, m.submitter, id));
+    if (!m.is_validated) {
+        batch.Erase(std::make_pair(DB_WATER_UNVALIDATED, id));
+    }
+}
+
+void WriteExchangeIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const ExchangeRateMeasurement& m)
+{
+    counters.AddExchangeRate(m);
+    batch.Write(PairTimeKey(m.from_currency, m.to_currency, m.timestamp, id), INDEX_PRESENT);
+    batch.Write(HeightKey(DB_EXCHANGE_BY_HEIGHT, m.block_height, id), INDEX_PRESENT);
+    batch.Write(SubmitterKey(DB_EXCHANGE_BY_SUBMITTER, m.submitter, id), INDEX_PRESENT);
+    if (!m.is_validated) {
+        batch.Write(std::make_pair(DB_EXCHANGE_UNVALIDATED, id), INDEX_PRESENT);
+    }
+}
+
+void EraseExchangeIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const ExchangeRateMeasurement& m)
+{
+    counters.RemoveExchangeRate(m);
+    batch.Erase(PairTimeKey(m.from_currency, m.to_currency, m.timestamp, id));
+    batch.Erase(HeightKey(DB_EXCHANGE_BY_HEIGHT, m.block_height, id));
+    batch.Erase(SubmitterKey(DB_EXCHANGE_BY_SUBMITTER, m.submitter, id));
+    if (!m.is_validated) {
+        batch.Erase(std::make_pair(DB_EXCHANGE_UNVALIDATED, id));
+    }
+}
+
+/** Overloads so the export/import code can be shared by both measurement types */
+void WriteIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const WaterPriceMeasurement& m) { WriteWaterIndexes(batch, counters, id, m); }
+void WriteIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const ExchangeRateMeasurement& m) { WriteExchangeIndexes(batch, counters, id, m); }
+void EraseIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const WaterPriceMeasurement& m) { EraseWaterIndexes(batch, counters, id, m); }
+void EraseIndexes(CDBBatch& batch, MeasurementCounters& counters, const uint256& id, const ExchangeRateMeasurement& m) { EraseExchangeIndexes(batch, counters, id, m); }
+
+/**
+ * Measurement dump file layout:
+ *
+ *   header:  magic, format version, measurement type, creation time, header checksum
+ *   records: CompactSize length followed by the serialized measurement, repeated
+ *   trailer: CompactSize 0, record count, hash over all record bytes
+ *
+ * The format only depends on measurement serialization, not on the LevelDB
+ * key layout, so dumps survive index and keyspace changes.
+ */
+constexpr uint32_t EXPORT_MAGIC = 0x584d444f; // "OMDX" little-endian
+constexpr uint32_t EXPORT_FORMAT_VERSION = 1;
+
+struct ExportHeader {
+    uint32_t magic{EXPORT_MAGIC};
+    uint32_t format_version{EXPORT_FORMAT_VERSION};
+    uint8_t type{0};
+    int64_t created_at{0};
+
+    SERIALIZE_METHODS(ExportHeader, obj) { READWRITE(obj.magic, obj.format_version, obj.type, obj.created_at); }
+
+    uint32_t Checksum() const
+    {
+        HashWriter hasher{};
+        hasher << *this;
+        return ReadLE32(hasher.GetHash().begin());
+    }
+};
+
+template <typename Measurement>
+uint64_t WriteExportRecords(CDBWrapper& db, uint8_t prefix, AutoFile& file)
+{
+    HashWriter payload{};
+    uint64_t count = 0;
+    DataStream record;
+    std::unique_ptr<CDBIterator> iterator(db.NewIterator());
+
+    // Records are streamed one at a time; the iterator reads from a consistent snapshot
+    for (iterator->Seek(prefix); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!iterator->GetKey(key) || key.first != prefix) {
+            break;
+        }
+
+        Measurement measurement;
+        if (!iterator->GetValue(measurement)) {
+            continue;
+        }
+
+        record.clear();
+        record << measurement;
+        WriteCompactSize(file, record.size());
+        file.write(std::span<const std::byte>{record.data(), record.size()});
+        payload.write(std::span<const std::byte>{record.data(), record.size()});
+        count++;
+    }
+
+    WriteCompactSize(file, 0);
+    file << count << payload.GetHash();
+    return count;
+}
+
+/** Read the next record of a dump into record, false at the trailer */
+bool ReadImportRecord(AutoFile& file, DataStream& record)
+{
+    uint64_t size = ReadCompactSize(file);
+    if (size == 0) {
+        return false;
+    }
+
+    record.clear();
+    record.resize(size);
+    file.read(std::span<std::byte>{record.data(), record.size()});
+    return true;
+}
+
+/**
+ * Check the records of a dump against its trailer, one record at a time.
+ * Returns the number of records.
+ */
+template <typename Measurement>
+uint64_t VerifyImportRecords(AutoFile& file)
+{
+    HashWriter payload{};
+    uint64_t count = 0;
+    DataStream record;
+
+    while (ReadImportRecord(file, record)) {
+        payload.write(std::span<const std::byte>{record.data(), record.size()});
+
+        Measurement measurement;
+        record >> measurement;
+        count++;
+    }
+
+    uint64_t expected_count;
+    uint256 expected_hash;
+    file >> expected_count >> expected_hash;
+    if (expected_count != count || expected_hash != payload.GetHash()) {
+        throw std::runtime_error(strprintf("trailer mismatch (%d records read, %d expected)", count, expected_count));
+    }
+    return count;
+}
+
+/**
+ * Write the records of a verified dump and their indexes. Records are
+ * streamed into batches of about INDEX_BATCH_FLUSH_SIZE, each written with
+ * the counters it leaves behind, and the last one is synced. A record the
+ * dump repeats ends up as its last copy.
+ */
+template <typename Measurement>
+bool WriteImportRecords(CDBWrapper& db, uint8_t prefix, AutoFile& file, MeasurementCounters& committed)
+{
+    CDBBatch batch(db);
+    MeasurementCounters counters = committed;
+    DataStream record;
+
+    // Records in the unwritten batch, which the database cannot return yet
+    std::map<uint256, Measurement> pending;
+
+    while (ReadImportRecord(file, record)) {
+        Measurement measurement;
+        record >> measurement;
+        const uint256 id = measurement.measurement_id;
+
+        Measurement previous;
+        if (auto it = pending.find(id); it != pending.end()) {
+            EraseIndexes(batch, counters, id, it->second);
+        } else if (db.Read(std::make_pair(prefix, id), previous)) {
+            EraseIndexes(batch, counters, id, previous);
+        }
+        batch.Write(std::make_pair(prefix, id), measurement);
+        WriteIndexes(batch, counters, id, measurement);
+        pending.insert_or_assign(id, std::move(measurement));
+
+        if (batch.ApproximateSize() > INDEX_BATCH_FLUSH_SIZE) {
+            batch.Write(DB_MEASUREMENT_STATS, counters);
+            if (!db.WriteBatch(batch)) {
+                return false;
+            }
+            committed = counters;
+            batch.Clear();
+            pending.clear();
+        }
+    }
+
+    batch.Write(DB_MEASUREMENT_STATS, counters);
+    if (!db.WriteBatch(batch, true)) {
+        return false;
+    }
+    committed = counters;
+    return true;
+}
+
+} // namespace
+
 CMeasurementDB::CMeasurementDB(size_t cache_size, bool memory_only, bool wipe_data)
 {
     DBParams db_params;
@@ -31,10 +463,157 @@ CMeasurementDB::CMeasurementDB(size_t cache_size, bool memory_only, bool wipe_da
         LogPrintf("O Measurement DB: Error opening database: %s\n", e.what());
         throw;
     }
+    
+    UpgradeIndexes();
+    
+    LOCK(m_db_mutex);
+    m_db->Read(DB_MEASUREMENT_STATS, m_counters);
 }
 
 CMeasurementDB::~CMeasurementDB() = default;
 
+void MeasurementCounters::AddWaterPrice(const WaterPriceMeasurement& m)
+{
+    water_price_count++;
+    water_price_count_by_currency[m.currency_code]++;
+}
+
+void MeasurementCounters::RemoveWaterPrice(const WaterPriceMeasurement& m)
+{
+    if (water_price_count > 0) water_price_count--;
+    auto it = water_price_count_by_currency.find(m.currency_code);
+    if (it != water_price_count_by_currency.end() && --it->second == 0) {
+        water_price_count_by_currency.erase(it);
+    }
+}
+
+bool CMeasurementDB::WriteBatchWithCounters(CDBBatch& batch, const MeasurementCounters& counters)
+{
+    batch.Write(DB_MEASUREMENT_STATS, counters);
+    if (!CommitBatch(batch)) {
+        return false;
+    }
+    m_counters = counters;
+    return true;
+}
+
+bool CMeasurementDB::CommitBatch(CDBBatch& batch)
+{
+    AssertLockHeld(m_db_mutex);
+    const bool defer{OConsensus::ODeferSyncScope::Active()};
+    if (!m_db->WriteBatch(batch, !defer)) {
+        return false;
+    }
+    m_unsynced = defer;
+    return true;
+}
+
+bool CMeasurementDB::Sync()
+{
+    LOCK(m_db_mutex);
+    if (!m_unsynced) {
+        return true;
+    }
+    
+    // A synced write flushes the log including all earlier unsynced writes
+    CDBBatch batch(*m_db);
+    if (!m_db->WriteBatch(batch, true)) {
+        LogPrintf("O Measurement DB: Failed to sync deferred writes\n");
+        return false;
+    }
+    m_unsynced = false;
+    return true;
+}
+
+void CMeasurementDB::UpgradeIndexes()
+{
+    LOCK(m_db_mutex);
+    
+    int version = 0;
+    if (m_db->Read(DB_MEASUREMENT_VERSION, version) && version >= MEASUREMENT_DB_VERSION) {
+        return;
+    }
+    
+    if (m_db->IsEmpty()) {
+        m_db->Write(DB_MEASUREMENT_VERSION, MEASUREMENT_DB_VERSION, true);
+        return;
+    }
+    
+    LogPrintf("O Measurement DB: Upgrading database from version %d to %d, rebuilding indexes\n",
+              version, MEASUREMENT_DB_VERSION);
+    
+    CDBBatch batch(*m_db);
+    MeasurementCounters counters; // Recounted from scratch alongside the indexes
+    size_t indexed_water = 0;
+    size_t indexed_exchange = 0;
+    size_t indexed_invites = 0;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    // Index writes are idempotent, so every index is rebuilt regardless of
+    // which version the database was left at.
+    for (iterator->Seek(DB_WATER_PRICE); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!iterator->GetKey(key) || key.first != DB_WATER_PRICE) {
+            break;
+        }
+        
+        WaterPriceMeasurement measurement;
+        if (iterator->GetValue(measurement)) {
+            WriteWaterIndexes(batch, counters, key.second, measurement);
+            indexed_water++;
+        }
+        
+        if (batch.ApproximateSize() > INDEX_BATCH_FLUSH_SIZE) {
+            m_db->WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    
+    for (iterator->Seek(DB_EXCHANGE_RATE); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!iterator->GetKey(key) || key.first != DB_EXCHANGE_RATE) {
+            break;
+        }
+        
+        ExchangeRateMeasurement measurement;
+        if (iterator->GetValue(measurement)) {
+            WriteExchangeIndexes(batch, counters, key.second, measurement);
+            indexed_exchange++;
+        }
+        
+        if (batch.ApproximateSize() > INDEX_BATCH_FLUSH_SIZE) {
+            m_db->WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    
+    for (iterator->Seek(DB_INVITE); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!iterator->GetKey(key) || key.first != DB_INVITE) {
+            break;
+        }
+        
+        MeasurementInvite invite;
+        if (iterator->GetValue(invite)) {
+            WriteInviteIndexes(batch, key.second, invite);
+            indexed_invites++;
+        }
+        
+        if (batch.ApproximateSize() > INDEX_BATCH_FLUSH_SIZE) {
+            m_db->WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    
+    // The version is written last so an interrupted upgrade is simply redone
+    batch.Write(DB_MEASUREMENT_STATS, counters);
+    batch.Write(DB_MEASUREMENT_VERSION, MEASUREMENT_DB_VERSION);
+    m_db->WriteBatch(batch, true);
+    
+    LogPrintf("O Measurement DB: Indexed %d water prices, %d exchange rates and %d invites\n",
+              indexed_water, indexed_exchange, indexed_invites);
+}
+
 // ===== Water Price Measurement Operations =====
 
 bool CMeasurementDB::WriteWaterPrice(const uint256& measurement_id, const WaterPriceMeasurement& measurement)
@@ -42,9 +621,18 @@ bool CMeasurementDB::WriteWaterPrice(const uint256& measurement_id, const WaterP
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    MeasurementCounters counters = m_counters;
+    
+    // Drop index entries of any record being overwritten
+    WaterPriceMeasurement previous;
+    if (m_db->Read(std::make_pair(DB_WATER_PRICE, measurement_id), previous)) {
+        EraseWaterIndexes(batch, counters, measurement_id, previous);
+    }
+    
     batch.Write(std::make_pair(DB_WATER_PRICE, measurement_id), measurement);
+    WriteWaterIndexes(batch, counters, measurement_id, measurement);
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success) {
         LogDebug(BCLog::NET, "O Measurement DB: Wrote water price %s for %s (price: %d)\n",
@@ -77,9 +665,16 @@ bool CMeasurementDB::EraseWaterPrice(const uint256& measurement_id)
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    MeasurementCounters counters = m_counters;
+    
+    WaterPriceMeasurement previous;
+    if (m_db->Read(std::make_pair(DB_WATER_PRICE, measurement_id), previous)) {
+        EraseWaterIndexes(batch, counters, measurement_id, previous);
+    }
+    
     batch.Erase(std::make_pair(DB_WATER_PRICE, measurement_id));
     
-    return m_db->WriteBatch(batch, true);
+    return WriteBatchWithCounters(batch, counters);
 }
 
 std::vector<WaterPriceMeasurement> CMeasurementDB::GetWaterPricesInRange(
@@ -88,21 +683,22 @@ std::vector<WaterPriceMeasurement> CMeasurementDB::GetWaterPricesInRange(
     LOCK(m_db_mutex);
     
     std::vector<WaterPriceMeasurement> measurements;
+    if (end_time < start_time) {
+        return measurements;
+    }
+    
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    const CurrencyTimeKey end_key(currency, end_time, uint256{});
     
-    for (iterator->Seek(DB_WATER_PRICE); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_WATER_PRICE) {
+    for (iterator->Seek(CurrencyTimeKey(currency, start_time, uint256{})); iterator->Valid(); iterator->Next()) {
+        CurrencyTimeKey key;
+        if (!iterator->GetKey(key) || key.currency != currency || key.timestamp > end_key.timestamp) {
             break;
         }
         
         WaterPriceMeasurement measurement;
-        if (iterator->GetValue(measurement)) {
-            if (measurement.currency_code == currency &&
-                measurement.timestamp >= start_time &&
-                measurement.timestamp <= end_time) {
-                measurements.push_back(measurement);
-            }
+        if (m_db->Read(std::make_pair(DB_WATER_PRICE, key.id), measurement)) {
+            measurements.push_back(std::move(measurement));
         }
     }
     
@@ -127,9 +723,18 @@ bool CMeasurementDB::WriteExchangeRate(const uint256& measurement_id, const Exch
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    MeasurementCounters counters = m_counters;
+    
+    // Drop index entries of any record being overwritten
+    ExchangeRateMeasurement previous;
+    if (m_db->Read(std::make_pair(DB_EXCHANGE_RATE, measurement_id), previous)) {
+        EraseExchangeIndexes(batch, counters, measurement_id, previous);
+    }
+    
     batch.Write(std::make_pair(DB_EXCHANGE_RATE, measurement_id), measurement);
+    WriteExchangeIndexes(batch, counters, measurement_id, measurement);
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success) {
         LogDebug(BCLog::NET, "O Measurement DB: Wrote exchange rate %s (%s/%s: %.6f)\n",
@@ -163,9 +768,16 @@ bool CMeasurementDB::EraseExchangeRate(const uint256& measurement_id)
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    MeasurementCounters counters = m_counters;
+    
+    ExchangeRateMeasurement previous;
+    if (m_db->Read(std::make_pair(DB_EXCHANGE_RATE, measurement_id), previous)) {
+        EraseExchangeIndexes(batch, counters, measurement_id, previous);
+    }
+    
     batch.Erase(std::make_pair(DB_EXCHANGE_RATE, measurement_id));
     
-    return m_db->WriteBatch(batch, true);
+    return WriteBatchWithCounters(batch, counters);
 }
 
 std::vector<ExchangeRateMeasurement> CMeasurementDB::GetExchangeRatesInRange(
@@ -175,22 +787,23 @@ std::vector<ExchangeRateMeasurement> CMeasurementDB::GetExchangeRatesInRange(
     LOCK(m_db_mutex);
     
     std::vector<ExchangeRateMeasurement> measurements;
+    if (end_time < start_time) {
+        return measurements;
+    }
+    
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    const PairTimeKey end_key(from_currency, to_currency, end_time, uint256{});
     
-    for (iterator->Seek(DB_EXCHANGE_RATE); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_EXCHANGE_RATE) {
+    for (iterator->Seek(PairTimeKey(from_currency, to_currency, start_time, uint256{})); iterator->Valid(); iterator->Next()) {
+        PairTimeKey key;
+        if (!iterator->GetKey(key) || key.from_currency != from_currency ||
+            key.to_currency != to_currency || key.timestamp > end_key.timestamp) {
             break;
         }
         
         ExchangeRateMeasurement measurement;
-        if (iterator->GetValue(measurement)) {
-            if (measurement.from_currency == from_currency &&
-                measurement.to_currency == to_currency &&
-                measurement.timestamp >= start_time &&
-                measurement.timestamp <= end_time) {
-                measurements.push_back(measurement);
-            }
+        if (m_db->Read(std::make_pair(DB_EXCHANGE_RATE, key.id), measurement)) {
+            measurements.push_back(std::move(measurement));
         }
     }
     
@@ -215,9 +828,18 @@ bool CMeasurementDB::WriteInvite(const uint256& invite_id, const MeasurementInvi
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    
+    // Drop index entries of any invite being overwritten
+    MeasurementInvite previous;
+    if (m_db->Read(std::make_pair(DB_INVITE, invite_id), previous)) {
+        EraseInviteIndexes(batch, invite_id, previous);
+    }
+    
     batch.Write(std::make_pair(DB_INVITE, invite_id), invite);
+    WriteInviteIndexes(batch, invite_id, invite);
+    m_invite_cache.Erase(invite_id);
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = CommitBatch(batch);
     
     if (success) {
         LogDebug(BCLog::NET, "O Measurement DB: Wrote invite %s for user %s\n",
@@ -274,31 +896,26 @@ bool CMeasurementDB::EraseInvite(const uint256& invite_id)
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    MeasurementInvite previous;
+    if (m_db->Read(std::make_pair(DB_INVITE, invite_id), previous)) {
+        EraseInviteIndexes(batch, invite_id, previous);
+    }
     batch.Erase(std::make_pair(DB_INVITE, invite_id));
+    m_invite_cache.Erase(invite_id);
     
-    return m_db->WriteBatch(batch, true);
+    return CommitBatch(batch);
 }
 
 std::vector<MeasurementInvite> CMeasurementDB::GetUserInvites(const CPubKey& user) const
 {
     LOCK(m_db_mutex);
-    
-    std::vector<MeasurementInvite> user_invites;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
-    
-    for (iterator->Seek(DB_INVITE); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_INVITE) {
-            break;
-        }
-        
-        MeasurementInvite invite;
-        if (iterator->GetValue(invite) && invite.invited_user == user) {
-            user_invites.push_back(invite);
-        }
-    }
-    
-    return user_invites;
+    return ReadUserInvites(*m_db, user, /*first_expiry=*/0, /*active_only=*/false);
+}
+
+std::vector<MeasurementInvite> CMeasurementDB::GetActiveUserInvites(const CPubKey& user, int64_t current_time) const
+{
+    LOCK(m_db_mutex);
+    return ReadUserInvites(*m_db, user, std::max<int64_t>(current_time, 0) + 1, /*active_only=*/true);
 }
 
 std::vector<MeasurementInvite> CMeasurementDB::GetActiveInvites() const
@@ -327,6 +944,28 @@ std::vector<MeasurementInvite> CMeasurementDB::GetActiveInvites() const
     return active_invites;
 }
 
+InviteStatus CMeasurementDB::GetInviteStatus(const uint256& invite_id) const
+{
+    if (auto cached = m_invite_cache.Get(invite_id)) {
+        return cached.value();
+    }
+    
+    // Filled under the lock that writers hold while invalidating
+    LOCK(m_db_mutex);
+    
+    InviteStatus status;
+    MeasurementInvite invite;
+    if (m_db->Read(std::make_pair(DB_INVITE, invite_id), invite)) {
+        status.exists = true;
+        status.invited_user = invite.invited_user;
+        status.expires_at = invite.expires_at;
+        status.is_used = invite.is_used;
+    }
+    m_invite_cache.Put(invite_id, status);
+    
+    return status;
+}
+
 // ===== Validated URL Operations =====
 
 bool CMeasurementDB::WriteValidatedURL(const uint256& url_id, const ValidatedURL& url)
@@ -336,7 +975,7 @@ bool CMeasurementDB::WriteValidatedURL(const uint256& url_id, const ValidatedURL
     CDBBatch batch(*m_db);
     batch.Write(std::make_pair(DB_VALIDATED_URL, url_id), url);
     
-    return m_db->WriteBatch(batch, true);
+    return CommitBatch(batch);
 }
 
 std::optional<ValidatedURL> CMeasurementDB::ReadValidatedURL(const uint256& url_id) const
@@ -417,7 +1056,7 @@ bool CMeasurementDB::WriteDailyAverage(const std::string& currency, const std::s
     CDBBatch batch(*m_db);
     batch.Write(std::make_pair(DB_DAILY_AVERAGE, key), average);
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = CommitBatch(batch);
     
     if (success) {
         LogDebug(BCLog::NET, "O Measurement DB: Wrote daily average %s/%s (price: %.2f, count: %d)\n",
@@ -472,6 +1111,25 @@ std::vector<DailyAverage> CMeasurementDB::GetDailyAveragesInRange(
     return averages;
 }
 
+bool CMeasurementDB::BatchWriteDailyAverages(const std::vector<DailyAverage>& averages)
+{
+    LOCK(m_db_mutex);
+    
+    CDBBatch batch(*m_db);
+    
+    for (const auto& average : averages) {
+        batch.Write(std::make_pair(DB_DAILY_AVERAGE, average.currency_code + "_" + average.date), average);
+    }
+    
+    bool success = CommitBatch(batch);
+    
+    if (success) {
+        LogDebug(BCLog::NET, "O Measurement DB: Batch wrote %d daily averages\n", averages.size());
+    }
+    
+    return success;
+}
+
 std::vector<DailyAverage> CMeasurementDB::GetRecentDailyAverages(const std::string& currency, int days) const
 {
     // TODO: Calculate actual date strings for range query
@@ -502,6 +1160,94 @@ std::vector<DailyAverage> CMeasurementDB::GetRecentDailyAverages(const std::stri
     return averages;
 }
 
+// ===== Block Undo Operations =====
+
+bool CMeasurementDB::WriteBlockUndo(const uint256& block_hash, int height, const std::vector<unsigned char>& undo)
+{
+    LOCK(m_db_mutex);
+    
+    CDBBatch batch(*m_db);
+    batch.Write(std::make_pair(DB_BLOCK_UNDO, block_hash), undo);
+    batch.Write(HeightKey(DB_BLOCK_UNDO_BY_HEIGHT, height, block_hash), INDEX_PRESENT);
+    
+    return CommitBatch(batch);
+}
+
+std::optional<std::vector<unsigned char>> CMeasurementDB::ReadBlockUndo(const uint256& block_hash) const
+{
+    LOCK(m_db_mutex);
+    
+    std::vector<unsigned char> undo;
+    if (m_db->Read(std::make_pair(DB_BLOCK_UNDO, block_hash), undo)) {
+        return undo;
+    }
+    return std::nullopt;
+}
+
+bool CMeasurementDB::HasBlockUndo(const uint256& block_hash) const
+{
+    LOCK(m_db_mutex);
+    return m_db->Exists(std::make_pair(DB_BLOCK_UNDO, block_hash));
+}
+
+bool CMeasurementDB::EraseBlockUndo(const uint256& block_hash, int height)
+{
+    LOCK(m_db_mutex);
+    
+    CDBBatch batch(*m_db);
+    batch.Erase(std::make_pair(DB_BLOCK_UNDO, block_hash));
+    batch.Erase(HeightKey(DB_BLOCK_UNDO_BY_HEIGHT, height, block_hash));
+    
+    return CommitBatch(batch);
+}
+
+bool CMeasurementDB::PruneBlockUndo(int height)
+{
+    LOCK(m_db_mutex);
+    
+    const int pruned_height = GetBlockUndoPrunedHeight();
+    if (height <= pruned_height) {
+        return true;
+    }
+    
+    CDBBatch batch(*m_db);
+    size_t pruned = 0;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    
+    for (iterator->Seek(HeightKey(DB_BLOCK_UNDO_BY_HEIGHT, pruned_height, uint256{})); iterator->Valid(); iterator->Next()) {
+        HeightKey key(DB_BLOCK_UNDO_BY_HEIGHT);
+        if (!iterator->GetKey(key) || key.height >= static_cast<uint32_t>(height)) {
+            break;
+        }
+        batch.Erase(std::make_pair(DB_BLOCK_UNDO, key.id));
+        batch.Erase(key);
+        pruned++;
+        
+        if (batch.ApproximateSize() > INDEX_BATCH_FLUSH_SIZE) {
+            m_db->WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    
+    // The height is written last so an interrupted prune is simply redone
+    batch.Write(DB_BLOCK_UNDO_PRUNED, height);
+    if (!CommitBatch(batch)) {
+        return false;
+    }
+    
+    LogDebug(BCLog::NET, "O Measurement DB: Pruned %d block undo records below height %d\n", pruned, height);
+    return true;
+}
+
+int CMeasurementDB::GetBlockUndoPrunedHeight() const
+{
+    LOCK(m_db_mutex);
+    
+    int height = 0;
+    m_db->Read(DB_BLOCK_UNDO_PRUNED, height);
+    return height;
+}
+
 // ===== Batch Operations =====
 
 bool CMeasurementDB::BatchWriteWaterPrices(const std::vector<std::pair<uint256, WaterPriceMeasurement>>& batch)
@@ -509,12 +1255,24 @@ bool CMeasurementDB::BatchWriteWaterPrices(const std::vector<std::pair<uint256,
     LOCK(m_db_mutex);
     
     CDBBatch db_batch(*m_db);
+    MeasurementCounters counters = m_counters;
+    
+    // Measurements written earlier in the same batch are what a later entry replaces
+    std::map<uint256, const WaterPriceMeasurement*> written;
     
     for (const auto& [id, measurement] : batch) {
+        WaterPriceMeasurement previous;
+        if (auto it = written.find(id); it != written.end()) {
+            EraseWaterIndexes(db_batch, counters, id, *it->second);
+        } else if (m_db->Read(std::make_pair(DB_WATER_PRICE, id), previous)) {
+            EraseWaterIndexes(db_batch, counters, id, previous);
+        }
         db_batch.Write(std::make_pair(DB_WATER_PRICE, id), measurement);
+        WriteWaterIndexes(db_batch, counters, id, measurement);
+        written[id] = &measurement;
     }
     
-    bool success = m_db->WriteBatch(db_batch, true);
+    bool success = WriteBatchWithCounters(db_batch, counters);
     
     if (success) {
         LogPrintf("O Measurement DB: Batch wrote %d water price measurements\n", batch.size());
@@ -528,12 +1286,24 @@ bool CMeasurementDB::BatchWriteExchangeRates(const std::vector<std::pair<uint256
     LOCK(m_db_mutex);
     
     CDBBatch db_batch(*m_db);
+    MeasurementCounters counters = m_counters;
+    
+    // Measurements written earlier in the same batch are what a later entry replaces
+    std::map<uint256, const ExchangeRateMeasurement*> written;
     
     for (const auto& [id, measurement] : batch) {
+        ExchangeRateMeasurement previous;
+        if (auto it = written.find(id); it != written.end()) {
+            EraseExchangeIndexes(db_batch, counters, id, *it->second);
+        } else if (m_db->Read(std::make_pair(DB_EXCHANGE_RATE, id), previous)) {
+            EraseExchangeIndexes(db_batch, counters, id, previous);
+        }
         db_batch.Write(std::make_pair(DB_EXCHANGE_RATE, id), measurement);
+        WriteExchangeIndexes(db_batch, counters, id, measurement);
+        written[id] = &measurement;
     }
     
-    bool success = m_db->WriteBatch(db_batch, true);
+    bool success = WriteBatchWithCounters(db_batch, counters);
     
     if (success) {
         LogPrintf("O Measurement DB: Batch wrote %d exchange rate measurements\n", batch.size());
@@ -548,11 +1318,23 @@ bool CMeasurementDB::BatchWriteInvites(const std::vector<std::pair<uint256, Meas
     
     CDBBatch db_batch(*m_db);
     
+    // Invites written earlier in the same batch are what a later entry replaces
+    std::map<uint256, const MeasurementInvite*> written;
+    
     for (const auto& [id, invite] : batch) {
+        MeasurementInvite previous;
+        if (auto it = written.find(id); it != written.end()) {
+            EraseInviteIndexes(db_batch, id, *it->second);
+        } else if (m_db->Read(std::make_pair(DB_INVITE, id), previous)) {
+            EraseInviteIndexes(db_batch, id, previous);
+        }
         db_batch.Write(std::make_pair(DB_INVITE, id), invite);
+        WriteInviteIndexes(db_batch, id, invite);
+        written[id] = &invite;
+        m_invite_cache.Erase(id);
     }
     
-    bool success = m_db->WriteBatch(db_batch, true);
+    bool success = CommitBatch(db_batch);
     
     if (success) {
         LogPrintf("O Measurement DB: Batch wrote %d measurement invites\n", batch.size());
@@ -570,25 +1352,14 @@ std::vector<uint256> CMeasurementDB::FindMeasurementsBySubmitter(const CPubKey&
     std::vector<uint256> measurement_ids;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
-    uint8_t prefix = (type == MeasurementType::WATER_PRICE) ? DB_WATER_PRICE : DB_EXCHANGE_RATE;
+    uint8_t prefix = (type == MeasurementType::WATER_PRICE) ? DB_WATER_BY_SUBMITTER : DB_EXCHANGE_BY_SUBMITTER;
     
-    for (iterator->Seek(prefix); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != prefix) {
+    for (iterator->Seek(SubmitterKey(prefix, submitter, uint256{})); iterator->Valid(); iterator->Next()) {
+        SubmitterKey key(prefix);
+        if (!iterator->GetKey(key) || key.submitter != submitter) {
             break;
         }
-        
-        if (type == MeasurementType::WATER_PRICE) {
-            WaterPriceMeasurement measurement;
-            if (iterator->GetValue(measurement) && measurement.submitter == submitter) {
-                measurement_ids.push_back(key.second);
-            }
-        } else if (type == MeasurementType::EXCHANGE_RATE) {
-            ExchangeRateMeasurement measurement;
-            if (iterator->GetValue(measurement) && measurement.submitter == submitter) {
-                measurement_ids.push_back(key.second);
-            }
-        }
+        measurement_ids.push_back(key.id);
     }
     
     return measurement_ids;
@@ -601,25 +1372,14 @@ std::vector<uint256> CMeasurementDB::FindUnvalidatedMeasurements(MeasurementType
     std::vector<uint256> unvalidated;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
-    uint8_t prefix = (type == MeasurementType::WATER_PRICE) ? DB_WATER_PRICE : DB_EXCHANGE_RATE;
+    uint8_t prefix = (type == MeasurementType::WATER_PRICE) ? DB_WATER_UNVALIDATED : DB_EXCHANGE_UNVALIDATED;
     
     for (iterator->Seek(prefix); iterator->Valid(); iterator->Next()) {
         std::pair<uint8_t, uint256> key;
         if (!iterator->GetKey(key) || key.first != prefix) {
             break;
         }
-        
-        if (type == MeasurementType::WATER_PRICE) {
-            WaterPriceMeasurement measurement;
-            if (iterator->GetValue(measurement) && !measurement.is_validated) {
-                unvalidated.push_back(key.second);
-            }
-        } else if (type == MeasurementType::EXCHANGE_RATE) {
-            ExchangeRateMeasurement measurement;
-            if (iterator->GetValue(measurement) && !measurement.is_validated) {
-                unvalidated.push_back(key.second);
-            }
-        }
+        unvalidated.push_back(key.second);
     }
     
     return unvalidated;
@@ -630,31 +1390,20 @@ std::vector<uint256> CMeasurementDB::FindMeasurementsByHeight(int start_height,
     LOCK(m_db_mutex);
     
     std::vector<uint256> measurements;
+    if (end_height < start_height || end_height < 0) {
+        return measurements;
+    }
+    
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
-    uint8_t prefix = (type == MeasurementType::WATER_PRICE) ? DB_WATER_PRICE : DB_EXCHANGE_RATE;
+    uint8_t prefix = (type == MeasurementType::WATER_PRICE) ? DB_WATER_BY_HEIGHT : DB_EXCHANGE_BY_HEIGHT;
     
-    for (iterator->Seek(prefix); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != prefix) {
+    for (iterator->Seek(HeightKey(prefix, start_height, uint256{})); iterator->Valid(); iterator->Next()) {
+        HeightKey key(prefix);
+        if (!iterator->GetKey(key) || key.height > static_cast<uint32_t>(end_height)) {
             break;
         }
-        
-        if (type == MeasurementType::WATER_PRICE) {
-            WaterPriceMeasurement measurement;
-            if (iterator->GetValue(measurement)) {
-                if (measurement.block_height >= start_height && measurement.block_height <= end_height) {
-                    measurements.push_back(key.second);
-                }
-            }
-        } else if (type == MeasurementType::EXCHANGE_RATE) {
-            ExchangeRateMeasurement measurement;
-            if (iterator->GetValue(measurement)) {
-                if (measurement.block_height >= start_height && measurement.block_height <= end_height) {
-                    measurements.push_back(key.second);
-                }
-            }
-        }
+        measurements.push_back(key.id);
     }
     
     return measurements;
@@ -665,37 +1414,13 @@ std::vector<uint256> CMeasurementDB::FindMeasurementsByHeight(int start_height,
 size_t CMeasurementDB::GetWaterPriceCount() const
 {
     LOCK(m_db_mutex);
-    
-    size_t count = 0;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
-    
-    for (iterator->Seek(DB_WATER_PRICE); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_WATER_PRICE) {
-            break;
-        }
-        count++;
-    }
-    
-    return count;
+    return m_counters.water_price_count;
 }
 
 size_t CMeasurementDB::GetExchangeRateCount() const
 {
     LOCK(m_db_mutex);
-    
-    size_t count = 0;
-    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
-    
-    for (iterator->Seek(DB_EXCHANGE_RATE); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_EXCHANGE_RATE) {
-            break;
-        }
-        count++;
-    }
-    
-    return count;
+    return m_counters.exchange_rate_count;
 }
 
 size_t CMeasurementDB::GetInviteCount() const
@@ -740,10 +1465,16 @@ size_t CMeasurementDB::GetValidatedURLCount() const
 }
 
 std::map<std::string, size_t> CMeasurementDB::GetMeasurementCountByCurrency() const
+{
+    LOCK(m_db_mutex);
+    return {m_counters.water_price_count_by_currency.begin(), m_counters.water_price_count_by_currency.end()};
+}
+
+MeasurementCounters CMeasurementDB::ComputeCounters() const
 {
     LOCK(m_db_mutex);
     
-    std::map<std::string, size_t> counts;
+    MeasurementCounters counters;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
     for (iterator->Seek(DB_WATER_PRICE); iterator->Valid(); iterator->Next()) {
@@ -754,11 +1485,38 @@ std::map<std::string, size_t> CMeasurementDB::GetMeasurementCountByCurrency() co
         
         WaterPriceMeasurement measurement;
         if (iterator->GetValue(measurement)) {
-            counts[measurement.currency_code]++;
+            counters.AddWaterPrice(measurement);
+        }
+    }
+    
+    for (iterator->Seek(DB_EXCHANGE_RATE); iterator->Valid(); iterator->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!iterator->GetKey(key) || key.first != DB_EXCHANGE_RATE) {
+            break;
+        }
+        
+        ExchangeRateMeasurement measurement;
+        if (iterator->GetValue(measurement)) {
+            counters.AddExchangeRate(measurement);
         }
     }
     
-    return counts;
+    return counters;
+}
+
+bool CMeasurementDB::RebuildCounters()
+{
+    LOCK(m_db_mutex);
+    
+    CDBBatch batch(*m_db);
+    bool success = WriteBatchWithCounters(batch, ComputeCounters());
+    
+    if (success) {
+        LogPrintf("O Measurement DB: Rebuilt counters (water: %d, exchange: %d)\n",
+                  m_counters.water_price_count, m_counters.exchange_rate_count);
+    }
+    
+    return success;
 }
 
 // ===== Maintenance =====
@@ -768,6 +1526,7 @@ bool CMeasurementDB::PruneOldMeasurements(int64_t cutoff_timestamp)
     LOCK(m_db_mutex);
     
     CDBBatch batch(*m_db);
+    MeasurementCounters counters = m_counters;
     int pruned_water = 0;
     int pruned_exchange = 0;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
@@ -781,6 +1540,7 @@ bool CMeasurementDB::PruneOldMeasurements(int64_t cutoff_timestamp)
         
         WaterPriceMeasurement measurement;
         if (iterator->GetValue(measurement) && measurement.timestamp < cutoff_timestamp) {
+            EraseWaterIndexes(batch, counters, key.second, measurement);
             batch.Erase(std::make_pair(DB_WATER_PRICE, key.second));
             pruned_water++;
         }
@@ -795,12 +1555,13 @@ bool CMeasurementDB::PruneOldMeasurements(int64_t cutoff_timestamp)
         
         ExchangeRateMeasurement measurement;
         if (iterator->GetValue(measurement) && measurement.timestamp < cutoff_timestamp) {
+            EraseExchangeIndexes(batch, counters, key.second, measurement);
             batch.Erase(std::make_pair(DB_EXCHANGE_RATE, key.second));
             pruned_exchange++;
         }
     }
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = WriteBatchWithCounters(batch, counters);
     
     if (success && (pruned_water > 0 || pruned_exchange > 0)) {
         LogPrintf("O Measurement DB: Pruned %d water prices and %d exchange rates (before %d)\n",
@@ -810,6 +1571,23 @@ bool CMeasurementDB::PruneOldMeasurements(int64_t cutoff_timestamp)
     return success;
 }
 
+std::vector<uint256> CMeasurementDB::GetExpiredInvites(int64_t current_time) const
+{
+    LOCK(m_db_mutex);
+    
+    std::vector<uint256> expired;
+    std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
+    for (iterator->Seek(InviteExpiryKey(0, uint256{})); iterator->Valid(); iterator->Next()) {
+        InviteExpiryKey key;
+        if (!iterator->GetKey(key) || static_cast<int64_t>(key.prune_time) >= current_time) {
+            break;
+        }
+        expired.push_back(key.id);
+    }
+    
+    return expired;
+}
+
 bool CMeasurementDB::PruneExpiredInvites(int64_t current_time)
 {
     LOCK(m_db_mutex);
@@ -818,23 +1596,29 @@ bool CMeasurementDB::PruneExpiredInvites(int64_t current_time)
     int pruned = 0;
     std::unique_ptr<CDBIterator> iterator(m_db->NewIterator());
     
-    for (iterator->Seek(DB_INVITE); iterator->Valid(); iterator->Next()) {
-        std::pair<uint8_t, uint256> key;
-        if (!iterator->GetKey(key) || key.first != DB_INVITE) {
+    // Used invites sort first with a prune time of zero, followed by the
+    // invites in expiry order, so everything to prune is one key range
+    for (iterator->Seek(InviteExpiryKey(0, uint256{})); iterator->Valid(); iterator->Next()) {
+        InviteExpiryKey key;
+        if (!iterator->GetKey(key) || static_cast<int64_t>(key.prune_time) >= current_time) {
             break;
         }
         
-        MeasurementInvite invite;
-        if (iterator->GetValue(invite)) {
-            // Prune if used or expired
-            if (invite.is_used || invite.expires_at < current_time) {
-                batch.Erase(std::make_pair(DB_INVITE, key.second));
-                pruned++;
-            }
+        std::pair<CPubKey, int64_t> user_expiry;
+        if (iterator->GetValue(user_expiry)) {
+            batch.Erase(InviteUserKey(user_expiry.first, user_expiry.second, key.id));
         }
+        batch.Erase(key);
+        batch.Erase(std::make_pair(DB_INVITE, key.id));
+        m_invite_cache.Erase(key.id);
+        pruned++;
     }
     
-    bool success = m_db->WriteBatch(batch, true);
+    if (pruned == 0) {
+        return true;
+    }
+    
+    bool success = CommitBatch(batch);
     
     if (success && pruned > 0) {
         LogPrintf("O Measurement DB: Pruned %d expired/used invites\n", pruned);
@@ -867,7 +1651,7 @@ bool CMeasurementDB::PruneInactiveURLs()
         }
     }
     
-    bool success = m_db->WriteBatch(batch, true);
+    bool success = CommitBatch(batch);
     
     if (success && pruned > 0) {
         LogPrintf("O Measurement DB: Pruned %d inactive URLs\n", pruned);
@@ -878,14 +1662,23 @@ bool CMeasurementDB::PruneInactiveURLs()
 
 void CMeasurementDB::Compact()
 {
-    LOCK(m_db_mutex);
-    
-    LogPrintf("O Measurement DB: Database compaction requested\n");
-    LogPrintf("O Measurement DB: Note: Compaction happens automatically via LevelDB\n");
-    LogPrintf("O Measurement DB: To force compaction, restart node with -reindex\n");
-    
-    // Note: CDBWrapper doesn't expose CompactRange publicly
-    // Compaction happens automatically in LevelDB
+    LogPrintf("O Measurement DB: Compacting %d key prefixes\n", MEASUREMENT_DB_HOT_PREFIXES.size());
+    for (const uint8_t prefix : MEASUREMENT_DB_HOT_PREFIXES) {
+        CompactKeyRange(OConsensus::OKeyRange{prefix, 0, std::nullopt});
+    }
+    LogPrintf("O Measurement DB: Compaction finished\n");
+}
+
+uint64_t CMeasurementDB::EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const
+{
+    return m_db->EstimateSize(range.BeginKey(), range.EndKey());
+}
+
+void CMeasurementDB::CompactKeyRange(const OConsensus::OKeyRange& range) const
+{
+    // LevelDB compaction is internally synchronized, so m_db_mutex is not
+    // held and writers are not blocked while the range is rewritten.
+    m_db->CompactRange(range.BeginKey(), range.EndKey());
 }
 
 size_t CMeasurementDB::EstimateSize() const
@@ -903,34 +1696,98 @@ std::optional<fs::path> CMeasurementDB::StoragePath() const
 
 bool CMeasurementDB::ExportMeasurements(const fs::path& export_path, MeasurementType type) const
 {
-    LOCK(m_db_mutex);
+    // m_db_mutex is not held: the iterator reads from a consistent snapshot,
+    // so writers are not blocked for the length of the export
+    const bool water = type == MeasurementType::WATER_PRICE;
+    const fs::path temp_path = export_path + ".new";
+    
+    AutoFile file{fsbridge::fopen(temp_path, "wb")};
+    if (file.IsNull()) {
+        LogPrintf("O Measurement DB: Export failed: cannot open %s\n", fs::PathToString(temp_path));
+        return false;
+    }
     
     try {
         LogPrintf("O Measurement DB: Exporting %s measurements to %s\n",
-                  type == MeasurementType::WATER_PRICE ? "water price" : "exchange rate",
-                  fs::PathToString(export_path));
+                  water ? "water price" : "exchange rate", fs::PathToString(export_path));
+        
+        ExportHeader header;
+        header.type = static_cast<uint8_t>(type);
+        header.created_at = GetTime();
+        file << header << header.Checksum();
+        
+        uint64_t count = water ? WriteExportRecords<WaterPriceMeasurement>(*m_db, DB_WATER_PRICE, file)
+                               : WriteExportRecords<ExchangeRateMeasurement>(*m_db, DB_EXCHANGE_RATE, file);
         
-        // TODO: Implement proper serialization to file
-        // For now, just log the operation
+        if (!file.Commit()) {
+            throw std::runtime_error("Commit failed");
+        }
+        if (file.fclose() != 0) {
+            throw std::runtime_error("Close failed");
+        }
+        if (!RenameOver(temp_path, export_path)) {
+            throw std::runtime_error("Rename failed");
+        }
         
+        LogPrintf("O Measurement DB: Exported %d measurements\n", count);
         return true;
     } catch (const std::exception& e) {
         LogPrintf("O Measurement DB: Export failed: %s\n", e.what());
+        file.fclose();
+        fs::remove(temp_path);
         return false;
     }
 }
 
 bool CMeasurementDB::ImportMeasurements(const fs::path& import_path, MeasurementType type)
 {
-    LOCK(m_db_mutex);
+    const bool water = type == MeasurementType::WATER_PRICE;
+    
+    AutoFile file{fsbridge::fopen(import_path, "rb")};
+    if (file.IsNull()) {
+        LogPrintf("O Measurement DB: Import failed: cannot open %s\n", fs::PathToString(import_path));
+        return false;
+    }
     
     try {
         LogPrintf("O Measurement DB: Importing %s measurements from %s\n",
-                  type == MeasurementType::WATER_PRICE ? "water price" : "exchange rate",
-                  fs::PathToString(import_path));
+                  water ? "water price" : "exchange rate", fs::PathToString(import_path));
+        
+        ExportHeader header;
+        uint32_t checksum;
+        file >> header >> checksum;
+        if (header.magic != EXPORT_MAGIC || checksum != header.Checksum()) {
+            throw std::runtime_error("not a measurement export or corrupt header");
+        }
+        if (header.format_version != EXPORT_FORMAT_VERSION) {
+            throw std::runtime_error(strprintf("unsupported export format version %d", header.format_version));
+        }
+        if (header.type != static_cast<uint8_t>(type)) {
+            throw std::runtime_error("export contains a different measurement type");
+        }
+        
+        // The whole dump is verified before anything is written, then read again to write it
+        const int64_t records_start = file.tell();
+        const uint64_t count = water ? VerifyImportRecords<WaterPriceMeasurement>(file)
+                                     : VerifyImportRecords<ExchangeRateMeasurement>(file);
+        file.seek(records_start, SEEK_SET);
+        
+        bool success;
+        {
+            LOCK(m_db_mutex);
+            success = water ? WriteImportRecords<WaterPriceMeasurement>(*m_db, DB_WATER_PRICE, file, m_counters)
+                            : WriteImportRecords<ExchangeRateMeasurement>(*m_db, DB_EXCHANGE_RATE, file, m_counters);
+        }
         
-        // TODO: Implement proper deserialization from file
+        // Cached statistics and the stability map were computed from the replaced records
+        g_measurement_stats.Clear();
+        g_stability_snapshot.Rebuild();
         
+        if (!success) {
+            LogPrintf("O Measurement DB: Import failed while writing, the batches written so far are kept\n");
+            return false;
+        }
+        LogPrintf("O Measurement DB: Imported %d measurements\n", count);
         return true;
     } catch (const std::exception& e) {
         LogPrintf("O Measurement DB: Import failed: %s\n", e.what());
@@ -980,7 +1837,12 @@ bool CMeasurementDB::VerifyIntegrity() const
     LogPrintf("O Measurement DB: Integrity check - Water: %d, Exchange: %d, Corrupted: %d\n",
               total_water, total_exchange, corrupted);
     
-    return corrupted == 0;
+    bool counters_match = ComputeCounters() == m_counters;
+    if (!counters_match) {
+        LogPrintf("O Measurement DB: Persisted counters do not match records, run RebuildCounters\n");
+    }
+    
+    return corrupted == 0 && counters_match;
 }
 
 } // namespace OMeasurement
@@ -5,11 +5,16 @@
 #ifndef BITCOIN_MEASUREMENT_O_MEASUREMENT_DB_H
 #define BITCOIN_MEASUREMENT_O_MEASUREMENT_DB_H
 
+#include <consensus/o_db_maintenance.h>
+#include <consensus/o_lookup_cache.h>
 #include <dbwrapper.h>
 #include <measurement/measurement_system.h>
 #include <sync.h>
 #include <uint256.h>
+#include <util/hasher.h>
 
+#include <array>
+#include <map>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -23,17 +28,82 @@ static constexpr uint8_t DB_EXCHANGE_RATE = 'e';      // Exchange rate measureme
 static constexpr uint8_t DB_INVITE = 'i';              // Measurement invitations
 static constexpr uint8_t DB_VALIDATED_URL = 'u';      // Validated URLs for bots
 static constexpr uint8_t DB_DAILY_AVERAGE = 'd';      // Daily averages by currency
-static constexpr uint8_t DB_WATER_BY_CURRENCY = 'W';  // Index: currency -> measurement IDs
-static constexpr uint8_t DB_EXCHANGE_BY_PAIR = 'E';   // Index: currency pair -> measurement IDs
-static constexpr uint8_t DB_INVITE_BY_USER = 'I';     // Index: user -> invite IDs
-static constexpr uint8_t DB_MEASUREMENT_STATS = 's';  // Statistics
+static constexpr uint8_t DB_WATER_BY_CURRENCY = 'W';  // Index: (currency, timestamp, id)
+static constexpr uint8_t DB_EXCHANGE_BY_PAIR = 'E';   // Index: (from, to, timestamp, id)
+static constexpr uint8_t DB_WATER_BY_HEIGHT = 'h';    // Index: (block height, id) for water prices
+static constexpr uint8_t DB_EXCHANGE_BY_HEIGHT = 'H'; // Index: (block height, id) for exchange rates
+static constexpr uint8_t DB_WATER_BY_SUBMITTER = 'b';  // Index: (submitter pubkey, id) for water prices
+static constexpr uint8_t DB_EXCHANGE_BY_SUBMITTER = 'B'; // Index: (submitter pubkey, id) for exchange rates
+static constexpr uint8_t DB_WATER_UNVALIDATED = 'n';   // Index: ids of unvalidated water prices
+static constexpr uint8_t DB_EXCHANGE_UNVALIDATED = 'N'; // Index: ids of unvalidated exchange rates
+static constexpr uint8_t DB_INVITE_BY_USER = 'I';     // Index: (user pubkey, expiry, id) for invites
+static constexpr uint8_t DB_INVITE_BY_EXPIRY = 'X';   // Index: (prune time, id) -> (user, expiry) for invites
+static constexpr uint8_t DB_MEASUREMENT_STATS = 's';  // Aggregate counters (MeasurementCounters)
+static constexpr uint8_t DB_BLOCK_UNDO = 'x';         // O state undo records by block hash
+static constexpr uint8_t DB_BLOCK_UNDO_BY_HEIGHT = 'y'; // Index: (block height, hash) of undo records
+static constexpr uint8_t DB_BLOCK_UNDO_PRUNED = 'p';  // Height below which undo records were pruned
 static constexpr uint8_t DB_MEASUREMENT_VERSION = 'v'; // Database version
 
+/** Prefixes that see most erases and overwrites, compacted by background maintenance */
+static constexpr std::array<uint8_t, 14> MEASUREMENT_DB_HOT_PREFIXES{
+    DB_WATER_PRICE, DB_EXCHANGE_RATE, DB_INVITE, DB_VALIDATED_URL,
+    DB_WATER_BY_CURRENCY, DB_EXCHANGE_BY_PAIR, DB_WATER_BY_HEIGHT, DB_EXCHANGE_BY_HEIGHT,
+    DB_WATER_BY_SUBMITTER, DB_EXCHANGE_BY_SUBMITTER, DB_WATER_UNVALIDATED, DB_EXCHANGE_UNVALIDATED,
+    DB_INVITE_BY_USER, DB_INVITE_BY_EXPIRY};
+
+/** Current on-disk layout version. Bump when adding index keyspaces that must be
+ *  rebuilt for existing databases (see CMeasurementDB::UpgradeIndexes). */
+static constexpr int MEASUREMENT_DB_VERSION = 4;
+
+/** Persisted aggregate counters, updated in the same batch as every measurement write */
+struct MeasurementCounters {
+    uint64_t water_price_count{0};
+    uint64_t exchange_rate_count{0};
+    std::map<std::string, uint64_t> water_price_count_by_currency;
+    
+    SERIALIZE_METHODS(MeasurementCounters, obj) {
+        READWRITE(obj.water_price_count, obj.exchange_rate_count, obj.water_price_count_by_currency);
+    }
+    
+    void AddWaterPrice(const WaterPriceMeasurement& m);
+    void RemoveWaterPrice(const WaterPriceMeasurement& m);
+    void AddExchangeRate(const ExchangeRateMeasurement&) { exchange_rate_count++; }
+    void RemoveExchangeRate(const ExchangeRateMeasurement&) { if (exchange_rate_count > 0) exchange_rate_count--; }
+    
+    bool operator==(const MeasurementCounters&) const = default;
+};
+
+/** The fields of an invite that decide whether it can be used, as cached by CMeasurementDB */
+struct InviteStatus {
+    bool exists{false};
+    CPubKey invited_user;
+    int64_t expires_at{0};
+    bool is_used{false};
+};
+
 /** Measurement Database - Persistent storage for water price and exchange rate data */
 class CMeasurementDB {
 private:
     std::unique_ptr<CDBWrapper> m_db;
     mutable RecursiveMutex m_db_mutex;
+    MeasurementCounters m_counters GUARDED_BY(m_db_mutex);
+    bool m_unsynced GUARDED_BY(m_db_mutex){false};
+    
+    /** Invite ID -> usability fields. Filled by GetInviteStatus and invalidated
+     *  by every invite write or erase, both under m_db_mutex. */
+    mutable OConsensus::OLookupCache<uint256, InviteStatus, BlockHasher> m_invite_cache;
+    
+    /** Rebuild secondary indexes for databases written by an older version */
+    void UpgradeIndexes();
+    
+    /** Scan all measurements and compute the aggregate counters from scratch */
+    MeasurementCounters ComputeCounters() const;
+    
+    /** Write a batch together with updated counters, adopting them on success */
+    bool WriteBatchWithCounters(CDBBatch& batch, const MeasurementCounters& counters);
+    
+    /** Write a batch, synced unless the calling thread is in an ODeferSyncScope */
+    bool CommitBatch(CDBBatch& batch);
     
 public:
     explicit CMeasurementDB(size_t cache_size, bool memory_only = false, bool wipe_data = false);
@@ -101,12 +171,24 @@ public:
     /** Erase invite */
     bool EraseInvite(const uint256& invite_id);
     
-    /** Get all invites for a user */
+    /** Get all invites for a user, in expiry order */
     std::vector<MeasurementInvite> GetUserInvites(const CPubKey& user) const;
     
+    /** Get a user's unused invites expiring after current_time, reading only those past the expiry */
+    std::vector<MeasurementInvite> GetActiveUserInvites(const CPubKey& user, int64_t current_time) const;
+    
     /** Get active (unused, not expired) invites */
     std::vector<MeasurementInvite> GetActiveInvites() const;
     
+    /** Read the fields that decide whether an invite can be used. Cached. */
+    InviteStatus GetInviteStatus(const uint256& invite_id) const;
+    
+    /** Resize the invite cache (0 disables it) */
+    void SetInviteCacheCapacity(size_t capacity) { m_invite_cache.SetCapacity(capacity); }
+    
+    /** Entry count and hit/miss counters of the invite cache */
+    OConsensus::OLookupCache<uint256, InviteStatus, BlockHasher>::Stats GetInviteCacheStats() const { return m_invite_cache.GetStats(); }
+    
     // ===== Validated URL Operations =====
     
     /** Write validated URL to database */
@@ -136,9 +218,32 @@ public:
     std::vector<DailyAverage> GetDailyAveragesInRange(
         const std::string& currency, const std::string& start_date, const std::string& end_date) const;
     
+    /** Write daily averages for many currencies in one batch */
+    bool BatchWriteDailyAverages(const std::vector<DailyAverage>& averages);
+    
     /** Get recent daily averages */
     std::vector<DailyAverage> GetRecentDailyAverages(const std::string& currency, int days) const;
     
+    // ===== Block Undo Operations =====
+    
+    /** Store the serialized O state undo record of a connected block (see OConsensus::OBlockUndo) */
+    bool WriteBlockUndo(const uint256& block_hash, int height, const std::vector<unsigned char>& undo);
+    
+    /** Read the serialized O state undo record of a block */
+    std::optional<std::vector<unsigned char>> ReadBlockUndo(const uint256& block_hash) const;
+    
+    /** Check if an undo record exists for a block */
+    bool HasBlockUndo(const uint256& block_hash) const;
+    
+    /** Erase the undo record of a disconnected block */
+    bool EraseBlockUndo(const uint256& block_hash, int height);
+    
+    /** Erase the undo records of blocks below height, which can then no longer be disconnected */
+    bool PruneBlockUndo(int height);
+    
+    /** Height below which undo records were pruned, 0 if none were */
+    int GetBlockUndoPrunedHeight() const;
+    
     // ===== Batch Operations =====
     
     /** Batch write water prices */
@@ -163,10 +268,10 @@ public:
     
     // ===== Statistics =====
     
-    /** Get total water price measurement count */
+    /** Get total water price measurement count (from the persisted counters) */
     size_t GetWaterPriceCount() const;
     
-    /** Get total exchange rate measurement count */
+    /** Get total exchange rate measurement count (from the persisted counters) */
     size_t GetExchangeRateCount() const;
     
     /** Get total invite count */
@@ -178,23 +283,45 @@ public:
     /** Get validated URL count */
     size_t GetValidatedURLCount() const;
     
-    /** Get measurements count by currency */
+    /** Get water price measurement count by currency (from the persisted counters) */
     std::map<std::string, size_t> GetMeasurementCountByCurrency() const;
     
+    /** Recompute the persisted counters from a full scan */
+    bool RebuildCounters();
+    
+    // ===== Write Durability =====
+    
+    /** Make all writes committed since the last sync durable. Writes made
+     *  inside an ODeferSyncScope are committed without fsync until then. */
+    bool Sync();
+    
     // ===== Maintenance =====
     
     /** Prune old measurements before cutoff timestamp */
     bool PruneOldMeasurements(int64_t cutoff_timestamp);
     
-    /** Prune expired invites */
+    /** Ids of the invites PruneExpiredInvites(current_time) would prune */
+    std::vector<uint256> GetExpiredInvites(int64_t current_time) const;
+    
+    /**
+     * Prune used invites and those expired before current_time, walking only
+     * the expiry index range to prune. Invites are consensus state: blocks
+     * prune them as they connect, see OConsensus::ProcessOTransactions.
+     */
     bool PruneExpiredInvites(int64_t current_time);
     
     /** Prune inactive URLs */
     bool PruneInactiveURLs();
     
-    /** Compact the database */
+    /** Compact all hot key prefixes */
     void Compact();
     
+    /** Estimated on-disk size of a range of keys, see OConsensus::SplitPrefix */
+    uint64_t EstimateKeyRangeSize(const OConsensus::OKeyRange& range) const;
+    
+    /** Compact a range of keys */
+    void CompactKeyRange(const OConsensus::OKeyRange& range) const;
+    
     /** Get database size estimate */
     size_t EstimateSize() const;
     
@@ -203,13 +330,22 @@ public:
     
     // ===== Backup/Restore =====
     
-    /** Export measurements to file (for backup) */
+    /** Stream all measurements of one type to a checksummed dump file (for backup
+     *  and seeding new nodes). The file is written next to export_path and renamed
+     *  into place once complete. Records come from a snapshot of the database, and
+     *  writes are not blocked while they are streamed. */
     bool ExportMeasurements(const fs::path& export_path, MeasurementType type) const;
     
-    /** Import measurements from file (for restore) */
+    /** Bulk-load a dump written by ExportMeasurements. The dump is streamed twice:
+     *  first to check it against its trailer, then to write it in bounded batches
+     *  that are synced once at the end, so it is never held in memory. Returns false,
+     *  having imported nothing, if the dump cannot be read or a checksum does not
+     *  match; a write failure after that keeps the batches already written. The
+     *  measurement statistics and stability snapshot are then rebuilt from the
+     *  imported records. */
     bool ImportMeasurements(const fs::path& import_path, MeasurementType type);
     
-    /** Verify database integrity */
+    /** Verify database integrity, including that the persisted counters match the records */
     bool VerifyIntegrity() const;
 };
 
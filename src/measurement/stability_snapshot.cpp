@@ -0,0 +1,173 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <measurement/stability_snapshot.h>
+#include <measurement/measurement_system.h>
+#include <chain.h>
+#include <hash.h>
+#include <logging.h>
+#include <primitives/block.h>
+#include <primitives/o_transactions.h>
+#include <tinyformat.h>
+#include <util/time.h>
+
+namespace OMeasurement {
+
+StabilitySnapshotCache g_stability_snapshot;
+
+namespace {
+
+/** Deviation from the theoretical rate below which a currency counts as stable */
+constexpr double STABLE_DEVIATION_THRESHOLD = 0.10;
+
+std::string ComputeETag(const std::vector<CurrencyStabilityEntry>& entries)
+{
+    HashWriter hasher{};
+    for (const auto& entry : entries) {
+        hasher << entry.currency << entry.o_currency
+               << strprintf("%d|%.8f|%.8f|%.8f|%d|%d",
+                            entry.avg_water_price.has_value(), entry.avg_water_price.value_or(0.0),
+                            entry.exchange_rate, entry.deviation, entry.is_stable, entry.measurement_count);
+    }
+    return "\"" + hasher.GetHash().GetHex().substr(0, 16) + "\"";
+}
+
+} // namespace
+
+bool BlockChangesMeasurements(const CBlock& block)
+{
+    using OTransactions::OTxType;
+    for (const auto& tx : block.vtx) {
+        const auto view = OTransactions::GetOTxView(*tx);
+        if (!view) {
+            continue;
+        }
+        // The record type leads a batch payload
+        OTxType type = view->type;
+        if (type == OTxType::BATCH && !view->payload.empty()) {
+            type = static_cast<OTxType>(view->payload[0]);
+        }
+        if (type == OTxType::WATER_PRICE || type == OTxType::EXCHANGE_RATE ||
+            type == OTxType::MEASUREMENT_VALIDATION) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<const StabilitySnapshot> BuildStabilitySnapshot(int height)
+{
+    auto snapshot = std::make_shared<StabilitySnapshot>();
+    snapshot->height = height;
+    snapshot->build_time = GetTime();
+
+    for (const auto& currency : g_measurement_system.GetSupportedFiatCurrencies()) {
+        std::string o_currency = g_measurement_system.GetOCurrencyFromFiat(currency);
+        if (o_currency.empty()) {
+            continue;
+        }
+
+        auto avg_exchange = g_measurement_system.GetAverageExchangeRateWithConfidence(o_currency, currency, 7);
+        if (!avg_exchange.has_value()) {
+            continue;
+        }
+
+        CurrencyStabilityEntry entry;
+        entry.currency = currency;
+        entry.o_currency = o_currency;
+        entry.avg_water_price = g_measurement_system.GetAverageWaterPrice(currency, 30);
+        entry.exchange_rate = avg_exchange->value;
+        entry.deviation = g_measurement_system.CalculateStabilityDeviation(o_currency, avg_exchange->value);
+        entry.is_stable = entry.deviation <= STABLE_DEVIATION_THRESHOLD;
+        entry.measurement_count = avg_exchange->measurement_count;
+        snapshot->entries.push_back(std::move(entry));
+    }
+
+    snapshot->etag = ComputeETag(snapshot->entries);
+    return snapshot;
+}
+
+std::shared_ptr<const StabilitySnapshot> StabilitySnapshotCache::Get()
+{
+    {
+        LOCK(m_mutex);
+        if (m_snapshot) {
+            return m_snapshot;
+        }
+    }
+
+    // First request before any block was connected
+    auto snapshot = BuildStabilitySnapshot(-1);
+    LOCK(m_mutex);
+    if (!m_snapshot) {
+        m_snapshot = snapshot;
+    }
+    return m_snapshot;
+}
+
+void StabilitySnapshotCache::Refresh(int height)
+{
+    // Build outside the lock so readers keep being served the previous snapshot
+    auto snapshot = BuildStabilitySnapshot(height);
+
+    LOCK(m_mutex);
+    m_snapshot = std::move(snapshot);
+    m_dirty = false;
+
+    LogDebug(BCLog::NET, "O Measurement: Stability snapshot rebuilt at height %d (%d currencies, etag %s)\n",
+             height, m_snapshot->entries.size(), m_snapshot->etag);
+}
+
+void StabilitySnapshotCache::Rebuild()
+{
+    int height;
+    {
+        LOCK(m_mutex);
+        height = m_snapshot ? m_snapshot->height : -1;
+    }
+    Refresh(height);
+}
+
+void StabilitySnapshotCache::BlockConnected(int height, bool measurements_changed)
+{
+    {
+        LOCK(m_mutex);
+        m_dirty |= measurements_changed;
+        if (!m_dirty) {
+            return;
+        }
+        if (m_snapshot && m_snapshot->height >= 0 &&
+            height >= m_snapshot->height && height - m_snapshot->height < STABILITY_SNAPSHOT_REFRESH_BLOCKS) {
+            return;
+        }
+    }
+
+    Refresh(height);
+}
+
+void StabilitySnapshotCache::BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    // The background chainstate of an assumeutxo snapshot connects historical blocks
+    if (role == ChainstateRole::BACKGROUND) {
+        return;
+    }
+    BlockConnected(pindex->nHeight, BlockChangesMeasurements(*block));
+}
+
+void StabilitySnapshotCache::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    // Disconnected measurements must not linger until the next refresh interval
+    if (BlockChangesMeasurements(*block)) {
+        Refresh(pindex->nHeight - 1);
+    }
+}
+
+void StabilitySnapshotCache::Clear()
+{
+    LOCK(m_mutex);
+    m_snapshot.reset();
+    m_dirty = false;
+}
+
+} // namespace OMeasurement
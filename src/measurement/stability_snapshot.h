@@ -0,0 +1,94 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MEASUREMENT_STABILITY_SNAPSHOT_H
+#define BITCOIN_MEASUREMENT_STABILITY_SNAPSHOT_H
+
+#include <sync.h>
+#include <validationinterface.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace OMeasurement {
+
+/** Blocks between two snapshot rebuilds triggered by block connection */
+static constexpr int STABILITY_SNAPSHOT_REFRESH_BLOCKS = 6;
+
+/** Stability of one fiat currency and its O counterpart */
+struct CurrencyStabilityEntry {
+    std::string currency;                      // Fiat currency code
+    std::string o_currency;                    // Corresponding O currency
+    std::optional<double> avg_water_price;     // 30-day water price, if statistically significant
+    double exchange_rate{0.0};                 // 7-day O/fiat exchange rate
+    double deviation{0.0};                     // Deviation from the theoretical rate
+    bool is_stable{false};
+    int measurement_count{0};                  // Exchange rate measurements behind the average
+};
+
+/** Immutable view of all per-currency stability data at one point in time */
+struct StabilitySnapshot {
+    std::vector<CurrencyStabilityEntry> entries; // Currencies with an exchange rate average
+    int height{-1};                              // Block height the snapshot was built at
+    int64_t build_time{0};
+    std::string etag;                            // Quoted HTTP entity tag over the entry contents
+};
+
+/**
+ * Materialized per-currency stability data for the map and stability REST
+ * endpoints.
+ *
+ * Computing the map touches every supported fiat currency, so it is done
+ * when measurements change (on block connect, rate-limited to one rebuild
+ * every STABILITY_SNAPSHOT_REFRESH_BLOCKS blocks, on block disconnect, and
+ * after daily averages are recalculated) instead of on every HTTP request.
+ * Blocks are seen through the validation interface, so only blocks that were
+ * actually connected count and rebuilds run on the notification thread
+ * rather than under cs_main. Readers get a shared pointer to the current
+ * snapshot and never block on a rebuild.
+ */
+class StabilitySnapshotCache : public CValidationInterface {
+public:
+    /** Current snapshot, building the first one on demand */
+    std::shared_ptr<const StabilitySnapshot> Get() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Rebuild the snapshot now */
+    void Refresh(int height) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Rebuild the snapshot now at the height of the current one, after measurements changed outside a block */
+    void Rebuild() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Note a connected block; rebuilds when measurements changed and the refresh interval has passed */
+    void BlockConnected(int height, bool measurements_changed) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Drop the current snapshot */
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    // CValidationInterface
+    void BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    mutable Mutex m_mutex;
+    std::shared_ptr<const StabilitySnapshot> m_snapshot GUARDED_BY(m_mutex);
+    bool m_dirty GUARDED_BY(m_mutex){false};
+};
+
+/** Whether a block carries water price, exchange rate or measurement validation records */
+bool BlockChangesMeasurements(const CBlock& block);
+
+/** Compute a snapshot from the current measurement statistics */
+std::shared_ptr<const StabilitySnapshot> BuildStabilitySnapshot(int height);
+
+/** Global stability snapshot instance */
+extern StabilitySnapshotCache g_stability_snapshot;
+
+} // namespace OMeasurement
+
+#endif // BITCOIN_MEASUREMENT_STABILITY_SNAPSHOT_H
@@ -4984,19 +4984,10 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         LogDebug(BCLog::NET, "received getmeasureinv for user %s from peer=%d\n",
                  getmeasureinv.user_pubkey.GetID().GetHex().c_str(), pfrom.GetId());
 
-        // Get invites for the requested user
+        // Get active invites for the requested user, read through the per-user index
         if (OMeasurement::g_measurement_db) {
-            std::vector<OMeasurement::MeasurementInvite> user_invites =
-                OMeasurement::g_measurement_db->GetUserInvites(getmeasureinv.user_pubkey);
-
-            // Filter to only active invites
-            std::vector<OMeasurement::MeasurementInvite> active_invites;
-            int64_t current_time = GetTime();
-            for (const auto& invite : user_invites) {
-                if (!invite.is_used && !invite.is_expired && invite.expires_at > current_time) {
-                    active_invites.push_back(invite);
-                }
-            }
+            std::vector<OMeasurement::MeasurementInvite> active_invites =
+                OMeasurement::g_measurement_db->GetActiveUserInvites(getmeasureinv.user_pubkey, GetTime());
 
             // Send response if we have any active invites
             if (!active_invites.empty()) {
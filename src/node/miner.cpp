@@ -176,9 +176,12 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock()
     pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
     pblocktemplate->vchCoinbaseCommitment = m_chainstate.m_chainman.GenerateCoinbaseCommitment(*pblock, pindexPrev);
 
-    // O Blockchain: Add stabilization transactions if needed
-    if (OConsensus::ShouldTriggerStabilization(*pblock, nHeight)) {
-        auto stab_txs = OConsensus::g_stabilization_mining.CreateStabilizationTransactions(*pblock, nHeight);
+    // O Blockchain: Add stabilization transactions if needed. The plan is keyed
+    // by the parent block and cached, so connecting the mined block reuses it.
+    pblock->hashPrevBlock = pindexPrev->GetBlockHash();
+    const auto stab_plan = OConsensus::g_stabilization_mining.GetBlockPlan(*pblock, nHeight);
+    if (stab_plan->triggered) {
+        const auto& stab_txs = stab_plan->transactions;
         
         for (const auto& stab_tx : stab_txs) {
             // Add stabilization transaction to block template
@@ -207,7 +210,9 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock()
     // O Blockchain: Add automatic measurement invitation transactions
     // Run every 10 blocks to avoid spam
     if (nHeight % 10 == 0) {
-        std::vector<CMutableTransaction> invitation_txs;
+        // Invitations are written MAX_O_BATCH_RECORDS to a transaction
+        std::vector<OTransactions::CBatchData> invitation_batches;
+        int invitation_count = 0;
         
         try {
             // Get all supported currencies (142 currencies)
@@ -241,7 +246,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock()
                                 currency,
                                 nHeight);
                         
-                        // Convert to blockchain transactions
+                        // Convert to batch records
                         for (const auto& invite : invites) {
                             OTransactions::CMeasurementInviteData tx_data;
                             tx_data.invite_id = invite.invite_id;
@@ -257,31 +262,38 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock()
                                 continue;
                             }
                             
-                            // Create transaction
-                            CMutableTransaction mtx;
-                            mtx.version = CTransaction::CURRENT_VERSION;
-                            
-                            // OP_RETURN output with invitation data
-                            CTxOut opReturnOut;
-                            opReturnOut.nValue = 0;
-                            opReturnOut.scriptPubKey = tx_data.ToScript();
-                            mtx.vout.push_back(opReturnOut);
-                            
-                            invitation_txs.push_back(mtx);
+                            // Start a new batch when the current one is full
+                            if (invitation_batches.empty() ||
+                                invitation_batches.back().records.size() >= OTransactions::MAX_O_BATCH_RECORDS) {
+                                OTransactions::CBatchData& batch = invitation_batches.emplace_back();
+                                batch.record_type = OTransactions::OTxType::MEASUREMENT_INVITE;
+                                batch.record_version = OTransactions::O_TX_VERSION_COMPACT;
+                            }
+                            invitation_batches.back().AddRecord(tx_data);
+                            invitation_count++;
                         }
                     }
                 }
             }
             
-            // Add invitation transactions to block
-            for (const auto& inv_tx : invitation_txs) {
-                pblock->vtx.push_back(MakeTransactionRef(inv_tx));
+            // Add invitation batch transactions to block
+            for (const auto& batch : invitation_batches) {
+                CMutableTransaction mtx;
+                mtx.version = CTransaction::CURRENT_VERSION;
+                
+                // OP_RETURN output with the batch of invitations
+                CTxOut opReturnOut;
+                opReturnOut.nValue = 0;
+                opReturnOut.scriptPubKey = batch.ToScript();
+                mtx.vout.push_back(opReturnOut);
+                
+                pblock->vtx.push_back(MakeTransactionRef(std::move(mtx)));
                 nBlockTx++;
             }
             
-            if (!invitation_txs.empty()) {
-                LogPrintf("O Mining: Added %d automatic invitation transactions to block template at height %d\n",
-                         static_cast<int>(invitation_txs.size()), nHeight);
+            if (invitation_count > 0) {
+                LogPrintf("O Mining: Added %d automatic invitations in %d transactions to block template at height %d\n",
+                         invitation_count, static_cast<int>(invitation_batches.size()), nHeight);
             }
         } catch (const std::exception& e) {
             LogPrintf("O Mining: Error creating invitation transactions: %s\n", e.what());
@@ -25,7 +25,12 @@ public:
     /** Convert from legacy CTxOut (BTC only) */
     CMultiCurrencyTxOut(const CTxOut& txout)
         : scriptPubKey(txout.scriptPubKey) {
-        amounts.emplace_back(CURRENCY_BTC, txout.nValue);
+        amounts.push_back(LegacyAmount(txout));
+    }
+    
+    /** Amount a legacy CTxOut converts to, without copying its script */
+    static MultiCurrencyAmount LegacyAmount(const CTxOut& txout) {
+        return MultiCurrencyAmount(CURRENCY_BTC, txout.nValue);
     }
     
     /** Convert to legacy CTxOut (BTC amount only) */
@@ -129,9 +134,9 @@ public:
         return txin;
     }
     
-    /** Serialization */
+    /** Serialization, the witness is serialized with the transaction as for CTxIn */
     SERIALIZE_METHODS(CMultiCurrencyTxIn, obj) {
-        READWRITE(obj.prevout, obj.scriptSig, obj.nSequence, obj.scriptWitness);
+        READWRITE(obj.prevout, obj.scriptSig, obj.nSequence);
     }
 };
 
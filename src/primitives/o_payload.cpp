@@ -0,0 +1,87 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/o_payload.h>
+
+#include <algorithm>
+#include <span>
+
+namespace OTransactions {
+
+namespace {
+
+/** Read a data push, pointing data at the pushed bytes inside the script */
+bool ReadPush(const CScript& script, CScript::const_iterator& pc, std::span<const unsigned char>& data)
+{
+    const CScript::const_iterator start = pc;
+    opcodetype opcode;
+    if (!script.GetOp(pc, opcode) || opcode > OP_PUSHDATA4) {
+        return false;
+    }
+    const size_t header = 1 + (opcode == OP_PUSHDATA1 ? 1 : opcode == OP_PUSHDATA2 ? 2 : opcode == OP_PUSHDATA4 ? 4 : 0);
+    // Built from offsets, pc is end() when the push ends the script
+    data = std::span<const unsigned char>(script.data() + (start - script.begin()), pc - start).subspan(header);
+    return true;
+}
+
+/** Read a small number, written as OP_1..OP_16 or as a one byte push */
+std::optional<uint8_t> ReadSmallNumber(const CScript& script, CScript::const_iterator pc)
+{
+    if (pc < script.end() && *pc >= OP_1 && *pc <= OP_16) {
+        return static_cast<uint8_t>(CScript::DecodeOP_N(static_cast<opcodetype>(*pc)));
+    }
+    std::span<const unsigned char> data;
+    if (ReadPush(script, pc, data) && data.size() == 1) {
+        return data[0];
+    }
+    return std::nullopt;
+}
+
+/** Advance past one opcode and its push data */
+void Skip(const CScript& script, CScript::const_iterator& pc)
+{
+    opcodetype opcode;
+    script.GetOp(pc, opcode);
+}
+
+} // namespace
+
+std::optional<OPayloadLocation> ParseOPayload(const CScript& script)
+{
+    CScript::const_iterator pc = script.begin();
+    if (pc == script.end() || *pc != OP_RETURN) {
+        return std::nullopt;
+    }
+    ++pc;
+    
+    std::span<const unsigned char> data;
+    if (!ReadPush(script, pc, data) || !std::ranges::equal(data, O_TX_PREFIX)) {
+        return std::nullopt;
+    }
+    
+    const std::optional<uint8_t> first = ReadSmallNumber(script, pc);
+    if (!first) {
+        return std::nullopt;
+    }
+    Skip(script, pc);
+    
+    OPayloadLocation location;
+    if (const std::optional<uint8_t> second = ReadSmallNumber(script, pc)) {
+        Skip(script, pc);
+        location.version = *first;
+        location.type = *second;
+    } else {
+        location.version = O_TX_VERSION;
+        location.type = *first;
+    }
+    
+    if (!ReadPush(script, pc, data)) {
+        return std::nullopt;
+    }
+    location.offset = static_cast<uint32_t>(data.data() - script.data());
+    location.size = static_cast<uint32_t>(data.size());
+    return location;
+}
+
+} // namespace OTransactions
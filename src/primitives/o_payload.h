@@ -0,0 +1,61 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_PRIMITIVES_O_PAYLOAD_H
+#define BITCOIN_PRIMITIVES_O_PAYLOAD_H
+
+#include <script/script.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace OTransactions {
+
+/** O Blockchain Transaction Version */
+static constexpr uint8_t O_TX_VERSION = 0x01;
+
+/**
+ * Compact payload encoding of measurements and invitations: currencies as
+ * registry ids, enumerated proof types, varint timestamps and the measurer
+ * as a key hash. See CWaterPriceMeasurementData::SerializeCompact.
+ */
+static constexpr uint8_t O_TX_VERSION_COMPACT = 0x02;
+
+/** OP_RETURN prefix for O transactions: "OBLK" in hex */
+static const std::vector<unsigned char> O_TX_PREFIX = {0x4F, 0x42, 0x4C, 0x4B};
+
+/**
+ * Framing of an O transaction payload within an output script:
+ *
+ *     OP_RETURN <O_TX_PREFIX> [version] <type> <payload>
+ *
+ * Version and type are small numbers, written either as OP_1..OP_16 or as a
+ * one byte push. The version is optional and defaults to O_TX_VERSION, the
+ * validation and invite types are written without it.
+ *
+ * Accepting OP_1..OP_16 is consensus-critical: it is the form ToScript
+ * writes, and blocks only apply O transactions whose framing decodes.
+ *
+ * Only offsets are stored, so the location stays valid for copies of the
+ * script it was found in.
+ */
+struct OPayloadLocation {
+    uint32_t output{0};  // Index of the output within the transaction
+    uint32_t offset{0};  // Start of the payload within the output script
+    uint32_t size{0};    // Payload size in bytes
+    uint8_t type{0};     // Raw OTxType
+    uint8_t version{0};
+};
+
+/**
+ * Decode the framing of an O payload from an output script without copying
+ * the payload. Returns nullopt if the script is not an O output.
+ * The output field of the result is left at 0.
+ */
+std::optional<OPayloadLocation> ParseOPayload(const CScript& script);
+
+} // namespace OTransactions
+
+#endif // BITCOIN_PRIMITIVES_O_PAYLOAD_H
@@ -4,13 +4,167 @@
 
 #include <primitives/o_transactions.h>
 
+#include <consensus/merkle.h>
+#include <consensus/multicurrency.h>
 #include <hash.h>
 #include <script/script.h>
 #include <streams.h>
+#include <util/overflow.h>
 #include <util/strencodings.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace OTransactions {
 
+namespace {
+
+/** Decode the payload of an O output script of the given type */
+template <typename T>
+std::optional<T> DecodeScript(const CScript& script, OTxType type) {
+    const auto location = ParseOPayload(script);
+    if (!location || location->type != static_cast<uint8_t>(type)) {
+        return std::nullopt;
+    }
+    return DeserializeOPayload<T>(std::span{script.data() + location->offset, location->size}, location->version);
+}
+
+/** Decode an O payload if it has the given type */
+template <typename T>
+std::optional<T> DecodeView(const OTxView& view, OTxType type) {
+    if (view.type != type) {
+        return std::nullopt;
+    }
+    return DeserializeOPayload<T>(view.payload, view.version);
+}
+
+/** Run the OTxView overload of an Extract function on the O payload of a transaction */
+template <typename T>
+std::optional<T> ExtractFromTransaction(const CTransaction& tx, std::optional<T> (*extract)(const OTxView&)) {
+    const auto view = GetOTxView(tx);
+    return view ? extract(*view) : std::nullopt;
+}
+
+/** Build the OP_RETURN script of an O payload */
+CScript MakeOScript(OTxType type, uint8_t version, const DataStream& ds, bool write_version = true) {
+    CScript script;
+    script << OP_RETURN;
+    script << O_TX_PREFIX;
+    if (write_version) {
+        script << version;
+    }
+    script << static_cast<uint8_t>(type);
+    script << std::vector<unsigned char>(UCharCast(ds.data()), UCharCast(ds.data() + ds.size()));
+    return script;
+}
+
+// ===== Compact encoding =====
+
+/** Compact timestamps count seconds from 2025-01-01 */
+static constexpr int64_t COMPACT_TIME_EPOCH{1735689600};
+
+/** Proof types of a compact water price measurement, 0 is followed by the proof type string */
+static constexpr uint64_t PROOF_TYPE_OTHER{0};
+static constexpr uint64_t PROOF_TYPE_URL{1};
+static constexpr uint64_t PROOF_TYPE_GPS_PHOTO{2};
+
+/** Signed integers are zigzag encoded so small negative values stay short */
+void WriteSignedVarInt(DataStream& s, int64_t n) {
+    uint64_t zigzag = (static_cast<uint64_t>(n) << 1) ^ static_cast<uint64_t>(n >> 63);
+    s << VARINT(zigzag);
+}
+
+int64_t ReadSignedVarInt(SpanReader& s) {
+    uint64_t zigzag;
+    s >> VARINT(zigzag);
+    return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+}
+
+/**
+ * Currencies are written as a varint: 0 followed by the code for a code not
+ * in the built-in currency table, otherwise 1 + (id << 1 | fiat). Fiat codes
+ * such as "USD" are stored as the id of their O currency ("OUSD"). Currencies
+ * registered at runtime differ between nodes, so they are never given an id.
+ */
+void WriteCurrency(DataStream& s, const std::string& code) {
+    uint64_t ref{0};
+    if (const auto id = GetDefaultCurrencyId(code)) {
+        ref = 1 + (uint64_t{*id} << 1);
+    } else if (const auto o_id = GetDefaultCurrencyId("O" + code)) {
+        ref = 1 + (uint64_t{*o_id} << 1 | 1);
+    }
+    s << VARINT(ref);
+    if (ref == 0) {
+        s << code;
+    }
+}
+
+std::string ReadCurrency(SpanReader& s) {
+    uint64_t ref;
+    s >> VARINT(ref);
+    if (ref == 0) {
+        std::string code;
+        s >> code;
+        return code;
+    }
+    const uint64_t id = (ref - 1) >> 1;
+    const auto symbol = id <= std::numeric_limits<CurrencyId>::max() ?
+        GetDefaultCurrencySymbol(static_cast<CurrencyId>(id)) : std::nullopt;
+    if (!symbol) {
+        throw std::ios_base::failure("Unknown currency id in compact O payload");
+    }
+    const bool fiat = (ref - 1) & 1;
+    if (fiat && symbol->size() < 2) {
+        throw std::ios_base::failure("Invalid fiat currency in compact O payload");
+    }
+    return std::string{fiat ? symbol->substr(1) : *symbol};
+}
+
+void WriteTime(DataStream& s, int64_t time) {
+    WriteSignedVarInt(s, time - COMPACT_TIME_EPOCH);
+}
+
+/** Add an offset read from a payload to a time */
+int64_t AddTime(int64_t time, int64_t offset) {
+    const auto sum = CheckedAdd(time, offset);
+    if (!sum) {
+        throw std::ios_base::failure("Time out of range in compact O payload");
+    }
+    return *sum;
+}
+
+int64_t ReadTime(SpanReader& s) {
+    return AddTime(COMPACT_TIME_EPOCH, ReadSignedVarInt(s));
+}
+
+/** Key hash of a measurer, whether its key is carried or only its hash */
+CKeyID MeasurerId(const CPubKey& measurer, const CKeyID& measurer_id) {
+    return measurer.IsValid() ? measurer.GetID() : measurer_id;
+}
+
+/** Measurers are referenced by key hash, their key is that of the invitation they answer */
+void WriteMeasurer(DataStream& s, const CPubKey& measurer, const CKeyID& measurer_id) {
+    s << MeasurerId(measurer, measurer_id);
+}
+
+/** BIP340 Schnorr signature by the x-only key of a compressed signer */
+bool VerifySchnorr(const CPubKey& signer, const uint256& hash, const std::vector<unsigned char>& signature) {
+    return signature.size() == O_SCHNORR_SIG_SIZE && signer.IsCompressed() &&
+           XOnlyPubKey{signer}.VerifySchnorr(hash, signature);
+}
+
+/** Schnorr by a carried measurer key, or compact ECDSA recovering to the key hash of a compact payload */
+bool VerifyMeasurerSignature(const CPubKey& measurer, const CKeyID& measurer_id, const uint256& hash,
+                             const std::vector<unsigned char>& signature) {
+    if (measurer.IsValid()) {
+        return VerifySchnorr(measurer, hash, signature);
+    }
+    CPubKey recovered;
+    return recovered.RecoverCompact(hash, signature) && recovered.GetID() == measurer_id;
+}
+
+} // namespace
+
 // ===== CUserVerificationData =====
 
 bool CUserVerificationData::IsValid() const {
@@ -78,47 +232,12 @@ CScript CUserVerificationData::ToScript() const {
 }
 
 bool CUserVerificationData::FromScript(const CScript& script, CUserVerificationData& data) {
-    if (!script.IsUnspendable()) {
-        return false;
-    }
-    
-    CScript::const_iterator pc = script.begin();
-    opcodetype opcode;
-    std::vector<unsigned char> vch;
-    
-    // Read OP_RETURN
-    if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) {
-        return false;
-    }
-    
-    // Read prefix
-    if (!script.GetOp(pc, opcode, vch) || vch != O_TX_PREFIX) {
-        return false;
-    }
-    
-    // Read version
-    if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 || vch[0] != O_TX_VERSION) {
-        return false;
-    }
-    
-    // Read type
-    if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 || 
-        vch[0] != static_cast<uint8_t>(OTxType::USER_VERIFY)) {
-        return false;
-    }
-    
-    // Read data
-    if (!script.GetOp(pc, opcode, vch)) {
-        return false;
-    }
-    
-    try {
-        DataStream ds{vch};
-        ds >> data;
-        return data.IsValid();
-    } catch (...) {
+    auto decoded = DecodeScript<CUserVerificationData>(script, OTxType::USER_VERIFY);
+    if (!decoded) {
         return false;
     }
+    data = std::move(*decoded);
+    return data.IsValid();
 }
 
 // ===== CWaterPriceMeasurementData =====
@@ -132,7 +251,8 @@ bool CWaterPriceMeasurementData::IsValid() const {
         return false;
     }
     
-    if (!measurer.IsValid()) {
+    // Compact payloads name the measurer by key hash only
+    if (!measurer.IsValid() && measurer_id.IsNull()) {
         return false;
     }
     
@@ -161,68 +281,66 @@ bool CWaterPriceMeasurementData::IsValid() const {
 
 uint256 CWaterPriceMeasurementData::GetHash() const {
     HashWriter ss{};
-    ss << currency_code << price << measurer << timestamp << invite_id << proof_type << proof_data;
+    // The measurer enters by key hash, so a compact payload hashes the same before and after its key is resolved
+    ss << currency_code << price << MeasurerId(measurer, measurer_id) << timestamp << invite_id << proof_type << proof_data;
     return ss.GetHash();
 }
 
-CScript CWaterPriceMeasurementData::ToScript() const {
+bool CWaterPriceMeasurementData::VerifySignature() const {
+    return VerifyMeasurerSignature(measurer, measurer_id, GetHash(), signature);
+}
+
+CScript CWaterPriceMeasurementData::ToScript(uint8_t version) const {
     DataStream ds;
-    ds << *this;
-    
-    std::vector<unsigned char> data(UCharCast(ds.data()), UCharCast(ds.data() + ds.size()));
-    
-    CScript script;
-    script << OP_RETURN;
-    script << O_TX_PREFIX;
-    script << O_TX_VERSION;
-    script << static_cast<uint8_t>(OTxType::WATER_PRICE);
-    script << data;
-    
-    return script;
+    if (version == O_TX_VERSION_COMPACT) {
+        SerializeCompact(ds);
+    } else {
+        ds << *this;
+    }
+    return MakeOScript(OTxType::WATER_PRICE, version, ds);
+}
+
+void CWaterPriceMeasurementData::SerializeCompact(DataStream& s) const {
+    WriteCurrency(s, currency_code);
+    WriteSignedVarInt(s, price);
+    WriteMeasurer(s, measurer, measurer_id);
+    WriteTime(s, timestamp);
+    s << invite_id;
+    const uint64_t proof = proof_type == "url" ? PROOF_TYPE_URL : proof_type == "gps_photo" ? PROOF_TYPE_GPS_PHOTO : PROOF_TYPE_OTHER;
+    s << VARINT(proof);
+    if (proof == PROOF_TYPE_OTHER) {
+        s << proof_type;
+    }
+    s << proof_data << signature;
+}
+
+void CWaterPriceMeasurementData::UnserializeCompact(SpanReader& s) {
+    currency_code = ReadCurrency(s);
+    price = ReadSignedVarInt(s);
+    s >> measurer_id;
+    timestamp = ReadTime(s);
+    s >> invite_id;
+    uint64_t proof;
+    s >> VARINT(proof);
+    if (proof == PROOF_TYPE_URL) {
+        proof_type = "url";
+    } else if (proof == PROOF_TYPE_GPS_PHOTO) {
+        proof_type = "gps_photo";
+    } else if (proof == PROOF_TYPE_OTHER) {
+        s >> proof_type;
+    } else {
+        throw std::ios_base::failure("Unknown proof type in compact O payload");
+    }
+    s >> proof_data >> signature;
 }
 
 bool CWaterPriceMeasurementData::FromScript(const CScript& script, CWaterPriceMeasurementData& data) {
-    if (!script.IsUnspendable()) {
-        return false;
-    }
-    
-    CScript::const_iterator pc = script.begin();
-    opcodetype opcode;
-    std::vector<unsigned char> vch;
-    
-    // Read OP_RETURN
-    if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) {
-        return false;
-    }
-    
-    // Read prefix
-    if (!script.GetOp(pc, opcode, vch) || vch != O_TX_PREFIX) {
-        return false;
-    }
-    
-    // Read version
-    if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 || vch[0] != O_TX_VERSION) {
-        return false;
-    }
-    
-    // Read type
-    if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 || 
-        vch[0] != static_cast<uint8_t>(OTxType::WATER_PRICE)) {
-        return false;
-    }
-    
-    // Read data
-    if (!script.GetOp(pc, opcode, vch)) {
-        return false;
-    }
-    
-    try {
-        DataStream ds{vch};
-        ds >> data;
-        return data.IsValid();
-    } catch (...) {
+    auto decoded = DecodeScript<CWaterPriceMeasurementData>(script, OTxType::WATER_PRICE);
+    if (!decoded) {
         return false;
     }
+    data = std::move(*decoded);
+    return data.IsValid();
 }
 
 // ===== CExchangeRateMeasurementData =====
@@ -236,7 +354,8 @@ bool CExchangeRateMeasurementData::IsValid() const {
         return false;
     }
     
-    if (!measurer.IsValid()) {
+    // Compact payloads name the measurer by key hash only
+    if (!measurer.IsValid() && measurer_id.IsNull()) {
         return false;
     }
     
@@ -261,166 +380,118 @@ bool CExchangeRateMeasurementData::IsValid() const {
 
 uint256 CExchangeRateMeasurementData::GetHash() const {
     HashWriter ss{};
-    ss << from_currency << to_currency << exchange_rate << measurer << timestamp << invite_id << proof_data;
+    ss << from_currency << to_currency << exchange_rate << MeasurerId(measurer, measurer_id) << timestamp << invite_id << proof_data;
     return ss.GetHash();
 }
 
-CScript CExchangeRateMeasurementData::ToScript() const {
+bool CExchangeRateMeasurementData::VerifySignature() const {
+    return VerifyMeasurerSignature(measurer, measurer_id, GetHash(), signature);
+}
+
+CScript CExchangeRateMeasurementData::ToScript(uint8_t version) const {
     DataStream ds;
-    ds << *this;
-    
-    std::vector<unsigned char> data(UCharCast(ds.data()), UCharCast(ds.data() + ds.size()));
-    
-    CScript script;
-    script << OP_RETURN;
-    script << O_TX_PREFIX;
-    script << O_TX_VERSION;
-    script << static_cast<uint8_t>(OTxType::EXCHANGE_RATE);
-    script << data;
-    
-    return script;
+    if (version == O_TX_VERSION_COMPACT) {
+        SerializeCompact(ds);
+    } else {
+        ds << *this;
+    }
+    return MakeOScript(OTxType::EXCHANGE_RATE, version, ds);
+}
+
+void CExchangeRateMeasurementData::SerializeCompact(DataStream& s) const {
+    WriteCurrency(s, from_currency);
+    WriteCurrency(s, to_currency);
+    WriteSignedVarInt(s, exchange_rate);
+    WriteMeasurer(s, measurer, measurer_id);
+    WriteTime(s, timestamp);
+    s << invite_id << proof_data << signature;
+}
+
+void CExchangeRateMeasurementData::UnserializeCompact(SpanReader& s) {
+    from_currency = ReadCurrency(s);
+    to_currency = ReadCurrency(s);
+    exchange_rate = ReadSignedVarInt(s);
+    s >> measurer_id;
+    timestamp = ReadTime(s);
+    s >> invite_id >> proof_data >> signature;
 }
 
 bool CExchangeRateMeasurementData::FromScript(const CScript& script, CExchangeRateMeasurementData& data) {
-    if (!script.IsUnspendable()) {
-        return false;
-    }
-    
-    CScript::const_iterator pc = script.begin();
-    opcodetype opcode;
-    std::vector<unsigned char> vch;
-    
-    // Read OP_RETURN
-    if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) {
-        return false;
-    }
-    
-    // Read prefix
-    if (!script.GetOp(pc, opcode, vch) || vch != O_TX_PREFIX) {
-        return false;
-    }
-    
-    // Read version
-    if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 || vch[0] != O_TX_VERSION) {
-        return false;
-    }
-    
-    // Read type
-    if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 || 
-        vch[0] != static_cast<uint8_t>(OTxType::EXCHANGE_RATE)) {
-        return false;
-    }
-    
-    // Read data
-    if (!script.GetOp(pc, opcode, vch)) {
-        return false;
-    }
-    
-    try {
-        DataStream ds{vch};
-        ds >> data;
-        return data.IsValid();
-    } catch (...) {
+    auto decoded = DecodeScript<CExchangeRateMeasurementData>(script, OTxType::EXCHANGE_RATE);
+    if (!decoded) {
         return false;
     }
+    data = std::move(*decoded);
+    return data.IsValid();
 }
 
 // ===== Helper Functions =====
 
-bool IsOTransaction(const CTransaction& tx) {
-    // Check all outputs for OP_RETURN with O prefix
-    for (const auto& output : tx.vout) {
-        const CScript& script = output.scriptPubKey;
-        
-        if (!script.IsUnspendable()) {
-            continue;
-        }
-        
-        CScript::const_iterator pc = script.begin();
-        opcodetype opcode;
-        std::vector<unsigned char> vch;
-        
-        // Check for OP_RETURN
-        if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) {
-            continue;
-        }
-        
-        // Check for O prefix
-        if (script.GetOp(pc, opcode, vch) && vch == O_TX_PREFIX) {
-            return true;
+std::optional<OTxView> GetOTxView(const CTransaction& tx) {
+    for (size_t i = 0; i < tx.vout.size(); i++) {
+        const CScript& script = tx.vout[i].scriptPubKey;
+        if (const auto location = ParseOPayload(script)) {
+            return OTxView{
+                .type = static_cast<OTxType>(location->type),
+                .version = location->version,
+                .output_index = static_cast<uint32_t>(i),
+                .payload = std::span{script.data() + location->offset, location->size},
+            };
         }
     }
-    
-    return false;
+    return std::nullopt;
+}
+
+bool IsOTransaction(const CTransaction& tx) {
+    return GetOTxView(tx).has_value();
+}
+
+std::optional<OTxType> GetOTxType(const OTxView& view) {
+    if (view.version != O_TX_VERSION && view.version != O_TX_VERSION_COMPACT) {
+        return std::nullopt;
+    }
+    return view.type;
 }
 
 std::optional<OTxType> GetOTxType(const CTransaction& tx) {
-    // Find OP_RETURN output with O prefix
-    for (const auto& output : tx.vout) {
-        const CScript& script = output.scriptPubKey;
-        
-        if (!script.IsUnspendable()) {
-            continue;
-        }
-        
-        CScript::const_iterator pc = script.begin();
-        opcodetype opcode;
-        std::vector<unsigned char> vch;
-        
-        // Read OP_RETURN
-        if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) {
-            continue;
-        }
-        
-        // Read prefix
-        if (!script.GetOp(pc, opcode, vch) || vch != O_TX_PREFIX) {
-            continue;
-        }
-        
-        // Read version
-        if (!script.GetOp(pc, opcode, vch) || vch.size() != 1 || vch[0] != O_TX_VERSION) {
-            continue;
-        }
-        
-        // Read type
-        if (!script.GetOp(pc, opcode, vch) || vch.size() != 1) {
-            continue;
-        }
-        
-        return static_cast<OTxType>(vch[0]);
+    const auto view = GetOTxView(tx);
+    return view ? GetOTxType(*view) : std::nullopt;
+}
+
+std::optional<CUserVerificationData> ExtractUserVerification(const OTxView& view) {
+    auto data = DecodeView<CUserVerificationData>(view, OTxType::USER_VERIFY);
+    if (!data || !data->IsValid()) {
+        return std::nullopt;
     }
-    
-    return std::nullopt;
+    return data;
 }
 
 std::optional<CUserVerificationData> ExtractUserVerification(const CTransaction& tx) {
-    for (const auto& output : tx.vout) {
-        CUserVerificationData data;
-        if (CUserVerificationData::FromScript(output.scriptPubKey, data)) {
-            return data;
-        }
+    return ExtractFromTransaction(tx, &ExtractUserVerification);
+}
+
+std::optional<CWaterPriceMeasurementData> ExtractWaterPriceMeasurement(const OTxView& view) {
+    auto data = DecodeView<CWaterPriceMeasurementData>(view, OTxType::WATER_PRICE);
+    if (!data || !data->IsValid()) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return data;
 }
 
 std::optional<CWaterPriceMeasurementData> ExtractWaterPriceMeasurement(const CTransaction& tx) {
-    for (const auto& output : tx.vout) {
-        CWaterPriceMeasurementData data;
-        if (CWaterPriceMeasurementData::FromScript(output.scriptPubKey, data)) {
-            return data;
-        }
+    return ExtractFromTransaction(tx, &ExtractWaterPriceMeasurement);
+}
+
+std::optional<CExchangeRateMeasurementData> ExtractExchangeRateMeasurement(const OTxView& view) {
+    auto data = DecodeView<CExchangeRateMeasurementData>(view, OTxType::EXCHANGE_RATE);
+    if (!data || !data->IsValid()) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return data;
 }
 
 std::optional<CExchangeRateMeasurementData> ExtractExchangeRateMeasurement(const CTransaction& tx) {
-    for (const auto& output : tx.vout) {
-        CExchangeRateMeasurementData data;
-        if (CExchangeRateMeasurementData::FromScript(output.scriptPubKey, data)) {
-            return data;
-        }
-    }
-    return std::nullopt;
+    return ExtractFromTransaction(tx, &ExtractExchangeRateMeasurement);
 }
 
 // ===== CMeasurementValidationData =====
@@ -457,6 +528,10 @@ uint256 CMeasurementValidationData::GetHash() const {
     return ss.GetHash();
 }
 
+bool CMeasurementValidationData::VerifySignature() const {
+    return VerifySchnorr(validator, GetHash(), signature);
+}
+
 CScript CMeasurementValidationData::ToScript() const {
     DataStream ds;
     ds << *this;
@@ -474,54 +549,20 @@ CScript CMeasurementValidationData::ToScript() const {
 }
 
 bool CMeasurementValidationData::FromScript(const CScript& script, CMeasurementValidationData& data) {
-    auto pc = script.begin();
-    std::vector<unsigned char> vch;
-    opcodetype opcode;
-    
-    // Check for OP_RETURN
-    if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) {
-        return false;
-    }
-    
-    // Check for O_TX_PREFIX
-    if (!script.GetOp(pc, opcode, vch)) {
-        return false;
-    }
-    if (vch.size() != O_TX_PREFIX.size() || 
-        !std::equal(vch.begin(), vch.end(), O_TX_PREFIX.begin())) {
-        return false;
-    }
-    
-    // Check for MEASUREMENT_VALIDATION type
-    if (!script.GetOp(pc, opcode, vch)) {
-        return false;
-    }
-    if (vch.size() != 1 || vch[0] != static_cast<uint8_t>(OTxType::MEASUREMENT_VALIDATION)) {
-        return false;
-    }
-    
-    // Parse serialized data
-    if (!script.GetOp(pc, opcode, vch)) {
-        return false;
-    }
-    
-    try {
-        DataStream ds{vch};
-        ds >> data;
-        return true;
-    } catch (...) {
+    auto decoded = DecodeScript<CMeasurementValidationData>(script, OTxType::MEASUREMENT_VALIDATION);
+    if (!decoded) {
         return false;
     }
+    data = std::move(*decoded);
+    return true;
+}
+
+std::optional<CMeasurementValidationData> ExtractMeasurementValidation(const OTxView& view) {
+    return DecodeView<CMeasurementValidationData>(view, OTxType::MEASUREMENT_VALIDATION);
 }
 
 std::optional<CMeasurementValidationData> ExtractMeasurementValidation(const CTransaction& tx) {
-    for (const auto& output : tx.vout) {
-        CMeasurementValidationData data;
-        if (CMeasurementValidationData::FromScript(output.scriptPubKey, data)) {
-            return data;
-        }
-    }
-    return std::nullopt;
+    return ExtractFromTransaction(tx, &ExtractMeasurementValidation);
 }
 
 // ===== CMeasurementInviteData =====
@@ -560,71 +601,158 @@ uint256 CMeasurementInviteData::GetHash() const {
     return ss.GetHash();
 }
 
-CScript CMeasurementInviteData::ToScript() const {
+CScript CMeasurementInviteData::ToScript(uint8_t version) const {
     DataStream ds;
-    ds << *this;
-    
-    std::vector<unsigned char> data(UCharCast(ds.data()), UCharCast(ds.data() + ds.size()));
-    
-    // Build OP_RETURN script: OP_RETURN <O_TX_PREFIX> <MEASUREMENT_INVITE> <serialized data>
-    CScript script;
-    script << OP_RETURN;
-    script << std::vector<unsigned char>(O_TX_PREFIX.begin(), O_TX_PREFIX.end());
-    script << static_cast<uint8_t>(OTxType::MEASUREMENT_INVITE);
-    script << data;
+    if (version == O_TX_VERSION_COMPACT) {
+        SerializeCompact(ds);
+    } else {
+        ds << *this;
+    }
     
-    return script;
+    // Version 1 invitations are written without a version:
+    // OP_RETURN <O_TX_PREFIX> <MEASUREMENT_INVITE> <serialized data>
+    return MakeOScript(OTxType::MEASUREMENT_INVITE, version, ds, /*write_version=*/version != O_TX_VERSION);
+}
+
+void CMeasurementInviteData::SerializeCompact(DataStream& s) const {
+    // The invited user is named in full, later measurements refer to it by key hash
+    s << invite_id << invited_user << measurement_type;
+    WriteCurrency(s, currency_code);
+    WriteTime(s, created_at);
+    WriteSignedVarInt(s, expires_at - created_at);
+    WriteSignedVarInt(s, block_height);
+    s << signature;
+}
+
+void CMeasurementInviteData::UnserializeCompact(SpanReader& s) {
+    s >> invite_id >> invited_user >> measurement_type;
+    currency_code = ReadCurrency(s);
+    created_at = ReadTime(s);
+    expires_at = AddTime(created_at, ReadSignedVarInt(s));
+    const int64_t height = ReadSignedVarInt(s);
+    if (height < std::numeric_limits<int>::min() || height > std::numeric_limits<int>::max()) {
+        throw std::ios_base::failure("Block height out of range in compact O payload");
+    }
+    block_height = static_cast<int>(height);
+    s >> signature;
 }
 
 bool CMeasurementInviteData::FromScript(const CScript& script, CMeasurementInviteData& data) {
-    auto pc = script.begin();
-    std::vector<unsigned char> vch;
-    opcodetype opcode;
-    
-    // Check for OP_RETURN
-    if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) {
+    auto decoded = DecodeScript<CMeasurementInviteData>(script, OTxType::MEASUREMENT_INVITE);
+    if (!decoded) {
         return false;
     }
-    
-    // Check for O_TX_PREFIX
-    if (!script.GetOp(pc, opcode, vch)) {
+    data = std::move(*decoded);
+    return true;
+}
+
+std::optional<CMeasurementInviteData> ExtractMeasurementInvite(const OTxView& view) {
+    return DecodeView<CMeasurementInviteData>(view, OTxType::MEASUREMENT_INVITE);
+}
+
+std::optional<CMeasurementInviteData> ExtractMeasurementInvite(const CTransaction& tx) {
+    return ExtractFromTransaction(tx, &ExtractMeasurementInvite);
+}
+
+// ===== CBatchData =====
+
+bool CBatchData::IsValid() const {
+    switch (record_type) {
+    case OTxType::WATER_PRICE:
+    case OTxType::EXCHANGE_RATE:
+    case OTxType::MEASUREMENT_INVITE:
+        if (record_version != O_TX_VERSION && record_version != O_TX_VERSION_COMPACT) {
+            return false;
+        }
+        break;
+    case OTxType::MEASUREMENT_VALIDATION:
+        // Validations have no compact encoding
+        if (record_version != O_TX_VERSION) {
+            return false;
+        }
+        break;
+    default:
         return false;
     }
-    if (vch.size() != O_TX_PREFIX.size() || 
-        !std::equal(vch.begin(), vch.end(), O_TX_PREFIX.begin())) {
+    
+    if (records.empty() || records.size() > MAX_O_BATCH_RECORDS) {
         return false;
     }
     
-    // Check for MEASUREMENT_INVITE type
-    if (!script.GetOp(pc, opcode, vch)) {
+    // Invitations are not signed yet, see CMeasurementInviteData::IsValid.
+    // Their batches carry no signature at all, so their encoding is fixed.
+    if (record_type == OTxType::MEASUREMENT_INVITE) {
+        if (submitter.size() != 0 || !signature.empty()) {
+            return false;
+        }
+    } else if (!submitter.IsValid() || signature.empty()) {
         return false;
     }
-    if (vch.size() != 1 || vch[0] != static_cast<uint8_t>(OTxType::MEASUREMENT_INVITE)) {
+    
+    // A repeated record would be applied twice under the same signature
+    std::vector<const std::vector<unsigned char>*> sorted;
+    sorted.reserve(records.size());
+    for (const auto& record : records) {
+        sorted.push_back(&record);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return *a < *b; });
+    if (std::adjacent_find(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return *a == *b; }) != sorted.end()) {
         return false;
     }
     
-    // Parse serialized data
-    if (!script.GetOp(pc, opcode, vch)) {
+    return true;
+}
+
+uint256 CBatchData::GetMerkleRoot(bool* mutated) const {
+    std::vector<uint256> leaves;
+    leaves.reserve(records.size());
+    for (const auto& record : records) {
+        leaves.push_back(Hash(record));
+    }
+    return ComputeMerkleRoot(std::move(leaves), mutated);
+}
+
+uint256 CBatchData::GetHash(bool* mutated) const {
+    HashWriter ss{};
+    ss << static_cast<uint8_t>(record_type) << record_version << GetMerkleRoot(mutated) << submitter;
+    return ss.GetHash();
+}
+
+bool CBatchData::VerifySignature() const {
+    // [A, B, C] and [A, B, C, C] share a merkle root and so a signature
+    bool mutated{false};
+    const uint256 hash{GetHash(&mutated)};
+    if (mutated) {
         return false;
     }
-    
-    try {
-        DataStream ds{vch};
-        ds >> data;
-        return true;
-    } catch (...) {
+    return VerifySchnorr(submitter, hash, signature);
+}
+
+CScript CBatchData::ToScript() const {
+    DataStream ds;
+    ds << *this;
+    return MakeOScript(OTxType::BATCH, O_TX_VERSION, ds);
+}
+
+bool CBatchData::FromScript(const CScript& script, CBatchData& data) {
+    auto decoded = DecodeScript<CBatchData>(script, OTxType::BATCH);
+    if (!decoded) {
         return false;
     }
+    data = std::move(*decoded);
+    return data.IsValid();
 }
 
-std::optional<CMeasurementInviteData> ExtractMeasurementInvite(const CTransaction& tx) {
-    for (const auto& output : tx.vout) {
-        CMeasurementInviteData data;
-        if (CMeasurementInviteData::FromScript(output.scriptPubKey, data)) {
-            return data;
-        }
+std::optional<CBatchData> ExtractBatch(const OTxView& view) {
+    auto data = DecodeView<CBatchData>(view, OTxType::BATCH);
+    if (!data || !data->IsValid()) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return data;
+}
+
+std::optional<CBatchData> ExtractBatch(const CTransaction& tx) {
+    return ExtractFromTransaction(tx, &ExtractBatch);
 }
 
 } // namespace OTransactions
@@ -5,13 +5,18 @@
 #ifndef BITCOIN_PRIMITIVES_O_TRANSACTIONS_H
 #define BITCOIN_PRIMITIVES_O_TRANSACTIONS_H
 
+#include <attributes.h>
+#include <primitives/o_payload.h>
 #include <primitives/transaction.h>
 #include <pubkey.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <streams.h>
 #include <uint256.h>
 #include <util/strencodings.h>
 
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -24,14 +29,18 @@ enum class OTxType : uint8_t {
     EXCHANGE_RATE = 0x03,        // Exchange rate measurement
     BUSINESS_REGISTER = 0x04,    // Business miner registration (future)
     MEASUREMENT_VALIDATION = 0x05, // Human validation of a measurement
-    MEASUREMENT_INVITE = 0x06    // Measurement invitation (consensus on who measures what)
+    MEASUREMENT_INVITE = 0x06,   // Measurement invitation (consensus on who measures what)
+    BATCH = 0x07                 // Several records of one of the types above, see CBatchData
 };
 
-/** O Blockchain Transaction Version */
-static constexpr uint8_t O_TX_VERSION = 0x01;
-
-/** OP_RETURN prefix for O transactions: "OBLK" in hex */
-static const std::vector<unsigned char> O_TX_PREFIX = {0x4F, 0x42, 0x4C, 0x4B};
+/**
+ * Size of a BIP340 Schnorr signature. Payloads that carry the signer's key
+ * (O_TX_VERSION measurements and validations, batches) are signed with
+ * Schnorr by its x-only key. O_TX_VERSION_COMPACT measurements carry only
+ * the key hash and are signed with a 65 byte compact ECDSA signature from
+ * which the key is recovered. Each payload accepts its one scheme only.
+ */
+static constexpr size_t O_SCHNORR_SIG_SIZE{64};
 
 /**
  * Generic User Verification Transaction Data
@@ -101,6 +110,7 @@ public:
     std::string proof_type;                  // "url" or "gps_photo"
     std::string proof_data;                  // URL or GPS coords + photo hash
     std::vector<unsigned char> signature;    // Measurer's signature
+    CKeyID measurer_id;                      // Compact payloads only: key hash of measurer, the invited user
     
     CWaterPriceMeasurementData()
         : currency_code(), price(0), measurer(), timestamp(0),
@@ -117,14 +127,29 @@ public:
     /** Get price as double */
     double GetPriceAsDouble() const { return static_cast<double>(price) / 1000000.0; }
     
-    /** Get hash for signing/verification */
+    /**
+     * Get hash for signing/verification, also the id the measurement is
+     * stored under. The measurer enters by key hash, so full and compact
+     * payloads of one measurement hash alike.
+     */
     uint256 GetHash() const;
     
-    /** Create OP_RETURN script for this measurement */
-    CScript ToScript() const;
+    /**
+     * Check the measurer's signature over GetHash(): Schnorr when the
+     * measurer key is carried, compact ECDSA recovering to measurer_id
+     * for compact payloads, see O_SCHNORR_SIG_SIZE.
+     */
+    bool VerifySignature() const;
+    
+    /** Create OP_RETURN script for this measurement in the given payload version */
+    CScript ToScript(uint8_t version = O_TX_VERSION) const;
     
     /** Parse from OP_RETURN script */
     static bool FromScript(const CScript& script, CWaterPriceMeasurementData& data);
+    
+    /** O_TX_VERSION_COMPACT encoding */
+    void SerializeCompact(DataStream& s) const;
+    void UnserializeCompact(SpanReader& s);
 };
 
 /**
@@ -143,6 +168,7 @@ public:
     uint256 invite_id;                       // Measurement invitation ID
     std::string proof_data;                  // Exchange platform URL or proof
     std::vector<unsigned char> signature;    // Measurer's signature
+    CKeyID measurer_id;                      // Compact payloads only: key hash of measurer, the invited user
     
     CExchangeRateMeasurementData()
         : from_currency(), to_currency(), exchange_rate(0), measurer(),
@@ -159,14 +185,29 @@ public:
     /** Get rate as double */
     double GetRateAsDouble() const { return static_cast<double>(exchange_rate) / 1000000.0; }
     
-    /** Get hash for signing/verification */
+    /**
+     * Get hash for signing/verification, also the id the measurement is
+     * stored under. The measurer enters by key hash, so full and compact
+     * payloads of one measurement hash alike.
+     */
     uint256 GetHash() const;
     
-    /** Create OP_RETURN script for this measurement */
-    CScript ToScript() const;
+    /**
+     * Check the measurer's signature over GetHash(): Schnorr when the
+     * measurer key is carried, compact ECDSA recovering to measurer_id
+     * for compact payloads, see O_SCHNORR_SIG_SIZE.
+     */
+    bool VerifySignature() const;
+    
+    /** Create OP_RETURN script for this measurement in the given payload version */
+    CScript ToScript(uint8_t version = O_TX_VERSION) const;
     
     /** Parse from OP_RETURN script */
     static bool FromScript(const CScript& script, CExchangeRateMeasurementData& data);
+    
+    /** O_TX_VERSION_COMPACT encoding */
+    void SerializeCompact(DataStream& s) const;
+    void UnserializeCompact(SpanReader& s);
 };
 
 /**
@@ -202,6 +243,9 @@ public:
     /** Get hash for signing/verification */
     uint256 GetHash() const;
     
+    /** Check the validator's Schnorr signature over GetHash() */
+    bool VerifySignature() const;
+    
     /** Create OP_RETURN script for this validation */
     CScript ToScript() const;
     
@@ -241,37 +285,193 @@ public:
     /** Get hash for signing/verification */
     uint256 GetHash() const;
     
-    /** Create OP_RETURN script for this invitation */
-    CScript ToScript() const;
+    /** Create OP_RETURN script for this invitation in the given payload version */
+    CScript ToScript(uint8_t version = O_TX_VERSION) const;
     
     /** Parse from OP_RETURN script */
     static bool FromScript(const CScript& script, CMeasurementInviteData& data);
+    
+    /** O_TX_VERSION_COMPACT encoding */
+    void SerializeCompact(DataStream& s) const;
+    void UnserializeCompact(SpanReader& s);
 };
 
 /**
  * Helper functions for O transactions
  */
 
+/**
+ * The O payload of a transaction, decoded without copying. The payload
+ * points into the output script, so the view must not outlive the
+ * transaction it was taken from.
+ */
+struct OTxView {
+    OTxType type;
+    uint8_t version;
+    uint32_t output_index;
+    std::span<const unsigned char> payload;
+};
+
+/**
+ * Get the O payload of a transaction, the first output that is an O output.
+ * Callers decoding more than one thing from a transaction take the view once
+ * and pass it to the OTxView overloads below, see PrecheckOTransaction.
+ */
+std::optional<OTxView> GetOTxView(const CTransaction& tx LIFETIMEBOUND);
+
+/**
+ * Deserialize the data of an O payload of the given version, nullopt if it
+ * is malformed or the type has no encoding for that version
+ */
+template <typename T>
+std::optional<T> DeserializeOPayload(std::span<const unsigned char> payload, uint8_t version = O_TX_VERSION) {
+    try {
+        T data;
+        SpanReader reader{payload};
+        if (version == O_TX_VERSION) {
+            reader >> data;
+        } else if constexpr (requires { data.UnserializeCompact(reader); }) {
+            if (version != O_TX_VERSION_COMPACT) {
+                return std::nullopt;
+            }
+            data.UnserializeCompact(reader);
+        } else {
+            return std::nullopt;
+        }
+        return data;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+/**
+ * Serialize data as an O payload of the given version. Types without a
+ * compact encoding are always written as version 1.
+ */
+template <typename T>
+std::vector<unsigned char> SerializeOPayload(const T& data, uint8_t version = O_TX_VERSION) {
+    DataStream ds;
+    if constexpr (requires { data.SerializeCompact(ds); }) {
+        if (version == O_TX_VERSION_COMPACT) {
+            data.SerializeCompact(ds);
+        } else {
+            ds << data;
+        }
+    } else {
+        ds << data;
+    }
+    return std::vector<unsigned char>(UCharCast(ds.data()), UCharCast(ds.data() + ds.size()));
+}
+
+/** Maximum number of records in a batch O transaction */
+static constexpr size_t MAX_O_BATCH_RECORDS{100};
+
+/**
+ * Batch O Transaction Data
+ * 
+ * Carries up to MAX_O_BATCH_RECORDS water price, exchange rate, validation
+ * or invitation records of one type in a single transaction. Each record is
+ * the payload a transaction of its own would carry, without the record's
+ * signature. One signature by the submitter covers the merkle root of all
+ * records, and every measurement or validation in the batch must be the
+ * submitter's own. Invitation batches are written by miners and, like
+ * single invitations, are not signed yet; they carry neither a submitter nor
+ * a signature and are accepted on the same terms as single invitations.
+ * 
+ * The signature is a BIP340 Schnorr signature by the x-only key of a
+ * compressed submitter.
+ */
+class CBatchData {
+public:
+    OTxType record_type;                          // Type of every record
+    uint8_t record_version;                       // Payload version of the records
+    std::vector<std::vector<unsigned char>> records; // Serialized records
+    CPubKey submitter;                            // Who signed the batch
+    std::vector<unsigned char> signature;         // Schnorr or compact signature of GetHash() by the submitter
+    
+    CBatchData()
+        : record_type(OTxType::WATER_PRICE), record_version(O_TX_VERSION), records(),
+          submitter(), signature() {}
+    
+    SERIALIZE_METHODS(CBatchData, obj) {
+        uint8_t type_val = static_cast<uint8_t>(obj.record_type);
+        READWRITE(type_val, obj.record_version, obj.records, obj.submitter, obj.signature);
+        SER_READ(obj, obj.record_type = static_cast<OTxType>(type_val));
+    }
+    
+    /** Append a record, dropping its signature which the batch signature replaces */
+    template <typename T>
+    void AddRecord(T record) {
+        record.signature.clear();
+        records.push_back(SerializeOPayload(record, record_version));
+    }
+    
+    /**
+     * Decode record i. The record is given the batch signature so that it
+     * passes the checks of a single record; the signature is over the batch,
+     * not the record, and is only checked by CBatchData::VerifySignature.
+     */
+    template <typename T>
+    std::optional<T> GetRecord(size_t i) const {
+        auto record = DeserializeOPayload<T>(records.at(i), record_version);
+        if (record) {
+            record->signature = signature;
+        }
+        return record;
+    }
+    
+    /** Validate the batch structure, not its records or signature. Repeated records are invalid. */
+    bool IsValid() const;
+    
+    /**
+     * Merkle root over the hashes of the serialized records. mutated is set
+     * when repeated records make a different list hash to the same root.
+     */
+    uint256 GetMerkleRoot(bool* mutated = nullptr) const;
+    
+    /** Get hash for signing/verification, commits to all records through the merkle root */
+    uint256 GetHash(bool* mutated = nullptr) const;
+    
+    /** Check the signature was made by the submitter over a root no other list of records has */
+    bool VerifySignature() const;
+    
+    /** Create OP_RETURN script for this batch */
+    CScript ToScript() const;
+    
+    /** Parse from OP_RETURN script */
+    static bool FromScript(const CScript& script, CBatchData& data);
+};
+
 /** Check if a transaction contains O-specific data */
 bool IsOTransaction(const CTransaction& tx);
 
-/** Get O transaction type from transaction */
+/** Get O transaction type from transaction, nullopt for unknown payload versions */
 std::optional<OTxType> GetOTxType(const CTransaction& tx);
+std::optional<OTxType> GetOTxType(const OTxView& view);
 
 /** Extract user verification data from transaction */
 std::optional<CUserVerificationData> ExtractUserVerification(const CTransaction& tx);
+std::optional<CUserVerificationData> ExtractUserVerification(const OTxView& view);
 
 /** Extract water price measurement data from transaction */
 std::optional<CWaterPriceMeasurementData> ExtractWaterPriceMeasurement(const CTransaction& tx);
+std::optional<CWaterPriceMeasurementData> ExtractWaterPriceMeasurement(const OTxView& view);
 
 /** Extract exchange rate measurement data from transaction */
 std::optional<CExchangeRateMeasurementData> ExtractExchangeRateMeasurement(const CTransaction& tx);
+std::optional<CExchangeRateMeasurementData> ExtractExchangeRateMeasurement(const OTxView& view);
 
 /** Extract measurement validation data from transaction */
 std::optional<CMeasurementValidationData> ExtractMeasurementValidation(const CTransaction& tx);
+std::optional<CMeasurementValidationData> ExtractMeasurementValidation(const OTxView& view);
 
 /** Extract measurement invitation data from transaction */
 std::optional<CMeasurementInviteData> ExtractMeasurementInvite(const CTransaction& tx);
+std::optional<CMeasurementInviteData> ExtractMeasurementInvite(const OTxView& view);
+
+/** Extract batch data from transaction */
+std::optional<CBatchData> ExtractBatch(const CTransaction& tx);
+std::optional<CBatchData> ExtractBatch(const OTxView& view);
 
 } // namespace OTransactions
 
@@ -17,6 +17,7 @@
 #include <consensus/geographic_access_control.h>
 #include <measurement/measurement_system.h>
 #include <measurement/o_measurement_db.h>
+#include <measurement/stability_snapshot.h>
 #include <node/context.h>
 #include <util/strencodings.h>
 #include <util/time.h>
@@ -52,6 +53,19 @@ static bool WriteErrorResponse(HTTPRequest* req, const std::string& error_code,
     return WriteJSONResponse(req, error, status);
 }
 
+// Reply 304 if the client already holds the representation tagged etag
+static bool WriteNotModified(HTTPRequest* req, const std::string& etag)
+{
+    auto if_none_match = req->GetHeader("If-None-Match");
+    if (!if_none_match.first || if_none_match.second.find(etag) == std::string::npos) {
+        return false;
+    }
+    req->WriteHeader("ETag", etag);
+    req->WriteHeader("Access-Control-Allow-Origin", "*");
+    req->WriteReply(HTTP_NOT_MODIFIED);
+    return true;
+}
+
 // Helper to parse JSON request body
 static bool ParseJSONRequest(HTTPRequest* req, UniValue& json)
 {
@@ -448,41 +462,32 @@ bool rest_map_countries(const std::any& context, HTTPRequest* req, const std::st
         return WriteErrorResponse(req, "METHOD_NOT_ALLOWED", "Only GET method is allowed", HTTP_BAD_METHOD);
     }
     
-    // Get all supported fiat currencies
-    std::vector<std::string> currencies = OMeasurement::g_measurement_system.GetSupportedFiatCurrencies();
+    // Served from the materialized snapshot, rebuilt when measurements change
+    auto snapshot = OMeasurement::g_stability_snapshot.Get();
+    if (WriteNotModified(req, snapshot->etag)) {
+        return true;
+    }
     
     UniValue countries(UniValue::VARR);
     int stable_count = 0;
     int unstable_count = 0;
     
-    for (const auto& currency : currencies) {
-        std::string o_currency = OMeasurement::g_measurement_system.GetOCurrencyFromFiat(currency);
-        if (o_currency.empty()) {
-            continue;
-        }
-        
-        auto avg_water = g_measurement_system.GetAverageWaterPrice(currency, 30);
-        if (!avg_water.has_value()) continue;
+    for (const auto& entry : snapshot->entries) {
+        if (!entry.avg_water_price.has_value()) continue;
         
-        auto avg_exchange = g_measurement_system.GetAverageExchangeRateWithConfidence(o_currency, currency, 7);
-        if (!avg_exchange.has_value()) continue;
-        
-        double deviation = g_measurement_system.CalculateStabilityDeviation(o_currency, avg_exchange->value);
-        bool is_stable = deviation <= 0.10;
-        
-        if (is_stable) stable_count++;
+        if (entry.is_stable) stable_count++;
         else unstable_count++;
         
         UniValue country(UniValue::VOBJ);
-        country.pushKV("country_code", currency); // Simplified - would map to actual country codes
-        country.pushKV("currency", currency);
-        country.pushKV("o_currency", o_currency);
-        country.pushKV("avg_water_price", avg_water.value());
-        country.pushKV("water_price_currency", currency);
-        country.pushKV("is_stable", is_stable);
-        country.pushKV("stability_color", is_stable ? "green" : "red");
-        country.pushKV("measurement_count", avg_exchange->measurement_count);
-        country.pushKV("last_updated", GetTime());
+        country.pushKV("country_code", entry.currency); // Simplified - would map to actual country codes
+        country.pushKV("currency", entry.currency);
+        country.pushKV("o_currency", entry.o_currency);
+        country.pushKV("avg_water_price", entry.avg_water_price.value());
+        country.pushKV("water_price_currency", entry.currency);
+        country.pushKV("is_stable", entry.is_stable);
+        country.pushKV("stability_color", entry.is_stable ? "green" : "red");
+        country.pushKV("measurement_count", entry.measurement_count);
+        country.pushKV("last_updated", snapshot->build_time);
         
         // TODO: Add actual country coordinates
         UniValue coords(UniValue::VOBJ);
@@ -499,6 +504,7 @@ bool rest_map_countries(const std::any& context, HTTPRequest* req, const std::st
     response.pushKV("stable_countries", stable_count);
     response.pushKV("unstable_countries", unstable_count);
     
+    req->WriteHeader("ETag", snapshot->etag);
     return WriteJSONResponse(req, response);
 }
 
@@ -525,14 +531,12 @@ bool rest_notifications_invites(const std::any& context, HTTPRequest* req, const
         return WriteErrorResponse(req, "DATABASE_ERROR", "Measurement database not initialized", HTTP_INTERNAL_SERVER_ERROR);
     }
     
-    std::vector<OMeasurement::MeasurementInvite> active_invites = g_measurement_db->GetActiveInvites();
-    
-    // Filter invites for this user
     int64_t current_time = GetTime();
+    std::vector<OMeasurement::MeasurementInvite> active_invites = g_measurement_db->GetActiveUserInvites(publickey, current_time);
+    
     UniValue invites(UniValue::VARR);
     
     for (const auto& invite : active_invites) {
-        if (invite.invited_user != publickey) continue;
         if (!invite.IsValid(current_time)) continue;
         
         UniValue inv(UniValue::VOBJ);
@@ -1094,26 +1098,21 @@ bool rest_info_stability_status(const std::any& context, HTTPRequest* req, const
         return WriteErrorResponse(req, "METHOD_NOT_ALLOWED", "Only GET method is allowed", HTTP_BAD_METHOD);
     }
     
-    std::vector<std::string> currencies = OMeasurement::g_measurement_system.GetSupportedFiatCurrencies();
+    auto snapshot = OMeasurement::g_stability_snapshot.Get();
+    if (WriteNotModified(req, snapshot->etag)) {
+        return true;
+    }
     
     int total = 0;
     int stable = 0;
     int unstable = 0;
     
-    for (const auto& currency : currencies) {
-        std::string o_currency = OMeasurement::g_measurement_system.GetOCurrencyFromFiat(currency);
-        if (o_currency.empty()) {
-            continue;
-        }
-        auto avg = g_measurement_system.GetAverageExchangeRateWithConfidence(o_currency, currency, 7);
-        if (avg.has_value()) {
-            total++;
-            double deviation = g_measurement_system.CalculateStabilityDeviation(o_currency, avg->value);
-            if (deviation <= 0.10) {
-                stable++;
-            } else {
-                unstable++;
-            }
+    for (const auto& entry : snapshot->entries) {
+        total++;
+        if (entry.is_stable) {
+            stable++;
+        } else {
+            unstable++;
         }
     }
     
@@ -1124,8 +1123,9 @@ bool rest_info_stability_status(const std::any& context, HTTPRequest* req, const
     response.pushKV("stable_currencies", stable);
     response.pushKV("unstable_currencies", unstable);
     response.pushKV("stability_percentage", stability_percentage);
-    response.pushKV("last_updated", GetTime());
+    response.pushKV("last_updated", snapshot->build_time);
     
+    req->WriteHeader("ETag", snapshot->etag);
     return WriteJSONResponse(req, response);
 }
 
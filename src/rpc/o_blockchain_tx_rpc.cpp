@@ -19,8 +19,10 @@
 #include <policy/policy.h>
 #include <primitives/o_transactions.h>
 #include <primitives/transaction.h>
+#include <random.h>
 #include <rpc/blockchain.h>
 #include <rpc/request.h>
+#include <tinyformat.h>
 #include <univalue.h>
 #include <util/moneystr.h>
 #include <util/strencodings.h>
@@ -74,6 +76,83 @@ static UniValue CreateAndBroadcastOTransaction(
     return result;
 }
 
+/** Get a new key from the wallet to sign O data with */
+static CKey GetNewSigningKey(CWallet& wallet, const std::string& label)
+{
+    util::Result<CTxDestination> dest_result = wallet.GetNewDestination(OutputType::LEGACY, label);
+    if (!dest_result) {
+        throw JSONRPCError(RPC_WALLET_ERROR, "Failed to get wallet address: " + util::ErrorString(dest_result).original);
+    }
+    
+    const PKHash* pkhash = std::get_if<PKHash>(&*dest_result);
+    if (!pkhash) {
+        throw JSONRPCError(RPC_WALLET_ERROR, "Address is not a valid public key hash");
+    }
+    
+    CKey private_key;
+    std::unique_ptr<SigningProvider> provider = wallet.GetSolvingProvider(GetScriptForDestination(*dest_result));
+    if (!provider || !provider->GetKey(ToKeyID(*pkhash), private_key)) {
+        throw JSONRPCError(RPC_WALLET_ERROR, "Failed to get private key for signing");
+    }
+    return private_key;
+}
+
+/** The entries of a batch RPC argument, checked against MAX_O_BATCH_RECORDS */
+static const std::vector<UniValue>& GetBatchEntries(const UniValue& param)
+{
+    const std::vector<UniValue>& entries = param.get_array().getValues();
+    if (entries.empty() || entries.size() > MAX_O_BATCH_RECORDS) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Batch must contain 1 to %d entries", MAX_O_BATCH_RECORDS));
+    }
+    return entries;
+}
+
+/**
+ * Sign a batch with key and create its transaction. The records are checked
+ * as they will be decoded, carrying the batch signature.
+ */
+template <typename T>
+static UniValue CreateAndBroadcastOBatch(CBatchData& batch, const CKey& key, CWallet* pwallet)
+{
+    // Schnorr signatures verify without public key recovery
+    batch.submitter = key.GetPubKey();
+    batch.signature.resize(O_SCHNORR_SIG_SIZE);
+    if (!key.SignSchnorr(batch.GetHash(), batch.signature, /*merkle_root=*/nullptr, GetRandHash())) {
+        throw JSONRPCError(RPC_WALLET_ERROR, "Failed to sign batch");
+    }
+    
+    if (!batch.IsValid()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid batch data, entries must be distinct");
+    }
+    for (size_t i = 0; i < batch.records.size(); i++) {
+        const std::optional<T> record = batch.GetRecord<T>(i);
+        if (!record || !record->IsValid()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid data in entry %d", i));
+        }
+    }
+    
+    UniValue result = CreateAndBroadcastOTransaction(batch.ToScript(), "BATCH", pwallet);
+    result.pushKV("records", batch.records.size());
+    result.pushKV("merkle_root", batch.GetMerkleRoot().GetHex());
+    result.pushKV("submitter", HexStr(batch.submitter));
+    return result;
+}
+
+/** Result fields shared by the batch RPCs */
+static std::vector<RPCResult> BatchResultFields(const std::string& record_type)
+{
+    return {
+        {RPCResult::Type::STR_HEX, "txid", "Transaction ID"},
+        {RPCResult::Type::STR_HEX, "tx_hex", "Transaction hex for broadcasting"},
+        {RPCResult::Type::STR, "type", "Transaction type (BATCH)"},
+        {RPCResult::Type::STR, "status", "Transaction status"},
+        {RPCResult::Type::STR, "note", "Broadcast instructions"},
+        {RPCResult::Type::NUM, "records", "Number of " + record_type + " records in the batch"},
+        {RPCResult::Type::STR_HEX, "merkle_root", "Merkle root of the records, signed by the submitter"},
+        {RPCResult::Type::STR_HEX, "submitter", "Public key that signed the batch"},
+    };
+}
+
 // ===== RPC Command Implementations =====
 
 static RPCHelpMan submituserverificationtx()
@@ -235,13 +314,17 @@ static RPCHelpMan submitwaterpricetx()
                 throw JSONRPCError(RPC_WALLET_ERROR, "Failed to get private key for signing");
             }
             
+            // Payloads carrying the key are signed with Schnorr, by a compressed key
             uint256 hash = data.GetHash();
-            std::vector<unsigned char> signature_vec;
-            if (!private_key.SignCompact(hash, signature_vec)) {
+            std::vector<unsigned char> signature_vec(O_SCHNORR_SIG_SIZE);
+            if (!private_key.SignSchnorr(hash, signature_vec, /*merkle_root=*/nullptr, GetRandHash())) {
                 throw JSONRPCError(RPC_WALLET_ERROR, "Failed to sign measurement");
             }
             
             data.signature = signature_vec;
+            if (!data.VerifySignature()) {
+                throw JSONRPCError(RPC_WALLET_ERROR, "The measurer key must be compressed to sign with Schnorr");
+            }
             
             // Validate data
             if (!data.IsValid()) {
@@ -343,13 +426,17 @@ static RPCHelpMan submitexchangeratetx()
                 throw JSONRPCError(RPC_WALLET_ERROR, "Failed to get private key for signing");
             }
             
+            // Payloads carrying the key are signed with Schnorr, by a compressed key
             uint256 hash = data.GetHash();
-            std::vector<unsigned char> signature_vec;
-            if (!private_key.SignCompact(hash, signature_vec)) {
+            std::vector<unsigned char> signature_vec(O_SCHNORR_SIG_SIZE);
+            if (!private_key.SignSchnorr(hash, signature_vec, /*merkle_root=*/nullptr, GetRandHash())) {
                 throw JSONRPCError(RPC_WALLET_ERROR, "Failed to sign measurement");
             }
             
             data.signature = signature_vec;
+            if (!data.VerifySignature()) {
+                throw JSONRPCError(RPC_WALLET_ERROR, "The measurer key must be compressed to sign with Schnorr");
+            }
             
             // Validate data
             if (!data.IsValid()) {
@@ -457,13 +544,17 @@ static RPCHelpMan submitvalidationtx()
                 throw JSONRPCError(RPC_WALLET_ERROR, "Failed to get private key for signing");
             }
             
+            // Payloads carrying the key are signed with Schnorr, by a compressed key
             uint256 hash = data.GetHash();
-            std::vector<unsigned char> signature_vec;
-            if (!private_key.SignCompact(hash, signature_vec)) {
+            std::vector<unsigned char> signature_vec(O_SCHNORR_SIG_SIZE);
+            if (!private_key.SignSchnorr(hash, signature_vec, /*merkle_root=*/nullptr, GetRandHash())) {
                 throw JSONRPCError(RPC_WALLET_ERROR, "Failed to sign validation");
             }
             
             data.signature = signature_vec;
+            if (!data.VerifySignature()) {
+                throw JSONRPCError(RPC_WALLET_ERROR, "The validator key must be compressed to sign with Schnorr");
+            }
             
             // Validate data
             if (!data.IsValid()) {
@@ -568,6 +659,204 @@ static RPCHelpMan submitinvitetx()
     };
 }
 
+static RPCHelpMan submitwaterpricebatchtx()
+{
+    return RPCHelpMan{
+        "submitwaterpricebatchtx",
+        "\nCreate one BATCH blockchain transaction carrying several water price measurements.\n"
+        "All measurements are made by one wallet key, which signs the batch once.\n",
+        {
+            {"measurements", RPCArg::Type::ARR, RPCArg::Optional::NO, "The measurements, at most " + util::ToString(MAX_O_BATCH_RECORDS),
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"currency_code", RPCArg::Type::STR, RPCArg::Optional::NO, "Currency code (USD, EUR, JPY, etc.)"},
+                            {"price", RPCArg::Type::NUM, RPCArg::Optional::NO, "Price * 1,000,000 (6 decimal places)"},
+                            {"invite_id", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "Measurement invitation ID"},
+                            {"proof_type", RPCArg::Type::STR, RPCArg::Optional::NO, "'url' or 'gps_photo'"},
+                            {"proof_data", RPCArg::Type::STR, RPCArg::Optional::NO, "URL or GPS coords + photo hash"},
+                        },
+                    },
+                },
+            },
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "", BatchResultFields("water price")
+        },
+        RPCExamples{
+            HelpExampleCli("submitwaterpricebatchtx", "'[{\"currency_code\":\"USD\",\"price\":1500000,\"invite_id\":\"abc123...\",\"proof_type\":\"url\",\"proof_data\":\"https://walmart.com/water\"}]'")
+            + HelpExampleRpc("submitwaterpricebatchtx", "[{\"currency_code\":\"USD\",\"price\":1500000,\"invite_id\":\"abc123...\",\"proof_type\":\"url\",\"proof_data\":\"https://walmart.com/water\"}]")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+        {
+            // Get wallet
+            std::shared_ptr<CWallet> const pwallet = GetWalletForJSONRPCRequest(request);
+            if (!pwallet) throw JSONRPCError(RPC_WALLET_NOT_FOUND, "Wallet not found");
+            
+            LOCK(pwallet->cs_wallet);
+            
+            // Ensure wallet is unlocked for signing
+            EnsureWalletIsUnlocked(*pwallet);
+            
+            const CKey key = GetNewSigningKey(*pwallet, "measurement");
+            const int64_t now = GetTime();
+            
+            // Records name the measurer by key hash, the batch carries the key
+            CBatchData batch;
+            batch.record_type = OTxType::WATER_PRICE;
+            batch.record_version = O_TX_VERSION_COMPACT;
+            for (const UniValue& entry : GetBatchEntries(request.params[0])) {
+                CWaterPriceMeasurementData data;
+                data.currency_code = entry.find_value("currency_code").get_str();
+                data.price = entry.find_value("price").getInt<int64_t>();
+                data.invite_id = ParseHashO(entry, "invite_id");
+                data.proof_type = entry.find_value("proof_type").get_str();
+                data.proof_data = entry.find_value("proof_data").get_str();
+                data.timestamp = now;
+                data.measurer_id = key.GetPubKey().GetID();
+                batch.AddRecord(data);
+            }
+            
+            return CreateAndBroadcastOBatch<CWaterPriceMeasurementData>(batch, key, pwallet.get());
+        },
+    };
+}
+
+static RPCHelpMan submitexchangeratebatchtx()
+{
+    return RPCHelpMan{
+        "submitexchangeratebatchtx",
+        "\nCreate one BATCH blockchain transaction carrying several exchange rate measurements.\n"
+        "All measurements are made by one wallet key, which signs the batch once.\n",
+        {
+            {"measurements", RPCArg::Type::ARR, RPCArg::Optional::NO, "The measurements, at most " + util::ToString(MAX_O_BATCH_RECORDS),
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"from_currency", RPCArg::Type::STR, RPCArg::Optional::NO, "From currency (e.g., OUSD)"},
+                            {"to_currency", RPCArg::Type::STR, RPCArg::Optional::NO, "To currency (e.g., USD)"},
+                            {"exchange_rate", RPCArg::Type::NUM, RPCArg::Optional::NO, "Rate * 1,000,000 (6 decimal places)"},
+                            {"invite_id", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "Measurement invitation ID"},
+                            {"proof_data", RPCArg::Type::STR, RPCArg::Optional::NO, "Exchange platform URL or proof"},
+                        },
+                    },
+                },
+            },
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "", BatchResultFields("exchange rate")
+        },
+        RPCExamples{
+            HelpExampleCli("submitexchangeratebatchtx", "'[{\"from_currency\":\"OUSD\",\"to_currency\":\"USD\",\"exchange_rate\":1500000,\"invite_id\":\"def456...\",\"proof_data\":\"https://exchange.com/OUSD-USD\"}]'")
+            + HelpExampleRpc("submitexchangeratebatchtx", "[{\"from_currency\":\"OUSD\",\"to_currency\":\"USD\",\"exchange_rate\":1500000,\"invite_id\":\"def456...\",\"proof_data\":\"https://exchange.com/OUSD-USD\"}]")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+        {
+            // Get wallet
+            std::shared_ptr<CWallet> const pwallet = GetWalletForJSONRPCRequest(request);
+            if (!pwallet) throw JSONRPCError(RPC_WALLET_NOT_FOUND, "Wallet not found");
+            
+            LOCK(pwallet->cs_wallet);
+            
+            // Ensure wallet is unlocked for signing
+            EnsureWalletIsUnlocked(*pwallet);
+            
+            const CKey key = GetNewSigningKey(*pwallet, "measurement");
+            const int64_t now = GetTime();
+            
+            // Records name the measurer by key hash, the batch carries the key
+            CBatchData batch;
+            batch.record_type = OTxType::EXCHANGE_RATE;
+            batch.record_version = O_TX_VERSION_COMPACT;
+            for (const UniValue& entry : GetBatchEntries(request.params[0])) {
+                CExchangeRateMeasurementData data;
+                data.from_currency = entry.find_value("from_currency").get_str();
+                data.to_currency = entry.find_value("to_currency").get_str();
+                data.exchange_rate = entry.find_value("exchange_rate").getInt<int64_t>();
+                data.invite_id = ParseHashO(entry, "invite_id");
+                data.proof_data = entry.find_value("proof_data").get_str();
+                data.timestamp = now;
+                data.measurer_id = key.GetPubKey().GetID();
+                batch.AddRecord(data);
+            }
+            
+            return CreateAndBroadcastOBatch<CExchangeRateMeasurementData>(batch, key, pwallet.get());
+        },
+    };
+}
+
+static RPCHelpMan submitvalidationbatchtx()
+{
+    return RPCHelpMan{
+        "submitvalidationbatchtx",
+        "\nCreate one BATCH blockchain transaction carrying several measurement validations.\n"
+        "All validations are made by one wallet key, which signs the batch once.\n",
+        {
+            {"validations", RPCArg::Type::ARR, RPCArg::Optional::NO, "The validations, at most " + util::ToString(MAX_O_BATCH_RECORDS),
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"measurement_id", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "ID of measurement being validated"},
+                            {"measurement_type", RPCArg::Type::STR, RPCArg::Optional::NO, "'water_price' or 'exchange_rate'"},
+                            {"validation_result", RPCArg::Type::BOOL, RPCArg::Default{true}, "true = valid, false = invalid"},
+                            {"validation_notes", RPCArg::Type::STR, RPCArg::Default{""}, "Optional notes (e.g., why invalid)"},
+                        },
+                    },
+                },
+            },
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "", BatchResultFields("validation")
+        },
+        RPCExamples{
+            HelpExampleCli("submitvalidationbatchtx", "'[{\"measurement_id\":\"abc123...\",\"measurement_type\":\"water_price\",\"validation_result\":true}]'")
+            + HelpExampleRpc("submitvalidationbatchtx", "[{\"measurement_id\":\"abc123...\",\"measurement_type\":\"water_price\",\"validation_result\":true}]")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+        {
+            // Get wallet
+            std::shared_ptr<CWallet> const pwallet = GetWalletForJSONRPCRequest(request);
+            if (!pwallet) throw JSONRPCError(RPC_WALLET_NOT_FOUND, "Wallet not found");
+            
+            LOCK(pwallet->cs_wallet);
+            
+            // Ensure wallet is unlocked for signing
+            EnsureWalletIsUnlocked(*pwallet);
+            
+            const CKey key = GetNewSigningKey(*pwallet, "validation");
+            const int64_t now = GetTime();
+            
+            // Validations have no compact encoding
+            CBatchData batch;
+            batch.record_type = OTxType::MEASUREMENT_VALIDATION;
+            batch.record_version = O_TX_VERSION;
+            for (const UniValue& entry : GetBatchEntries(request.params[0])) {
+                CMeasurementValidationData data;
+                data.measurement_id = ParseHashO(entry, "measurement_id");
+                
+                const std::string type_str = entry.find_value("measurement_type").get_str();
+                if (type_str == "water_price") {
+                    data.measurement_type = OTxType::WATER_PRICE;
+                } else if (type_str == "exchange_rate") {
+                    data.measurement_type = OTxType::EXCHANGE_RATE;
+                } else {
+                    throw JSONRPCError(RPC_INVALID_PARAMETER, "measurement_type must be 'water_price' or 'exchange_rate'");
+                }
+                
+                const UniValue& result = entry.find_value("validation_result");
+                const UniValue& notes = entry.find_value("validation_notes");
+                data.validation_result = result.isNull() ? true : result.get_bool();
+                data.validation_notes = notes.isNull() ? "" : notes.get_str();
+                data.timestamp = now;
+                data.validator = key.GetPubKey();
+                batch.AddRecord(data);
+            }
+            
+            return CreateAndBroadcastOBatch<CMeasurementValidationData>(batch, key, pwallet.get());
+        },
+    };
+}
+
 // ===== RPC Command Registration =====
 
 void RegisterOBlockchainTxRPCCommands(CRPCTable& t)
@@ -579,6 +868,9 @@ void RegisterOBlockchainTxRPCCommands(CRPCTable& t)
         {"blockchain", &submitexchangeratetx},
         {"blockchain", &submitvalidationtx},
         {"blockchain", &submitinvitetx},
+        {"blockchain", &submitwaterpricebatchtx},
+        {"blockchain", &submitexchangeratebatchtx},
+        {"blockchain", &submitvalidationbatchtx},
     };
     
     for (const auto& c : commands) {
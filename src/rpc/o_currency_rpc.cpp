@@ -112,7 +112,7 @@ static RPCHelpMan getcurrency()
         {
             std::string symbol_or_id = request.params[0].get_str();
             
-            std::optional<CurrencyMetadata> metadata;
+            const CurrencyMetadata* metadata{nullptr};
             
             // Try as symbol first
             auto id = g_currency_registry.GetCurrencyId(symbol_or_id);
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <rpc/o_measurement_rpc.h>
+#include <consensus/o_brightid_db.h>
 #include <measurement/measurement_system.h>
 #include <measurement/o_measurement_db.h>
 #include <rpc/server.h>
@@ -371,6 +372,25 @@ static RPCHelpMan getmeasurementstatistics()
                 {RPCResult::Type::NUM, "validations", "Total validations"},
                 {RPCResult::Type::NUM, "conversion_rate_water", "Water price conversion rate"},
                 {RPCResult::Type::NUM, "conversion_rate_exchange", "Exchange rate conversion rate"},
+                {RPCResult::Type::OBJ, "lookup_caches", /*optional=*/true, "In-memory caches used when validating O transactions (see -olookupcache)",
+                {
+                    {RPCResult::Type::OBJ, "measurer", /*optional=*/true, "Measurer verification status by O address",
+                    {
+                        {RPCResult::Type::NUM, "entries", "Cached entries"},
+                        {RPCResult::Type::NUM, "capacity", "Maximum entries"},
+                        {RPCResult::Type::NUM, "hits", "Lookups served from the cache"},
+                        {RPCResult::Type::NUM, "misses", "Lookups that read the database"},
+                        {RPCResult::Type::NUM, "hit_rate", "hits / (hits + misses)"},
+                    }},
+                    {RPCResult::Type::OBJ, "invite", /*optional=*/true, "Measurement invite status by invite id",
+                    {
+                        {RPCResult::Type::NUM, "entries", "Cached entries"},
+                        {RPCResult::Type::NUM, "capacity", "Maximum entries"},
+                        {RPCResult::Type::NUM, "hits", "Lookups served from the cache"},
+                        {RPCResult::Type::NUM, "misses", "Lookups that read the database"},
+                        {RPCResult::Type::NUM, "hit_rate", "hits / (hits + misses)"},
+                    }},
+                }},
             }
         },
         RPCExamples{
@@ -395,6 +415,20 @@ static RPCHelpMan getmeasurementstatistics()
             result.pushKV("conversion_rate_water", conv_water);
             result.pushKV("conversion_rate_exchange", conv_exchange);
             
+            auto cache_stats = [](const auto& stats) {
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("entries", (uint64_t)stats.entries);
+                obj.pushKV("capacity", (uint64_t)stats.capacity);
+                obj.pushKV("hits", stats.hits);
+                obj.pushKV("misses", stats.misses);
+                obj.pushKV("hit_rate", stats.HitRate());
+                return obj;
+            };
+            UniValue caches(UniValue::VOBJ);
+            if (OConsensus::g_brightid_db) caches.pushKV("measurer", cache_stats(OConsensus::g_brightid_db->GetMeasurerCacheStats()));
+            if (g_measurement_db) caches.pushKV("invite", cache_stats(g_measurement_db->GetInviteCacheStats()));
+            if (!caches.empty()) result.pushKV("lookup_caches", std::move(caches));
+            
             return result;
         },
     };
@@ -11,6 +11,7 @@ enum HTTPStatusCode
 {
     HTTP_OK                    = 200,
     HTTP_NO_CONTENT            = 204,
+    HTTP_NOT_MODIFIED          = 304,
     HTTP_BAD_REQUEST           = 400,
     HTTP_UNAUTHORIZED          = 401,
     HTTP_FORBIDDEN             = 403,
@@ -2,8 +2,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <common/args.h>
 #include <consensus/o_brightid_db.h>
 #include <consensus/brightid_integration.h>
+#include <dbwrapper.h>
+#include <key.h>
 #include <test/util/setup_common.h>
 #include <boost/test/unit_test.hpp>
 #include <util/strencodings.h>
@@ -303,5 +306,193 @@ BOOST_AUTO_TEST_CASE(brightid_db_concurrent_write_read)
     }
 }
 
+BOOST_AUTO_TEST_CASE(brightid_db_birth_currency_index)
+{
+    auto db = std::make_unique<CBrightIDUserDB>(1 << 20, true, false);
+    
+    std::vector<CPubKey> pubkeys;
+    for (int i = 0; i < 4; i++) {
+        BrightIDUser user;
+        user.brightid_address = "birth_user_" + std::to_string(i);
+        user.context_id = (i < 3) ? "USA:OUSD" : "MEX:OMXN";
+        user.status = BrightIDStatus::VERIFIED;
+        user.is_active = true;
+        BOOST_CHECK(db->WriteUser(user.brightid_address, user));
+        
+        pubkeys.push_back(GenerateRandomKey().GetPubKey());
+        BOOST_CHECK(db->LinkAddresses(user.brightid_address, HexStr(pubkeys.back())));
+    }
+    
+    // A user without a linked O address is not a recipient
+    BrightIDUser unlinked;
+    unlinked.context_id = "USA:OUSD";
+    unlinked.status = BrightIDStatus::VERIFIED;
+    unlinked.is_active = true;
+    BOOST_CHECK(db->WriteUser("birth_user_unlinked", unlinked));
+    
+    auto usd = db->FindUsersByBirthCurrency("OUSD");
+    BOOST_CHECK_EQUAL(usd.size(), 3U);
+    BOOST_CHECK(std::find(usd.begin(), usd.end(), pubkeys[0]) != usd.end());
+    BOOST_CHECK_EQUAL(db->FindUsersByBirthCurrency("OMXN").size(), 1U);
+    BOOST_CHECK(db->FindUsersByBirthCurrency("OUS").empty());
+    BOOST_CHECK(db->FindUsersByBirthCurrency("OEUR").empty());
+    
+    // Status changes, unlinking and erasing all update the index
+    BOOST_CHECK(db->UpdateUserStatus("birth_user_0", BrightIDStatus::EXPIRED));
+    BOOST_CHECK_EQUAL(db->FindUsersByBirthCurrency("OUSD").size(), 2U);
+    BOOST_CHECK(db->UpdateUserStatus("birth_user_0", BrightIDStatus::VERIFIED));
+    BOOST_CHECK_EQUAL(db->FindUsersByBirthCurrency("OUSD").size(), 3U);
+    
+    BOOST_CHECK(db->UnlinkAddresses("birth_user_1"));
+    BOOST_CHECK_EQUAL(db->FindUsersByBirthCurrency("OUSD").size(), 2U);
+    
+    BOOST_CHECK(db->EraseUser("birth_user_2"));
+    usd = db->FindUsersByBirthCurrency("OUSD");
+    BOOST_REQUIRE_EQUAL(usd.size(), 1U);
+    BOOST_CHECK(usd[0] == pubkeys[0]);
+    
+    // Moving to another birth currency moves the index entry
+    auto moved = db->ReadUser("birth_user_0");
+    BOOST_REQUIRE(moved.has_value());
+    moved->context_id = "MEX:OMXN";
+    BOOST_CHECK(db->WriteUser("birth_user_0", *moved));
+    BOOST_CHECK(db->FindUsersByBirthCurrency("OUSD").empty());
+    BOOST_CHECK_EQUAL(db->FindUsersByBirthCurrency("OMXN").size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(brightid_db_counters)
+{
+    auto db = std::make_unique<CBrightIDUserDB>(1 << 20, true, false);
+    
+    for (int i = 0; i < 4; i++) {
+        BrightIDUser user;
+        user.brightid_address = "counted_user_" + std::to_string(i);
+        user.status = (i < 3) ? BrightIDStatus::VERIFIED : BrightIDStatus::UNVERIFIED;
+        user.trust_score = 0.85 - i * 0.1;
+        user.is_active = (i != 0);
+        BOOST_CHECK(db->WriteUser(user.brightid_address, user));
+    }
+    
+    BOOST_CHECK_EQUAL(db->GetUserCount(), 4U);
+    BOOST_CHECK_EQUAL(db->GetVerifiedUserCount(), 3U);
+    BOOST_CHECK_EQUAL(db->GetActiveUserCount(), 2U);
+    BOOST_CHECK_CLOSE(db->GetAverageTrustScore(), 0.75, 1e-6);
+    BOOST_CHECK_EQUAL(db->GetUserCountByStatus()[BrightIDStatus::VERIFIED], 3U);
+    
+    BOOST_CHECK(db->UpdateUserStatus("counted_user_1", BrightIDStatus::EXPIRED));
+    BOOST_CHECK(db->UpdateTrustScore("counted_user_2", 0.95));
+    BOOST_CHECK(db->EraseUser("counted_user_3"));
+    
+    BOOST_CHECK_EQUAL(db->GetUserCount(), 3U);
+    BOOST_CHECK_EQUAL(db->GetVerifiedUserCount(), 2U);
+    BOOST_CHECK_EQUAL(db->GetActiveUserCount(), 1U);
+    BOOST_CHECK_CLOSE(db->GetAverageTrustScore(), 0.90, 1e-6);
+    auto by_status = db->GetUserCountByStatus();
+    BOOST_CHECK_EQUAL(by_status[BrightIDStatus::EXPIRED], 1U);
+    BOOST_CHECK(by_status.count(BrightIDStatus::UNVERIFIED) == 0);
+    
+    // A batch repeating a user counts it once, and erasing it twice removes it once
+    BrightIDUser repeated;
+    repeated.status = BrightIDStatus::UNVERIFIED;
+    repeated.trust_score = 0.5;
+    BrightIDUser verified = repeated;
+    verified.status = BrightIDStatus::VERIFIED;
+    BOOST_CHECK(db->BatchWriteUsers({{"counted_user_4", repeated}, {"counted_user_4", verified}}));
+    BOOST_CHECK_EQUAL(db->GetUserCount(), 4U);
+    BOOST_CHECK_EQUAL(db->GetVerifiedUserCount(), 3U);
+    BOOST_CHECK(db->GetUserCountByStatus().count(BrightIDStatus::UNVERIFIED) == 0);
+    BOOST_CHECK(db->VerifyIntegrity());
+    
+    BOOST_CHECK(db->BatchEraseUsers({"counted_user_4", "counted_user_4"}));
+    BOOST_CHECK_EQUAL(db->GetUserCount(), 3U);
+    BOOST_CHECK_EQUAL(db->GetVerifiedUserCount(), 2U);
+    
+    BOOST_CHECK(db->VerifyIntegrity());
+}
+
+BOOST_AUTO_TEST_CASE(brightid_db_upgrade_rebuilds_indexes)
+{
+    std::vector<CPubKey> pubkeys;
+    
+    // A version 1 database holds users and links but no counters or birth currency index
+    {
+        CDBWrapper old_db{DBParams{.path = gArgs.GetDataDirNet() / "brightid_users", .cache_bytes = 1 << 20,
+                                   .wipe_data = true, .obfuscate = true}};
+        CDBBatch batch(old_db);
+        for (int i = 0; i < 3; i++) {
+            BrightIDUser user;
+            user.brightid_address = "upgraded_user_" + std::to_string(i);
+            user.context_id = (i < 2) ? "USA:OUSD" : "MEX:OMXN";
+            user.status = BrightIDStatus::VERIFIED;
+            user.trust_score = 0.5;
+            user.is_active = true;
+            batch.Write(std::make_pair(DB_BRIGHTID_USER, user.brightid_address), user);
+            
+            pubkeys.push_back(GenerateRandomKey().GetPubKey());
+            batch.Write(std::make_pair(DB_BRIGHTID_TO_O, user.brightid_address), HexStr(pubkeys.back()));
+            batch.Write(std::make_pair(DB_O_TO_BRIGHTID, HexStr(pubkeys.back())), user.brightid_address);
+        }
+        batch.Write(DB_BRIGHTID_VERSION, 1);
+        old_db.WriteBatch(batch, true);
+    }
+    
+    auto db = std::make_unique<CBrightIDUserDB>(1 << 20, false, false);
+    
+    BOOST_CHECK_EQUAL(db->GetUserCount(), 3U);
+    BOOST_CHECK_EQUAL(db->GetVerifiedUserCount(), 3U);
+    BOOST_CHECK_EQUAL(db->GetActiveUserCount(), 3U);
+    BOOST_CHECK_CLOSE(db->GetAverageTrustScore(), 0.5, 1e-6);
+    auto usd = db->FindUsersByBirthCurrency("OUSD");
+    BOOST_CHECK_EQUAL(usd.size(), 2U);
+    BOOST_CHECK(std::find(usd.begin(), usd.end(), pubkeys[0]) != usd.end());
+    BOOST_CHECK_EQUAL(db->FindUsersByBirthCurrency("OMXN").size(), 1U);
+    
+    // Reopening at the current version leaves the rebuilt state as it is
+    db.reset();
+    db = std::make_unique<CBrightIDUserDB>(1 << 20, false, false);
+    BOOST_CHECK_EQUAL(db->GetUserCount(), 3U);
+    BOOST_CHECK_EQUAL(db->FindUsersByBirthCurrency("OUSD").size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(brightid_db_measurer_cache)
+{
+    auto db = std::make_unique<CBrightIDUserDB>(1 << 20, true, false);
+    
+    BrightIDUser user;
+    user.brightid_address = "cached_measurer";
+    user.status = BrightIDStatus::VERIFIED;
+    user.is_active = true;
+    BOOST_CHECK(db->WriteUser(user.brightid_address, user));
+    
+    // Unlinked addresses are cached as unverified, and linking invalidates them
+    BOOST_CHECK(!db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK(!db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK(db->LinkAddresses(user.brightid_address, "o_measurer"));
+    BOOST_CHECK(db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK(db->IsOAddressVerified("o_measurer"));
+    
+    auto stats = db->GetMeasurerCacheStats();
+    BOOST_CHECK_EQUAL(stats.entries, 1U);
+    BOOST_CHECK_EQUAL(stats.hits, 2U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    
+    // Status updates, unlinking and erasing the user are seen immediately
+    BOOST_CHECK(db->UpdateUserStatus(user.brightid_address, BrightIDStatus::EXPIRED));
+    BOOST_CHECK(!db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK(db->UpdateUserStatus(user.brightid_address, BrightIDStatus::VERIFIED));
+    BOOST_CHECK(db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK(db->UnlinkAddresses(user.brightid_address));
+    BOOST_CHECK(!db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK(db->LinkAddresses(user.brightid_address, "o_measurer"));
+    BOOST_CHECK(db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK(db->EraseUser(user.brightid_address));
+    BOOST_CHECK(!db->IsOAddressVerified("o_measurer"));
+    
+    // A disabled cache still answers from the database
+    db->SetMeasurerCacheCapacity(0);
+    BOOST_CHECK(!db->IsOAddressVerified("o_measurer"));
+    BOOST_CHECK_EQUAL(db->GetMeasurerCacheStats().entries, 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
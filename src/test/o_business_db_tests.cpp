@@ -2,8 +2,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <common/args.h>
 #include <consensus/o_business_db.h>
 #include <consensus/o_pow_pob.h>
+#include <dbwrapper.h>
+#include <hash.h>
 #include <test/util/setup_common.h>
 #include <boost/test/unit_test.hpp>
 #include <util/strencodings.h>
@@ -198,5 +201,143 @@ BOOST_AUTO_TEST_CASE(business_db_get_all_stats)
     BOOST_CHECK(all_stats.size() > 0);
 }
 
+BOOST_AUTO_TEST_CASE(business_db_recipient_sketch)
+{
+    auto db = std::make_unique<CBusinessMinerDB>(512 * 1024, true, false);
+    
+    // Recipient hashes are SHA256 outputs in production
+    auto recipient = [](int id) { return (HashWriter{} << id).GetHash().GetUint64(0); };
+    
+    // Small counts are close to exact, large ones within a few standard errors
+    HyperLogLog small;
+    for (int i = 0; i < 30; i++) small.Add(recipient(i));
+    for (int i = 0; i < 30; i++) small.Add(recipient(i));
+    BOOST_CHECK(small.Estimate() >= 29 && small.Estimate() <= 31);
+    
+    HyperLogLog large;
+    for (int i = 0; i < 100000; i++) large.Add(recipient(i));
+    BOOST_CHECK(large.Estimate() > 75000 && large.Estimate() < 125000);
+    
+    // Merging per block gives the same sketch as adding everything directly
+    RecipientSketch direct, merged;
+    for (int block = 0; block < 10; block++) {
+        RecipientSketch block_recipients;
+        for (int i = 0; i < 10; i++) {
+            direct.Add(recipient(block * 10 + i), 100 + block);
+            block_recipients.Add(recipient(block * 10 + i), 100 + block);
+        }
+        merged.Merge(block_recipients);
+    }
+    BOOST_CHECK(merged == direct);
+    BOOST_CHECK(direct.Estimate(109) >= 95 && direct.Estimate(109) <= 105);
+    
+    // Recipients leave the window once the qualification period has passed
+    direct.Add(recipient(1000), 100 + BUSINESS_QUALIFICATION_PERIOD);
+    BOOST_CHECK(direct.Estimate(100 + BUSINESS_QUALIFICATION_PERIOD) >= 95);
+    direct.Add(recipient(1001), 100 + 2 * BUSINESS_QUALIFICATION_PERIOD);
+    BOOST_CHECK(direct.Estimate(100 + 2 * BUSINESS_QUALIFICATION_PERIOD) <= 2U);
+    
+    // The sketch is stored with the stats
+    BusinessMinerStats stats;
+    stats.miner_pubkey_hash = MakeTestUint256(1);
+    stats.recipient_sketch = merged;
+    BOOST_CHECK(db->WriteBusinessStats(stats.miner_pubkey_hash, stats));
+    auto read = db->ReadBusinessStats(stats.miner_pubkey_hash);
+    BOOST_REQUIRE(read.has_value());
+    BOOST_CHECK(read->recipient_sketch == merged);
+}
+
+BOOST_AUTO_TEST_CASE(business_db_active_miner_counts)
+{
+    auto db = std::make_unique<CBusinessMinerDB>(512 * 1024, true, false);
+    
+    const auto make_stats = [](const uint256& hash, int height, bool qualifies) {
+        BusinessMinerStats stats;
+        stats.miner_pubkey_hash = hash;
+        stats.last_qualification_height = height;
+        stats.is_qualified = qualifies;
+        stats.total_transactions = MIN_BUSINESS_TRANSACTIONS;
+        stats.distinct_recipients = MIN_BUSINESS_DISTINCT_KEYS;
+        stats.transaction_volume = MIN_BUSINESS_VOLUME;
+        return stats;
+    };
+    
+    const uint256 a = MakeTestUint256(6000);
+    const uint256 b = MakeTestUint256(6001);
+    const uint256 c = MakeTestUint256(6002);
+    BOOST_CHECK(db->WriteBusinessStats(a, make_stats(a, 1000, true)));
+    BOOST_CHECK(db->WriteBusinessStats(b, make_stats(b, 1000, false)));
+    BOOST_CHECK(db->WriteBusinessStats(c, make_stats(c, 1500, true)));
+    
+    auto counts = db->GetActiveMinerCounts(1500);
+    BOOST_CHECK_EQUAL(counts.active, 3U);
+    BOOST_CHECK_EQUAL(counts.qualified, 2U);
+    
+    // Moving the window past height 1000 drops a and b, moving it back restores them
+    counts = db->GetActiveMinerCounts(1001 + BUSINESS_QUALIFICATION_PERIOD);
+    BOOST_CHECK_EQUAL(counts.active, 1U);
+    BOOST_CHECK_EQUAL(counts.qualified, 1U);
+    counts = db->GetActiveMinerCounts(1500);
+    BOOST_CHECK_EQUAL(counts.active, 3U);
+    BOOST_CHECK_EQUAL(counts.qualified, 2U);
+    
+    // Writes and erases keep the counts current
+    BOOST_CHECK(db->WriteBusinessStats(b, make_stats(b, 1600, true)));
+    BOOST_CHECK(db->EraseBusinessStats(a));
+    counts = db->GetActiveMinerCounts(1500);
+    BOOST_CHECK_EQUAL(counts.active, 2U);
+    BOOST_CHECK_EQUAL(counts.qualified, 2U);
+    BOOST_CHECK_EQUAL(db->GetQualifiedBusinessMiners(1500).size(), 2U);
+    
+    // A batch updating one miner twice leaves a single index entry
+    BOOST_CHECK(db->BatchWriteStats({{c, make_stats(c, 1700, false)}, {c, make_stats(c, 1800, true)}}));
+    counts = db->GetActiveMinerCounts(1800 + BUSINESS_QUALIFICATION_PERIOD);
+    BOOST_CHECK_EQUAL(counts.active, 1U);
+    BOOST_CHECK_EQUAL(counts.qualified, 1U);
+    BOOST_CHECK_EQUAL(db->GetBusinessMinersSince(1700).size(), 1U);
+    
+    // Pruning removes both the stats and their index entries
+    BOOST_CHECK(db->PruneOldData(1800 + BUSINESS_QUALIFICATION_PERIOD * 3));
+    BOOST_CHECK_EQUAL(db->GetBusinessMinerCount(), 0U);
+    BOOST_CHECK(db->GetBusinessMinersSince(0).empty());
+    BOOST_CHECK_EQUAL(db->GetActiveMinerCounts(1800).active, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(business_db_upgrade_builds_qualified_index)
+{
+    // A version 1 database holds the stats but not the qualification height index
+    {
+        CDBWrapper old_db{DBParams{.path = gArgs.GetDataDirNet() / "business_miners", .cache_bytes = 1 << 20,
+                                   .wipe_data = true, .obfuscate = true}};
+        CDBBatch batch(old_db);
+        for (int i = 0; i < 3; i++) {
+            BusinessMinerStats stats;
+            stats.miner_pubkey_hash = MakeTestUint256(7000 + i);
+            stats.last_qualification_height = 1000 + 100 * i;
+            stats.is_qualified = true;
+            stats.total_transactions = MIN_BUSINESS_TRANSACTIONS;
+            stats.distinct_recipients = MIN_BUSINESS_DISTINCT_KEYS;
+            stats.transaction_volume = (i < 2) ? MIN_BUSINESS_VOLUME : 0;
+            batch.Write(std::make_pair(DB_BUSINESS_STATS, stats.miner_pubkey_hash), stats);
+        }
+        batch.Write(DB_BUSINESS_VERSION, 1);
+        old_db.WriteBatch(batch, true);
+    }
+    
+    auto db = std::make_unique<CBusinessMinerDB>(512 * 1024, false, false);
+    
+    BOOST_CHECK_EQUAL(db->GetBusinessMinerCount(), 3U);
+    BOOST_CHECK_EQUAL(db->GetBusinessMinersSince(1100).size(), 2U);
+    auto counts = db->GetActiveMinerCounts(1200);
+    BOOST_CHECK_EQUAL(counts.active, 3U);
+    BOOST_CHECK_EQUAL(counts.qualified, 2U);
+    
+    // Reopening at the current version leaves the index as it is
+    db.reset();
+    db = std::make_unique<CBusinessMinerDB>(512 * 1024, false, false);
+    BOOST_CHECK_EQUAL(db->GetBusinessMinersSince(0).size(), 3U);
+    BOOST_CHECK_EQUAL(db->GetActiveMinerCounts(1200).qualified, 2U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,68 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/multicurrency.h>
+#include <test/util/setup_common.h>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_FIXTURE_TEST_SUITE(o_currency_registry_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(currency_registry_lookups)
+{
+    CurrencyRegistry registry;
+    BOOST_CHECK_EQUAL(registry.Size(), 143U);
+    BOOST_CHECK_EQUAL(registry.GetAllCurrencies().size(), 143U);
+    BOOST_CHECK_EQUAL(registry.GetAllCurrencies().front().symbol, "BTC");
+
+    // Every built-in currency is found by id and by symbol
+    for (const auto& currency : registry.GetAllCurrencies()) {
+        BOOST_CHECK(registry.IsSupported(currency.id));
+        BOOST_CHECK(registry.GetCurrencyId(currency.symbol) == currency.id);
+        BOOST_CHECK_EQUAL(registry.GetCurrency(currency.id)->symbol, currency.symbol);
+    }
+    BOOST_CHECK(registry.GetCurrencyId("OEUR") == CURRENCY_EUR);
+    BOOST_CHECK_EQUAL(registry.GetCurrency(CURRENCY_IQD)->decimals, 3);
+    BOOST_CHECK(!registry.GetCurrencyId("EUR"));
+    BOOST_CHECK(!registry.GetCurrencyId(""));
+    BOOST_CHECK(!registry.GetCurrencyId("OEURXXXXX"));
+    BOOST_CHECK(!registry.GetCurrency(CURRENCY_GQE));
+    BOOST_CHECK(!registry.GetCurrency(MAX_CURRENCIES));
+    BOOST_CHECK(!registry.IsSupported(MAX_CURRENCIES + 1));
+
+    // Registration rejects taken ids and symbols and unpackable symbols
+    BOOST_CHECK(!registry.RegisterCurrency(CurrencyMetadata(CURRENCY_USD, "TEST", "Test", 2, true, "")));
+    BOOST_CHECK(!registry.RegisterCurrency(CurrencyMetadata(500, "OUSD", "Test", 2, true, "")));
+    BOOST_CHECK(!registry.RegisterCurrency(CurrencyMetadata(500, "", "Test", 2, true, "")));
+    BOOST_CHECK(!registry.RegisterCurrency(CurrencyMetadata(500, "TOOLONGSYM", "Test", 2, true, "")));
+    BOOST_CHECK(!registry.RegisterCurrency(CurrencyMetadata(MAX_CURRENCIES, "TEST", "Test", 2, true, "")));
+    BOOST_CHECK_EQUAL(registry.Size(), 143U);
+
+    // Filling every remaining id keeps all symbols reachable through probing
+    for (CurrencyId id = 0; id < MAX_CURRENCIES; id++) {
+        if (!registry.IsSupported(id)) {
+            BOOST_CHECK(registry.RegisterCurrency(CurrencyMetadata(id, "T" + std::to_string(id), "Test", 2, false, "")));
+        }
+    }
+    BOOST_CHECK_EQUAL(registry.Size(), size_t{MAX_CURRENCIES});
+    for (const auto& currency : registry.GetAllCurrencies()) {
+        BOOST_CHECK(registry.GetCurrencyId(currency.symbol) == currency.id);
+    }
+    BOOST_CHECK(!registry.GetCurrencyId("T1000"));
+
+    // The built-in table holds the defaults only, whatever was registered since
+    for (const auto& currency : CurrencyRegistry{}.GetAllCurrencies()) {
+        BOOST_CHECK(GetDefaultCurrencyId(currency.symbol) == currency.id);
+        BOOST_CHECK(GetDefaultCurrencySymbol(currency.id) == currency.symbol);
+    }
+    BOOST_CHECK(registry.GetCurrencyId("T500") == 500);
+    BOOST_CHECK(!GetDefaultCurrencyId("T500"));
+    BOOST_CHECK(!GetDefaultCurrencySymbol(500));
+    BOOST_CHECK(!GetDefaultCurrencyId("USD"));
+    BOOST_CHECK(!GetDefaultCurrencyId(""));
+    BOOST_CHECK(!GetDefaultCurrencySymbol(MAX_CURRENCIES));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
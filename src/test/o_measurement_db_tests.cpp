@@ -2,13 +2,19 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <common/args.h>
+#include <consensus/o_db_maintenance.h>
+#include <dbwrapper.h>
 #include <measurement/o_measurement_db.h>
 #include <measurement/measurement_system.h>
+#include <key.h>
 #include <test/util/setup_common.h>
 #include <boost/test/unit_test.hpp>
 #include <util/strencodings.h>
 #include <uint256.h>
 
+#include <thread>
+
 using namespace OMeasurement;
 
 // Helper to create unique uint256 for testing
@@ -152,6 +158,30 @@ BOOST_AUTO_TEST_CASE(measurement_db_daily_average)
     BOOST_CHECK(read->confidence_level == ConfidenceLevel::HIGH_CONFIDENCE);
 }
 
+BOOST_AUTO_TEST_CASE(measurement_db_batch_daily_averages)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    std::vector<DailyAverage> averages;
+    for (const std::string currency : {"OUSD", "OEUR", "OJPY"}) {
+        DailyAverage avg;
+        avg.currency_code = currency;
+        avg.date = "2025-10-20";
+        avg.avg_water_price = 1.25;
+        avg.measurement_count = 7;
+        averages.push_back(avg);
+    }
+    
+    BOOST_CHECK(db->BatchWriteDailyAverages(averages));
+    
+    for (const auto& avg : averages) {
+        auto read = db->ReadDailyAverage(avg.currency_code, "2025-10-20");
+        BOOST_REQUIRE(read.has_value());
+        BOOST_CHECK_EQUAL(read->currency_code, avg.currency_code);
+        BOOST_CHECK_EQUAL(read->measurement_count, 7);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(measurement_db_validated_url)
 {
     auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
@@ -207,6 +237,88 @@ BOOST_AUTO_TEST_CASE(measurement_db_measurement_invite)
     BOOST_CHECK_EQUAL(read->is_expired, false);
 }
 
+BOOST_AUTO_TEST_CASE(measurement_db_invite_cache)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    MeasurementInvite invite;
+    invite.invite_id = uint256{"3333333333333333333333333333333333333333333333333333333333333333"};
+    invite.expires_at = 1234567890;
+    
+    // Missing invites are cached too, and writing the invite invalidates them
+    BOOST_CHECK(!db->GetInviteStatus(invite.invite_id).exists);
+    BOOST_CHECK(db->WriteInvite(invite.invite_id, invite));
+    auto status = db->GetInviteStatus(invite.invite_id);
+    BOOST_CHECK(status.exists);
+    BOOST_CHECK(!status.is_used);
+    BOOST_CHECK_EQUAL(status.expires_at, 1234567890);
+    BOOST_CHECK(!db->GetInviteStatus(invite.invite_id).is_used);
+    
+    auto stats = db->GetInviteCacheStats();
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    
+    // Using and erasing the invite are seen immediately
+    BOOST_CHECK(db->MarkInviteUsed(invite.invite_id));
+    BOOST_CHECK(db->GetInviteStatus(invite.invite_id).is_used);
+    BOOST_CHECK(db->EraseInvite(invite.invite_id));
+    BOOST_CHECK(!db->GetInviteStatus(invite.invite_id).exists);
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_invite_user_index)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    CKey alice_key = GenerateRandomKey();
+    CKey bob_key = GenerateRandomKey();
+    
+    // Alice's invites expire at 1100, 1200, ..., Bob has one expiring at 1500
+    for (int i = 0; i < 5; i++) {
+        MeasurementInvite invite;
+        invite.invite_id = MakeTestUint256(8000 + i);
+        invite.invited_user = (i < 4) ? alice_key.GetPubKey() : bob_key.GetPubKey();
+        invite.expires_at = 1100 + 100 * i;
+        BOOST_CHECK(db->WriteInvite(invite.invite_id, invite));
+    }
+    
+    BOOST_CHECK_EQUAL(db->GetUserInvites(alice_key.GetPubKey()).size(), 4U);
+    BOOST_CHECK_EQUAL(db->GetUserInvites(bob_key.GetPubKey()).size(), 1U);
+    
+    // Active invites start after the current time, in expiry order
+    auto active = db->GetActiveUserInvites(alice_key.GetPubKey(), 1200);
+    BOOST_REQUIRE_EQUAL(active.size(), 2U);
+    BOOST_CHECK(active[0].invite_id == MakeTestUint256(8002));
+    BOOST_CHECK(active[1].invite_id == MakeTestUint256(8003));
+    
+    // Used invites are no longer active, and moving an expiry moves its index entry
+    BOOST_CHECK(db->MarkInviteUsed(MakeTestUint256(8003)));
+    auto extended = db->ReadInvite(MakeTestUint256(8000));
+    BOOST_REQUIRE(extended.has_value());
+    extended->expires_at = 5000;
+    BOOST_CHECK(db->WriteInvite(extended->invite_id, *extended));
+    active = db->GetActiveUserInvites(alice_key.GetPubKey(), 1200);
+    BOOST_REQUIRE_EQUAL(active.size(), 2U);
+    BOOST_CHECK(active[0].invite_id == MakeTestUint256(8002));
+    BOOST_CHECK(active[1].invite_id == MakeTestUint256(8000));
+    BOOST_CHECK_EQUAL(db->GetUserInvites(alice_key.GetPubKey()).size(), 4U);
+    
+    // Pruning removes used and expired invites along with their index entries
+    BOOST_CHECK(db->PruneExpiredInvites(1300));
+    BOOST_CHECK(!db->HasInvite(MakeTestUint256(8001)));
+    BOOST_CHECK(db->HasInvite(MakeTestUint256(8002)));
+    BOOST_CHECK(!db->HasInvite(MakeTestUint256(8003)));
+    BOOST_CHECK_EQUAL(db->GetInviteCount(), 3U);
+    BOOST_CHECK_EQUAL(db->GetUserInvites(alice_key.GetPubKey()).size(), 2U);
+    BOOST_CHECK_EQUAL(db->GetActiveUserInvites(bob_key.GetPubKey(), 1300).size(), 1U);
+    
+    // Erasing removes the index entries too
+    BOOST_CHECK(db->EraseInvite(MakeTestUint256(8004)));
+    BOOST_CHECK(db->GetUserInvites(bob_key.GetPubKey()).empty());
+    BOOST_CHECK(db->PruneExpiredInvites(10000));
+    BOOST_CHECK_EQUAL(db->GetInviteCount(), 0U);
+    BOOST_CHECK(db->GetUserInvites(alice_key.GetPubKey()).empty());
+}
+
 BOOST_AUTO_TEST_CASE(measurement_db_confidence_level_serialization)
 {
     auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
@@ -274,5 +386,459 @@ BOOST_AUTO_TEST_CASE(measurement_db_erase_operations)
     BOOST_CHECK(!db->ReadWaterPrice(m.measurement_id).has_value());
 }
 
+BOOST_AUTO_TEST_CASE(measurement_db_range_index)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    // Interleave currencies so the primary keyspace is not ordered by currency
+    for (int i = 0; i < 20; i++) {
+        WaterPriceMeasurement m;
+        m.measurement_id = MakeTestUint256(3000 + i);
+        m.currency_code = (i % 2 == 0) ? "USD" : "EUR";
+        m.price = 100 + i;
+        m.timestamp = 1000000 + i * 100;
+        m.block_height = 10 + i;
+        BOOST_CHECK(db->WriteWaterPrice(m.measurement_id, m));
+        
+        ExchangeRateMeasurement e;
+        e.measurement_id = MakeTestUint256(4000 + i);
+        e.from_currency = "OUSD";
+        e.to_currency = (i % 2 == 0) ? "USD" : "EUR";
+        e.exchange_rate = 1.0 + i * 0.01;
+        e.timestamp = 1000000 + i * 100;
+        e.block_height = 10 + i;
+        BOOST_CHECK(db->WriteExchangeRate(e.measurement_id, e));
+    }
+    
+    // USD entries are at even i: timestamps 1000000, 1000200, ..., 1001800
+    auto usd = db->GetWaterPricesInRange("USD", 1000200, 1000600);
+    BOOST_CHECK_EQUAL(usd.size(), 3U);
+    for (const auto& m : usd) {
+        BOOST_CHECK_EQUAL(m.currency_code, "USD");
+        BOOST_CHECK(m.timestamp >= 1000200 && m.timestamp <= 1000600);
+    }
+    BOOST_CHECK_EQUAL(db->GetWaterPricesInRange("EUR", 0, 2000000).size(), 10U);
+    BOOST_CHECK(db->GetWaterPricesInRange("US", 0, 2000000).empty());
+    BOOST_CHECK(db->GetWaterPricesInRange("USD", 1000600, 1000200).empty());
+    
+    auto rates = db->GetExchangeRatesInRange("OUSD", "EUR", 1000100, 1000300);
+    BOOST_CHECK_EQUAL(rates.size(), 2U);
+    BOOST_CHECK(db->GetExchangeRatesInRange("USD", "OUSD", 0, 2000000).empty());
+    
+    BOOST_CHECK_EQUAL(db->FindMeasurementsByHeight(12, 15, MeasurementType::WATER_PRICE).size(), 4U);
+    BOOST_CHECK_EQUAL(db->FindMeasurementsByHeight(0, 100, MeasurementType::EXCHANGE_RATE).size(), 20U);
+    BOOST_CHECK(db->FindMeasurementsByHeight(30, 40, MeasurementType::WATER_PRICE).empty());
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_range_index_maintenance)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    WaterPriceMeasurement m;
+    m.measurement_id = MakeTestUint256(5000);
+    m.currency_code = "JPY";
+    m.timestamp = 5000;
+    m.block_height = 50;
+    BOOST_CHECK(db->WriteWaterPrice(m.measurement_id, m));
+    BOOST_CHECK_EQUAL(db->GetWaterPricesInRange("JPY", 0, 10000).size(), 1U);
+    
+    // Overwriting must move the index entries, not duplicate them
+    m.currency_code = "CHF";
+    m.timestamp = 6000;
+    m.block_height = 60;
+    BOOST_CHECK(db->WriteWaterPrice(m.measurement_id, m));
+    BOOST_CHECK(db->GetWaterPricesInRange("JPY", 0, 10000).empty());
+    BOOST_CHECK_EQUAL(db->GetWaterPricesInRange("CHF", 0, 10000).size(), 1U);
+    BOOST_CHECK(db->FindMeasurementsByHeight(50, 50, MeasurementType::WATER_PRICE).empty());
+    BOOST_CHECK_EQUAL(db->FindMeasurementsByHeight(60, 60, MeasurementType::WATER_PRICE).size(), 1U);
+    
+    // Pruning and erasing remove index entries as well
+    BOOST_CHECK(db->PruneOldMeasurements(7000));
+    BOOST_CHECK(db->GetWaterPricesInRange("CHF", 0, 10000).empty());
+    BOOST_CHECK(db->FindMeasurementsByHeight(0, 100, MeasurementType::WATER_PRICE).empty());
+    
+    BOOST_CHECK(db->WriteWaterPrice(m.measurement_id, m));
+    BOOST_CHECK(db->EraseWaterPrice(m.measurement_id));
+    BOOST_CHECK(db->GetWaterPricesInRange("CHF", 0, 10000).empty());
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_submitter_and_validation_index)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    CKey alice_key = GenerateRandomKey();
+    CKey bob_key = GenerateRandomKey();
+    
+    for (int i = 0; i < 6; i++) {
+        WaterPriceMeasurement m;
+        m.measurement_id = MakeTestUint256(6000 + i);
+        m.submitter = (i < 4) ? alice_key.GetPubKey() : bob_key.GetPubKey();
+        m.currency_code = "USD";
+        m.is_validated = (i % 2 == 0);
+        BOOST_CHECK(db->WriteWaterPrice(m.measurement_id, m));
+    }
+    
+    ExchangeRateMeasurement e;
+    e.measurement_id = MakeTestUint256(7000);
+    e.submitter = alice_key.GetPubKey();
+    BOOST_CHECK(db->WriteExchangeRate(e.measurement_id, e));
+    
+    BOOST_CHECK_EQUAL(db->FindMeasurementsBySubmitter(alice_key.GetPubKey(), MeasurementType::WATER_PRICE).size(), 4U);
+    BOOST_CHECK_EQUAL(db->FindMeasurementsBySubmitter(bob_key.GetPubKey(), MeasurementType::WATER_PRICE).size(), 2U);
+    BOOST_CHECK_EQUAL(db->FindMeasurementsBySubmitter(alice_key.GetPubKey(), MeasurementType::EXCHANGE_RATE).size(), 1U);
+    BOOST_CHECK(db->FindMeasurementsBySubmitter(bob_key.GetPubKey(), MeasurementType::EXCHANGE_RATE).empty());
+    
+    BOOST_CHECK_EQUAL(db->FindUnvalidatedMeasurements(MeasurementType::WATER_PRICE).size(), 3U);
+    BOOST_CHECK_EQUAL(db->FindUnvalidatedMeasurements(MeasurementType::EXCHANGE_RATE).size(), 1U);
+    
+    // Validating a measurement removes it from the pending set
+    auto pending = db->ReadWaterPrice(MakeTestUint256(6001));
+    BOOST_REQUIRE(pending.has_value());
+    pending->is_validated = true;
+    BOOST_CHECK(db->WriteWaterPrice(pending->measurement_id, *pending));
+    BOOST_CHECK_EQUAL(db->FindUnvalidatedMeasurements(MeasurementType::WATER_PRICE).size(), 2U);
+    
+    // Erasing removes both index entries
+    BOOST_CHECK(db->EraseWaterPrice(MakeTestUint256(6003)));
+    BOOST_CHECK_EQUAL(db->FindUnvalidatedMeasurements(MeasurementType::WATER_PRICE).size(), 1U);
+    BOOST_CHECK_EQUAL(db->FindMeasurementsBySubmitter(alice_key.GetPubKey(), MeasurementType::WATER_PRICE).size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_upgrade_rebuilds_indexes)
+{
+    CKey alice_key = GenerateRandomKey();
+    
+    // A version 2 database holds only the records: no counters, submitter,
+    // validation or invite indexes
+    {
+        CDBWrapper old_db{DBParams{.path = gArgs.GetDataDirNet() / "measurements", .cache_bytes = 1 << 20,
+                                   .wipe_data = true, .obfuscate = true}};
+        CDBBatch batch(old_db);
+        for (int i = 0; i < 4; i++) {
+            WaterPriceMeasurement m;
+            m.measurement_id = MakeTestUint256(13000 + i);
+            m.submitter = alice_key.GetPubKey();
+            m.currency_code = (i < 3) ? "USD" : "EUR";
+            m.timestamp = 1000 + i;
+            m.block_height = 10 + i;
+            m.is_validated = (i == 0);
+            batch.Write(std::make_pair(DB_WATER_PRICE, m.measurement_id), m);
+        }
+        ExchangeRateMeasurement e;
+        e.measurement_id = MakeTestUint256(13100);
+        e.from_currency = "OUSD";
+        e.to_currency = "USD";
+        e.timestamp = 1000;
+        batch.Write(std::make_pair(DB_EXCHANGE_RATE, e.measurement_id), e);
+        MeasurementInvite invite;
+        invite.invite_id = MakeTestUint256(13200);
+        invite.invited_user = alice_key.GetPubKey();
+        invite.expires_at = 5000;
+        batch.Write(std::make_pair(DB_INVITE, invite.invite_id), invite);
+        batch.Write(DB_MEASUREMENT_VERSION, 2);
+        old_db.WriteBatch(batch, true);
+    }
+    
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, false, false);
+    
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 4U);
+    BOOST_CHECK_EQUAL(db->GetExchangeRateCount(), 1U);
+    BOOST_CHECK_EQUAL(db->GetMeasurementCountByCurrency()["USD"], 3U);
+    BOOST_CHECK_EQUAL(db->GetWaterPricesInRange("USD", 0, 2000).size(), 3U);
+    BOOST_CHECK_EQUAL(db->GetExchangeRatesInRange("OUSD", "USD", 0, 2000).size(), 1U);
+    BOOST_CHECK_EQUAL(db->FindMeasurementsByHeight(10, 13, MeasurementType::WATER_PRICE).size(), 4U);
+    BOOST_CHECK_EQUAL(db->FindMeasurementsBySubmitter(alice_key.GetPubKey(), MeasurementType::WATER_PRICE).size(), 4U);
+    BOOST_CHECK_EQUAL(db->FindUnvalidatedMeasurements(MeasurementType::WATER_PRICE).size(), 3U);
+    BOOST_CHECK_EQUAL(db->GetActiveUserInvites(alice_key.GetPubKey(), 1000).size(), 1U);
+    BOOST_CHECK(db->VerifyIntegrity());
+    
+    // Reopening at the current version leaves the rebuilt state as it is
+    db.reset();
+    db = std::make_unique<CMeasurementDB>(2 << 20, false, false);
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 4U);
+    BOOST_CHECK_EQUAL(db->GetUserInvites(alice_key.GetPubKey()).size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_export_import)
+{
+    auto source = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    for (int i = 0; i < 50; i++) {
+        WaterPriceMeasurement m;
+        m.measurement_id = MakeTestUint256(8000 + i);
+        m.currency_code = (i % 2 == 0) ? "USD" : "EUR";
+        m.price = 100 + i;
+        m.volume = 1.5;
+        m.timestamp = 1000 + i;
+        m.block_height = i;
+        m.is_validated = (i % 3 != 0);
+        BOOST_CHECK(source->WriteWaterPrice(m.measurement_id, m));
+    }
+    ExchangeRateMeasurement e;
+    e.measurement_id = MakeTestUint256(9000);
+    e.from_currency = "OUSD";
+    e.to_currency = "USD";
+    e.exchange_rate = 1.02;
+    BOOST_CHECK(source->WriteExchangeRate(e.measurement_id, e));
+    
+    const fs::path water_path = m_path_root / "water.dat";
+    BOOST_CHECK(source->ExportMeasurements(water_path, MeasurementType::WATER_PRICE));
+    
+    // Importing restores both the records and their indexes
+    auto target = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    BOOST_CHECK(target->ImportMeasurements(water_path, MeasurementType::WATER_PRICE));
+    BOOST_CHECK_EQUAL(target->GetWaterPriceCount(), 50U);
+    BOOST_CHECK_EQUAL(target->GetExchangeRateCount(), 0U);
+    BOOST_CHECK_EQUAL(target->GetWaterPricesInRange("USD", 0, 2000).size(), 25U);
+    BOOST_CHECK_EQUAL(target->FindUnvalidatedMeasurements(MeasurementType::WATER_PRICE).size(), 17U);
+    auto restored = target->ReadWaterPrice(MakeTestUint256(8007));
+    BOOST_REQUIRE(restored.has_value());
+    BOOST_CHECK_EQUAL(restored->price, 107);
+    BOOST_CHECK_CLOSE(restored->volume, 1.5, 1e-6);
+    
+    // Importing over the same records replaces them and their indexes
+    BOOST_CHECK(target->ImportMeasurements(water_path, MeasurementType::WATER_PRICE));
+    BOOST_CHECK_EQUAL(target->GetWaterPriceCount(), 50U);
+    BOOST_CHECK_EQUAL(target->GetWaterPricesInRange("USD", 0, 2000).size(), 25U);
+    BOOST_CHECK_EQUAL(target->FindUnvalidatedMeasurements(MeasurementType::WATER_PRICE).size(), 17U);
+    BOOST_CHECK(target->VerifyIntegrity());
+    
+    // A dump of one type cannot be imported as the other
+    BOOST_CHECK(!target->ImportMeasurements(water_path, MeasurementType::EXCHANGE_RATE));
+    
+    // Corrupted record data fails the trailer checksum
+    {
+        std::FILE* file = fsbridge::fopen(water_path, "r+b");
+        BOOST_REQUIRE(file);
+        std::fseek(file, 40, SEEK_SET);
+        std::fputc(0x7f, file);
+        std::fclose(file);
+    }
+    auto corrupt_target = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    BOOST_CHECK(!corrupt_target->ImportMeasurements(water_path, MeasurementType::WATER_PRICE));
+    
+    // Nothing is written unless the whole dump verifies, also when it ends early
+    BOOST_CHECK_EQUAL(corrupt_target->GetWaterPriceCount(), 0U);
+    BOOST_CHECK(corrupt_target->GetWaterPricesInRange("USD", 0, 2000).empty());
+    fs::resize_file(water_path, fs::file_size(water_path) - 40);
+    BOOST_CHECK(!corrupt_target->ImportMeasurements(water_path, MeasurementType::WATER_PRICE));
+    BOOST_CHECK_EQUAL(corrupt_target->GetWaterPriceCount(), 0U);
+    
+    BOOST_CHECK(!target->ImportMeasurements(m_path_root / "missing.dat", MeasurementType::WATER_PRICE));
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_counters)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    for (int i = 0; i < 5; i++) {
+        WaterPriceMeasurement m;
+        m.measurement_id = MakeTestUint256(10000 + i);
+        m.currency_code = (i < 3) ? "USD" : "EUR";
+        m.timestamp = 1000 + i;
+        BOOST_CHECK(db->WriteWaterPrice(m.measurement_id, m));
+    }
+    ExchangeRateMeasurement e;
+    e.measurement_id = MakeTestUint256(11000);
+    e.timestamp = 5000;
+    BOOST_CHECK(db->WriteExchangeRate(e.measurement_id, e));
+    
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 5U);
+    BOOST_CHECK_EQUAL(db->GetExchangeRateCount(), 1U);
+    BOOST_CHECK_EQUAL(db->GetMeasurementCountByCurrency()["USD"], 3U);
+    
+    // Overwriting moves the record between currencies without changing the total
+    auto moved = db->ReadWaterPrice(MakeTestUint256(10000));
+    BOOST_REQUIRE(moved.has_value());
+    moved->currency_code = "EUR";
+    BOOST_CHECK(db->WriteWaterPrice(moved->measurement_id, *moved));
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 5U);
+    auto by_currency = db->GetMeasurementCountByCurrency();
+    BOOST_CHECK_EQUAL(by_currency["USD"], 2U);
+    BOOST_CHECK_EQUAL(by_currency["EUR"], 3U);
+    
+    BOOST_CHECK(db->EraseWaterPrice(MakeTestUint256(10001)));
+    BOOST_CHECK(db->PruneOldMeasurements(1003));
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 2U);
+    BOOST_CHECK_EQUAL(db->GetExchangeRateCount(), 1U);
+    BOOST_CHECK(db->GetMeasurementCountByCurrency().count("USD") == 0);
+    
+    BOOST_CHECK(db->VerifyIntegrity());
+    BOOST_CHECK(db->RebuildCounters());
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_batch_repeated_ids)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    // Each batch writes the same id twice, moving it to another currency and time
+    WaterPriceMeasurement first;
+    first.measurement_id = MakeTestUint256(12000);
+    first.currency_code = "USD";
+    first.timestamp = 1000;
+    WaterPriceMeasurement second = first;
+    second.currency_code = "EUR";
+    second.timestamp = 2000;
+    BOOST_CHECK(db->BatchWriteWaterPrices({{first.measurement_id, first}, {second.measurement_id, second}}));
+    
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 1U);
+    auto by_currency = db->GetMeasurementCountByCurrency();
+    BOOST_CHECK(by_currency.count("USD") == 0);
+    BOOST_CHECK_EQUAL(by_currency["EUR"], 1U);
+    BOOST_CHECK(db->GetWaterPricesInRange("USD", 0, 3000).empty());
+    BOOST_CHECK_EQUAL(db->GetWaterPricesInRange("EUR", 0, 3000).size(), 1U);
+    
+    ExchangeRateMeasurement rate;
+    rate.measurement_id = MakeTestUint256(12001);
+    rate.from_currency = "OUSD";
+    rate.to_currency = "USD";
+    rate.timestamp = 1000;
+    ExchangeRateMeasurement moved_rate = rate;
+    moved_rate.to_currency = "EUR";
+    BOOST_CHECK(db->BatchWriteExchangeRates({{rate.measurement_id, rate}, {moved_rate.measurement_id, moved_rate}}));
+    
+    BOOST_CHECK_EQUAL(db->GetExchangeRateCount(), 1U);
+    BOOST_CHECK(db->GetExchangeRatesInRange("OUSD", "USD", 0, 3000).empty());
+    BOOST_CHECK_EQUAL(db->GetExchangeRatesInRange("OUSD", "EUR", 0, 3000).size(), 1U);
+    
+    CKey user_key = GenerateRandomKey();
+    MeasurementInvite invite;
+    invite.invite_id = MakeTestUint256(12002);
+    invite.invited_user = user_key.GetPubKey();
+    invite.expires_at = 1100;
+    MeasurementInvite extended = invite;
+    extended.expires_at = 5000;
+    BOOST_CHECK(db->BatchWriteInvites({{invite.invite_id, invite}, {extended.invite_id, extended}}));
+    
+    BOOST_CHECK_EQUAL(db->GetUserInvites(user_key.GetPubKey()).size(), 1U);
+    BOOST_CHECK(db->PruneExpiredInvites(2000));
+    BOOST_CHECK(db->HasInvite(invite.invite_id));
+    BOOST_CHECK_EQUAL(db->GetActiveUserInvites(user_key.GetPubKey(), 2000).size(), 1U);
+    
+    BOOST_CHECK(db->VerifyIntegrity());
+}
+
+BOOST_AUTO_TEST_CASE(compaction_ranges_follow_the_data)
+{
+    // Keys sharing the bytes after the prefix, as a currency code does, with
+    // an estimate of one MiB per key
+    const uint8_t prefix{0x20};
+    std::vector<std::array<uint8_t, 9>> keys;
+    for (uint8_t i = 0; i < 64; i++) {
+        keys.push_back({prefix, 0x03, 'U', 'S', 'D', 0, 0, 0, i});
+    }
+    const auto estimate = [&](const OConsensus::OKeyRange& range) {
+        uint64_t size = 0;
+        for (const auto& key : keys) {
+            if (key >= range.BeginKey() && key < range.EndKey()) size += 1 << 20;
+        }
+        return size;
+    };
+    
+    const auto ranges = OConsensus::SplitPrefix(prefix, estimate);
+    BOOST_REQUIRE_EQUAL(ranges.size(), 64 * (1 << 20) / OConsensus::O_DB_COMPACTION_RANGE_BYTES);
+    BOOST_CHECK_EQUAL(ranges.front().begin, 0U);
+    BOOST_CHECK(!ranges.back().end.has_value());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        BOOST_CHECK_EQUAL(estimate(ranges[i]), OConsensus::O_DB_COMPACTION_RANGE_BYTES);
+        if (i + 1 < ranges.size()) BOOST_CHECK(ranges[i].end == ranges[i + 1].begin);
+    }
+    
+    // A prefix without data on disk is one range
+    const auto empty = OConsensus::SplitPrefix(prefix, [](const OConsensus::OKeyRange&) { return uint64_t{0}; });
+    BOOST_REQUIRE_EQUAL(empty.size(), 1U);
+    BOOST_CHECK(empty[0].EndKey()[0] == prefix + 1);
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_incremental_maintenance)
+{
+    g_measurement_db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    
+    MeasurementInvite expired;
+    expired.invite_id = MakeTestUint256(12000);
+    expired.expires_at = GetTime() - 1;
+    MeasurementInvite active = expired;
+    active.invite_id = MakeTestUint256(12001);
+    active.expires_at = GetTime() + 86400;
+    BOOST_CHECK(g_measurement_db->WriteInvite(expired.invite_id, expired));
+    BOOST_CHECK(g_measurement_db->WriteInvite(active.invite_id, active));
+    for (int i = 0; i < 50; i++) {
+        WaterPriceMeasurement m;
+        m.measurement_id = MakeTestUint256(13000 + i);
+        m.currency_code = "USD";
+        m.timestamp = 1000 + i;
+        BOOST_CHECK(g_measurement_db->WriteWaterPrice(m.measurement_id, m));
+    }
+    BOOST_CHECK(g_measurement_db->PruneOldMeasurements(1025));
+    
+    // A zero budget runs exactly one step per slice, starting with pruning
+    OConsensus::ODBMaintenance maintenance;
+    BOOST_CHECK(!maintenance.RunSlice(std::chrono::milliseconds{0}));
+    BOOST_CHECK_EQUAL(maintenance.NextJob(), 1U);
+    
+    // Compaction resumes where the previous slice stopped until the pass
+    // completes. A prefix takes a step to split it and one per range, here a
+    // single range for each small prefix, and the prefixes of databases that
+    // are not open a step to skip them.
+    size_t slices = 2; // The first slice and the one completing the pass
+    while (!maintenance.RunSlice(std::chrono::milliseconds{0})) {
+        BOOST_REQUIRE(++slices < 10000);
+    }
+    BOOST_CHECK_EQUAL(slices, OConsensus::ODBMaintenance::JobCount() + MEASUREMENT_DB_HOT_PREFIXES.size());
+    BOOST_CHECK_EQUAL(maintenance.CompletedPasses(), 1);
+    BOOST_CHECK_EQUAL(maintenance.NextJob(), 0U);
+    
+    // The next pass waits for the pass interval
+    BOOST_CHECK(!maintenance.RunSlice(std::chrono::milliseconds{1000}));
+    BOOST_CHECK_EQUAL(maintenance.NextJob(), 0U);
+    
+    // Invites are consensus state, pruned by blocks and not by maintenance
+    BOOST_CHECK(g_measurement_db->HasInvite(expired.invite_id));
+    BOOST_CHECK(g_measurement_db->HasInvite(active.invite_id));
+    
+    // Compaction leaves live data intact
+    BOOST_CHECK_EQUAL(g_measurement_db->GetWaterPriceCount(), 25U);
+    BOOST_CHECK_EQUAL(g_measurement_db->GetWaterPricesInRange("USD", 0, 2000).size(), 25U);
+    BOOST_CHECK(g_measurement_db->ReadWaterPrice(MakeTestUint256(13049)).has_value());
+    BOOST_CHECK(g_measurement_db->VerifyIntegrity());
+    
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(measurement_db_deferred_sync)
+{
+    auto db = std::make_unique<CMeasurementDB>(2 << 20, false, true);
+    
+    // Deferred writes are visible to reads before they are synced
+    WaterPriceMeasurement m;
+    m.measurement_id = MakeTestUint256(14000);
+    m.currency_code = "USD";
+    m.timestamp = 1000;
+    {
+        OConsensus::ODeferSyncScope deferred;
+        BOOST_CHECK(db->WriteWaterPrice(m.measurement_id, m));
+        BOOST_CHECK(db->ReadWaterPrice(m.measurement_id).has_value());
+        BOOST_CHECK_EQUAL(db->GetWaterPricesInRange("USD", 0, 2000).size(), 1U);
+        
+        // Only the thread that opened the scope defers its writes
+        OConsensus::ODeferSyncScope nested;
+        BOOST_CHECK(OConsensus::ODeferSyncScope::Active());
+        bool other_thread_deferred{true};
+        std::thread([&] { other_thread_deferred = OConsensus::ODeferSyncScope::Active(); }).join();
+        BOOST_CHECK(!other_thread_deferred);
+        
+        BOOST_CHECK(db->Sync());
+        BOOST_CHECK(db->Sync());
+    }
+    BOOST_CHECK(!OConsensus::ODeferSyncScope::Active());
+    
+    // Synced state survives reopening the database
+    db.reset();
+    db = std::make_unique<CMeasurementDB>(2 << 20, false, false);
+    BOOST_CHECK(db->ReadWaterPrice(m.measurement_id).has_value());
+    BOOST_CHECK_EQUAL(db->GetWaterPriceCount(), 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,245 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <measurement/measurement_stats.h>
+#include <measurement/measurement_system.h>
+#include <measurement/o_measurement_db.h>
+#include <measurement/stability_snapshot.h>
+#include <primitives/block.h>
+#include <primitives/o_transactions.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <boost/test/unit_test.hpp>
+
+using namespace OMeasurement;
+
+static uint256 MakeTestUint256(int id) {
+    uint256 result;
+    result.SetNull();
+    *(reinterpret_cast<int*>(result.begin())) = id;
+    return result;
+}
+
+BOOST_FIXTURE_TEST_SUITE(o_measurement_stats_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(daily_accumulator_matches_direct_computation)
+{
+    const std::vector<double> values = {1.00, 1.02, 0.98, 1.01, 0.99, 1.03, 0.97, 1.00, 1.01, 5.00};
+
+    DailyAccumulator acc;
+    for (size_t i = 0; i < values.size(); i++) {
+        BOOST_CHECK(acc.Add(MakeTestUint256(i), values[i], 1000 + i));
+    }
+    // Adding the same measurement twice is a no-op
+    BOOST_CHECK(!acc.Add(MakeTestUint256(0), values[0], 1000));
+    BOOST_CHECK_EQUAL(acc.Count(), static_cast<int>(values.size()));
+
+    WindowStatistics stats = SummarizeBuckets({&acc});
+    MeasurementSystem system;
+    BOOST_CHECK_EQUAL(stats.count, static_cast<int>(values.size()));
+    BOOST_CHECK_CLOSE(stats.std_deviation, system.CalculateStandardDeviation(values), 1e-6);
+    BOOST_CHECK_CLOSE(stats.gaussian_average, system.CalculateGaussianAverage(values), 1e-6);
+
+    // The outlier is trimmed from the Gaussian average but not from the mean
+    BOOST_CHECK(stats.gaussian_average < 1.01);
+    BOOST_CHECK(stats.mean > 1.3);
+
+    // Removing the outlier reverts its contribution
+    BOOST_CHECK(acc.Remove(MakeTestUint256(9)));
+    BOOST_CHECK(!acc.Remove(MakeTestUint256(9)));
+    stats = SummarizeBuckets({&acc});
+    BOOST_CHECK_EQUAL(stats.count, 9);
+    BOOST_CHECK_CLOSE(stats.mean, 1.0011111, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(stats_cache_tracks_connect_and_disconnect)
+{
+    const int64_t now = 1760000000;
+    SetMockTime(now);
+    g_measurement_db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    MeasurementStatsCache cache;
+
+    // Measurements already in the database are loaded on first query
+    for (int i = 0; i < 5; i++) {
+        WaterPriceMeasurement m;
+        m.measurement_id = MakeTestUint256(100 + i);
+        m.currency_code = "USD";
+        m.price = 100 + i;
+        m.timestamp = now - i * 3600;
+        m.is_validated = true;
+        BOOST_CHECK(g_measurement_db->WriteWaterPrice(m.measurement_id, m));
+    }
+    WindowStatistics stats = cache.GetWaterPriceStats("USD", now - 7 * 86400, now);
+    BOOST_CHECK_EQUAL(stats.count, 5);
+    BOOST_CHECK_CLOSE(stats.mean, 102.0, 1e-6);
+
+    // Connecting a block adds to the loaded series
+    WaterPriceMeasurement connected;
+    connected.measurement_id = MakeTestUint256(200);
+    connected.currency_code = "USD";
+    connected.price = 110;
+    connected.timestamp = now;
+    connected.is_validated = true;
+    cache.AddWaterPrice(connected);
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("USD", now - 7 * 86400, now).count, 6);
+
+    // Disconnecting reverts it
+    cache.RemoveWaterPrice(connected);
+    stats = cache.GetWaterPriceStats("USD", now - 7 * 86400, now);
+    BOOST_CHECK_EQUAL(stats.count, 5);
+    BOOST_CHECK_CLOSE(stats.mean, 102.0, 1e-6);
+
+    // Unvalidated measurements and other series are not counted
+    WaterPriceMeasurement pending = connected;
+    pending.measurement_id = MakeTestUint256(201);
+    pending.is_validated = false;
+    cache.AddWaterPrice(pending);
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("USD", now - 7 * 86400, now).count, 5);
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("EUR", now - 7 * 86400, now).count, 0);
+
+    ExchangeRateMeasurement rate;
+    rate.measurement_id = MakeTestUint256(300);
+    rate.from_currency = "OUSD";
+    rate.to_currency = "USD";
+    rate.exchange_rate = 1.05;
+    rate.timestamp = now;
+    rate.is_validated = true;
+    BOOST_CHECK(g_measurement_db->WriteExchangeRate(rate.measurement_id, rate));
+    stats = cache.GetExchangeRateStats("OUSD", "USD", now - 86400, now);
+    BOOST_CHECK_EQUAL(stats.count, 1);
+    BOOST_CHECK_CLOSE(stats.gaussian_average, 1.05, 1e-6);
+
+    // Windows beyond the retention horizon fall back to the database
+    WaterPriceMeasurement old;
+    old.measurement_id = MakeTestUint256(400);
+    old.currency_code = "USD";
+    old.price = 90;
+    old.timestamp = now - (STATS_RETENTION_DAYS + 10) * 86400;
+    old.is_validated = true;
+    BOOST_CHECK(g_measurement_db->WriteWaterPrice(old.measurement_id, old));
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("USD", 0, now).count, 6);
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("USD", now - 7 * 86400, now).count, 5);
+
+    g_measurement_db.reset();
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(stats_window_bounds_are_exact)
+{
+    const int64_t now = 1760000000;
+    SetMockTime(now);
+    g_measurement_db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    MeasurementStatsCache cache;
+
+    // A window from noon yesterday to just before now, whose first and last
+    // day also hold measurements outside it
+    const int64_t start_time = (now / 86400 - 1) * 86400 + 43200;
+    const int64_t end_time = now - 60;
+    const std::vector<int64_t> timestamps{start_time - 1, start_time, end_time, end_time + 1};
+    for (size_t i = 0; i < timestamps.size(); i++) {
+        WaterPriceMeasurement m;
+        m.measurement_id = MakeTestUint256(500 + i);
+        m.currency_code = "USD";
+        m.price = 100 + i;
+        m.timestamp = timestamps[i];
+        m.is_validated = true;
+        BOOST_CHECK(g_measurement_db->WriteWaterPrice(m.measurement_id, m));
+    }
+    WindowStatistics stats = cache.GetWaterPriceStats("USD", start_time, end_time);
+    BOOST_CHECK_EQUAL(stats.count, 2);
+    BOOST_CHECK_CLOSE(stats.mean, 101.5, 1e-6);
+
+    // The same holds for measurements added as blocks connect
+    WaterPriceMeasurement early;
+    early.measurement_id = MakeTestUint256(510);
+    early.currency_code = "USD";
+    early.price = 50;
+    early.timestamp = start_time - 1;
+    early.is_validated = true;
+    cache.AddWaterPrice(early);
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("USD", start_time, end_time).count, 2);
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("USD", start_time - 1, end_time).count, 4);
+
+    // A day-aligned window covers whole buckets
+    BOOST_CHECK_EQUAL(cache.GetWaterPriceStats("USD", (now / 86400 - 1) * 86400, now).count, 5);
+
+    g_measurement_db.reset();
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(stability_snapshot_refresh_interval)
+{
+    g_measurement_db = std::make_unique<CMeasurementDB>(2 << 20, true, false);
+    StabilitySnapshotCache cache;
+
+    // The first read builds a snapshot on demand
+    auto initial = cache.Get();
+    BOOST_CHECK_EQUAL(initial->height, -1);
+    BOOST_CHECK(initial->entries.empty());
+    BOOST_CHECK(!initial->etag.empty());
+    BOOST_CHECK(cache.Get() == initial);
+
+    // Blocks without measurement changes keep the snapshot
+    cache.BlockConnected(10, false);
+    BOOST_CHECK(cache.Get() == initial);
+
+    cache.BlockConnected(10, true);
+    BOOST_CHECK_EQUAL(cache.Get()->height, 10);
+
+    // Further changes are picked up once the refresh interval has passed
+    cache.BlockConnected(11, true);
+    BOOST_CHECK_EQUAL(cache.Get()->height, 10);
+    cache.BlockConnected(10 + STABILITY_SNAPSHOT_REFRESH_BLOCKS, false);
+    BOOST_CHECK_EQUAL(cache.Get()->height, 10 + STABILITY_SNAPSHOT_REFRESH_BLOCKS);
+
+    // Unchanged content keeps the same entity tag
+    BOOST_CHECK_EQUAL(cache.Get()->etag, initial->etag);
+
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(stability_snapshot_follows_measurement_blocks)
+{
+    auto make_tx = [](const CScript& script) {
+        CMutableTransaction tx;
+        tx.vout.emplace_back(0, script);
+        return MakeTransactionRef(std::move(tx));
+    };
+
+    CBlock block;
+    CMutableTransaction plain;
+    plain.vout.emplace_back(1000, CScript{} << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(std::move(plain)));
+
+    // Invitations alone do not change the averages
+    OTransactions::CMeasurementInviteData invite;
+    invite.invite_id = MakeTestUint256(1);
+    invite.currency_code = "USD";
+    block.vtx.push_back(make_tx(invite.ToScript()));
+    OTransactions::CBatchData invites;
+    invites.record_type = OTransactions::OTxType::MEASUREMENT_INVITE;
+    invites.AddRecord(invite);
+    block.vtx.push_back(make_tx(invites.ToScript()));
+    BOOST_CHECK(!BlockChangesMeasurements(block));
+
+    // Measurements do, whether written alone or in a batch
+    OTransactions::CExchangeRateMeasurementData rate;
+    rate.from_currency = "OUSD";
+    rate.to_currency = "USD";
+    rate.exchange_rate = 1000000;
+    OTransactions::CBatchData rates;
+    rates.record_type = OTransactions::OTxType::EXCHANGE_RATE;
+    rates.AddRecord(rate);
+    block.vtx.push_back(make_tx(rates.ToScript()));
+    BOOST_CHECK(BlockChangesMeasurements(block));
+
+    block.vtx.pop_back();
+    OTransactions::CWaterPriceMeasurementData price;
+    price.currency_code = "USD";
+    price.price = 1500000;
+    block.vtx.push_back(make_tx(price.ToScript()));
+    BOOST_CHECK(BlockChangesMeasurements(block));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,277 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <consensus/o_brightid_db.h>
+#include <consensus/o_stabilization_db.h>
+#include <consensus/o_undo.h>
+#include <consensus/stabilization_mining.h>
+#include <key.h>
+#include <test/util/setup_common.h>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <set>
+#include <thread>
+
+using namespace OConsensus;
+
+BOOST_FIXTURE_TEST_SUITE(o_stabilization_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(recipient_sampler_is_deterministic)
+{
+    std::vector<CPubKey> candidates;
+    for (int i = 0; i < 200; i++) {
+        candidates.push_back(GenerateRandomKey().GetPubKey());
+    }
+    const uint256 seed = m_rng.rand256();
+
+    RecipientSampler forward(seed, 20);
+    for (const auto& candidate : candidates) forward.Add(candidate);
+
+    // Visiting order does not change the sample
+    RecipientSampler backward(seed, 20);
+    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) backward.Add(*it);
+
+    auto sample = forward.Finish();
+    BOOST_CHECK_EQUAL(forward.Seen(), 200U);
+    BOOST_CHECK_EQUAL(sample.size(), 20U);
+    BOOST_CHECK(sample == backward.Finish());
+
+    // The sample is a subset of distinct candidates
+    std::set<CPubKey> unique(sample.begin(), sample.end());
+    BOOST_CHECK_EQUAL(unique.size(), sample.size());
+    for (const auto& pubkey : sample) {
+        BOOST_CHECK(std::find(candidates.begin(), candidates.end(), pubkey) != candidates.end());
+    }
+
+    // A different seed selects a different sample
+    RecipientSampler other(m_rng.rand256(), 20);
+    for (const auto& candidate : candidates) other.Add(candidate);
+    BOOST_CHECK(sample != other.Finish());
+
+    // Fewer candidates than capacity returns all of them
+    RecipientSampler small(seed, 500);
+    for (const auto& candidate : candidates) small.Add(candidate);
+    BOOST_CHECK_EQUAL(small.Finish().size(), candidates.size());
+
+    BOOST_CHECK(RecipientSampler(seed, 0).Finish().empty());
+}
+
+BOOST_AUTO_TEST_CASE(stabilization_state_is_persisted)
+{
+    g_stabilization_db = std::make_unique<CStabilizationDB>(1 << 20, true, false);
+
+    StabilizationMining mining;
+    mining.UpdateStabilityStatus("USD", 1.0, 1.0, 1.0, 100);
+    const auto before = mining.GetStatusSnapshot();
+
+    // Readers keep a consistent snapshot while writers publish new ones
+    std::thread reader([&] {
+        for (int i = 0; i < 1000; i++) {
+            const auto snapshot = mining.GetStatusSnapshot();
+            BOOST_CHECK(snapshot->count("USD"));
+        }
+    });
+    for (int height = 101; height < 200; height++) {
+        mining.UpdateStabilityStatus("EUR", 1.0, 1.5, 1.0, height);
+    }
+    reader.join();
+    BOOST_CHECK(before->at("USD").IsStable());
+    BOOST_CHECK(!before->count("EUR"));
+    BOOST_CHECK(mining.GetStabilityStatus("EUR")->IsUnstable());
+    BOOST_CHECK_EQUAL(mining.GetStabilityStatus("EUR")->unstable_since_height, 101);
+
+    // Status survives a restart
+    StabilizationMining restarted;
+    restarted.LoadState();
+    BOOST_CHECK_EQUAL(restarted.GetAllStabilityStatus().size(), 2U);
+    BOOST_CHECK(restarted.GetStabilityStatus("USD")->IsStable());
+    BOOST_CHECK_EQUAL(restarted.GetStabilityStatus("EUR")->last_check_height, 199);
+    BOOST_CHECK_EQUAL(restarted.GetUnstableCurrencies().size(), 1U);
+
+    // Recording the same transaction twice counts it once
+    StabilizationTransaction tx;
+    tx.tx_id = m_rng.rand256();
+    tx.unstable_currency = "EUR";
+    tx.coins_created = 500;
+    tx.recipients.resize(5);
+    tx.block_height = 300;
+    restarted.RecordStabilizationTransaction(tx);
+    restarted.RecordStabilizationTransaction(tx);
+    BOOST_CHECK_EQUAL(restarted.GetStabilizationHistory("EUR", 0, 1000).size(), 1U);
+    BOOST_CHECK(restarted.GetStabilizationHistory("EUR", 301, 1000).empty());
+    BOOST_CHECK(restarted.GetStabilizationHistory("USD", 0, 1000).empty());
+    BOOST_CHECK_EQUAL(restarted.GetStatistics().total_transactions, 1);
+    BOOST_CHECK_EQUAL(restarted.GetStatistics().total_recipients, 5);
+
+    // Pruning drops the history but keeps the totals
+    restarted.PruneOldData(301);
+    BOOST_CHECK_EQUAL(g_stabilization_db->GetTransactionCount(), 0U);
+    BOOST_CHECK_EQUAL(restarted.GetTotalCoinsCreated("EUR"), 500);
+
+    g_stabilization_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(stabilization_plan_is_cached_per_block)
+{
+    StabilizationMining mining;
+    mining.UpdateStabilityStatus("EUR", 1.0, 1.5, 1.0, 100);
+    const int height = 100 + StabilizationConfig::UNSTABLE_TIME_RANGE;
+
+    CBlock block;
+    block.hashPrevBlock = m_rng.rand256();
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.emplace_back(5000 * COIN, CScript{});
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    CMutableTransaction spend;
+    spend.vin.emplace_back(COutPoint{Txid::FromUint256(m_rng.rand256()), 0});
+    spend.vout.emplace_back(1000000, CScript{});
+    block.vtx.push_back(MakeTransactionRef(spend));
+
+    const auto plan = mining.GetBlockPlan(block, height);
+    BOOST_CHECK(plan->triggered);
+    BOOST_CHECK_EQUAL(plan->block_volume.Get(CURRENCY_BTC), 5000 * COIN + 1000000);
+    BOOST_CHECK(plan->coins_per_currency.at("EUR") > 0);
+    BOOST_CHECK_EQUAL(plan->total_coins, plan->coins_per_currency.at("EUR"));
+    BOOST_CHECK_EQUAL(mining.CalculateStabilizationCoins(block, height), plan->total_coins);
+    BOOST_CHECK(!mining.GetBlockPlan(block, height - 1)->triggered);
+
+    // Minted transactions added by the miner do not change the plan
+    CMutableTransaction minted;
+    minted.vout.emplace_back(100, CScript{});
+    block.vtx.push_back(MakeTransactionRef(minted));
+    BOOST_CHECK_EQUAL(mining.GetBlockPlan(block, height), plan);
+
+    // Different transactions or a status update build a new plan
+    spend.vout[0].nValue = 2000000;
+    block.vtx[1] = MakeTransactionRef(spend);
+    const auto other_txs = mining.GetBlockPlan(block, height);
+    BOOST_CHECK(other_txs != plan);
+    BOOST_CHECK(other_txs->total_coins > plan->total_coins);
+    mining.UpdateStabilityStatus("USD", 1.0, 1.0, 1.0, height - 1);
+    const auto other_status = mining.GetBlockPlan(block, height);
+    BOOST_CHECK(other_status != other_txs);
+    BOOST_CHECK_EQUAL(mining.GetBlockPlan(block, height), other_status);
+
+    // A new tip keeps only the plans building on it
+    mining.EvictBlockPlans(block.hashPrevBlock);
+    BOOST_CHECK_EQUAL(mining.GetBlockPlan(block, height), other_status);
+    mining.EvictBlockPlans(m_rng.rand256());
+    BOOST_CHECK(mining.GetBlockPlan(block, height) != other_status);
+
+    // Filling the cache with plans for lower heights keeps the plan at the
+    // tip, even one whose previous block hash sorts first
+    block.hashPrevBlock = uint256::ZERO;
+    const auto tip_plan = mining.GetBlockPlan(block, height);
+    CBlock stale = block;
+    for (int i = 1; i <= 8; i++) {
+        stale.hashPrevBlock = m_rng.rand256();
+        mining.GetBlockPlan(stale, height - i);
+    }
+    BOOST_CHECK_EQUAL(mining.GetBlockPlan(block, height), tip_plan);
+
+    // Recipients are sampled from the BrightID database, a write to it needs a new plan
+    g_brightid_db = std::make_unique<CBrightIDUserDB>(1 << 20, true, false);
+    const auto before_write = mining.GetBlockPlan(block, height);
+    BOOST_CHECK_EQUAL(before_write->brightid_version, g_brightid_db->GetWriteVersion());
+    BOOST_CHECK_EQUAL(mining.GetBlockPlan(block, height), before_write);
+    BrightIDUser user;
+    user.status = BrightIDStatus::VERIFIED;
+    BOOST_CHECK(g_brightid_db->WriteUser("plan_user", user));
+    const auto after_write = mining.GetBlockPlan(block, height);
+    BOOST_CHECK(after_write != before_write);
+    BOOST_CHECK_EQUAL(mining.GetBlockPlan(block, height), after_write);
+    g_brightid_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(block_volume_is_gathered_per_currency)
+{
+    StabilizationMining mining;
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.emplace_back(1000000, CScript{});
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    for (CAmount value : {300000, 700000}) {
+        CMutableTransaction spend;
+        spend.vin.emplace_back(COutPoint{Txid::FromUint256(m_rng.rand256()), 0});
+        spend.vout.emplace_back(value, CScript{});
+        spend.vout.emplace_back(value, CScript{});
+        block.vtx.push_back(MakeTransactionRef(spend));
+    }
+    // Stabilization transactions have no inputs and are not counted
+    CMutableTransaction stabilization;
+    stabilization.vout.emplace_back(5000 * COIN, CScript{});
+    block.vtx.push_back(MakeTransactionRef(stabilization));
+
+    // The coinbase outputs count towards the volume
+    BlockVolume volume = mining.GetBlockTransactionVolume(block);
+    BOOST_CHECK_EQUAL(volume.by_currency.size(), 1U);
+    BOOST_CHECK_EQUAL(volume.Get(CURRENCY_BTC), 3000000);
+    BOOST_CHECK_EQUAL(volume.Get(CURRENCY_EUR), 0);
+
+    // Legacy outputs carry no O currency amounts, a share of the base volume is assumed
+    BOOST_CHECK_EQUAL(mining.GetVolumeInCurrency("OEUR", volume), 300000);
+    BOOST_CHECK_EQUAL(mining.GetTransactionVolumeInCurrency("OEUR", block), 300000);
+    volume.by_currency[CURRENCY_EUR] = 4000;
+    BOOST_CHECK_EQUAL(mining.GetVolumeInCurrency("OEUR", volume), 4000);
+    BOOST_CHECK_EQUAL(mining.GetVolumeInCurrency("OUSD", volume), 300000);
+}
+
+BOOST_AUTO_TEST_CASE(stabilization_is_reverted_on_disconnect)
+{
+    g_stabilization_db = std::make_unique<CStabilizationDB>(1 << 20, true, false);
+    StabilizationMining mining;
+
+    auto make_plan = [&](int height, CAmount coins) {
+        StabilizationPlan plan;
+        plan.height = height;
+        for (const std::string currency : {"EUR", "USD"}) {
+            StabilizationTransaction tx;
+            tx.tx_id = m_rng.rand256();
+            tx.unstable_currency = currency;
+            tx.coins_created = coins;
+            tx.recipients.resize(3);
+            tx.block_height = height;
+            plan.records.push_back(tx);
+        }
+        return plan;
+    };
+
+    // Two blocks record stabilization transactions
+    mining.RecordStabilizationPlan(make_plan(200, 100));
+    mining.RecordStabilizationPlan(make_plan(201, 40));
+    BOOST_CHECK_EQUAL(g_stabilization_db->GetTransactionCount(), 4U);
+    BOOST_CHECK_EQUAL(g_stabilization_db->ReadTotals().coins_created, 280);
+    BOOST_CHECK_EQUAL(mining.GetTotalCoinsCreated("EUR"), 140);
+
+    // Disconnecting the tip takes its transactions out of history and totals
+    const uint256 block_hash = m_rng.rand256();
+    CBlockIndex index;
+    index.phashBlock = &block_hash;
+    index.nHeight = 201;
+    BOOST_CHECK(DisconnectOTransactions(index));
+    BOOST_CHECK_EQUAL(g_stabilization_db->GetTransactionCount(), 2U);
+    BOOST_CHECK(mining.GetStabilizationHistory("EUR", 201, 201).empty());
+    BOOST_CHECK_EQUAL(mining.GetStabilizationHistory("EUR", 200, 200).size(), 1U);
+    BOOST_CHECK_EQUAL(mining.GetTotalCoinsCreated("EUR"), 100);
+    BOOST_CHECK_EQUAL(mining.GetTotalCoinsCreated("USD"), 100);
+    const StabilizationTotals totals = g_stabilization_db->ReadTotals();
+    BOOST_CHECK_EQUAL(totals.coins_created, 200);
+    BOOST_CHECK_EQUAL(totals.transactions, 2);
+    BOOST_CHECK_EQUAL(totals.recipients, 6);
+
+    // Disconnecting again changes nothing, and the block can be connected again
+    BOOST_CHECK(DisconnectOTransactions(index));
+    BOOST_CHECK_EQUAL(g_stabilization_db->ReadTotals().transactions, 2);
+    mining.RecordStabilizationPlan(make_plan(201, 40));
+    BOOST_CHECK_EQUAL(g_stabilization_db->ReadTotals().coins_created, 280);
+
+    g_stabilization_db.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
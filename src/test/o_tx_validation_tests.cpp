@@ -0,0 +1,605 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <checkqueue.h>
+#include <consensus/o_brightid_db.h>
+#include <consensus/o_tx_validation.h>
+#include <key.h>
+#include <measurement/o_measurement_db.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+#include <boost/test/unit_test.hpp>
+
+using namespace OConsensus;
+using OMeasurement::g_measurement_db;
+
+static uint256 MakeTestUint256(int id) {
+    uint256 result;
+    result.SetNull();
+    *(reinterpret_cast<int*>(result.begin())) = id;
+    return result;
+}
+
+static CTransactionRef MakeOTx(const CScript& script) {
+    CMutableTransaction tx;
+    tx.vout.emplace_back(0, script);
+    return MakeTransactionRef(std::move(tx));
+}
+
+/** Sign with the Schnorr signature of payloads that carry the signer's key */
+template <typename T>
+static void SignSchnorr(const CKey& key, T& data) {
+    data.signature.resize(OTransactions::O_SCHNORR_SIG_SIZE);
+    BOOST_REQUIRE(key.SignSchnorr(data.GetHash(), data.signature, nullptr, uint256::ONE));
+}
+
+BOOST_FIXTURE_TEST_SUITE(o_tx_validation_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(o_tx_precheck_matches_serial_processing)
+{
+    g_measurement_db = std::make_unique<OMeasurement::CMeasurementDB>(2 << 20, true, false);
+    g_brightid_db = std::make_unique<CBrightIDUserDB>(2 << 20, true, false);
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey measurer = key.GetPubKey();
+
+    // A verified user that can be invited to measure
+    BrightIDUser user;
+    user.brightid_address = "brightid:measurer";
+    user.status = BrightIDStatus::VERIFIED;
+    user.is_active = true;
+    BOOST_CHECK(g_brightid_db->WriteUser(user.brightid_address, user));
+    BOOST_CHECK(g_brightid_db->LinkAddresses(user.brightid_address, HexStr(measurer)));
+
+    OTransactions::CMeasurementInviteData invite;
+    invite.invite_id = MakeTestUint256(1);
+    invite.invited_user = measurer;
+    invite.created_at = 1000;
+    invite.expires_at = 2000;
+
+    OTransactions::CWaterPriceMeasurementData good_price;
+    good_price.currency_code = "USD";
+    good_price.price = 1500000;
+    good_price.measurer = measurer;
+    good_price.timestamp = 1000;
+    good_price.invite_id = invite.invite_id;
+    good_price.proof_type = "url";
+    good_price.proof_data = "https://example.com/water";
+    SignSchnorr(key, good_price);
+
+    auto bad_proof = good_price;
+    bad_proof.proof_data = "ftp://example.com/water";
+    SignSchnorr(key, bad_proof);
+
+    // Signed by a key other than the measurer's
+    CKey other;
+    other.MakeNewKey(true);
+    auto forged = good_price;
+    forged.price = 1400000;
+    SignSchnorr(other, forged);
+
+    // A compact ECDSA signature by the measurer, the scheme of compact payloads only
+    auto wrong_scheme = good_price;
+    wrong_scheme.price = 1600000;
+    BOOST_REQUIRE(key.SignCompact(wrong_scheme.GetHash(), wrong_scheme.signature));
+
+    CBlock block;
+    CMutableTransaction plain;
+    plain.vout.emplace_back(1000, CScript{} << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(std::move(plain)));
+    block.vtx.push_back(MakeOTx(invite.ToScript()));
+    block.vtx.push_back(MakeOTx(good_price.ToScript()));
+    block.vtx.push_back(MakeOTx(bad_proof.ToScript()));
+    block.vtx.push_back(MakeOTx(forged.ToScript()));
+    block.vtx.push_back(MakeOTx(wrong_scheme.ToScript()));
+
+    // Serial prechecks
+    std::vector<OTxPrecheck> serial;
+    for (const auto& tx : block.vtx) serial.push_back(PrecheckOTransaction(*tx));
+    BOOST_CHECK(!serial[0].type.has_value());
+    BOOST_CHECK(!serial[0].valid);
+    BOOST_CHECK(serial[1].type == OTransactions::OTxType::MEASUREMENT_INVITE);
+    BOOST_CHECK(serial[1].valid);
+    BOOST_CHECK(std::holds_alternative<OTransactions::CMeasurementInviteData>(serial[1].data));
+    BOOST_CHECK(serial[2].valid);
+    BOOST_CHECK(serial[3].type == OTransactions::OTxType::WATER_PRICE);
+    BOOST_CHECK(!serial[3].valid);
+    BOOST_CHECK(serial[4].type == OTransactions::OTxType::WATER_PRICE);
+    BOOST_CHECK(!serial[4].valid);
+    BOOST_CHECK(serial[5].type == OTransactions::OTxType::WATER_PRICE);
+    BOOST_CHECK(!serial[5].valid);
+
+    // The same verdicts when run as check queue jobs on worker threads
+    std::vector<OTxPrecheck> parallel(block.vtx.size());
+    {
+        CCheckQueue<OTxCheck> queue{/*batch_size=*/1, /*worker_threads_num=*/2, "O transaction precheck", "ocheck"};
+        CCheckQueueControl<OTxCheck> control(queue);
+        std::vector<OTxCheck> checks;
+        for (size_t i = 0; i < block.vtx.size(); i++) checks.emplace_back(*block.vtx[i], parallel[i]);
+        control.Add(std::move(checks));
+        BOOST_CHECK(!control.Complete().has_value());
+    }
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        BOOST_CHECK(parallel[i].type == serial[i].type);
+        BOOST_CHECK_EQUAL(parallel[i].valid, serial[i].valid);
+        BOOST_CHECK_EQUAL(parallel[i].data.index(), serial[i].data.index());
+    }
+
+    // Applying the block takes the verdicts from the prechecks instead of
+    // checking again: a price whose precheck failed is not stored
+    SetMockTime(1500);
+    CBlockIndex index;
+    index.nHeight = 10;
+    auto rejected = parallel;
+    rejected[2].valid = false;
+    BOOST_CHECK(ProcessOTransactions(block, &index, nullptr, &rejected));
+    BOOST_CHECK(g_measurement_db->HasInvite(invite.invite_id));
+    BOOST_CHECK(!g_measurement_db->ReadWaterPrice(good_price.GetHash()).has_value());
+
+    BOOST_CHECK(g_measurement_db->EraseInvite(invite.invite_id));
+    BOOST_CHECK(ProcessOTransactions(block, &index, nullptr, &parallel));
+    BOOST_CHECK(g_measurement_db->HasInvite(invite.invite_id));
+    BOOST_CHECK(g_measurement_db->ReadWaterPrice(good_price.GetHash()).has_value());
+    BOOST_CHECK(!g_measurement_db->ReadWaterPrice(bad_proof.GetHash()).has_value());
+    BOOST_CHECK(!g_measurement_db->ReadWaterPrice(forged.GetHash()).has_value());
+    BOOST_CHECK(!g_measurement_db->ReadWaterPrice(wrong_scheme.GetHash()).has_value());
+
+    // A precheck vector that does not match the block is ignored and the
+    // block is prechecked inline
+    std::vector<OTxPrecheck> mismatched(1);
+    BOOST_CHECK(g_measurement_db->EraseInvite(invite.invite_id));
+    BOOST_CHECK(g_measurement_db->EraseWaterPrice(good_price.GetHash()));
+    BOOST_CHECK(ProcessOTransactions(block, &index, nullptr, &mismatched));
+    BOOST_CHECK(g_measurement_db->HasInvite(invite.invite_id));
+    BOOST_CHECK(g_measurement_db->ReadWaterPrice(good_price.GetHash()).has_value());
+    SetMockTime(0);
+
+    g_brightid_db.reset();
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(o_payload_decodes_small_number_framing)
+{
+    // ToScript writes version and type with CScript::operator<<(int64_t), as OP_1..OP_16
+    OTransactions::CWaterPriceMeasurementData price;
+    price.currency_code = "USD";
+    price.price = 1500000;
+    price.timestamp = 1000;
+    const CScript price_script = price.ToScript();
+    BOOST_CHECK_EQUAL(price_script[6], OP_1);
+    const auto price_location = OTransactions::ParseOPayload(price_script);
+    BOOST_REQUIRE(price_location.has_value());
+    BOOST_CHECK_EQUAL(price_location->version, OTransactions::O_TX_VERSION);
+    BOOST_CHECK_EQUAL(price_location->type, static_cast<uint8_t>(OTransactions::OTxType::WATER_PRICE));
+    const auto decoded_price = OTransactions::DeserializeOPayload<OTransactions::CWaterPriceMeasurementData>(
+        std::span{price_script.data() + price_location->offset, price_location->size});
+    BOOST_REQUIRE(decoded_price.has_value());
+    BOOST_CHECK_EQUAL(decoded_price->price, price.price);
+
+    // Validation and invite payloads are written without a version
+    OTransactions::CMeasurementValidationData validation;
+    validation.measurement_id = MakeTestUint256(3);
+    const auto validation_location = OTransactions::ParseOPayload(validation.ToScript());
+    BOOST_REQUIRE(validation_location.has_value());
+    BOOST_CHECK_EQUAL(validation_location->version, OTransactions::O_TX_VERSION);
+    BOOST_CHECK_EQUAL(validation_location->type, static_cast<uint8_t>(OTransactions::OTxType::MEASUREMENT_VALIDATION));
+    BOOST_CHECK(OTransactions::ExtractMeasurementValidation(*MakeOTx(validation.ToScript())).has_value());
+
+    OTransactions::CMeasurementInviteData invite;
+    invite.invite_id = MakeTestUint256(4);
+    const CTransactionRef invite_tx = MakeOTx(invite.ToScript());
+    BOOST_CHECK(OTransactions::GetOTxType(*invite_tx) == OTransactions::OTxType::MEASUREMENT_INVITE);
+
+    // Scripts that end with a push are read without going past their end
+    BOOST_CHECK(!OTransactions::ParseOPayload(CScript{} << OP_RETURN << OTransactions::O_TX_PREFIX));
+    BOOST_CHECK(!OTransactions::ParseOPayload(CScript{} << OP_RETURN << OTransactions::O_TX_PREFIX << std::vector<unsigned char>{0x01}));
+    const auto last_push = OTransactions::ParseOPayload(CScript{} << OP_RETURN << OTransactions::O_TX_PREFIX << OP_1 << std::vector<unsigned char>{0x01, 0x02});
+    BOOST_REQUIRE(last_push.has_value());
+    BOOST_CHECK_EQUAL(last_push->size, 2U);
+
+    // OP_0 and OP_1NEGATE are not small numbers
+    const std::vector<unsigned char> payload{0x00};
+    BOOST_CHECK(!OTransactions::ParseOPayload(CScript{} << OP_RETURN << OTransactions::O_TX_PREFIX << OP_0 << payload));
+    BOOST_CHECK(!OTransactions::ParseOPayload(CScript{} << OP_RETURN << OTransactions::O_TX_PREFIX << OP_1NEGATE << payload));
+}
+
+BOOST_AUTO_TEST_CASE(o_tx_view_decodes_payload_in_place)
+{
+    OTransactions::CMeasurementInviteData invite;
+    invite.invite_id = MakeTestUint256(7);
+    invite.created_at = 1000;
+    invite.expires_at = 2000;
+
+    CMutableTransaction mtx;
+    mtx.vout.emplace_back(1000, CScript{} << OP_TRUE);
+    mtx.vout.emplace_back(0, invite.ToScript());
+    const CTransactionRef tx = MakeTransactionRef(std::move(mtx));
+
+    // The payload is a span into the output script, not a copy
+    const auto view = OTransactions::GetOTxView(*tx);
+    BOOST_REQUIRE(view.has_value());
+    BOOST_CHECK(view->type == OTransactions::OTxType::MEASUREMENT_INVITE);
+    BOOST_CHECK_EQUAL(view->version, OTransactions::O_TX_VERSION);
+    BOOST_CHECK_EQUAL(view->output_index, 1U);
+    const CScript& script = tx->vout[1].scriptPubKey;
+    BOOST_CHECK(view->payload.data() > script.data());
+    BOOST_CHECK(view->payload.data() + view->payload.size() == script.data() + script.size());
+
+    const auto decoded = OTransactions::DeserializeOPayload<OTransactions::CMeasurementInviteData>(view->payload);
+    BOOST_REQUIRE(decoded.has_value());
+    BOOST_CHECK(decoded->invite_id == invite.invite_id);
+    BOOST_CHECK(OTransactions::ExtractMeasurementInvite(*tx).has_value());
+    BOOST_CHECK(!OTransactions::ExtractWaterPriceMeasurement(*tx).has_value());
+    BOOST_CHECK(OTransactions::ExtractMeasurementInvite(*view)->invite_id == invite.invite_id);
+    BOOST_CHECK(!OTransactions::ExtractWaterPriceMeasurement(*view).has_value());
+    BOOST_CHECK(OTransactions::GetOTxType(*view) == OTransactions::OTxType::MEASUREMENT_INVITE);
+
+    // A copy of the transaction views its own outputs
+    const CTransaction copy{*tx};
+    const auto copy_view = OTransactions::GetOTxView(copy);
+    BOOST_REQUIRE(copy_view.has_value());
+    BOOST_CHECK(copy_view->payload.data() >= copy.vout[1].scriptPubKey.data());
+    BOOST_CHECK(std::ranges::equal(copy_view->payload, view->payload));
+
+    // Version and type may also be written as one byte pushes
+    OTransactions::CWaterPriceMeasurementData price;
+    price.currency_code = "USD";
+    price.price = 1500000;
+    price.timestamp = 1000;
+    DataStream ds;
+    ds << price;
+    const std::vector<unsigned char> payload(UCharCast(ds.data()), UCharCast(ds.data() + ds.size()));
+    CScript pushed;
+    pushed << OP_RETURN << OTransactions::O_TX_PREFIX << std::vector<unsigned char>{OTransactions::O_TX_VERSION}
+           << std::vector<unsigned char>{static_cast<uint8_t>(OTransactions::OTxType::WATER_PRICE)} << payload;
+    const CTransactionRef pushed_tx = MakeOTx(pushed);
+    const auto pushed_view = OTransactions::GetOTxView(*pushed_tx);
+    BOOST_REQUIRE(pushed_view.has_value());
+    BOOST_CHECK(pushed_view->type == OTransactions::OTxType::WATER_PRICE);
+    BOOST_CHECK(std::ranges::equal(pushed_view->payload, payload));
+
+    // Other OP_RETURN outputs and truncated O outputs are not O transactions
+    BOOST_CHECK(!OTransactions::IsOTransaction(*MakeOTx(CScript{} << OP_RETURN << payload)));
+    BOOST_CHECK(!OTransactions::IsOTransaction(*MakeOTx(CScript{} << OP_RETURN << OTransactions::O_TX_PREFIX << OP_1)));
+}
+
+BOOST_AUTO_TEST_CASE(o_tx_compact_payloads_round_trip)
+{
+    g_measurement_db = std::make_unique<OMeasurement::CMeasurementDB>(2 << 20, true, false);
+    g_brightid_db = std::make_unique<CBrightIDUserDB>(2 << 20, true, false);
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey measurer = key.GetPubKey();
+
+    BrightIDUser user;
+    user.brightid_address = "brightid:compact";
+    user.status = BrightIDStatus::VERIFIED;
+    user.is_active = true;
+    BOOST_CHECK(g_brightid_db->WriteUser(user.brightid_address, user));
+    BOOST_CHECK(g_brightid_db->LinkAddresses(user.brightid_address, HexStr(measurer)));
+
+    OTransactions::CMeasurementInviteData invite;
+    invite.invite_id = MakeTestUint256(11);
+    invite.invited_user = measurer;
+    invite.currency_code = "USD";
+    invite.created_at = 1000;
+    invite.expires_at = 2000;
+    invite.block_height = 9;
+
+    OTransactions::CWaterPriceMeasurementData price;
+    price.currency_code = "USD";
+    price.price = 1500000;
+    price.measurer = measurer;
+    price.timestamp = 1000;
+    price.invite_id = invite.invite_id;
+    price.proof_type = "url";
+    price.proof_data = "https://example.com/water";
+
+    // Compact payloads carry no measurer key, it is recovered from a compact
+    // ECDSA signature. The digest names the measurer by key hash, so the
+    // record as decoded signs the id it is stored under.
+    auto compact_price = price;
+    compact_price.measurer = CPubKey();
+    compact_price.measurer_id = measurer.GetID();
+    BOOST_CHECK(compact_price.GetHash() == price.GetHash());
+    BOOST_REQUIRE(key.SignCompact(price.GetHash(), price.signature));
+
+    OTransactions::CExchangeRateMeasurementData rate;
+    rate.from_currency = "OUSD";
+    rate.to_currency = "XYZ";
+    rate.exchange_rate = 990000;
+    rate.measurer = measurer;
+    rate.timestamp = 1000;
+    rate.invite_id = invite.invite_id;
+    rate.proof_data = "https://example.com/rate";
+    rate.signature = {0x01};
+
+    // Compact payloads are smaller and carry an explicit version
+    const CTransactionRef invite_tx = MakeOTx(invite.ToScript(OTransactions::O_TX_VERSION_COMPACT));
+    const CTransactionRef price_tx = MakeOTx(price.ToScript(OTransactions::O_TX_VERSION_COMPACT));
+    const CTransactionRef rate_tx = MakeOTx(rate.ToScript(OTransactions::O_TX_VERSION_COMPACT));
+    BOOST_CHECK_LT(invite_tx->vout[0].scriptPubKey.size(), invite.ToScript().size());
+    BOOST_CHECK_LT(price_tx->vout[0].scriptPubKey.size(), price.ToScript().size());
+    BOOST_CHECK_LT(rate_tx->vout[0].scriptPubKey.size(), rate.ToScript().size());
+    BOOST_CHECK_EQUAL(OTransactions::GetOTxView(*price_tx)->version, OTransactions::O_TX_VERSION_COMPACT);
+    BOOST_CHECK(OTransactions::GetOTxType(*price_tx) == OTransactions::OTxType::WATER_PRICE);
+
+    const auto decoded_invite = OTransactions::ExtractMeasurementInvite(*invite_tx);
+    BOOST_REQUIRE(decoded_invite.has_value());
+    BOOST_CHECK(decoded_invite->GetHash() == invite.GetHash());
+
+    // Measurers are named by key hash only
+    const auto decoded_price = OTransactions::ExtractWaterPriceMeasurement(*price_tx);
+    BOOST_REQUIRE(decoded_price.has_value());
+    BOOST_CHECK(!decoded_price->measurer.IsValid());
+    BOOST_CHECK(decoded_price->measurer_id == measurer.GetID());
+    BOOST_CHECK_EQUAL(decoded_price->currency_code, "USD");
+    BOOST_CHECK_EQUAL(decoded_price->timestamp, price.timestamp);
+    BOOST_CHECK_EQUAL(decoded_price->proof_type, "url");
+    BOOST_CHECK(CheckWaterPriceMeasurement(*decoded_price));
+
+    // The same signature does not verify as Schnorr against the full payload's key
+    BOOST_CHECK(!CheckWaterPriceMeasurement(price));
+
+    // Currencies missing from the built-in table are written out
+    const auto decoded_rate = OTransactions::ExtractExchangeRateMeasurement(*rate_tx);
+    BOOST_REQUIRE(decoded_rate.has_value());
+    BOOST_CHECK_EQUAL(decoded_rate->from_currency, "OUSD");
+    BOOST_CHECK_EQUAL(decoded_rate->to_currency, "XYZ");
+    BOOST_CHECK_EQUAL(decoded_rate->exchange_rate, rate.exchange_rate);
+
+    // A truncated payload does not decode
+    const auto view = OTransactions::GetOTxView(*price_tx);
+    BOOST_CHECK(!OTransactions::DeserializeOPayload<OTransactions::CWaterPriceMeasurementData>(
+        view->payload.first(view->payload.size() - 2), view->version).has_value());
+
+    // The measurer is resolved through the invitation when the measurement is applied
+    SetMockTime(1500);
+    CBlock block;
+    block.vtx = {invite_tx, price_tx};
+    CBlockIndex index;
+    index.nHeight = 10;
+    BOOST_CHECK(ProcessOTransactions(block, &index));
+    const auto stored = g_measurement_db->ReadWaterPrice(decoded_price->GetHash());
+    BOOST_REQUIRE(stored.has_value());
+    BOOST_CHECK(stored->measurement_id == price.GetHash());
+    BOOST_CHECK(stored->submitter == measurer);
+    SetMockTime(0);
+
+    g_brightid_db.reset();
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(o_tx_batch_applies_signed_records)
+{
+    g_measurement_db = std::make_unique<OMeasurement::CMeasurementDB>(2 << 20, true, false);
+    g_brightid_db = std::make_unique<CBrightIDUserDB>(2 << 20, true, false);
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey measurer = key.GetPubKey();
+
+    BrightIDUser user;
+    user.brightid_address = "brightid:batch";
+    user.status = BrightIDStatus::VERIFIED;
+    user.is_active = true;
+    BOOST_CHECK(g_brightid_db->WriteUser(user.brightid_address, user));
+    BOOST_CHECK(g_brightid_db->LinkAddresses(user.brightid_address, HexStr(measurer)));
+
+    // Miners write invitations as unsigned batches
+    OTransactions::CBatchData invites;
+    invites.record_type = OTransactions::OTxType::MEASUREMENT_INVITE;
+    invites.record_version = OTransactions::O_TX_VERSION_COMPACT;
+    std::vector<OTransactions::CWaterPriceMeasurementData> prices;
+    for (int i = 0; i < 3; i++) {
+        OTransactions::CMeasurementInviteData invite;
+        invite.invite_id = MakeTestUint256(20 + i);
+        invite.invited_user = measurer;
+        invite.currency_code = "USD";
+        invite.created_at = 1000;
+        invite.expires_at = 2000;
+        invites.AddRecord(invite);
+
+        OTransactions::CWaterPriceMeasurementData price;
+        price.currency_code = "USD";
+        price.price = 1500000 + i;
+        price.measurer = measurer;
+        price.timestamp = 1000;
+        price.invite_id = invite.invite_id;
+        price.proof_type = "url";
+        price.proof_data = "https://example.com/water";
+        prices.push_back(price);
+    }
+    prices[2].proof_data = "ftp://example.com/water";
+
+    // One signature covers all measurements, which name the measurer by key hash
+    OTransactions::CBatchData batch;
+    batch.record_type = OTransactions::OTxType::WATER_PRICE;
+    batch.record_version = OTransactions::O_TX_VERSION_COMPACT;
+    batch.submitter = measurer;
+    for (auto price : prices) {
+        price.measurer = CPubKey();
+        price.measurer_id = measurer.GetID();
+        batch.AddRecord(price);
+    }
+    SignSchnorr(key, batch);
+    BOOST_CHECK(batch.VerifySignature());
+
+    const CTransactionRef invites_tx = MakeOTx(invites.ToScript());
+    const CTransactionRef batch_tx = MakeOTx(batch.ToScript());
+    BOOST_CHECK(OTransactions::GetOTxType(*batch_tx) == OTransactions::OTxType::BATCH);
+    const auto decoded = OTransactions::ExtractBatch(*batch_tx);
+    BOOST_REQUIRE(decoded.has_value());
+    BOOST_CHECK(decoded->GetMerkleRoot() == batch.GetMerkleRoot());
+
+    // The record failing its own checks is left out, the rest are claimed by the submitter
+    const OTxPrecheck precheck = PrecheckOTransaction(*batch_tx);
+    BOOST_CHECK(precheck.type == OTransactions::OTxType::BATCH);
+    BOOST_CHECK(precheck.valid);
+    const auto* checked = std::get_if<OTxBatch>(&precheck.data);
+    BOOST_REQUIRE(checked);
+    BOOST_CHECK_EQUAL(checked->records.size(), 2U);
+    BOOST_CHECK(std::get<OTransactions::CWaterPriceMeasurementData>(checked->records[0]).measurer == measurer);
+
+    // Changing any record breaks the signature
+    auto tampered = batch;
+    tampered.records[1].back() ^= 1;
+    OTxBatch unused;
+    BOOST_CHECK(!CheckBatch(tampered, unused));
+
+    // A signed batch cannot carry someone else's measurements
+    CKey other;
+    other.MakeNewKey(true);
+    auto foreign = batch;
+    foreign.submitter = other.GetPubKey();
+    SignSchnorr(other, foreign);
+    BOOST_CHECK(foreign.VerifySignature());
+    BOOST_CHECK(!CheckBatch(foreign, unused));
+
+    // Too many records
+    auto oversized = invites;
+    oversized.records.resize(OTransactions::MAX_O_BATCH_RECORDS + 1, invites.records[0]);
+    BOOST_CHECK(!oversized.IsValid());
+
+    SetMockTime(1500);
+    CBlock block;
+    block.vtx = {invites_tx, batch_tx};
+    CBlockIndex index;
+    index.nHeight = 10;
+    BOOST_CHECK(ProcessOTransactions(block, &index));
+    for (int i = 0; i < 3; i++) {
+        BOOST_CHECK(g_measurement_db->HasInvite(MakeTestUint256(20 + i)));
+    }
+    for (int i = 0; i < 2; i++) {
+        const auto stored = g_measurement_db->ReadWaterPrice(prices[i].GetHash());
+        BOOST_REQUIRE(stored.has_value());
+        BOOST_CHECK(stored->submitter == measurer);
+    }
+    BOOST_CHECK(!g_measurement_db->ReadWaterPrice(prices[2].GetHash()).has_value());
+    SetMockTime(0);
+
+    g_brightid_db.reset();
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(o_tx_batch_rejects_repeated_records)
+{
+    CKey key;
+    key.MakeNewKey(true);
+
+    OTransactions::CBatchData batch;
+    batch.record_type = OTransactions::OTxType::MEASUREMENT_VALIDATION;
+    batch.submitter = key.GetPubKey();
+    std::vector<OTransactions::CMeasurementValidationData> validations;
+    for (int i = 0; i < 3; i++) {
+        OTransactions::CMeasurementValidationData validation;
+        validation.measurement_id = MakeTestUint256(40 + i);
+        validation.validator = key.GetPubKey();
+        validation.timestamp = 1000;
+        batch.AddRecord(validation);
+        validations.push_back(validation);
+    }
+    SignSchnorr(key, batch);
+    OTxBatch checked;
+    BOOST_CHECK(CheckBatch(batch, checked));
+    BOOST_CHECK_EQUAL(checked.records.size(), 3U);
+
+    // Repeating the trailing record keeps the merkle root, and so the signature
+    auto repeated = batch;
+    repeated.records.push_back(batch.records.back());
+    bool mutated{false};
+    BOOST_CHECK(repeated.GetMerkleRoot(&mutated) == batch.GetMerkleRoot());
+    BOOST_CHECK(mutated);
+    BOOST_CHECK(!repeated.IsValid());
+    BOOST_CHECK(!repeated.VerifySignature());
+    BOOST_CHECK(!CheckBatch(repeated, checked));
+    const OTxPrecheck precheck = PrecheckOTransaction(*MakeOTx(repeated.ToScript()));
+    BOOST_CHECK(precheck.type == OTransactions::OTxType::BATCH);
+    BOOST_CHECK(!precheck.valid);
+
+    // A record that differs only in its signature is the same validation
+    auto resigned = batch;
+    auto copy = validations.back();
+    copy.signature = {0x01};
+    resigned.records.push_back(OTransactions::SerializeOPayload(copy, resigned.record_version));
+    SignSchnorr(key, resigned);
+    BOOST_CHECK(resigned.IsValid());
+    BOOST_CHECK(resigned.VerifySignature());
+    BOOST_CHECK(!CheckBatch(resigned, checked));
+
+    // Invitation batches are unsigned and may not carry a signature
+    OTransactions::CBatchData invites;
+    invites.record_type = OTransactions::OTxType::MEASUREMENT_INVITE;
+    OTransactions::CMeasurementInviteData invite;
+    invite.invite_id = MakeTestUint256(50);
+    invite.invited_user = key.GetPubKey();
+    invite.created_at = 1000;
+    invite.expires_at = 2000;
+    invites.AddRecord(invite);
+    BOOST_CHECK(invites.IsValid());
+    auto signed_invites = invites;
+    signed_invites.submitter = key.GetPubKey();
+    SignSchnorr(key, signed_invites);
+    BOOST_CHECK(!signed_invites.IsValid());
+
+    // Two encodings of one invitation are rejected by its id
+    invite.block_height = 1;
+    invites.AddRecord(invite);
+    BOOST_CHECK(invites.IsValid());
+    BOOST_CHECK(!CheckBatch(invites, checked));
+}
+
+BOOST_AUTO_TEST_CASE(o_tx_batch_schnorr_signature)
+{
+    CKey key;
+    key.MakeNewKey(true);
+
+    OTransactions::CMeasurementValidationData validation;
+    validation.measurement_id = MakeTestUint256(30);
+    validation.validator = key.GetPubKey();
+    validation.timestamp = 1000;
+
+    OTransactions::CBatchData batch;
+    batch.record_type = OTransactions::OTxType::MEASUREMENT_VALIDATION;
+    batch.submitter = key.GetPubKey();
+    batch.AddRecord(validation);
+
+    // The signature is verified as Schnorr against the x-only submitter key
+    SignSchnorr(key, batch);
+    BOOST_CHECK(batch.VerifySignature());
+    OTxBatch checked;
+    BOOST_CHECK(CheckBatch(batch, checked));
+    BOOST_CHECK_EQUAL(checked.records.size(), 1U);
+
+    // It covers the records
+    auto tampered = batch;
+    tampered.records[0].back() ^= 1;
+    BOOST_CHECK(!tampered.VerifySignature());
+
+    // and only verifies for the submitter's key
+    CKey other;
+    other.MakeNewKey(true);
+    auto foreign = batch;
+    foreign.submitter = other.GetPubKey();
+    BOOST_CHECK(!foreign.VerifySignature());
+
+    // Compact ECDSA signatures are not accepted, each payload has one scheme
+    BOOST_REQUIRE(key.SignCompact(batch.GetHash(), batch.signature));
+    BOOST_CHECK(!batch.VerifySignature());
+    BOOST_CHECK(!CheckBatch(batch, checked));
+
+    // An uncompressed submitter has no x-only key to verify against
+    CKey uncompressed;
+    uncompressed.MakeNewKey(false);
+    auto legacy = batch;
+    legacy.submitter = uncompressed.GetPubKey();
+    SignSchnorr(uncompressed, legacy);
+    BOOST_CHECK(!legacy.VerifySignature());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,199 @@
+// Copyright (c) 2025 The O Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <consensus/o_brightid_db.h>
+#include <consensus/o_business_db.h>
+#include <consensus/o_pow_pob.h>
+#include <consensus/o_tx_validation.h>
+#include <consensus/o_undo.h>
+#include <measurement/o_measurement_db.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <boost/test/unit_test.hpp>
+
+using namespace OConsensus;
+using OMeasurement::g_measurement_db;
+
+static uint256 MakeTestUint256(int id) {
+    uint256 result;
+    result.SetNull();
+    *(reinterpret_cast<int*>(result.begin())) = id;
+    return result;
+}
+
+BOOST_FIXTURE_TEST_SUITE(o_undo_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(o_block_undo_reverts_connected_state)
+{
+    g_measurement_db = std::make_unique<OMeasurement::CMeasurementDB>(2 << 20, true, false);
+    g_brightid_db = std::make_unique<CBrightIDUserDB>(2 << 20, true, false);
+    g_business_db = std::make_unique<CBusinessMinerDB>(2 << 20, true, false);
+
+    // State before the block: one unvalidated measurement
+    OMeasurement::WaterPriceMeasurement existing;
+    existing.measurement_id = MakeTestUint256(1);
+    existing.currency_code = "USD";
+    existing.price = 100;
+    existing.timestamp = 1000;
+    BOOST_CHECK(g_measurement_db->WriteWaterPrice(existing.measurement_id, existing));
+
+    // The block validates it, adds a measurement and overwrites that again
+    OBlockUndo undo;
+    auto validated = existing;
+    validated.is_validated = true;
+    validated.validators.push_back(CPubKey{});
+    undo.SaveWaterPrice(validated.measurement_id);
+    BOOST_CHECK(g_measurement_db->WriteWaterPrice(validated.measurement_id, validated));
+
+    OMeasurement::WaterPriceMeasurement added = existing;
+    added.measurement_id = MakeTestUint256(2);
+    added.currency_code = "EUR";
+    undo.SaveWaterPrice(added.measurement_id);
+    BOOST_CHECK(g_measurement_db->WriteWaterPrice(added.measurement_id, added));
+    added.price = 120;
+    undo.SaveWaterPrice(added.measurement_id);
+    BOOST_CHECK(g_measurement_db->WriteWaterPrice(added.measurement_id, added));
+
+    // ...verifies a user, stores an invite and updates business stats
+    BrightIDUser user;
+    user.brightid_address = "brightid:alice";
+    user.status = BrightIDStatus::VERIFIED;
+    user.is_active = true;
+    undo.SaveUser(user.brightid_address);
+    BOOST_CHECK(g_brightid_db->WriteUser(user.brightid_address, user));
+    undo.SaveLink(user.brightid_address);
+    BOOST_CHECK(g_brightid_db->LinkAddresses(user.brightid_address, "02abcdef"));
+
+    OMeasurement::MeasurementInvite invite;
+    invite.invite_id = MakeTestUint256(3);
+    undo.SaveInvite(invite.invite_id);
+    BOOST_CHECK(g_measurement_db->WriteInvite(invite.invite_id, invite));
+
+    HybridPowPobConsensus consensus;
+    const uint256 miner = MakeTestUint256(4);
+    CMutableTransaction tx;
+    tx.vout.emplace_back(1000, CScript{} << OP_TRUE);
+    consensus.UpdateBusinessStats(miner, CTransaction(tx), 50, &undo);
+    BOOST_CHECK(g_business_db->HasBusinessMiner(miner));
+
+    // The first record stored for a block is kept
+    const uint256 block_hash = MakeTestUint256(100);
+    CBlockIndex index;
+    index.phashBlock = &block_hash;
+    index.nHeight = 50;
+    BOOST_CHECK(WriteOBlockUndo(index, undo));
+    OBlockUndo later;
+    later.SaveInvite(MakeTestUint256(5));
+    BOOST_CHECK(WriteOBlockUndo(index, later));
+
+    BOOST_CHECK(DisconnectOTransactions(index));
+
+    // Everything is back to the state before the block
+    auto restored = g_measurement_db->ReadWaterPrice(existing.measurement_id);
+    BOOST_REQUIRE(restored.has_value());
+    BOOST_CHECK(!restored->is_validated);
+    BOOST_CHECK(restored->validators.empty());
+    BOOST_CHECK(!g_measurement_db->ReadWaterPrice(added.measurement_id).has_value());
+    BOOST_CHECK_EQUAL(g_measurement_db->GetWaterPriceCount(), 1U);
+    BOOST_CHECK(!g_measurement_db->HasInvite(invite.invite_id));
+    BOOST_CHECK(!g_brightid_db->ReadUser(user.brightid_address).has_value());
+    BOOST_CHECK(!g_brightid_db->GetBrightIDAddress("02abcdef").has_value());
+    BOOST_CHECK(!g_business_db->HasBusinessMiner(miner));
+    BOOST_CHECK(g_measurement_db->VerifyIntegrity());
+    BOOST_CHECK(g_brightid_db->VerifyIntegrity());
+
+    // The record is consumed; disconnecting a block without one is a no-op
+    BOOST_CHECK(!g_measurement_db->HasBlockUndo(block_hash));
+    BOOST_CHECK(DisconnectOTransactions(index));
+
+    g_business_db.reset();
+    g_brightid_db.reset();
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(o_block_prunes_invites_with_undo)
+{
+    g_measurement_db = std::make_unique<OMeasurement::CMeasurementDB>(2 << 20, true, false);
+
+    OMeasurement::MeasurementInvite expired;
+    expired.invite_id = MakeTestUint256(10);
+    expired.expires_at = 1500;
+    OMeasurement::MeasurementInvite used = expired;
+    used.invite_id = MakeTestUint256(11);
+    used.expires_at = 5000;
+    OMeasurement::MeasurementInvite active = used;
+    active.invite_id = MakeTestUint256(12);
+    for (const auto& invite : {expired, used, active}) {
+        BOOST_CHECK(g_measurement_db->WriteInvite(invite.invite_id, invite));
+    }
+    BOOST_CHECK(g_measurement_db->MarkInviteUsed(used.invite_id));
+
+    // A block prunes the invites used or expired before its median time past
+    const uint256 block_hash = MakeTestUint256(101);
+    CBlockIndex index;
+    index.phashBlock = &block_hash;
+    index.nHeight = 51;
+    index.nTime = 2000;
+    OBlockUndo undo;
+    BOOST_CHECK(ProcessOTransactions(CBlock{}, &index, &undo));
+    BOOST_CHECK(!g_measurement_db->HasInvite(expired.invite_id));
+    BOOST_CHECK(!g_measurement_db->HasInvite(used.invite_id));
+    BOOST_CHECK(g_measurement_db->HasInvite(active.invite_id));
+    BOOST_CHECK_EQUAL(undo.invites.size(), 2U);
+
+    // and disconnecting it restores them as they were
+    BOOST_CHECK(WriteOBlockUndo(index, undo));
+    BOOST_CHECK(DisconnectOTransactions(index));
+    BOOST_CHECK(g_measurement_db->HasInvite(expired.invite_id));
+    BOOST_CHECK(g_measurement_db->GetInviteStatus(used.invite_id).is_used);
+    BOOST_CHECK_EQUAL(g_measurement_db->GetExpiredInvites(2000).size(), 2U);
+    BOOST_CHECK(g_measurement_db->VerifyIntegrity());
+
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_CASE(o_block_undo_is_pruned_below_height)
+{
+    g_measurement_db = std::make_unique<OMeasurement::CMeasurementDB>(2 << 20, true, false);
+
+    OBlockUndo undo;
+    undo.SaveInvite(MakeTestUint256(20));
+
+    std::vector<uint256> hashes;
+    for (int height = 0; height < 4; height++) {
+        hashes.push_back(MakeTestUint256(200 + height));
+    }
+    std::vector<CBlockIndex> indexes(hashes.size());
+    for (size_t i = 0; i < hashes.size(); i++) {
+        indexes[i].phashBlock = &hashes[i];
+        indexes[i].nHeight = i;
+        BOOST_CHECK(WriteOBlockUndo(indexes[i], undo));
+    }
+
+    // Records below the height are erased, the ones at or above it are kept
+    BOOST_CHECK(PruneOBlockUndo(2));
+    BOOST_CHECK_EQUAL(g_measurement_db->GetBlockUndoPrunedHeight(), 2);
+    BOOST_CHECK(!g_measurement_db->HasBlockUndo(hashes[0]));
+    BOOST_CHECK(!g_measurement_db->HasBlockUndo(hashes[1]));
+    BOOST_CHECK(g_measurement_db->HasBlockUndo(hashes[2]));
+    BOOST_CHECK(g_measurement_db->HasBlockUndo(hashes[3]));
+
+    // Pruning never moves back down
+    BOOST_CHECK(PruneOBlockUndo(1));
+    BOOST_CHECK_EQUAL(g_measurement_db->GetBlockUndoPrunedHeight(), 2);
+
+    // A pruned block can no longer be disconnected, a kept one still can
+    BOOST_CHECK(!DisconnectOTransactions(indexes[1]));
+    BOOST_CHECK(DisconnectOTransactions(indexes[3]));
+    BOOST_CHECK(!g_measurement_db->HasBlockUndo(hashes[3]));
+
+    // A disconnected block leaves nothing behind for a later prune
+    BOOST_CHECK(PruneOBlockUndo(4));
+    BOOST_CHECK(!g_measurement_db->HasBlockUndo(hashes[2]));
+
+    g_measurement_db.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,7 @@
 #include <consensus/stabilization_coins.h>
 #include <consensus/stabilization_consensus.h>
 #include <consensus/o_tx_validation.h>
+#include <consensus/o_undo.h>
 #include <cuckoocache.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -2618,6 +2619,26 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     std::optional<CCheckQueueControl<CScriptCheck>> control;
     if (auto& queue = m_chainman.GetCheckQueue(); queue.HasThreads() && fScriptChecks) control.emplace(queue);
 
+    // O Blockchain: decode and run the stateless checks of O transactions on
+    // worker threads while inputs and scripts are checked below. The results
+    // are consumed by ProcessOTransactions, which applies them in block order.
+    // o_prechecks must stay in scope for as long as `o_control`.
+    std::vector<OConsensus::OTxPrecheck> o_prechecks;
+    std::optional<CCheckQueueControl<OConsensus::OTxCheck>> o_control;
+    if (auto& o_queue = m_chainman.GetOCheckQueue(); o_queue.HasThreads()) {
+        o_prechecks.resize(block.vtx.size());
+        std::vector<OConsensus::OTxCheck> o_checks;
+        for (size_t i = 0; i < block.vtx.size(); i++) {
+            if (OTransactions::IsOTransaction(*block.vtx[i])) o_checks.emplace_back(*block.vtx[i], o_prechecks[i]);
+        }
+        if (!o_checks.empty()) {
+            o_control.emplace(o_queue);
+            o_control->Add(std::move(o_checks));
+        } else {
+            o_prechecks.clear();
+        }
+    }
+
     std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
 
     std::vector<int> prevheights;
@@ -2711,16 +2732,12 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
              Ticks<SecondsDouble>(m_chainman.time_connect),
              Ticks<MillisecondsDouble>(m_chainman.time_connect) / m_chainman.num_blocks_total);
 
-    // O Blockchain: Process O-specific transactions (user verifications, measurements)
-    if (!OConsensus::ProcessOTransactions(block, pindex)) {
-        LogPrintf("O Blockchain: Failed to process O transactions at height %d\n", pindex->nHeight);
-        // Note: We don't fail the block for O transaction processing errors (non-critical)
-        // Individual O txs may be invalid, but block can still be accepted
-    }
-
-    // O Blockchain: Check for stabilization mining after processing all transactions
-    if (OConsensus::ShouldTriggerStabilization(block, pindex->nHeight)) {
-        auto stab_txs = OConsensus::g_stabilization_mining.CreateStabilizationTransactions(block, pindex->nHeight);
+    // O Blockchain: Check for stabilization mining. The plan is shared with block
+    // assembly and the consensus checks below, which all read the O state left by
+    // the parent block, so it is built before this block's O transactions apply.
+    const auto stab_plan = OConsensus::g_stabilization_mining.GetBlockPlan(block, pindex->nHeight);
+    if (stab_plan->triggered) {
+        const auto& stab_txs = stab_plan->transactions;
         
         // Process stabilization transactions using specialized coin manager
         OConsensus::g_stabilization_coins_manager.UpdateCoinsWithStabilization(stab_txs, view, pindex->nHeight);
@@ -2745,6 +2762,17 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         return false;
     }
 
+    // O Blockchain: Process O-specific transactions (user verifications, measurements).
+    // O database writes are applied immediately; o_undo reverts them if the block
+    // is not connected after all, and is stored for DisconnectBlock otherwise.
+    OConsensus::OBlockUndo o_undo;
+    if (o_control) o_control->Complete();
+    if (!OConsensus::ProcessOTransactions(block, pindex, &o_undo, o_prechecks.empty() ? nullptr : &o_prechecks)) {
+        LogPrintf("O Blockchain: Failed to process O transactions at height %d\n", pindex->nHeight);
+        // Note: We don't fail the block for O transaction processing errors (non-critical)
+        // Individual O txs may be invalid, but block can still be accepted
+    }
+
     CAmount blockReward = nFees + GetBlockSubsidy(pindex->nHeight, params.GetConsensus());
     if (block.vtx[0]->GetValueOut() > blockReward && state.IsValid()) {
         state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-amount",
@@ -2758,6 +2786,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     }
     if (!state.IsValid()) {
         LogInfo("Block validation error: %s", state.ToString());
+        OConsensus::ApplyOBlockUndo(o_undo);
         return false;
     }
     const auto time_4{SteadyClock::now()};
@@ -2769,12 +2798,19 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
              Ticks<MillisecondsDouble>(m_chainman.time_verify) / m_chainman.num_blocks_total);
 
     if (fJustCheck) {
+        OConsensus::ApplyOBlockUndo(o_undo);
         return true;
     }
 
     if (!m_blockman.WriteBlockUndo(blockundo, state, *pindex)) {
+        OConsensus::ApplyOBlockUndo(o_undo);
         return false;
     }
+    if (!OConsensus::WriteOBlockUndo(*pindex, o_undo)) {
+        OConsensus::ApplyOBlockUndo(o_undo);
+        return FatalError(m_chainman.GetNotifications(), state, _("Failed to write O undo data."));
+    }
+    OConsensus::g_stabilization_mining.RecordStabilizationPlan(*stab_plan);
 
     const auto time_5{SteadyClock::now()};
     m_chainman.time_undo += time_5 - time_4;
@@ -2959,6 +2995,17 @@ bool Chainstate::FlushStateToDisk(
                 if (!CheckDiskSpace(m_chainman.m_options.datadir, 48 * 2 * 2 * CoinsTip().GetCacheSize())) {
                     return FatalError(m_chainman.GetNotifications(), state, _("Disk space is too low!"));
                 }
+                // O Blockchain: drop O undo data of blocks too deep to be disconnected,
+                // or whose undo data was pruned from disk, then sync O state written by
+                // connected blocks before the chainstate.
+                int o_undo_prune_height{m_chain.Height() - OConsensus::O_BLOCK_UNDO_KEEP_DEPTH};
+                if (m_blockman.IsPruneMode() && m_chain.Tip()) {
+                    o_undo_prune_height = std::max(o_undo_prune_height,
+                        m_blockman.GetFirstBlock(*m_chain.Tip(), BLOCK_HAVE_UNDO, m_chain[std::max(o_undo_prune_height, 0)])->nHeight);
+                }
+                if (!OConsensus::PruneOBlockUndo(o_undo_prune_height) || !OConsensus::SyncOState()) {
+                    return FatalError(m_chainman.GetNotifications(), state, _("Failed to write to O state databases."));
+                }
                 // Flush the chainstate (which may refer to block index entries).
                 const auto empty_cache{(mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical};
                 if (empty_cache ? !CoinsTip().Flush() : !CoinsTip().Sync()) {
@@ -3047,6 +3094,7 @@ void Chainstate::UpdateTip(const CBlockIndex* pindexNew)
     if (m_mempool) {
         m_mempool->AddTransactionsUpdated(1);
     }
+    OConsensus::g_stabilization_mining.EvictBlockPlans(pindexNew->GetBlockHash());
 
     std::vector<bilingual_str> warning_messages;
     if (!m_chainman.IsInitialBlockDownload()) {
@@ -3101,6 +3149,10 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
         bool flushed = view.Flush();
         assert(flushed);
     }
+    // O Blockchain: revert measurement, BrightID and business state of the block
+    if (!OConsensus::DisconnectOTransactions(*pindexDelete)) {
+        LogError("DisconnectTip(): Failed to revert O state of block %s\n", pindexDelete->GetBlockHash().ToString());
+    }
     LogDebug(BCLog::BENCH, "- Disconnect block: %.2fms\n",
              Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
 
@@ -4967,6 +5019,9 @@ bool Chainstate::ReplayBlocks()
                 LogError("RollbackBlock(): DisconnectBlock failed at %d, hash=%s\n", pindexOld->nHeight, pindexOld->GetBlockHash().ToString());
                 return false;
             }
+            if (!OConsensus::DisconnectOTransactions(*pindexOld)) {
+                LogError("RollbackBlock(): Failed to revert O state at %d, hash=%s\n", pindexOld->nHeight, pindexOld->GetBlockHash().ToString());
+            }
             // If DISCONNECT_UNCLEAN is returned, it means a non-existing UTXO was deleted, or an existing UTXO was
             // overwritten. It corresponds to cases where the block-to-be-disconnect never had all its operations
             // applied to the UTXO set. However, as both writing a UTXO and deleting a UTXO are idempotent operations,
@@ -6326,6 +6381,8 @@ static ChainstateManager::Options&& Flatten(ChainstateManager::Options&& opts)
 
 ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Options options, node::BlockManager::Options blockman_options)
     : m_script_check_queue{/*batch_size=*/128, std::clamp(options.worker_threads_num, 0, MAX_SCRIPTCHECK_THREADS)},
+      m_o_check_queue{/*batch_size=*/16, std::clamp(options.worker_threads_num, 0, OConsensus::MAX_O_CHECK_THREADS),
+                      "O transaction precheck", "ocheck"},
       m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)},
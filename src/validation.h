@@ -11,6 +11,7 @@
 #include <chain.h>
 #include <checkqueue.h>
 #include <consensus/amount.h>
+#include <consensus/o_tx_validation.h>
 #include <cuckoocache.h>
 #include <deploymentstatus.h>
 #include <kernel/chain.h>
@@ -948,6 +949,9 @@ private:
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
 
+    //! A queue for O transaction prechecks, run alongside the script verifications.
+    CCheckQueue<OConsensus::OTxCheck> m_o_check_queue;
+
     //! Timers and counters used for benchmarking validation in both background
     //! and active chainstates.
     SteadyClock::duration GUARDED_BY(::cs_main) time_check{};
@@ -1323,6 +1327,7 @@ public:
     void RecalculateBestHeader() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
+    CCheckQueue<OConsensus::OTxCheck>& GetOCheckQueue() { return m_o_check_queue; }
 
     ~ChainstateManager();
 };